@@ -0,0 +1,316 @@
+﻿//-----------------------------------------------------------------------------------
+// File : AsyncLoader.h
+// Desc : Asynchronous Loader Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __ASYNC_LOADER_H__
+#define __ASYNC_LOADER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <ThreadPool.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// AsyncLoader class
+//////////////////////////////////////////////////////////////////////////////////////
+class AsyncLoader
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+    struct Request;
+
+public:
+    //================================================================================
+    // Type definition.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // STATE enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum STATE
+    {
+        STATE_PENDING = 0,      //!< 読み込み待ちです.
+        STATE_LOADING,          //!< ワーカースレッドで読み込み中です.
+        STATE_LOADED,           //!< 読み込みが済み, メインスレッドでの生成待ちです.
+        STATE_COMPLETED,        //!< 完了しました.
+        STATE_FAILED,           //!< 失敗しました.
+        STATE_CANCELED          //!< キャンセルされました.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // PRIORITY enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum PRIORITY
+    {
+        PRIORITY_LOW = 0,       //!< 低優先度です.
+        PRIORITY_NORMAL,        //!< 通常の優先度です.
+        PRIORITY_HIGH           //!< 高優先度です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Future class
+    //////////////////////////////////////////////////////////////////////////////////
+    class Future
+    {
+        //============================================================================
+        // list of friend classes and methods.
+        //============================================================================
+        friend class AsyncLoader;
+
+    public:
+        //============================================================================
+        // public methods.
+        //============================================================================
+
+        //---------------------------------------------------------------------------
+        //! @brief      コンストラクタです.
+        //---------------------------------------------------------------------------
+        Future();
+
+        //---------------------------------------------------------------------------
+        //! @brief      要求に対応しているかどうかチェックします.
+        //---------------------------------------------------------------------------
+        bool IsValid() const;
+
+        //---------------------------------------------------------------------------
+        //! @brief      状態を取得します.
+        //!
+        //! @note       要求に対応していない場合は STATE_CANCELED を返却します.
+        //---------------------------------------------------------------------------
+        STATE GetState() const;
+
+        //---------------------------------------------------------------------------
+        //! @brief      完了・失敗・キャンセルのいずれかで終わったかどうかチェックします.
+        //---------------------------------------------------------------------------
+        bool IsDone() const;
+
+        //---------------------------------------------------------------------------
+        //! @brief      キャンセルされたかどうかチェックします.
+        //!
+        //! @note       読み込み処理の途中で呼び出して, 処理を打ち切るのに使います.
+        //---------------------------------------------------------------------------
+        bool IsCanceled() const;
+
+        //---------------------------------------------------------------------------
+        //! @brief      キャンセルします.
+        //!
+        //! @note       読み込み待ちの要求は読み込まずに破棄されます. 読み込み中の要求は
+        //!             読み込みが終わるのを待ってから破棄され, 生成処理は呼ばれません.
+        //!             完了通知は STATE_CANCELED で呼ばれます.
+        //---------------------------------------------------------------------------
+        void Cancel();
+
+    private:
+        //============================================================================
+        // private variables.
+        //============================================================================
+        std::shared_ptr< Request >  m_Request;      //!< 要求です.
+
+        //============================================================================
+        // private methods.
+        //============================================================================
+        explicit Future( const std::shared_ptr< Request >& request );
+    };
+
+    typedef std::function< bool( const Future& ) >  LoadFunc;       //!< ワーカースレッドで実行する読み込み処理です.
+    typedef std::function< bool() >                 CreateFunc;     //!< メインスレッドで実行するGPUリソースの生成処理です.
+    typedef std::function< void( STATE ) >          Callback;       //!< メインスレッドで呼ばれる完了通知です(最終状態).
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Desc structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Desc
+    {
+        const char*     pName;          //!< ログ表示用の名前です.
+        PRIORITY        Priority;       //!< 優先度です.
+        LoadFunc        Load;           //!< 読み込み処理です(ファイル入出力やCPUでの変換を行います).
+        CreateFunc      Create;         //!< 生成処理です(デバイスを使う処理を行います).
+        Callback        OnComplete;     //!< 完了通知です.
+
+        //---------------------------------------------------------------------------
+        //! @brief      コンストラクタです.
+        //---------------------------------------------------------------------------
+        Desc()
+        : pName     ( "" )
+        , Priority  ( PRIORITY_NORMAL )
+        , Load      ()
+        , Create    ()
+        , OnComplete()
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        u32     MaxCreatePerUpdate;     //!< Update() 1回あたりに実行する生成処理の最大数です.
+
+        //---------------------------------------------------------------------------
+        //! @brief      コンストラクタです.
+        //---------------------------------------------------------------------------
+        Config()
+        : MaxCreatePerUpdate( 2 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     PendingCount;       //!< 読み込み待ちの要求数です.
+        u32     LoadingCount;       //!< 読み込み中の要求数です.
+        u32     LoadedCount;        //!< 生成待ちの要求数です.
+        u32     CompletedCount;     //!< 完了した要求数です.
+        u32     FailedCount;        //!< 失敗した要求数です.
+        u32     CanceledCount;      //!< キャンセルされた要求数です.
+
+        //---------------------------------------------------------------------------
+        //! @brief      コンストラクタです.
+        //---------------------------------------------------------------------------
+        Statistics()
+        : PendingCount  ( 0 )
+        , LoadingCount  ( 0 )
+        , LoadedCount   ( 0 )
+        , CompletedCount( 0 )
+        , FailedCount   ( 0 )
+        , CanceledCount ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    AsyncLoader();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~AsyncLoader();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     pPool       読み込み処理を実行するスレッドプールです.
+    //! @param [in]     config      設定です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       スレッドプールは終了処理が済むまで破棄しないでください.
+    //-------------------------------------------------------------------------------
+    bool Init( ThreadPool* pPool, const Config& config = Config() );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //!
+    //! @note       残っている要求は全てキャンセルし, 読み込み中の処理が終わるのを待ちます.
+    //!             生成処理と完了通知は呼ばれません.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      読み込みを要求します.
+    //!
+    //! @param [in]     desc        要求の設定です.
+    //! @return     要求の状態を問い合わせるためのフューチャーを返却します.
+    //! @note       優先度の高いものから順に読み込みます. 同じ優先度の場合は要求した順になります.
+    //-------------------------------------------------------------------------------
+    Future Submit( const Desc& desc );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      読み込みが済んだ要求の生成処理と完了通知を実行します.
+    //!
+    //! @note       メインスレッドから毎フレーム呼び出します.
+    //-------------------------------------------------------------------------------
+    void Update();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      要求が終わるまで待機します.
+    //!
+    //! @param [in]     future      待機する要求のフューチャーです.
+    //! @return     最終状態を返却します.
+    //! @note       メインスレッドから呼び出します. 読み込み待ちの要求は呼び出しスレッドで読み込み,
+    //!             生成処理と完了通知も Update() を待たずにここで実行します.
+    //-------------------------------------------------------------------------------
+    STATE Wait( const Future& future );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全ての要求が終わったかどうかチェックします.
+    //-------------------------------------------------------------------------------
+    bool IsIdle() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    Statistics GetStatistics() const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Request structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Request
+    {
+        std::string     Name;           //!< 名前です.
+        PRIORITY        Priority;       //!< 優先度です.
+        u32             Sequence;       //!< 要求した順番です.
+        LoadFunc        Load;           //!< 読み込み処理です.
+        CreateFunc      Create;         //!< 生成処理です.
+        Callback        OnComplete;     //!< 完了通知です.
+        std::mutex      Mutex;          //!< 状態を保護するミューテックスです.
+        STATE           State;          //!< 状態です.
+        bool            IsLoadFailed;   //!< 読み込みに失敗したかどうか.
+        bool            IsCanceled;     //!< キャンセルされたかどうか.
+    };
+
+    typedef std::shared_ptr< Request >  RequestPtr;
+
+    ThreadPool*                 m_pPool;            //!< スレッドプールです.
+    Config                      m_Config;           //!< 設定です.
+    std::vector< RequestPtr >   m_Pending;          //!< 読み込み待ちの要求です(優先度順のヒープ).
+    std::vector< RequestPtr >   m_Loading;          //!< 読み込み中の要求です.
+    std::deque< RequestPtr >    m_Loaded;           //!< 生成待ちの要求です.
+    mutable std::mutex          m_Mutex;            //!< ミューテックスです.
+    std::condition_variable     m_Cond;             //!< 読み込み完了通知用の条件変数です.
+    u32                         m_DispatchCount;    //!< スレッドプールに積んだまま終わっていないジョブ数です.
+    u32                         m_Sequence;         //!< 次に発行する要求番号です.
+    Statistics                  m_Statistics;       //!< 統計情報です(完了・失敗・キャンセル数のみ).
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    void Dispatch();
+    void RunLoad( const RequestPtr& request, bool enqueue );
+    void Finish( const RequestPtr& request );
+    static bool IsLowerPriority( const RequestPtr& lhs, const RequestPtr& rhs );
+
+    AsyncLoader     ( const AsyncLoader& );     // アクセス禁止.
+    void operator = ( const AsyncLoader& );     // アクセス禁止.
+};
+
+#endif//__ASYNC_LOADER_H__
@@ -0,0 +1,200 @@
+﻿//-----------------------------------------------------------------------------------
+// File : BlockCompressor.h
+// Desc : Block Compression Encoder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __BLOCK_COMPRESSOR_H__
+#define __BLOCK_COMPRESSOR_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <ThreadPool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// BlockCompressor class
+//////////////////////////////////////////////////////////////////////////////////////
+class BlockCompressor
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //////////////////////////////////////////////////////////////////////////////////
+    // FORMAT enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum FORMAT
+    {
+        FORMAT_BC1 = 0,         //!< RGB 4bpp です(アルファは扱いません).
+        FORMAT_BC3,             //!< RGBA 8bpp です.
+        FORMAT_BC4,             //!< R 4bpp です.
+        FORMAT_BC5,             //!< RG 8bpp です(法線マップ向け).
+        FORMAT_BC7,             //!< RGBA 8bpp の高品質フォーマットです.
+        NUM_FORMAT              //!< フォーマット数です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // QUALITY enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum QUALITY
+    {
+        QUALITY_FAST = 0,       //!< 端点を主軸の範囲から求めるだけの高速な設定です.
+        QUALITY_NORMAL,         //!< 最小二乗法で端点を数回求め直す設定です.
+        QUALITY_HIGH,           //!< 端点の近傍探索まで行う高品質な設定です.
+    };
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        FORMAT      Format;         //!< 出力フォーマットです.
+        QUALITY     Quality;        //!< 品質です.
+        u32         TileSize;       //!< 1ジョブで処理するタイルの一辺のブロック数です.
+
+        Config()
+        : Format    ( FORMAT_BC1 )
+        , Quality   ( QUALITY_NORMAL )
+        , TileSize  ( 8 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     BlockCount;         //!< エンコードしたブロック数です.
+        u32     TileCount;          //!< 並列処理したタイル数です.
+        u32     PixelCount;         //!< 誤差を求めた画素数です(ブロックの端の埋めた画素は含みません).
+        u32     ColorChannelCount;  //!< 誤差を求めたカラーチャンネル数です.
+        u32     AlphaChannelCount;  //!< 誤差を求めたアルファチャンネル数です(アルファを扱わないフォーマットは0).
+        f64     ColorSquaredError;  //!< カラーチャンネルの元画像との二乗誤差の合計です.
+        f64     AlphaSquaredError;  //!< アルファチャンネルの元画像との二乗誤差の合計です.
+
+        Statistics()
+        : BlockCount        ( 0 )
+        , TileCount         ( 0 )
+        , PixelCount        ( 0 )
+        , ColorChannelCount ( 0 )
+        , AlphaChannelCount ( 0 )
+        , ColorSquaredError ( 0.0 )
+        , AlphaSquaredError ( 0.0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      1ブロックあたりのバイト数を取得します.
+    //-------------------------------------------------------------------------------
+    static u32 GetBlockSize( FORMAT format );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ブロック1行あたりのバイト数を取得します.
+    //-------------------------------------------------------------------------------
+    static u32 GetPitch( FORMAT format, u32 width );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      圧縮後のデータサイズを取得します.
+    //-------------------------------------------------------------------------------
+    static u32 GetSlicePitch( FORMAT format, u32 width, u32 height );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      4x4 画素の1ブロックをエンコードします.
+    //!
+    //! @param [in]     pRGBA       RGBA8 で並んだ16画素です.
+    //! @param [in]     config      設定です.
+    //! @param [out]    pOutput     出力先です(GetBlockSize() バイト).
+    //! @note       BC1 は常に4色モードで出力し, アルファは捨てます.
+    //!             BC4 は R チャンネル, BC5 は RG チャンネルをエンコードします.
+    //!             BC7 はモード6(1サブセット, RGBA 7bit + Pビット, 4bitインデックス)のみを使います.
+    //!             不透明なブロックはアルファが必ず 255 に復元されるようにエンコードします.
+    //-------------------------------------------------------------------------------
+    static void EncodeBlock( const u8* pRGBA, const Config& config, u8* pOutput );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      1ブロックをデコードします.
+    //!
+    //! @param [in]     format      フォーマットです.
+    //! @param [in]     pBlock      ブロックデータです.
+    //! @param [out]    pRGBA       RGBA8 で並んだ16画素の出力先です.
+    //! @retval true    デコードに成功.
+    //! @retval false   対応していないブロック(モード6以外のBC7)のため, 黒で埋めました.
+    //! @note       BC4 は (R, 0, 0, 255), BC5 は (R, G, 0, 255) として出力します.
+    //-------------------------------------------------------------------------------
+    static bool DecodeBlock( FORMAT format, const u8* pBlock, u8* pRGBA );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      画像をエンコードします.
+    //!
+    //! @param [in]     pRGBA       RGBA8 の画像です.
+    //! @param [in]     width       横幅です.
+    //! @param [in]     height      縦幅です.
+    //! @param [in]     pitch       入力画像の1行あたりのバイト数です.
+    //! @param [in]     config      設定です.
+    //! @param [out]    pOutput     出力先です(GetSlicePitch() バイト).
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @param [out]    pStats      統計情報です(nullptrの場合は出力しません).
+    //! @note       画像を TileSize x TileSize ブロックのタイルに分け, タイルごとに並列にエンコードします.
+    //!             4の倍数でない端のブロックは端の画素を繰り返して埋めます.
+    //!             統計情報を求める場合は, エンコードしたブロックをデコードして誤差を求めます.
+    //-------------------------------------------------------------------------------
+    static void Encode(
+        const u8*       pRGBA,
+        u32             width,
+        u32             height,
+        u32             pitch,
+        const Config&   config,
+        u8*             pOutput,
+        ThreadPool*     pPool  = nullptr,
+        Statistics*     pStats = nullptr );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      画像をデコードします.
+    //!
+    //! @param [in]     format      フォーマットです.
+    //! @param [in]     pBlocks     ブロックデータです.
+    //! @param [in]     width       横幅です.
+    //! @param [in]     height      縦幅です.
+    //! @param [in]     blockPitch  ブロック1行あたりのバイト数です.
+    //! @param [out]    pRGBA       RGBA8 の出力先です.
+    //! @param [in]     pitch       出力画像の1行あたりのバイト数です.
+    //! @retval true    デコードに成功.
+    //! @retval false   対応していないブロックが含まれていました.
+    //-------------------------------------------------------------------------------
+    static bool Decode(
+        FORMAT          format,
+        const u8*       pBlocks,
+        u32             width,
+        u32             height,
+        u32             blockPitch,
+        u8*             pRGBA,
+        u32             pitch );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    BlockCompressor ();                             // アクセス禁止.
+    BlockCompressor ( const BlockCompressor& );     // アクセス禁止.
+    void operator = ( const BlockCompressor& );     // アクセス禁止.
+};
+
+#endif//__BLOCK_COMPRESSOR_H__
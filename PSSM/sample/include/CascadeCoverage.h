@@ -0,0 +1,128 @@
+﻿//-----------------------------------------------------------------------------------
+// File : CascadeCoverage.h
+// Desc : Cascade Coverage Solver Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __CASCADE_COVERAGE_H__
+#define __CASCADE_COVERAGE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CascadeCoverage class
+//////////////////////////////////////////////////////////////////////////////////////
+class CascadeCoverage
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 MAX_CASCADE_COUNT = 4;     //!< 扱えるカスケードの最大数です.
+    static const u32 MAX_RECT_COUNT    = 16;    //!< 1カスケードあたりの最大矩形数です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Rect structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Rect
+    {
+        f32     MinX;       //!< X方向の最小値です(ライトの正規化デバイス座標).
+        f32     MinY;       //!< Y方向の最小値です(ライトの正規化デバイス座標).
+        f32     MaxX;       //!< X方向の最大値です(ライトの正規化デバイス座標).
+        f32     MaxY;       //!< Y方向の最大値です(ライトの正規化デバイス座標).
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    CascadeCoverage();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~CascadeCoverage();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      各カスケードで描画が必要な領域を求めます.
+    //!
+    //! @param [in]     pShadowMatrices     シャドウマップ行列です(細かいカスケードから順に並べます).
+    //! @param [in]     count               カスケード数です.
+    //! @param [in]     border              細かいカスケードの縁から除外する幅です(正規化デバイス座標).
+    //! @note       細かいカスケードの領域が軸平行な矩形に写らない場合(透視変換で歪ませた場合など)は,
+    //!             その組み合わせについては除外を行いません.
+    //-------------------------------------------------------------------------------
+    void Update( const asdx::Matrix* pShadowMatrices, u32 count, f32 border );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画が必要な矩形の数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetRectCount( u32 cascade ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画が必要な矩形を取得します.
+    //-------------------------------------------------------------------------------
+    const Rect& GetRect( u32 cascade, u32 index ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画が必要な矩形全体を囲む矩形を取得します.
+    //!
+    //! @param [in]     cascade     カスケード番号です.
+    //! @param [out]    result      囲む矩形です.
+    //! @retval true    描画が必要な領域があります.
+    //! @retval false   描画が必要な領域はありません.
+    //-------------------------------------------------------------------------------
+    bool GetBoundingRect( u32 cascade, Rect& result ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      AABBが描画が必要な領域に掛かるかどうか判定します.
+    //!
+    //! @param [in]     cascade     カスケード番号です.
+    //! @param [in]     box         判定するAABBです(ワールド空間).
+    //! @retval true    描画が必要です.
+    //! @retval false   細かいカスケードだけに含まれるため描画は不要です.
+    //-------------------------------------------------------------------------------
+    bool TestBox( u32 cascade, const asdx::BoundingBox& box ) const;
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    asdx::Matrix    m_ShadowMatrix[ MAX_CASCADE_COUNT ];                    //!< シャドウマップ行列です.
+    Rect            m_Rects       [ MAX_CASCADE_COUNT ][ MAX_RECT_COUNT ];  //!< 描画が必要な矩形です.
+    u32             m_RectCount   [ MAX_CASCADE_COUNT ];                    //!< 描画が必要な矩形の数です.
+    u32             m_CascadeCount;                                         //!< カスケード数です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    bool ComputeCoveredRect( u32 finer, u32 coarser, f32 border, Rect& result ) const;
+    void SubtractRect( u32 cascade, const Rect& value );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    CascadeCoverage     ( const CascadeCoverage& );     // アクセス禁止.
+    void operator =     ( const CascadeCoverage& );     // アクセス禁止.
+};
+
+#endif//__CASCADE_COVERAGE_H__
@@ -0,0 +1,204 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ChunkResidency.h
+// Desc : Streaming Chunk Residency Manager Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __CHUNK_RESIDENCY_H__
+#define __CHUNK_RESIDENCY_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// ChunkResidency class
+//////////////////////////////////////////////////////////////////////////////////////
+class ChunkResidency
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //////////////////////////////////////////////////////////////////////////////////
+    // STATE enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum STATE
+    {
+        STATE_EVICTED = 0,      //!< 詳細化データを持っていません(基本LODで描画します).
+        STATE_LOADING,          //!< 詳細化データを読み込み中です.
+        STATE_RESIDENT,         //!< 詳細化データが常駐しています.
+        STATE_FAILED,           //!< 読み込みに失敗しました(以降は要求しません).
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        u32     MaxLoadingCount;    //!< 同時に読み込むチャンク数の上限です.
+        u64     MemoryBudget;       //!< 常駐させる詳細化データの合計サイズの上限です(バイト).
+        f32     PixelError;         //!< 基本LODのまま描画してよい画面上の誤差です(ピクセル).
+
+        Config()
+        : MaxLoadingCount   ( 4 )
+        , MemoryBudget      ( 256 * 1024 * 1024 )
+        , PixelError        ( 1.0f )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     WantedCount;        //!< 基本LODでは誤差が許容値を超えるチャンク数です.
+        u32     ResidentCount;      //!< 常駐しているチャンク数です.
+        u32     LoadingCount;       //!< 読み込み中のチャンク数です.
+        u32     RequestCount;       //!< 直前の更新で要求したチャンク数です.
+        u32     EvictCount;         //!< 直前の更新で解放したチャンク数です.
+        u64     ResidentSize;       //!< 常駐しているデータの合計サイズです.
+
+        Statistics()
+        : WantedCount   ( 0 )
+        , ResidentCount ( 0 )
+        , LoadingCount  ( 0 )
+        , RequestCount  ( 0 )
+        , EvictCount    ( 0 )
+        , ResidentSize  ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    ChunkResidency();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~ChunkResidency();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     chunkCount      チャンク数です.
+    //! @param [in]     config          設定です.
+    //! @note       全てのチャンクは STATE_EVICTED から始まります.
+    //-------------------------------------------------------------------------------
+    void Init( u32 chunkCount, const Config& config );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクの情報を設定します.
+    //!
+    //! @param [in]     index       チャンク番号です.
+    //! @param [in]     mini        AABBの最小値です(ローカル座標系).
+    //! @param [in]     maxi        AABBの最大値です(ローカル座標系).
+    //! @param [in]     baseError   基本LODの誤差です(ローカル座標系での距離).
+    //! @param [in]     size        詳細化データを常駐させるのに必要なサイズです(バイト).
+    //-------------------------------------------------------------------------------
+    void SetChunk(
+        u32                     index,
+        const asdx::Vector3&    mini,
+        const asdx::Vector3&    maxi,
+        f32                     baseError,
+        u64                     size );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      優先度を求めて, 読み込むチャンクと解放するチャンクを決めます.
+    //!
+    //! @param [in]     worldViewProj   ワールドビュー射影行列です.
+    //! @param [in]     width           ビューポートの横幅(ピクセル数)です.
+    //! @param [in]     height          ビューポートの縦幅(ピクセル数)です.
+    //! @param [out]    requests        読み込みを開始するチャンク番号です(優先度の高い順).
+    //! @param [out]    evictions       詳細化データを解放するチャンク番号です.
+    //! @note       優先度は基本LODの誤差を画面に投影したピクセル数です. 視錐台の外側でも影を落とすので, 距離だけで評価します.
+    //!             要求したチャンクは STATE_LOADING に, 解放するチャンクは STATE_EVICTED になります.
+    //!             予算が足りない場合は, 要求するチャンクより優先度の低い常駐チャンクから解放します.
+    //-------------------------------------------------------------------------------
+    void Update(
+        const asdx::Matrix&     worldViewProj,
+        f32                     width,
+        f32                     height,
+        std::vector< u32 >&     requests,
+        std::vector< u32 >&     evictions );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      読み込みが完了したことを通知します.
+    //!
+    //! @param [in]     index       チャンク番号です.
+    //! @param [in]     success     常駐させた場合は true, 失敗した場合は false を指定します.
+    //-------------------------------------------------------------------------------
+    void OnLoaded( u32 index, bool success );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンク数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetChunkCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクの状態を取得します.
+    //-------------------------------------------------------------------------------
+    STATE GetState( u32 index ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      直前の更新で求めたチャンクの優先度を取得します.
+    //-------------------------------------------------------------------------------
+    f32 GetPriority( u32 index ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+private:
+    //////////////////////////////////////////////////////////////////////////////////
+    // Chunk structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Chunk
+    {
+        asdx::Vector3   Center;         //!< バウンディングスフィアの中心です.
+        f32             Radius;         //!< バウンディングスフィアの半径です.
+        f32             BaseError;      //!< 基本LODの誤差です.
+        u64             Size;           //!< 詳細化データのサイズです.
+        STATE           State;          //!< 状態です.
+        f32             Priority;       //!< 優先度です.
+    };
+
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< Chunk >    m_Chunks;           //!< チャンクです.
+    std::vector< u32 >      m_Candidates;       //!< 読み込み候補の作業領域です.
+    std::vector< u32 >      m_Victims;          //!< 解放候補の作業領域です.
+    Config                  m_Config;           //!< 設定です.
+    u64                     m_LoadingSize;      //!< 読み込み中のデータの合計サイズです.
+    Statistics              m_Statistics;       //!< 統計情報です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    ChunkResidency  ( const ChunkResidency& );  // アクセス禁止.
+    void operator = ( const ChunkResidency& );  // アクセス禁止.
+};
+
+#endif//__CHUNK_RESIDENCY_H__
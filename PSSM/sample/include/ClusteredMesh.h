@@ -0,0 +1,523 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ClusteredMesh.h
+// Desc : Clustered Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __CLUSTERED_MESH_H__
+#define __CLUSTERED_MESH_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMesh.h>
+#include <MeshClusterizer.h>
+#include <PackedVertex.h>
+#include <IndexCompactor.h>
+#include <MeshSimplifier.h>
+#include <MaterialTable.h>
+#include <TextureCache.h>
+#include <SubsetBatcher.h>
+#include <InstanceBuffer.h>
+#include <CookedMeshFormat.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// ClusteredMesh class
+//////////////////////////////////////////////////////////////////////////////////////
+class ClusteredMesh : public asdx::Mesh
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // BindStatistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct BindStatistics
+    {
+        u32     RequestCount;       //!< マテリアルの設定を要求した回数です.
+        u32     BindCount;          //!< 実際にマテリアルを設定した回数です.
+
+        BindStatistics()
+        : RequestCount  ( 0 )
+        , BindCount     ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+    using asdx::Mesh::Draw;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    ClusteredMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    virtual ~ClusteredMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブコンストラクタです.
+    //!
+    //! @note       GPUリソースとCPU側の配列の所有権を移すだけで, 何も再生成しません.
+    //-------------------------------------------------------------------------------
+    ClusteredMesh( ClusteredMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブ代入演算子です.
+    //-------------------------------------------------------------------------------
+    ClusteredMesh& operator = ( ClusteredMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @note       asdx::Mesh の初期化に加えて, メッシュレットを構築します.
+    //!             インデックスバッファは16bitに収まる場合は自動的に16bitで生成します.
+    //!             usePackedVertex が true の場合は頂点バッファを PackedVertex で生成するため,
+    //!             シェーダの入力は PackedVertex::INPUT_ELEMENTS に合わせる必要があります.
+    //!             マテリアルは MaterialTable に変換して保持し, テクスチャはファイル名ごとに1度だけ読み込みます.
+    //!             pMaterials を指定した場合はメッシュのマテリアルは参照せず, その内容をコピーして使います.
+    //!             pPool を指定した場合は全マテリアルのテクスチャファイルをまとめて並列に読み込みます.
+    //!             サブセットはマテリアル順に描画し, 直前と同じマテリアルの設定は省きます.
+    //-------------------------------------------------------------------------------
+    bool Init(
+        ID3D11Device*        pDevice,
+        const asdx::ResMesh& mesh,
+        const void*          pShaderBytecode,
+        const u32            byteCodeLength,
+        const char*          resFolderPath = "../res/",
+        const char*          dummyFolderPath = "../res/",
+        bool                 usePackedVertex = false,
+        const MaterialTable* pMaterials = nullptr,
+        ThreadPool*          pPool = nullptr );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度のみの描画に使う位置座標だけの頂点ストリームを生成します.
+    //!
+    //! @param [in]     pDevice             デバイスです.
+    //! @param [in]     mesh                Init() に渡したメッシュです.
+    //! @param [in]     pShaderBytecode     深度描画用頂点シェーダのバイトコードです.
+    //! @param [in]     byteCodeLength      バイトコードの長さです.
+    //! @param [in]     weldPositions       同じ位置座標の頂点をまとめるかどうか.
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //! @note       Init() の後に呼び出します. 頂点シェーダの入力は POSITION のみにしておく必要があります.
+    //!             weldPositions が true の場合は, 位置座標だけが等しい頂点をまとめてインデックスを振り直します.
+    //!             インデックスの並びは変わらないので, メッシュレットのカリング結果はそのまま使えます.
+    //-------------------------------------------------------------------------------
+    bool InitDepthStream(
+        ID3D11Device*        pDevice,
+        const asdx::ResMesh& mesh,
+        const void*          pShaderBytecode,
+        const u32            byteCodeLength,
+        bool                 weldPositions = true );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度(LOD)のインデックスバッファを生成します.
+    //!
+    //! @param [in]     pDevice     デバイスです.
+    //! @param [in]     chain       MeshSimplifier::Build() の結果です(詳細度の情報は引き取ります).
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //! @note       InitDepthStream() の後に呼び出します. 頂点バッファは全ての詳細度で共有します.
+    //!             深度描画用の頂点ストリームがある場合は, そちらの頂点番号に振り直したものも生成します.
+    //-------------------------------------------------------------------------------
+    bool InitLod( ID3D11Device* pDevice, MeshSimplifier::LodChain&& chain );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インスタンス描画用の入力レイアウトを生成します.
+    //!
+    //! @param [in]     pDevice                 デバイスです.
+    //! @param [in]     pShaderBytecode         インスタンス描画用頂点シェーダのバイトコードです.
+    //! @param [in]     byteCodeLength          バイトコードの長さです.
+    //! @param [in]     pDepthShaderBytecode    インスタンス描画用の深度描画用頂点シェーダのバイトコードです(nullptr可).
+    //! @param [in]     depthByteCodeLength     バイトコードの長さです.
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //! @note       InitDepthStream() の後に呼び出します. 頂点シェーダの入力は頂点データに加えて
+    //!             InstanceBuffer::INPUT_ELEMENTS に合わせる必要があります.
+    //-------------------------------------------------------------------------------
+    bool InitInstancing(
+        ID3D11Device*   pDevice,
+        const void*     pShaderBytecode,
+        const u32       byteCodeLength,
+        const void*     pDepthShaderBytecode,
+        const u32       depthByteCodeLength );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      空間分割のチャンクを設定します.
+    //!
+    //! @param [in]     pChunks     クック時に求めたチャンクです.
+    //! @param [in]     chunkCount  チャンク数です.
+    //! @retval true    設定に成功.
+    //! @retval false   設定に失敗.
+    //! @note       Init() の後に呼び出します. チャンクを設定すると SetChunkMask() で
+    //!             チャンク単位に描画するサブセットを絞り込めるようになります.
+    //-------------------------------------------------------------------------------
+    bool InitChunks( const CookedChunk* pChunks, u32 chunkCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      カリング結果の描画範囲だけを描画します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     result              MeshClusterizer::Cull() の結果です.
+    //-------------------------------------------------------------------------------
+    void Draw( ID3D11DeviceContext* pDeviceContext, const MeshClusterizer::CullResult& result );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度のみを描画します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @note       位置座標だけの頂点ストリームを使い, マテリアルの設定は一切行いません.
+    //!             頂点シェーダ・定数バッファは呼び出し側で設定しておく必要があります.
+    //!             InitDepthStream() を呼んでいない場合は通常の描画を行います.
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnly( ID3D11DeviceContext* pDeviceContext );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      カリング結果の描画範囲だけ深度のみを描画します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     result              MeshClusterizer::Cull() の結果です.
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const MeshClusterizer::CullResult& result );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度を指定して描画します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     lod                 詳細度です(0 は元のメッシュ).
+    //! @note       メッシュレットは元のメッシュにしか無いので, カリングは行いません.
+    //-------------------------------------------------------------------------------
+    void DrawLod( ID3D11DeviceContext* pDeviceContext, u32 lod );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度を指定して深度のみを描画します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     lod                 詳細度です(0 は元のメッシュ).
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnlyLod( ID3D11DeviceContext* pDeviceContext, u32 lod );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インスタンス描画を行います.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     instances           転送済みのインスタンスデータです.
+    //! @param [in]     lod                 詳細度です(0 は元のメッシュ).
+    //! @note       定数バッファのワールド行列にはインスタンスのワールド行列より前に掛ける行列を設定しておきます.
+    //!             メッシュレットのカリングはインスタンスごとに行えないので行いません.
+    //-------------------------------------------------------------------------------
+    void DrawInstanced( ID3D11DeviceContext* pDeviceContext, const InstanceBuffer& instances, u32 lod = 0 );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度のみのインスタンス描画を行います.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     instances           転送済みのインスタンスデータです.
+    //! @param [in]     lod                 詳細度です(0 は元のメッシュ).
+    //! @note       InitInstancing() に深度描画用のバイトコードを渡していない場合は,
+    //!             インスタンス描画用の入力レイアウトで通常の頂点ストリームを使って描画します.
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnlyInstanced( ID3D11DeviceContext* pDeviceContext, const InstanceBuffer& instances, u32 lod = 0 );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクを視錐台でカリングします.
+    //!
+    //! @param [in]     worldViewProj       ワールドビュー射影行列です(逆量子化行列は含めません).
+    //! @param [in,out] pVisible            チャンクごとの可視フラグです(GetChunkCount() 個).
+    //! @return     見えるチャンク数を返却します.
+    //! @note       視錐台の外側にあるチャンクのフラグを 0 にします. 既に 0 のフラグはそのままなので,
+    //!             呼び出し側で他の判定結果を入れておけば組み合わせて使えます.
+    //-------------------------------------------------------------------------------
+    u32 CullChunks( const asdx::Matrix& worldViewProj, u8* pVisible ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画するチャンクを設定します.
+    //!
+    //! @param [in]     pVisible            チャンクごとの可視フラグです(nullptrの場合は全て描画します).
+    //! @note       フラグは描画が終わるまで保持しておく必要があります.
+    //!             インスタンス描画ではインスタンスごとに判定できないので無視されます.
+    //-------------------------------------------------------------------------------
+    void SetChunkMask( const u8* pVisible );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンク数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetChunkCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクのAABBを取得します(ローカル座標系).
+    //-------------------------------------------------------------------------------
+    const asdx::BoundingBox& GetChunkBoundingBox( u32 idx ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュレットを取得します.
+    //-------------------------------------------------------------------------------
+    const MeshClusterizer& GetClusterizer() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      位置座標の逆量子化行列を取得します.
+    //!
+    //! @note       ワールド行列の前に掛けて使います. 圧縮頂点を使わない場合は単位行列です.
+    //-------------------------------------------------------------------------------
+    const asdx::Matrix& GetDequantizeMatrix() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      圧縮頂点を使っているかどうかチェックします.
+    //-------------------------------------------------------------------------------
+    bool IsPackedVertex() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用の頂点数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetDepthVertexCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用の頂点ストライドを取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetDepthStride() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インデックスのサイズ(バイト数)を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetIndexStride() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ベース頂点ごとのチャンク数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetIndexChunkCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度の数を取得します(元のメッシュを含みます).
+    //-------------------------------------------------------------------------------
+    u32 GetLodCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度ごとの誤差を取得します(ローカル座標系での距離).
+    //!
+    //! @note       GetLodCount() 個の配列で, 先頭は元のメッシュなので 0 です.
+    //-------------------------------------------------------------------------------
+    const f32* GetLodErrors() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度ごとの三角形数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetLodTriangleCount( u32 lod ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルテーブルを取得します.
+    //-------------------------------------------------------------------------------
+    const MaterialTable& GetMaterialTable() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      テクスチャキャッシュを取得します.
+    //-------------------------------------------------------------------------------
+    const TextureCache& GetTextureCache() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアル設定の統計情報を取得します.
+    //!
+    //! @note       ResetBindStatistics() を呼び出してからの累計です.
+    //!             RequestCount - BindCount が省いた設定の回数になります.
+    //-------------------------------------------------------------------------------
+    const BindStatistics& GetBindStatistics() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアル設定の統計情報をリセットします.
+    //-------------------------------------------------------------------------------
+    void ResetBindStatistics();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルの設定を開始します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @note       サンプラーを設定し, 直前に設定したマテリアルの記録を破棄します.
+    //!             StaticBatch 等の他の描画からマテリアルを共有する場合に, BindMaterial() の前に呼び出します.
+    //-------------------------------------------------------------------------------
+    void BeginMaterialBinding( ID3D11DeviceContext* pDeviceContext );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルを設定します.
+    //!
+    //! @param [in]     pDeviceContext      デバイスコンテキストです.
+    //! @param [in]     materialId          マテリアル番号です.
+    //! @note       定数バッファとテクスチャを設定するだけで, 定数バッファの更新は行いません.
+    //!             直前に設定したマテリアルと同じ場合は何もしません.
+    //-------------------------------------------------------------------------------
+    void BindMaterial( ID3D11DeviceContext* pDeviceContext, u32 materialId );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //!
+    //! @note       描画中に呼び出してはいけません.
+    //-------------------------------------------------------------------------------
+    void Swap( ClusteredMesh& value );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // MaterialBinding structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct MaterialBinding
+    {
+        ID3D11Buffer*               pCB;                            //!< マテリアルの定数バッファです.
+        ID3D11ShaderResourceView*   pSRV[ MAX_TEXTURE_SLOT ];       //!< テクスチャです(テクスチャキャッシュが所有します).
+    };
+
+    MeshClusterizer                       m_Clusterizer;      //!< メッシュレットです.
+    const MeshClusterizer::CullResult*    m_pCullResult;      //!< 描画中のカリング結果です.
+    asdx::Matrix                          m_Dequantize;       //!< 位置座標の逆量子化行列です.
+    bool                                  m_IsPacked;         //!< 圧縮頂点を使うかどうか.
+    asdx::Vector3                         m_QuantizeMin;      //!< 位置座標の量子化に用いたAABBの最小値です.
+    asdx::Vector3                         m_QuantizeMax;      //!< 位置座標の量子化に用いたAABBの最大値です.
+    ID3D11Buffer*                         m_pDepthVB;         //!< 深度描画用の頂点バッファです.
+    ID3D11Buffer*                         m_pDepthIB;         //!< 深度描画用のインデックスバッファです(まとめない場合はnullptr).
+    ID3D11InputLayout*                    m_pDepthIL;         //!< 深度描画用の入力レイアウトです.
+    u32                                   m_DepthStride;      //!< 深度描画用の頂点ストライドです.
+    u32                                   m_DepthVertexCount; //!< 深度描画用の頂点数です.
+    DXGI_FORMAT                           m_IndexFormat;      //!< インデックスバッファのフォーマットです.
+    DXGI_FORMAT                           m_DepthIndexFormat; //!< 深度描画用インデックスバッファのフォーマットです.
+    std::vector< IndexCompactor::Chunk >  m_IndexChunks;      //!< インデックスバッファのチャンクです.
+    std::vector< IndexCompactor::Chunk >  m_DepthIndexChunks; //!< 深度描画用インデックスバッファのチャンクです.
+    std::vector< u32 >                    m_DepthRemap;       //!< 元の頂点番号から深度描画用の頂点番号への変換表です.
+    std::vector< MeshSimplifier::Level >  m_LodLevels;        //!< LOD1 以降の詳細度です.
+    std::vector< f32 >                    m_LodErrors;        //!< 詳細度ごとの誤差です(先頭は元のメッシュ).
+    ID3D11Buffer*                         m_pLodIB;           //!< 詳細度のインデックスバッファです.
+    ID3D11Buffer*                         m_pDepthLodIB;      //!< 深度描画用の詳細度のインデックスバッファです.
+    DXGI_FORMAT                           m_LodIndexFormat;   //!< 詳細度のインデックスバッファのフォーマットです.
+    DXGI_FORMAT                           m_DepthLodFormat;   //!< 深度描画用の詳細度のインデックスバッファのフォーマットです.
+    std::vector< IndexCompactor::Chunk >  m_LodIndexChunks;   //!< 詳細度のインデックスバッファのチャンクです.
+    std::vector< IndexCompactor::Chunk >  m_DepthLodChunks;   //!< 深度描画用の詳細度のインデックスバッファのチャンクです.
+    u32                                   m_CurrentLod;       //!< 描画中の詳細度です.
+    MaterialTable                         m_Materials;        //!< マテリアルテーブルです.
+    TextureCache                          m_TextureCache;     //!< テクスチャキャッシュです.
+    std::vector< MaterialBinding >        m_Bindings;         //!< マテリアルごとの描画設定です.
+    const MaterialTable*                  m_pSourceMaterials; //!< 初期化中に参照するマテリアルテーブルです.
+    ThreadPool*                           m_pSourcePool;      //!< 初期化中にテクスチャの読み込みに使うスレッドプールです.
+    std::vector< u32 >                    m_DrawOrder;        //!< マテリアル順のサブセットの描画順です.
+    u32                                   m_BoundMaterial;    //!< 描画中に設定済みのマテリアル番号です.
+    BindStatistics                        m_BindStats;        //!< マテリアル設定の統計情報です.
+    ID3D11InputLayout*                    m_pInstanceIL;      //!< インスタンス描画用の入力レイアウトです.
+    ID3D11InputLayout*                    m_pDepthInstanceIL; //!< 深度描画用のインスタンス描画用の入力レイアウトです.
+    const InstanceBuffer*                 m_pInstances;       //!< 描画中のインスタンスデータです.
+    std::vector< asdx::BoundingBox >      m_ChunkBounds;      //!< チャンクのAABBです.
+    std::vector< u32 >                    m_SubsetChunk;      //!< サブセットの属するチャンク番号です.
+    const u8*                             m_pChunkMask;       //!< 描画するチャンクのフラグです.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    virtual bool OnCreateIL  ( ID3D11Device* pDevice, const void* shaderByteCode, const u32 byteCodeLength );
+    virtual bool OnCreateVB  ( ID3D11Device* pDevice, const asdx::ResMesh& mesh );
+    virtual bool OnCreateIB  ( ID3D11Device* pDevice, const asdx::ResMesh& mesh );
+    virtual bool OnCreateMB  ( ID3D11Device* pDevice, const asdx::ResMesh& mesh );
+    virtual bool OnCreateMaterial( ID3D11Device* pDevice, const asdx::ResMesh& mesh, const char* resPath, const char* dummyPath );
+    virtual void OnDrawBegin ( ID3D11DeviceContext* pDeviceContext );
+    virtual void OnDrawSubset( ID3D11DeviceContext* pDeviceContext, const u32 index );
+    virtual void OnTermMaterial();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インデックスバッファを生成します.
+    //!
+    //! @param [in]     pDevice     デバイスです.
+    //! @param [in]     pIndices    頂点インデックスです.
+    //! @param [in]     indexCount  頂点インデックス数です.
+    //! @param [in]     pSubsets    サブセットです.
+    //! @param [in]     subsetCount サブセット数です.
+    //! @param [out]    ppBuffer    生成したインデックスバッファです.
+    //! @param [out]    format      インデックスバッファのフォーマットです.
+    //! @param [out]    chunks      ベース頂点ごとのチャンクです.
+    //! @note       16bitに収まる場合は16bitで生成します.
+    //-------------------------------------------------------------------------------
+    bool CreateIndexBuffer(
+        ID3D11Device*                           pDevice,
+        const asdx::ResMesh::Index*             pIndices,
+        u32                                     indexCount,
+        const asdx::ResMesh::Subset*            pSubsets,
+        u32                                     subsetCount,
+        ID3D11Buffer**                          ppBuffer,
+        DXGI_FORMAT&                            format,
+        std::vector< IndexCompactor::Chunk >&   chunks );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクの境界で分割してインデックス範囲を描画します.
+    //-------------------------------------------------------------------------------
+    void DrawIndexedRange(
+        ID3D11DeviceContext*                        pDeviceContext,
+        const std::vector< IndexCompactor::Chunk >& chunks,
+        u32                                         indexOffset,
+        u32                                         indexCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用のパイプラインを設定します.
+    //-------------------------------------------------------------------------------
+    void BindDepthStream( ID3D11DeviceContext* pDeviceContext, ID3D11Buffer* pIB, DXGI_FORMAT format );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用のストリームで描画できるかどうかチェックします.
+    //-------------------------------------------------------------------------------
+    bool CanUseDepthStream() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用のストリームを破棄します.
+    //-------------------------------------------------------------------------------
+    void TermDepthStream();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度のインデックスバッファを破棄します.
+    //-------------------------------------------------------------------------------
+    void TermLod();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルの描画設定を破棄します.
+    //-------------------------------------------------------------------------------
+    void TermBindings();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インスタンスデータの頂点ストリームを設定します.
+    //-------------------------------------------------------------------------------
+    void BindInstanceStream( ID3D11DeviceContext* pDeviceContext, ID3D11InputLayout* pIL );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インスタンス描画用の入力レイアウトを破棄します.
+    //-------------------------------------------------------------------------------
+    void TermInstancing();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サブセットの属するチャンクが描画対象かどうかチェックします.
+    //-------------------------------------------------------------------------------
+    bool IsSubsetVisible( u32 index ) const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    ClusteredMesh   ( const ClusteredMesh& );   // アクセス禁止.
+    void operator = ( const ClusteredMesh& );   // アクセス禁止.
+};
+
+#endif//__CLUSTERED_MESH_H__
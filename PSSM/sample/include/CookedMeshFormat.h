@@ -0,0 +1,140 @@
+﻿//-----------------------------------------------------------------------------------
+// File : CookedMeshFormat.h
+// Desc : Cooked Mesh File Format Definition.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __COOKED_MESH_FORMAT_H__
+#define __COOKED_MESH_FORMAT_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <MshFormat.h>
+#include <cstddef>
+
+
+// CMSHファイルのバージョン番号です.
+static const u32 CMSH_VERSION = 0x00000002;
+
+// CMSHファイルの各セクションのアライメントです.
+static const u32 CMSH_ALIGNMENT = 16;
+
+// 文字列が無いことを表すオフセットです.
+static const u32 CMSH_INVALID_STRING = 0xffffffff;
+
+// 接ベクトルをクッカーで生成したことを表すフラグです.
+static const u32 CMSH_FLAG_GENERATED_TANGENT = 0x1;
+
+// 頂点キャッシュ・オーバードロー・頂点フェッチの最適化を行ったことを表すフラグです.
+static const u32 CMSH_FLAG_OPTIMIZED = 0x2;
+
+// サブセットをマテリアル順に並び替えて結合したことを表すフラグです.
+static const u32 CMSH_FLAG_MATERIAL_SORTED = 0x4;
+
+// サブセットを空間的なチャンクごとに分割したことを表すフラグです.
+// サブセットはチャンクの順に並び, チャンク内ではマテリアル順に並びます.
+static const u32 CMSH_FLAG_CHUNKED = 0x8;
+
+// 重複する頂点を結合したことを表すフラグです.
+static const u32 CMSH_FLAG_WELDED = 0x10;
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CookedMeshHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct CookedMeshHeader
+{
+    u8      Magic[ 4 ];             //!< マジックです('C', 'M', 'S', 'H').
+    u32     Version;                //!< ファイルバージョンです.
+    u32     HeaderSize;             //!< ヘッダのサイズです.
+    u32     Flags;                  //!< フラグです.
+    u64     SourceHash;             //!< 元ファイルのハッシュ値です.
+    u64     ContentHash;            //!< ヘッダ以降のデータのハッシュ値です.
+    u64     FileSize;               //!< ファイルサイズです.
+    f32     BoundsMin[ 3 ];         //!< メッシュ全体のAABBの最小値です.
+    f32     BoundsMax[ 3 ];         //!< メッシュ全体のAABBの最大値です.
+    u32     VertexCount;            //!< 頂点数です.
+    u32     VertexStride;           //!< 頂点のストライドです.
+    u32     IndexCount;             //!< 頂点インデックス数です.
+    u32     IndexStride;            //!< 頂点インデックスのストライドです.
+    u32     MaterialCount;          //!< マテリアル数です.
+    u32     SubsetCount;            //!< サブセット数です.
+    u32     StringTableSize;        //!< 文字列テーブルのサイズです.
+    u32     Reserved0;              //!< 予約領域です.
+    u32     VertexOffset;           //!< 頂点データの開始位置です.
+    u32     IndexOffset;            //!< 頂点インデックスデータの開始位置です.
+    u32     MaterialOffset;         //!< マテリアルデータの開始位置です.
+    u32     SubsetOffset;           //!< サブセットデータの開始位置です.
+    u32     SubsetBoundsOffset;     //!< サブセットのAABBの開始位置です.
+    u32     StringTableOffset;      //!< 文字列テーブルの開始位置です.
+    u32     ChunkCount;             //!< チャンク数です(分割していない場合は 0).
+    u32     ChunkOffset;            //!< チャンクデータの開始位置です.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CookedMaterial structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct CookedMaterial
+{
+    f32     Ambient [ 3 ];          //!< 環境色です.
+    f32     Diffuse [ 3 ];          //!< 拡散反射色です.
+    f32     Specular[ 3 ];          //!< 鏡面反射色です.
+    f32     Emissive[ 3 ];          //!< 自己照明色です.
+    f32     Alpha;                  //!< 透過度です.
+    f32     Power;                  //!< 鏡面反射強度です.
+    u32     AmbientMap;             //!< アンビエントマップ名の文字列テーブル上のオフセットです.
+    u32     DiffuseMap;             //!< ディフューズマップ名の文字列テーブル上のオフセットです.
+    u32     SpecularMap;            //!< スペキュラーマップ名の文字列テーブル上のオフセットです.
+    u32     BumpMap;                //!< 凹凸マップ名の文字列テーブル上のオフセットです.
+    u32     DisplacementMap;        //!< 変位マップ名の文字列テーブル上のオフセットです.
+    u32     Reserved;               //!< 予約領域です.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CookedBounds structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct CookedBounds
+{
+    f32     Min[ 3 ];               //!< AABBの最小値です.
+    f32     Max[ 3 ];               //!< AABBの最大値です.
+};
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CookedChunk structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct CookedChunk
+{
+    f32     Min[ 3 ];               //!< AABBの最小値です.
+    f32     Max[ 3 ];               //!< AABBの最大値です.
+    u32     SubsetOffset;           //!< 先頭のサブセット番号です.
+    u32     SubsetCount;            //!< サブセット数です.
+    u32     Reserved[ 2 ];          //!< 予約領域です.
+};
+
+// 頂点は MshVertex, 頂点インデックスは u32, サブセットは MshSubset と同じレイアウトで格納する.
+// そのままバッファの生成に使える.
+
+
+//-----------------------------------------------------------------------------------
+//! @brief      FNV-1a (64bit) でハッシュ値を求めます.
+//!
+//! @param [in]     pData       データです.
+//! @param [in]     size        データサイズです.
+//! @param [in]     hash        初期値です. 続けて計算する場合は前回の結果を渡します.
+//! @return     ハッシュ値を返却します.
+//-----------------------------------------------------------------------------------
+inline u64 ComputeFnv1a64( const void* pData, size_t size, u64 hash = 0xcbf29ce484222325ULL )
+{
+    const u8* ptr = static_cast<const u8*>( pData );
+    for( size_t i=0; i<size; ++i )
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#endif//__COOKED_MESH_FORMAT_H__
@@ -0,0 +1,178 @@
+﻿//-----------------------------------------------------------------------------------
+// File : CookedResMesh.h
+// Desc : Cooked Resource Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __COOKED_RES_MESH_H__
+#define __COOKED_RES_MESH_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <asdxGeometry.h>
+#include <CookedMeshFormat.h>
+#include <MaterialTable.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// CookedResMesh class
+//////////////////////////////////////////////////////////////////////////////////////
+class CookedResMesh : public asdx::ResMesh
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    CookedResMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    virtual ~CookedResMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブコンストラクタです.
+    //!
+    //! @note       読み込んだバッファの所有権を移すだけで, データはコピーしません.
+    //-------------------------------------------------------------------------------
+    CookedResMesh( CookedResMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブ代入演算子です.
+    //-------------------------------------------------------------------------------
+    CookedResMesh& operator = ( CookedResMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      MeshCooker で出力した .cmsh ファイルをロードします.
+    //!
+    //! @param [in]     filename        入力ファイル名です.
+    //! @param [in]     verifyHash      ハッシュ値でデータの破損を検証するかどうか.
+    //! @retval true    ロードに成功.
+    //! @retval false   ロードに失敗.
+    //! @note       ファイルは1回の読み込みで取得し, 頂点・頂点インデックス・サブセットは
+    //!             読み込んだバッファを直接参照します.
+    //-------------------------------------------------------------------------------
+    bool LoadFromFile( const char* filename, bool verifyHash = false );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メモリ上の .cmsh データをロードします.
+    //!
+    //! @param [in]     buffer          .cmsh ファイルの内容です.
+    //! @param [in]     verifyHash      ハッシュ値でデータの破損を検証するかどうか.
+    //! @retval true    ロードに成功.
+    //! @retval false   ロードに失敗.
+    //! @note       バッファの所有権を受け取り, 頂点・頂点インデックス・サブセットはその中を直接参照します.
+    //!             ローダーが読み込んだバッファをコピー無しで引き渡すのに使います.
+    //-------------------------------------------------------------------------------
+    bool LoadFromMemory( std::vector< u8 >&& buffer, bool verifyHash = false );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メモリを解放します.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュ全体のAABBを取得します.
+    //!
+    //! @return     クック時に求めたAABBを返却します.
+    //-------------------------------------------------------------------------------
+    asdx::BoundingBox GetBoundingBox() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サブセットのAABBを取得します.
+    //!
+    //! @param [in]     idx         サブセット番号です.
+    //! @return     クック時に求めたAABBを返却します.
+    //-------------------------------------------------------------------------------
+    asdx::BoundingBox GetSubsetBoundingBox( const u32 idx ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンク数を取得します.
+    //!
+    //! @return     クック時に空間分割していない場合は 0 を返却します.
+    //-------------------------------------------------------------------------------
+    u32 GetChunkCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクを取得します.
+    //!
+    //! @return     読み込んだバッファ内のチャンクの先頭ポインタを返却します.
+    //-------------------------------------------------------------------------------
+    const CookedChunk* GetChunks() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ファイルのヘッダを取得します.
+    //!
+    //! @return     ファイルのヘッダを返却します.
+    //-------------------------------------------------------------------------------
+    const CookedMeshHeader& GetHeader() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルテーブルを取得します.
+    //!
+    //! @note       ロード時にファイル内のマテリアルと文字列テーブルから構築しておきます.
+    //-------------------------------------------------------------------------------
+    const MaterialTable& GetMaterialTable() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルを asdx::ResMesh::Material の形式に展開します.
+    //!
+    //! @note       ロード時には展開しないので, GetMaterial() を使う場合は先に呼び出しておく必要があります.
+    //!             テクスチャ名ごとに固定長の文字列配列を持つため, 1マテリアルあたり約1.3KBを使います.
+    //-------------------------------------------------------------------------------
+    void ExpandMaterials();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( CookedResMesh& value );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    std::vector< u8 >                       m_Buffer;           //!< 読み込んだファイルです.
+    std::vector< asdx::ResMesh::Material >  m_Materials;        //!< 展開したマテリアルです.
+    MaterialTable                           m_MaterialTable;    //!< マテリアルテーブルです.
+    CookedMeshHeader                        m_Header;           //!< ファイルのヘッダです.
+    const CookedBounds*                     m_pSubsetBounds;    //!< サブセットのAABBです.
+    const CookedChunk*                      m_pChunks;          //!< チャンクです.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    bool Attach( std::vector< u8 >& buffer, const char* filename, bool verifyHash );
+    bool Validate( const char* filename, bool verifyHash ) const;
+    void DetachViews();
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    CookedResMesh   ( const CookedResMesh& );   // アクセス禁止.
+    void operator = ( const CookedResMesh& );   // アクセス禁止.
+};
+
+#endif//__COOKED_RES_MESH_H__
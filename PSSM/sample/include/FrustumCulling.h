@@ -0,0 +1,57 @@
+﻿//-----------------------------------------------------------------------------------
+// File : FrustumCulling.h
+// Desc : Frustum Culling Utility.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __FRUSTUM_CULLING_H__
+#define __FRUSTUM_CULLING_H__
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+
+
+//-----------------------------------------------------------------------------------
+//! @brief      AABBが平面の裏側にあるかどうか判定します.
+//!
+//! @param [in]     plane       平面です.
+//! @param [in]     mini        AABBの最小値です.
+//! @param [in]     maxi        AABBの最大値です.
+//! @retval true    AABB全体が平面の裏側にあります.
+//! @retval false   AABBの一部が平面の表側にあります.
+//-----------------------------------------------------------------------------------
+inline bool IsOutside( const asdx::Plane& plane, const asdx::Vector3& mini, const asdx::Vector3& maxi )
+{
+    // 平面の法線方向に最も遠い頂点が裏側にあれば, AABB全体が裏側にある.
+    asdx::Vector3 p(
+        ( plane.normal.x >= 0.0f ) ? maxi.x : mini.x,
+        ( plane.normal.y >= 0.0f ) ? maxi.y : mini.y,
+        ( plane.normal.z >= 0.0f ) ? maxi.z : mini.z );
+
+    return ( asdx::Vector3::Dot( plane.normal, p ) + plane.d ) < 0.0f;
+}
+
+//-----------------------------------------------------------------------------------
+//! @brief      AABBが視錐台の外側にあるかどうか判定します.
+//!
+//! @param [in]     frustum     視錐台です.
+//! @param [in]     box         AABBです.
+//! @retval true    AABB全体が視錐台の外側にあります.
+//! @retval false   AABBが視錐台と交差する可能性があります.
+//! @note       保守的な判定なので, 視錐台の角の付近では外側でも false を返すことがあります.
+//-----------------------------------------------------------------------------------
+inline bool IsOutside( const asdx::BoundingFrustum& frustum, const asdx::BoundingBox& box )
+{
+    for( u32 i=0; i<6; ++i )
+    {
+        if ( IsOutside( frustum.plane[i], box.mini, box.maxi ) )
+        { return true; }
+    }
+
+    return false;
+}
+
+#endif//__FRUSTUM_CULLING_H__
@@ -0,0 +1,129 @@
+﻿//-----------------------------------------------------------------------------------
+// File : IndexCompactor.h
+// Desc : 16bit Index Compactor Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __INDEX_COMPACTOR_H__
+#define __INDEX_COMPACTOR_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// IndexCompactor class
+//////////////////////////////////////////////////////////////////////////////////////
+class IndexCompactor
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 MAX_INDEX_RANGE = 0xffff;      //!< 1つのチャンクで参照できる頂点番号の幅です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Chunk structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Chunk
+    {
+        u32     IndexOffset;        //!< 頂点インデックスの開始位置です.
+        u32     IndexCount;         //!< 頂点インデックス数です.
+        u32     BaseVertex;         //!< 描画時に加算するベース頂点です.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    IndexCompactor();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~IndexCompactor();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      32bitインデックスを16bitインデックスに変換します.
+    //!
+    //! @param [in]     pIndices        頂点インデックスです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @param [in]     pSubsets        サブセットです.
+    //! @param [in]     subsetCount     サブセット数です.
+    //! @retval true    変換に成功.
+    //! @retval false   16bitで表せない三角形があるため変換できなかった.
+    //! @note       サブセットごとに参照する頂点番号の最小値をベース頂点として引き,
+    //!             幅が MAX_INDEX_RANGE を超える場合はサブセットを三角形単位でチャンクに分割します.
+    //!             インデックスの並びは変わらないので, 元のインデックスオフセットがそのまま使えます.
+    //!             変換できない場合は32bitのまま1つのチャンクで全体を覆います.
+    //-------------------------------------------------------------------------------
+    bool Build(
+        const asdx::ResMesh::Index*     pIndices,
+        u32                             indexCount,
+        const asdx::ResMesh::Subset*    pSubsets,
+        u32                             subsetCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      変換結果を破棄します.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      16bitインデックスに変換できたかどうかチェックします.
+    //-------------------------------------------------------------------------------
+    bool Is16Bit() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      16bitインデックスを取得します.
+    //-------------------------------------------------------------------------------
+    const u16* GetIndices() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点インデックス数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetIndexCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンクを取得します.
+    //-------------------------------------------------------------------------------
+    const std::vector< Chunk >& GetChunks() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インデックスオフセットを含むチャンクを検索します.
+    //!
+    //! @param [in]     chunks          インデックスオフセット順に並んだチャンクです.
+    //! @param [in]     indexOffset     頂点インデックスの位置です.
+    //! @return     チャンク番号を返却します. 見つからない場合はチャンク数を返却します.
+    //-------------------------------------------------------------------------------
+    static u32 FindChunk( const std::vector< Chunk >& chunks, u32 indexOffset );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< u16 >      m_Indices;      //!< 16bitインデックスです.
+    std::vector< Chunk >    m_Chunks;       //!< チャンクです(インデックスオフセット順).
+    u32                     m_IndexCount;   //!< 頂点インデックス数です.
+    bool                    m_Is16Bit;      //!< 16bitインデックスに変換できたかどうか.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    void Fallback( u32 indexCount );
+
+    IndexCompactor  ( const IndexCompactor& );  // アクセス禁止.
+    void operator = ( const IndexCompactor& );  // アクセス禁止.
+};
+
+#endif//__INDEX_COMPACTOR_H__
@@ -0,0 +1,175 @@
+﻿//-----------------------------------------------------------------------------------
+// File : InstanceBuffer.h
+// Desc : Per-Instance Transform Buffer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __INSTANCE_BUFFER_H__
+#define __INSTANCE_BUFFER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <d3d11.h>
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// InstanceBuffer class
+//////////////////////////////////////////////////////////////////////////////////////
+class InstanceBuffer
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 INPUT_SLOT        = 1;                                     //!< インスタンスデータの入力スロットです.
+    static const u32 NUM_INPUT_ELEMENT = 3;                                     //!< 入力要素数です.
+    static const D3D11_INPUT_ELEMENT_DESC INPUT_ELEMENTS[ NUM_INPUT_ELEMENT ];  //!< 入力要素です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Transform structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Transform
+    {
+        asdx::Vector4   Row0;       //!< ワールド行列のX成分を求める行です.
+        asdx::Vector4   Row1;       //!< ワールド行列のY成分を求める行です.
+        asdx::Vector4   Row2;       //!< ワールド行列のZ成分を求める行です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     TestedCount;        //!< テストしたインスタンス数です.
+        u32     VisibleCount;       //!< 描画するインスタンス数です.
+
+        Statistics()
+        : TestedCount   ( 0 )
+        , VisibleCount  ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    InstanceBuffer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~InstanceBuffer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     pDevice         デバイスです.
+    //! @param [in]     maxCount        1回の描画で扱う最大インスタンス数です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------------
+    bool Init( ID3D11Device* pDevice, u32 maxCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      追加したインスタンスを全て削除します.
+    //-------------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インスタンスを追加します.
+    //!
+    //! @param [in]     world       ワールド行列です.
+    //! @retval true    追加に成功.
+    //! @retval false   最大インスタンス数を超えるため追加できません.
+    //-------------------------------------------------------------------------------
+    bool Add( const asdx::Matrix& world );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視錐台に入るインスタンスだけを詰めて追加し直します.
+    //!
+    //! @param [in]     pWorlds         インスタンスのワールド行列です.
+    //! @param [in]     count           インスタンス数です.
+    //! @param [in]     sphere          メッシュのバウンディングスフィアです(ローカル座標系).
+    //! @param [in]     viewProj        ビュー射影行列です.
+    //! @return     描画するインスタンス数を返却します.
+    //! @note       前回追加したインスタンスは削除されます. 描画の前に Upload() を呼び出す必要があります.
+    //-------------------------------------------------------------------------------
+    u32 Cull(
+        const asdx::Matrix*         pWorlds,
+        u32                         count,
+        const asdx::BoundingSphere& sphere,
+        const asdx::Matrix&         viewProj );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      追加したインスタンスをGPUに転送します.
+    //!
+    //! @param [in]     pDeviceContext  デバイスコンテキストです.
+    //! @retval true    転送に成功.
+    //! @retval false   転送に失敗.
+    //! @note       バッファは書き込みのたびに破棄して確保し直すので, パスごとに呼び出して構いません.
+    //-------------------------------------------------------------------------------
+    bool Upload( ID3D11DeviceContext* pDeviceContext );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点バッファを取得します.
+    //-------------------------------------------------------------------------------
+    ID3D11Buffer* GetBuffer() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      転送済みのインスタンス数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      最大インスタンス数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetCapacity() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      最後に行ったカリングの統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ワールド行列を3x4行列に変換します.
+    //!
+    //! @note       シェーダでは dot( Row, float4( position, 1 ) ) で各成分を求めます.
+    //!             法線ベクトルは上3x3の余因子行列で変換するので, 不均一な拡大縮小も扱えます.
+    //-------------------------------------------------------------------------------
+    static Transform ToTransform( const asdx::Matrix& world );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    ID3D11Buffer*               m_pVB;              //!< インスタンスデータの頂点バッファです.
+    u32                         m_Capacity;         //!< 最大インスタンス数です.
+    u32                         m_UploadedCount;    //!< 転送済みのインスタンス数です.
+    std::vector< Transform >    m_Transforms;       //!< 追加したインスタンスです.
+    Statistics                  m_Statistics;       //!< 統計情報です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    InstanceBuffer  ( const InstanceBuffer& );  // アクセス禁止.
+    void operator = ( const InstanceBuffer& );  // アクセス禁止.
+};
+
+#endif//__INSTANCE_BUFFER_H__
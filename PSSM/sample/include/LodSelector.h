@@ -0,0 +1,103 @@
+﻿//-----------------------------------------------------------------------------------
+// File : LodSelector.h
+// Desc : Level of Detail Selector Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __LOD_SELECTOR_H__
+#define __LOD_SELECTOR_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// LodSelector class
+//////////////////////////////////////////////////////////////////////////////////////
+class LodSelector
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    LodSelector();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~LodSelector();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      許容する誤差をピクセル(テクセル)単位で設定します.
+    //-------------------------------------------------------------------------------
+    void SetPixelError( f32 value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      許容する誤差をピクセル(テクセル)単位で取得します.
+    //-------------------------------------------------------------------------------
+    f32 GetPixelError() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      詳細度を選択します.
+    //!
+    //! @param [in]     pErrors         詳細度ごとの誤差です(ローカル座標系での距離, 先頭は元のメッシュで0).
+    //! @param [in]     levelCount      詳細度の数です.
+    //! @param [in]     worldViewProj   ワールドビュー射影行列です.
+    //! @param [in]     center          バウンディングスフィアの中心です(ローカル座標系).
+    //! @param [in]     radius          バウンディングスフィアの半径です(ローカル座標系).
+    //! @param [in]     width           ビューポートの横幅(ピクセル数)です.
+    //! @param [in]     height          ビューポートの縦幅(ピクセル数)です.
+    //! @return     投影した誤差が許容値に収まる最も粗い詳細度の番号を返却します.
+    //! @note       シャドウマップのカスケードでは, ビューポートにシャドウマップの解像度を渡します.
+    //-------------------------------------------------------------------------------
+    u32 Select(
+        const f32*              pErrors,
+        u32                     levelCount,
+        const asdx::Matrix&     worldViewProj,
+        const asdx::Vector3&    center,
+        f32                     radius,
+        f32                     width,
+        f32                     height ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ローカル座標系の長さ1がビューポート上で何ピクセルになるかを求めます.
+    //!
+    //! @note       バウンディングスフィアの最も手前の点で評価するので, 大きめの値になります.
+    //!             スフィアが視点をまたぐ場合は F32_MAX を返却します.
+    //-------------------------------------------------------------------------------
+    static f32 ComputePixelsPerUnit(
+        const asdx::Matrix&     worldViewProj,
+        const asdx::Vector3&    center,
+        f32                     radius,
+        f32                     width,
+        f32                     height );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    f32     m_PixelError;       //!< 許容する誤差(ピクセル)です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    /* NOTHING */
+};
+
+#endif//__LOD_SELECTOR_H__
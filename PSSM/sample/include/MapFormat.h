@@ -0,0 +1,81 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MapFormat.h
+// Desc : MAP File Format Definition.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MAP_FORMAT_H__
+#define __MAP_FORMAT_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+
+
+// MAPファイルのバージョン番号です.
+static const u32 MAP_VERSION = 0x00000002;
+
+// MAPファイルのデータヘッダのサイズです.
+static const u32 MAP_DATA_HEADER_SIZE = 24;
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MAP_FORMAT enum
+//////////////////////////////////////////////////////////////////////////////////////
+enum MAP_FORMAT
+{
+    MAP_FORMAT_R8   = 1,        //!< 8bit 1チャンネルの非圧縮フォーマットです.
+    MAP_FORMAT_BC3  = 4,        //!< BC3(DXT5)圧縮フォーマットです.
+
+    // 以下は TextureCooker が出力するフォーマットです. 既存のアセットの値と重ならないようにしています.
+    MAP_FORMAT_BC1  = 0x100,    //!< BC1(DXT1)圧縮フォーマットです.
+    MAP_FORMAT_BC4  = 0x101,    //!< BC4 圧縮フォーマットです(1チャンネル).
+    MAP_FORMAT_BC5  = 0x102,    //!< BC5 圧縮フォーマットです(2チャンネル, 法線マップ向け).
+    MAP_FORMAT_BC7  = 0x103     //!< BC7 圧縮フォーマットです.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MapDataHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MapDataHeader
+{
+    u32     Width;              //!< 横幅です.
+    u32     Height;             //!< 縦幅です.
+    u32     Depth;              //!< 奥行きです(2次元テクスチャの場合は0).
+    u32     Format;             //!< フォーマットです(MAP_FORMAT).
+    u32     MipMapCount;        //!< ミップマップ数です.
+    u32     SurfaceCount;       //!< サーフェイス数です(配列数).
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MapFileHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MapFileHeader
+{
+    u8              Magic[ 4 ];     //!< マジックです('M', 'A', 'P', '\0').
+    u32             Version;        //!< ファイルバージョンです.
+    u32             DataHeaderSize; //!< データヘッダのサイズです.
+    MapDataHeader   DataHeader;     //!< データヘッダです.
+};
+
+// 以降は サーフェイスごとに, ミップレベルの順で MapSurfaceHeader とピクセルデータが並ぶ.
+// データの開始位置は ( 12 + DataHeaderSize ) バイト目.
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MapSurfaceHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MapSurfaceHeader
+{
+    u32     Width;              //!< 横幅です.
+    u32     Height;             //!< 縦幅です.
+    u32     Pitch;              //!< 1行(圧縮フォーマットではブロック1行)あたりのバイト数です.
+    u32     SlicePitch;         //!< ピクセルデータのバイト数です.
+};
+
+// MapSurfaceHeader の直後に SlicePitch バイトのピクセルデータが続く.
+
+#endif//__MAP_FORMAT_H__
@@ -0,0 +1,156 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MapTexture.h
+// Desc : MAP Texture Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MAP_TEXTURE_H__
+#define __MAP_TEXTURE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <MapFormat.h>
+#include <MappedFile.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MapTexture class
+//////////////////////////////////////////////////////////////////////////////////////
+class MapTexture
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Surface structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Surface
+    {
+        const u8*   pPixels;        //!< ピクセルデータです.
+        u32         Width;          //!< 横幅です.
+        u32         Height;         //!< 縦幅です.
+        u32         Pitch;          //!< 1行あたりのバイト数です.
+        u32         SlicePitch;     //!< ピクセルデータのバイト数です.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MapTexture();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MapTexture();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      .map ファイルを読み込みます.
+    //!
+    //! @param [in]     filename        ファイル名です.
+    //! @retval true    読み込みに成功.
+    //! @retval false   読み込みに失敗(理由は GetError() で取得できます).
+    //! @note       ファイルをメモリにマップし, サーフェイスはマップされた領域を直接指します.
+    //!             ピクセルデータはコピーしないので, そのまま D3D11_SUBRESOURCE_DATA に渡せます.
+    //!             デバイスを使わないので, ワーカースレッドやツールからも呼び出せます.
+    //!             縦横, ミップマップ数, サーフェイス数とフォーマットに対するピッチを検証するので,
+    //!             成功した場合はサーフェイスの全ての行がマップした領域に収まります.
+    //-------------------------------------------------------------------------------
+    bool LoadFromFile( const char* filename );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マップを解除します.
+    //!
+    //! @note       取得済みのサーフェイスのピクセルデータは無効になります.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ピクセルデータのページを先に読み込んでおきます.
+    //!
+    //! @note       ページイン処理を呼び出しスレッドで済ませておくためのものです.
+    //-------------------------------------------------------------------------------
+    void Touch() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      横幅を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetWidth() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      縦幅を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetHeight() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      フォーマットを取得します(MAP_FORMAT).
+    //-------------------------------------------------------------------------------
+    u32 GetFormat() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ミップマップ数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetMipMapCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サーフェイス数(配列数)を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetSurfaceCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      エラーメッセージを取得します.
+    //!
+    //! @return     最後に失敗した読み込みのエラーメッセージを返却します.
+    //! @note       ログは出力しないので, ツールからもそのまま使えます.
+    //-------------------------------------------------------------------------------
+    const char* GetError() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サーフェイスを取得します.
+    //!
+    //! @param [in]     idx         サブリソース番号です(ミップレベル + 配列番号 * ミップマップ数).
+    //! @return     サーフェイスを返却します.
+    //-------------------------------------------------------------------------------
+    const Surface& GetSurface( u32 idx ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サーフェイスを取得します.
+    //!
+    //! @param [in]     mipLevel    ミップレベルです.
+    //! @param [in]     slice       配列番号です.
+    //! @return     サーフェイスを返却します.
+    //-------------------------------------------------------------------------------
+    const Surface& GetSurface( u32 mipLevel, u32 slice ) const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    MappedFile              m_File;         //!< マップしたファイルです.
+    std::vector< Surface >  m_Surfaces;     //!< サーフェイスです.
+    MapDataHeader           m_Header;       //!< データヘッダです.
+    const char*             m_pError;       //!< エラーメッセージです.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    bool Parse();
+
+    MapTexture      ( const MapTexture& );      // アクセス禁止.
+    void operator = ( const MapTexture& );      // アクセス禁止.
+};
+
+#endif//__MAP_TEXTURE_H__
@@ -0,0 +1,124 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MappedFile.h
+// Desc : Memory Mapped File Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+//////////////////////////////////////////////////////////////////////////////////////
+class MappedFile
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MappedFile();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MappedFile();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブコンストラクタです.
+    //-------------------------------------------------------------------------------
+    MappedFile( MappedFile&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブ代入演算子です.
+    //-------------------------------------------------------------------------------
+    MappedFile& operator = ( MappedFile&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ファイルを読み取り専用でメモリにマップします.
+    //!
+    //! @param [in]     filename        入力ファイル名です.
+    //! @retval true    マップに成功.
+    //! @retval false   マップに失敗.
+    //-------------------------------------------------------------------------------
+    bool Open( const char* filename );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マップを解除してファイルを閉じます.
+    //-------------------------------------------------------------------------------
+    void Close();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マップされているかどうか判定します.
+    //!
+    //! @retval true    マップされています.
+    //! @retval false   マップされていません.
+    //-------------------------------------------------------------------------------
+    bool IsOpen() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マップされたデータの先頭を取得します.
+    //!
+    //! @return     マップされたデータの先頭を返却します. マップされていない場合は nullptr です.
+    //-------------------------------------------------------------------------------
+    const u8* GetData() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ファイルサイズを取得します.
+    //!
+    //! @return     ファイルサイズを返却します.
+    //-------------------------------------------------------------------------------
+    u64 GetSize() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( MappedFile& value );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    /* NOTHING */
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    void*       m_pFile;        //!< ファイルハンドルです(POSIXではファイル記述子を格納します).
+    void*       m_pMapping;     //!< ファイルマッピングオブジェクトです(Win32のみ).
+    const u8*   m_pData;        //!< マップされたデータです.
+    u64         m_Size;         //!< ファイルサイズです.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MappedFile      ( const MappedFile& );      // アクセス禁止.
+    void operator = ( const MappedFile& );      // アクセス禁止.
+};
+
+#endif//__MAPPED_FILE_H__
@@ -0,0 +1,115 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MappedResMesh.h
+// Desc : Memory Mapped Resource Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MAPPED_RES_MESH_H__
+#define __MAPPED_RES_MESH_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <MappedFile.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MappedResMesh class
+//////////////////////////////////////////////////////////////////////////////////////
+class MappedResMesh : public asdx::ResMesh
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MappedResMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    virtual ~MappedResMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブコンストラクタです.
+    //!
+    //! @note       マップしたファイルとコピー先のバッファの所有権を移すだけで, データはコピーしません.
+    //-------------------------------------------------------------------------------
+    MappedResMesh( MappedResMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ムーブ代入演算子です.
+    //-------------------------------------------------------------------------------
+    MappedResMesh& operator = ( MappedResMesh&& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ファイルをメモリにマップしてロードします.
+    //!
+    //! @param [in]     filename        入力ファイル名です.
+    //! @retval true    ロードに成功.
+    //! @retval false   ロードに失敗.
+    //! @note       各配列はマップしたファイルを直接参照します. 配列の開始位置が
+    //!             アライメントされていない古いファイルの場合は, 1つのバッファにまとめてコピーします.
+    //-------------------------------------------------------------------------------
+    bool LoadFromFile( const char* filename );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メモリを解放します.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マップしたファイルを直接参照しているかどうか判定します.
+    //!
+    //! @retval true    ファイルを直接参照しています.
+    //! @retval false   ヒープにコピーしたデータを参照しています.
+    //-------------------------------------------------------------------------------
+    bool IsMapped() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( MappedResMesh& value );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    MappedFile          m_File;         //!< マップしたファイルです.
+    std::vector< u32 >  m_Arena;        //!< アライメントされていないファイルのコピー先です.
+    bool                m_IsMapped;     //!< ファイルを直接参照しているかどうか.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    void DetachViews();
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MappedResMesh   ( const MappedResMesh& );   // アクセス禁止.
+    void operator = ( const MappedResMesh& );   // アクセス禁止.
+};
+
+#endif//__MAPPED_RES_MESH_H__
@@ -0,0 +1,146 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MaterialTable.h
+// Desc : Compact Material Table Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MATERIAL_TABLE_H__
+#define __MATERIAL_TABLE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <CookedMeshFormat.h>
+#include <StringTable.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MaterialTable class
+//////////////////////////////////////////////////////////////////////////////////////
+class MaterialTable
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // CompactMaterial structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct CompactMaterial
+    {
+        asdx::Vector3   Ambient;            //!< 環境色です.
+        asdx::Vector3   Diffuse;            //!< 拡散反射色です.
+        asdx::Vector3   Specular;           //!< 鏡面反射色です.
+        asdx::Vector3   Emissive;           //!< 自己照明色です.
+        f32             Alpha;              //!< 透過度です.
+        f32             Power;              //!< 鏡面反射強度です.
+        u32             AmbientMap;         //!< アンビエントマップ名の文字列IDです.
+        u32             DiffuseMap;         //!< ディフューズマップ名の文字列IDです.
+        u32             SpecularMap;        //!< スペキュラーマップ名の文字列IDです.
+        u32             BumpMap;            //!< 凹凸マップ名の文字列IDです.
+        u32             DisplacementMap;    //!< 変位マップ名の文字列IDです.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MaterialTable();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MaterialTable();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //-------------------------------------------------------------------------------
+    MaterialTable( const MaterialTable& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      代入演算子です.
+    //-------------------------------------------------------------------------------
+    MaterialTable& operator = ( const MaterialTable& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュのマテリアルから構築します.
+    //!
+    //! @param [in]     mesh        メッシュです.
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //! @note       テクスチャ名は文字列テーブルに登録し, 同じ名前は1つにまとめます.
+    //-------------------------------------------------------------------------------
+    bool Build( const asdx::ResMesh& mesh );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      クック済みのマテリアルから構築します.
+    //!
+    //! @param [in]     pMaterials      クック済みのマテリアルです.
+    //! @param [in]     count           マテリアル数です.
+    //! @param [in]     pTable          ファイル内の文字列テーブルです.
+    //! @param [in]     tableSize       文字列テーブルのサイズです.
+    //! @retval true    構築に成功.
+    //! @retval false   構築に失敗.
+    //! @note       固定長の文字列配列には展開せず, 文字列テーブルから直接登録します.
+    //-------------------------------------------------------------------------------
+    bool Build(
+        const CookedMaterial*   pMaterials,
+        u32                     count,
+        const char*             pTable,
+        u32                     tableSize );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      破棄します.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアル数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルを取得します.
+    //-------------------------------------------------------------------------------
+    const CompactMaterial& GetMaterial( u32 index ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列テーブルを取得します.
+    //-------------------------------------------------------------------------------
+    const StringTable& GetStrings() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルと文字列の格納に使っているバイト数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetByteSize() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( MaterialTable& value );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< CompactMaterial >  m_Materials;    //!< マテリアルです.
+    StringTable                     m_Strings;      //!< テクスチャ名の文字列テーブルです.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    /* NOTHING */
+};
+
+#endif//__MATERIAL_TABLE_H__
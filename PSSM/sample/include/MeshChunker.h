@@ -0,0 +1,108 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshChunker.h
+// Desc : Spatial Mesh Chunker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MESH_CHUNKER_H__
+#define __MESH_CHUNKER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <CookedMeshFormat.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MeshChunker class
+//////////////////////////////////////////////////////////////////////////////////////
+class MeshChunker
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        u32     MaxTriangles;       //!< チャンクあたりの三角形数の上限です.
+        u32     MaxDepth;           //!< 分割の最大の深さです(チャンク数は 2^MaxDepth 以下になります).
+
+        Config()
+        : MaxTriangles  ( 8192 )
+        , MaxDepth      ( 8 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     ChunkCount;             //!< チャンク数です.
+        u32     SubsetCountBefore;      //!< 分割前のサブセット数です.
+        u32     SubsetCountAfter;       //!< 分割後のサブセット数です.
+        u32     MaxChunkTriangles;      //!< チャンクあたりの最大三角形数です.
+
+        Statistics()
+        : ChunkCount        ( 0 )
+        , SubsetCountBefore ( 0 )
+        , SubsetCountAfter  ( 0 )
+        , MaxChunkTriangles ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュを空間的なチャンクに分割します.
+    //!
+    //! @param [in]     pPositions      位置座標(f32 x 3)の先頭ポインタです.
+    //! @param [in]     stride          頂点のストライド(バイト)です.
+    //! @param [in]     vertexCount     頂点数です.
+    //! @param [in]     config          設定です.
+    //! @param [in,out] indices         頂点インデックスです.
+    //! @param [in,out] subsets         サブセットです.
+    //! @param [out]    chunks          チャンクです.
+    //! @param [out]    pStats          統計情報です(nullptrの場合は出力しません).
+    //! @note       三角形の重心で k-d 木を作り, 最も長い軸の中央値で分割していきます.
+    //!             チャンクごとにマテリアル順のサブセットを作り直すので,
+    //!             サブセットはチャンクの順に連続して並びます. 同じマテリアル内ではファイルでの順番を保ちます.
+    //!             どのサブセットからも参照されない頂点インデックスは取り除かれます.
+    //-------------------------------------------------------------------------------
+    static void Split(
+        const void*                     pPositions,
+        u32                             stride,
+        u32                             vertexCount,
+        const Config&                   config,
+        std::vector< u32 >&             indices,
+        std::vector< MshSubset >&       subsets,
+        std::vector< CookedChunk >&     chunks,
+        Statistics*                     pStats = nullptr );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MeshChunker     ();                         // アクセス禁止.
+    MeshChunker     ( const MeshChunker& );     // アクセス禁止.
+    void operator = ( const MeshChunker& );     // アクセス禁止.
+};
+
+#endif//__MESH_CHUNKER_H__
@@ -0,0 +1,179 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshClusterizer.h
+// Desc : Mesh Clusterizer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MESH_CLUSTERIZER_H__
+#define __MESH_CLUSTERIZER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <asdxResMesh.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MeshClusterizer class
+//////////////////////////////////////////////////////////////////////////////////////
+class MeshClusterizer
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 MAX_MESHLET_VERTEX_COUNT   = 64;      //!< メッシュレットあたりの最大頂点数です.
+    static const u32 MAX_MESHLET_TRIANGLE_COUNT = 124;     //!< メッシュレットあたりの最大三角形数です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Meshlet structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Meshlet
+    {
+        u32             SubsetID;       //!< サブセット番号です.
+        u32             IndexOffset;    //!< 頂点インデックスの開始位置です.
+        u32             IndexCount;     //!< 頂点インデックス数です.
+        u32             VertexCount;    //!< 参照している頂点数です.
+        asdx::Vector3   Center;         //!< バウンディングスフィアの中心です.
+        f32             Radius;         //!< バウンディングスフィアの半径です.
+        asdx::Vector3   BoxMin;         //!< AABBの最小値です.
+        asdx::Vector3   BoxMax;         //!< AABBの最大値です.
+        asdx::Vector3   ConeAxis;       //!< 法線コーンの軸です(三角形の巻き順から求めた法線で, 右手系で反時計回りに見える側を向きます).
+        f32             ConeCutoff;     //!< 法線コーンの判定値です(1.0の場合はコーンによるカリングを行いません).
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // DrawRange structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct DrawRange
+    {
+        u32     SubsetID;               //!< サブセット番号です.
+        u32     IndexOffset;            //!< 頂点インデックスの開始位置です.
+        u32     IndexCount;             //!< 頂点インデックス数です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // CullView structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct CullView
+    {
+        asdx::Matrix    WorldViewProj;          //!< ワールドビュー射影行列です.
+        asdx::Vector3   CameraPosition;         //!< カメラ位置です(ローカル座標).
+        bool            EnableCone;             //!< 法線コーンによる裏面カリングを行うかどうか.
+        bool            FrontCounterClockwise;  //!< ラスタライザーステートの FrontCounterClockwise と同じ値を設定します.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // CullResult structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct CullResult
+    {
+        std::vector< DrawRange >    Ranges;             //!< 描画範囲です(連続するメッシュレットは結合済み).
+        std::vector< u32 >          SubsetRangeOffset;  //!< サブセットごとの描画範囲の開始位置です.
+        u32                         TestedMeshlets;     //!< テストしたメッシュレット数です.
+        u32                         VisibleMeshlets;    //!< 可視のメッシュレット数です.
+        u32                         FrustumCulled;      //!< 視錐台でカリングされたメッシュレット数です.
+        u32                         ConeCulled;         //!< 法線コーンでカリングされたメッシュレット数です.
+        u32                         TotalTriangles;     //!< 全三角形数です.
+        u32                         VisibleTriangles;   //!< 描画する三角形数です.
+
+        CullResult()
+        : Ranges            ()
+        , SubsetRangeOffset ()
+        , TestedMeshlets    ( 0 )
+        , VisibleMeshlets   ( 0 )
+        , FrustumCulled     ( 0 )
+        , ConeCulled        ( 0 )
+        , TotalTriangles    ( 0 )
+        , VisibleTriangles  ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MeshClusterizer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MeshClusterizer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サブセットをメッシュレットに分割します.
+    //!
+    //! @param [in]     mesh        分割するメッシュです.
+    //! @retval true    分割に成功.
+    //! @retval false   分割に失敗.
+    //! @note       三角形は並び替えずに先頭から順に詰めていくため, 各メッシュレットは
+    //!             インデックスバッファ上の連続した範囲になります. 頂点キャッシュ最適化済みの
+    //!             メッシュを渡すと, まとまりの良いメッシュレットになります.
+    //-------------------------------------------------------------------------------
+    bool Build( const asdx::ResMesh& mesh );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュレットを破棄します.
+    //-------------------------------------------------------------------------------
+    void Release();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( MeshClusterizer& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      カリングを行い, 描画範囲を求めます.
+    //!
+    //! @param [in]     view        カリングに用いるビューです.
+    //! @param [out]    result      カリング結果です.
+    //-------------------------------------------------------------------------------
+    void Cull( const CullView& view, CullResult& result ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュレット数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetMeshletCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュレットを取得します.
+    //-------------------------------------------------------------------------------
+    const Meshlet& GetMeshlet( u32 index ) const;
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    std::vector< Meshlet >  m_Meshlets;         //!< メッシュレットです.
+    u32                     m_SubsetCount;      //!< サブセット数です.
+    u32                     m_TriangleCount;    //!< 全三角形数です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    void ComputeBounds( const asdx::ResMesh& mesh, Meshlet& meshlet ) const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MeshClusterizer ( const MeshClusterizer& );     // アクセス禁止.
+    void operator = ( const MeshClusterizer& );     // アクセス禁止.
+};
+
+#endif//__MESH_CLUSTERIZER_H__
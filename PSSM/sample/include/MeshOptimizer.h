@@ -0,0 +1,197 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshOptimizer.h
+// Desc : Mesh Optimizer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MESH_OPTIMIZER_H__
+#define __MESH_OPTIMIZER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MeshOptimizer class
+//////////////////////////////////////////////////////////////////////////////////////
+class MeshOptimizer
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 OPTIMIZE_CACHE_SIZE = 32;      //!< 三角形の並び替えで想定するキャッシュサイズ(LRU)です.
+    static const u32 ANALYZE_CACHE_SIZE  = 16;      //!< 解析で想定するキャッシュサイズ(FIFO)です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Range structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Range
+    {
+        u32     IndexOffset;        //!< 頂点インデックスの開始位置です.
+        u32     IndexCount;         //!< 頂点インデックス数です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // CacheStatistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct CacheStatistics
+    {
+        u32     TriangleCount;      //!< 三角形数です.
+        u32     VertexCount;        //!< 参照されている頂点数です.
+        u32     TransformCount;     //!< 頂点シェーダの実行回数です.
+        f32     ACMR;               //!< 三角形あたりの頂点シェーダ実行回数です.
+        f32     ATVR;               //!< 頂点あたりの頂点シェーダ実行回数です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        CacheStatistics     Before;     //!< 最適化前の統計情報です.
+        CacheStatistics     After;      //!< 最適化後の統計情報です.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MeshOptimizer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MeshOptimizer();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      オーバードロー削減で許容するACMRの悪化率を設定します.
+    //!
+    //! @param [in]     value       許容する悪化率です(1.0で悪化を許容しません).
+    //-------------------------------------------------------------------------------
+    void SetOverdrawThreshold( f32 value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全ての最適化を行います.
+    //!
+    //! @param [in,out] pVertices       頂点データです.
+    //! @param [in]     vertexStride    頂点のストライドです.
+    //! @param [in]     vertexCount     頂点数です.
+    //! @param [in,out] pIndices        頂点インデックスデータです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @param [in]     pRanges         サブセットごとの頂点インデックス範囲です.
+    //! @param [in]     rangeCount      範囲の数です.
+    //! @note       三角形の並び替えはサブセットの範囲内で行うため, サブセットはそのまま使えます.
+    //!             頂点の先頭には位置座標(f32 x 3)が格納されている必要があります.
+    //-------------------------------------------------------------------------------
+    void Optimize(
+        void*           pVertices,
+        u32             vertexStride,
+        u32             vertexCount,
+        u32*            pIndices,
+        u32             indexCount,
+        const Range*    pRanges,
+        u32             rangeCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点キャッシュの効率が良くなるように三角形を並び替えます.
+    //!
+    //! @param [in,out] pIndices        頂点インデックスデータです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @param [in]     vertexCount     頂点数です.
+    //-------------------------------------------------------------------------------
+    void OptimizeVertexCache( u32* pIndices, u32 indexCount, u32 vertexCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視点に依存しないオーバードロー削減のために三角形を並び替えます.
+    //!
+    //! @param [in,out] pIndices        頂点キャッシュ最適化済みの頂点インデックスデータです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @param [in]     pVertices       頂点データです.
+    //! @param [in]     vertexStride    頂点のストライドです.
+    //! @param [in]     vertexCount     頂点数です.
+    //-------------------------------------------------------------------------------
+    void OptimizeOverdraw(
+        u32*            pIndices,
+        u32             indexCount,
+        const void*     pVertices,
+        u32             vertexStride,
+        u32             vertexCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点フェッチの局所性が良くなるように頂点を並び替えます.
+    //!
+    //! @param [in,out] pVertices       頂点データです.
+    //! @param [in]     vertexStride    頂点のストライドです.
+    //! @param [in]     vertexCount     頂点数です.
+    //! @param [in,out] pIndices        頂点インデックスデータです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @note       参照されていない頂点は末尾に元の順番で並べるため, 頂点数は変わりません.
+    //-------------------------------------------------------------------------------
+    void OptimizeVertexFetch(
+        void*           pVertices,
+        u32             vertexStride,
+        u32             vertexCount,
+        u32*            pIndices,
+        u32             indexCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      最後に行った最適化の統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      FIFOキャッシュを想定して頂点キャッシュの効率を解析します.
+    //!
+    //! @param [in]     pIndices        頂点インデックスデータです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @param [in]     vertexCount     頂点数です.
+    //! @param [in]     cacheSize       キャッシュサイズです.
+    //! @return     解析結果を返却します.
+    //-------------------------------------------------------------------------------
+    static CacheStatistics AnalyzeVertexCache(
+        const u32*      pIndices,
+        u32             indexCount,
+        u32             vertexCount,
+        u32             cacheSize = ANALYZE_CACHE_SIZE );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    f32                 m_OverdrawThreshold;    //!< オーバードロー削減で許容するACMRの悪化率です.
+    Statistics          m_Statistics;           //!< 統計情報です.
+    std::vector< u32 >  m_Remap;                //!< 頂点番号の変換テーブルです.
+    std::vector< u32 >  m_Work;                 //!< 作業用の配列です.
+    std::vector< u32 >  m_Output;               //!< 並び替え結果です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    /* NOTHING */
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MeshOptimizer   ( const MeshOptimizer& );   // アクセス禁止.
+    void operator = ( const MeshOptimizer& );   // アクセス禁止.
+};
+
+#endif//__MESH_OPTIMIZER_H__
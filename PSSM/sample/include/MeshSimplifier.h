@@ -0,0 +1,126 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshSimplifier.h
+// Desc : Quadric Error Metric Mesh Simplifier Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MESH_SIMPLIFIER_H__
+#define __MESH_SIMPLIFIER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <ThreadPool.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MeshSimplifier class
+//////////////////////////////////////////////////////////////////////////////////////
+class MeshSimplifier
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 MAX_LOD_LEVEL = 8;     //!< 生成するLODの最大数です(元のメッシュを除く).
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        u32     LevelCount;         //!< 生成するLODの数です(元のメッシュを除く).
+        f32     ReductionRatio;     //!< 1段階ごとの三角形数の比率です.
+        f32     MaxError;           //!< 許容する誤差です(メッシュのAABBの対角線長に対する比率).
+        u32     MinTriangleCount;   //!< サブセットあたりの三角形数の下限です.
+
+        Config()
+        : LevelCount        ( 4 )
+        , ReductionRatio    ( 0.5f )
+        , MaxError          ( 0.05f )
+        , MinTriangleCount  ( 16 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Level structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Level
+    {
+        f32                                     Error;          //!< 元のメッシュからの誤差です(メッシュのローカル座標系での距離).
+        u32                                     IndexCount;     //!< 頂点インデックス数です.
+        std::vector< asdx::ResMesh::Subset >    Subsets;        //!< サブセットです(LodChain::Indices 内のオフセット).
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // LodChain structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct LodChain
+    {
+        std::vector< asdx::ResMesh::Index >     Indices;        //!< 全てのLODの頂点インデックスです.
+        std::vector< Level >                    Levels;         //!< LOD1 以降の詳細度です.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      LODを生成します.
+    //!
+    //! @param [in]     mesh        元のメッシュです.
+    //! @param [in]     config      設定です.
+    //! @param [out]    result      生成結果です.
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //-------------------------------------------------------------------------------
+    static bool Build(
+        const asdx::ResMesh&    mesh,
+        const Config&           config,
+        LodChain&               result,
+        ThreadPool*             pPool = nullptr );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      複数のメッシュのLODをまとめて生成します.
+    //!
+    //! @param [in]     ppMeshes    元のメッシュです.
+    //! @param [in]     meshCount   メッシュ数です.
+    //! @param [in]     config      設定です.
+    //! @param [out]    pResults    生成結果です(meshCount 個).
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //! @note       メッシュとサブセットの組を単位に並列に処理します.
+    //!             LODは頂点インデックスだけを作り直すので, 頂点データは元のメッシュのものをそのまま使います.
+    //!             サブセット・マテリアルの構成は全てのLODで元のメッシュと同じです.
+    //-------------------------------------------------------------------------------
+    static bool BuildParallel(
+        const asdx::ResMesh* const* ppMeshes,
+        u32                         meshCount,
+        const Config&               config,
+        LodChain*                   pResults,
+        ThreadPool*                 pPool );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MeshSimplifier  ();                         // アクセス禁止.
+    MeshSimplifier  ( const MeshSimplifier& );  // アクセス禁止.
+    void operator = ( const MeshSimplifier& );  // アクセス禁止.
+};
+
+#endif//__MESH_SIMPLIFIER_H__
@@ -0,0 +1,98 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MshFormat.h
+// Desc : MSH File Format Definition.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MSH_FORMAT_H__
+#define __MSH_FORMAT_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+
+
+// MSHファイルのバージョン番号です.
+static const u32 MSH_VERSION = 0x00000001;
+
+// MSHファイルのデータヘッダのサイズです.
+static const u32 MSH_DATA_HEADER_SIZE = 32;
+
+// MSHファイルのテクスチャファイル名の長さです.
+static const u32 MSH_FILENAME_LENGTH = 256;
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MshDataHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MshDataHeader
+{
+    u32     NumVertices;            //!< 頂点数です.
+    u32     NumIndices;             //!< 頂点インデックス数です.
+    u32     NumMaterials;           //!< マテリアル数です.
+    u32     NumSubsets;             //!< サブセット数です.
+    u32     VertexStructureSize;    //!< 頂点構造体のサイズです.
+    u32     IndexStructureSize;     //!< 頂点インデックスのサイズです.
+    u32     MaterialStructureSize;  //!< マテリアル構造体のサイズです.
+    u32     SubsetStructureSize;    //!< サブセット構造体のサイズです.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MshFileHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MshFileHeader
+{
+    u8              Magic[ 4 ];     //!< マジックです('M', 'S', 'H', '\0').
+    u32             Version;        //!< ファイルバージョンです.
+    u32             DataHeaderSize; //!< データヘッダのサイズです.
+    MshDataHeader   DataHeader;     //!< データヘッダです.
+};
+
+// 以降は 頂点, 頂点インデックス, マテリアル, サブセット の順に配列が並ぶ.
+// データの開始位置は ( 12 + DataHeaderSize ) バイト目.
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MshVertex structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MshVertex
+{
+    f32     Position[ 3 ];      //!< 位置座標です.
+    f32     Normal  [ 3 ];      //!< 法線ベクトルです.
+    f32     Tangent [ 3 ];      //!< 接ベクトルです.
+    f32     TexCoord[ 2 ];      //!< テクスチャ座標です.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MshMaterial structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MshMaterial
+{
+    f32     Ambient [ 3 ];                              //!< 環境色です.
+    f32     Diffuse [ 3 ];                              //!< 拡散反射色です.
+    f32     Specular[ 3 ];                              //!< 鏡面反射色です.
+    f32     Emissive[ 3 ];                              //!< 自己照明色です.
+    f32     Alpha;                                      //!< 透過度です.
+    f32     Power;                                      //!< 鏡面反射強度です.
+    char    AmbientMap     [ MSH_FILENAME_LENGTH ];     //!< アンビエントマップです.
+    char    DiffuseMap     [ MSH_FILENAME_LENGTH ];     //!< ディフューズマップです.
+    char    SpecularMap    [ MSH_FILENAME_LENGTH ];     //!< スペキュラーマップです.
+    char    BumpMap        [ MSH_FILENAME_LENGTH ];     //!< 凹凸マップです.
+    char    DisplacementMap[ MSH_FILENAME_LENGTH ];     //!< 変位マップです.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MshSubset structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct MshSubset
+{
+    u32     IndexOffset;        //!< インデックスバッファ先頭からのオフセットです.
+    u32     IndexCount;         //!< 描画するインデックス数です.
+    u32     MaterialID;         //!< マテリアルIDです.
+};
+
+#endif//__MSH_FORMAT_H__
@@ -0,0 +1,229 @@
+﻿//-----------------------------------------------------------------------------------
+// File : OcclusionCuller.h
+// Desc : Software Occlusion Culling Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __OCCLUSION_CULLER_H__
+#define __OCCLUSION_CULLER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+#include <ThreadPool.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// OcclusionCuller class
+//////////////////////////////////////////////////////////////////////////////////////
+class OcclusionCuller
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 TILE_WIDTH  = 8;                           //!< タイルの横幅(ピクセル)です.
+    static const u32 TILE_HEIGHT = 4;                           //!< タイルの縦幅(ピクセル)です.
+    static const u32 BIN_COUNT_X = 4;                           //!< 横方向のビン数です.
+    static const u32 BIN_COUNT_Y = 4;                           //!< 縦方向のビン数です.
+    static const u32 COARSE_TILE_X = 4;                         //!< 粗いレベルの1要素あたりの横方向タイル数です.
+    static const u32 COARSE_TILE_Y = 4;                         //!< 粗いレベルの1要素あたりの縦方向タイル数です.
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     SubmittedTriangles;     //!< 投入された三角形数です.
+        u32     RasterizedTriangles;    //!< ラスタライズ対象となった三角形数です.
+        u32     TestedObjects;          //!< テストしたオブジェクト数です.
+        u32     OccludedObjects;        //!< 遮蔽されていたオブジェクト数です.
+
+        Statistics()
+        : SubmittedTriangles ( 0 )
+        , RasterizedTriangles( 0 )
+        , TestedObjects      ( 0 )
+        , OccludedObjects    ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    OcclusionCuller();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~OcclusionCuller();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     width       深度バッファの横幅です(タイル幅の倍数に切り上げます).
+    //! @param [in]     height      深度バッファの縦幅です(タイル高さの倍数に切り上げます).
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合はシングルスレッドで処理します).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       深度バッファは2段の階層になっています. 細かいレベルはタイルごとの2層の最大深度とカバレッジマスクで,
+    //!             粗いレベルは COARSE_TILE_X x COARSE_TILE_Y タイルごとの最大深度です.
+    //!             AABBの判定は粗いレベルで遮蔽されている範囲を先に除外してから, 残りをタイル単位で判定します.
+    //-------------------------------------------------------------------------------
+    bool Init( u32 width, u32 height, ThreadPool* pPool );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      フレームの開始処理です. 深度バッファをクリアします.
+    //!
+    //! @param [in]     viewProj    ビュー射影行列です.
+    //-------------------------------------------------------------------------------
+    void Begin( const asdx::Matrix& viewProj );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      遮蔽物を投入します.
+    //!
+    //! @param [in]     world           ワールド行列です.
+    //! @param [in]     pPositions      位置座標の先頭ポインタです.
+    //! @param [in]     stride          位置座標のストライド(バイト)です.
+    //! @param [in]     vertexCount     頂点数です.
+    //! @param [in]     pIndices        頂点インデックスです.
+    //! @param [in]     indexCount      頂点インデックス数です.
+    //! @note       三角形のセットアップとビニングのみを行います. ラスタライズは Flush() で行います.
+    //-------------------------------------------------------------------------------
+    void AddOccluder(
+        const asdx::Matrix& world,
+        const void*         pPositions,
+        u32                 stride,
+        u32                 vertexCount,
+        const u32*          pIndices,
+        u32                 indexCount );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      投入済みの遮蔽物をラスタライズし, 粗いレベルの最大深度を更新します.
+    //-------------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ワールド空間のAABBが可視かどうか判定します.
+    //!
+    //! @param [in]     box         判定するAABBです.
+    //! @retval true    可視である可能性があります.
+    //! @retval false   遮蔽されているか画面外です.
+    //-------------------------------------------------------------------------------
+    bool TestBox( const asdx::BoundingBox& box );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      複数のAABBを並列に判定します.
+    //!
+    //! @param [in]     pBoxes      判定するAABBです.
+    //! @param [in]     count       AABBの数です.
+    //! @param [out]    pVisible    判定結果です(可視であれば1, 遮蔽されていれば0).
+    //-------------------------------------------------------------------------------
+    void TestBoxes( const asdx::BoundingBox* pBoxes, u32 count, u8* pVisible );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @return     統計情報を返却します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度バッファの横幅を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetWidth() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度バッファの縦幅を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetHeight() const;
+
+protected:
+    //////////////////////////////////////////////////////////////////////////////////
+    // Triangle structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Triangle
+    {
+        f32     EdgeA[ 3 ];         //!< エッジ関数の係数Aです.
+        f32     EdgeB[ 3 ];         //!< エッジ関数の係数Bです.
+        f32     EdgeC[ 3 ];         //!< エッジ関数の係数Cです.
+        f32     DepthA;             //!< 深度平面の係数Aです.
+        f32     DepthB;             //!< 深度平面の係数Bです.
+        f32     DepthC;             //!< 深度平面の係数Cです.
+        f32     DepthMax;           //!< 三角形の最大深度です.
+        u16     TileMinX;           //!< タイル範囲の最小値(X)です.
+        u16     TileMinY;           //!< タイル範囲の最小値(Y)です.
+        u16     TileMaxX;           //!< タイル範囲の最大値(X)です.
+        u16     TileMaxY;           //!< タイル範囲の最大値(Y)です.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // SlotData structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct SlotData
+    {
+        std::vector< Triangle >     Triangles;                          //!< セットアップ済み三角形です.
+        std::vector< u32 >          Bins[ BIN_COUNT_X * BIN_COUNT_Y ];  //!< ビンごとの三角形番号です.
+    };
+
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    u32                         m_Width;        //!< 深度バッファの横幅です.
+    u32                         m_Height;       //!< 深度バッファの縦幅です.
+    u32                         m_TileCountX;   //!< 横方向のタイル数です.
+    u32                         m_TileCountY;   //!< 縦方向のタイル数です.
+    std::vector< f32 >          m_ZMax0;        //!< 確定レイヤーの最大深度です.
+    std::vector< f32 >          m_ZMax1;        //!< 作業レイヤーの最大深度です.
+    std::vector< u32 >          m_Mask;         //!< 作業レイヤーのカバレッジマスクです.
+    u32                         m_CoarseCountX; //!< 粗いレベルの横方向の要素数です.
+    u32                         m_CoarseCountY; //!< 粗いレベルの縦方向の要素数です.
+    std::vector< f32 >          m_CoarseZMax;   //!< 粗いレベルの最大深度です.
+    std::vector< SlotData >     m_Slots;        //!< スロットごとのセットアップ結果です.
+    std::vector< asdx::Vector4 > m_ClipPos;     //!< クリップ空間に変換した頂点位置です.
+    asdx::Matrix                m_ViewProj;     //!< ビュー射影行列です.
+    ThreadPool*                 m_pPool;        //!< スレッドプールです.
+    Statistics                  m_Statistics;   //!< 統計情報です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    bool SetupTriangle( const asdx::Vector4* pClip, Triangle& result ) const;
+    void RasterizeBin( u32 binIndex );
+    void RasterizeTriangle( const Triangle& tri, u32 tileMinX, u32 tileMinY, u32 tileMaxX, u32 tileMaxY );
+    u32  ComputeCoverage( const Triangle& tri, u32 tileX, u32 tileY ) const;
+    bool GetBinRect( u32 binIndex, u32& tileMinX, u32& tileMinY, u32& tileMaxX, u32& tileMaxY ) const;
+    void UpdateCoarse( u32 coarseY );
+    bool IsVisible( const asdx::BoundingBox& box ) const;
+    bool IsTileRangeVisible( f32 minZ, u32 tileMinX, u32 tileMinY, u32 tileMaxX, u32 tileMaxY ) const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    OcclusionCuller ( const OcclusionCuller& );     // アクセス禁止.
+    void operator = ( const OcclusionCuller& );     // アクセス禁止.
+};
+
+#endif//__OCCLUSION_CULLER_H__
@@ -0,0 +1,129 @@
+﻿//-----------------------------------------------------------------------------------
+// File : PackedVertex.h
+// Desc : Packed Vertex Format Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __PACKED_VERTEX_H__
+#define __PACKED_VERTEX_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <d3d11.h>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// PackedVertex structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct PackedVertex
+{
+    static const u32 NUM_INPUT_ELEMENT = 4;                                 //!< 入力要素数です.
+    static const D3D11_INPUT_ELEMENT_DESC INPUT_ELEMENTS[ NUM_INPUT_ELEMENT ];  //!< 入力要素です.
+
+    u16     Position[ 4 ];      //!< AABBで正規化した位置座標(UNORM16)と, 従法線の符号(w)です.
+    s16     Normal  [ 2 ];      //!< 八面体エンコードした法線ベクトル(SNORM16)です.
+    s16     Tangent [ 2 ];      //!< 八面体エンコードした接ベクトル(SNORM16)です.
+    u16     TexCoord[ 2 ];      //!< テクスチャ座標(半精度浮動小数)です.
+};
+
+
+//-----------------------------------------------------------------------------------
+//! @brief      単位ベクトルを八面体エンコードします.
+//!
+//! @param [in]     value       単位ベクトルです.
+//! @param [out]    result      エンコード結果(SNORM16 x 2)です.
+//-----------------------------------------------------------------------------------
+void EncodeOctahedral( const asdx::Vector3& value, s16* result );
+
+//-----------------------------------------------------------------------------------
+//! @brief      八面体エンコードされた単位ベクトルをデコードします.
+//!
+//! @param [in]     value       エンコードされた値(SNORM16 x 2)です.
+//! @return     デコードした単位ベクトルを返却します.
+//-----------------------------------------------------------------------------------
+asdx::Vector3 DecodeOctahedral( const s16* value );
+
+//-----------------------------------------------------------------------------------
+//! @brief      単精度浮動小数を半精度浮動小数に変換します.
+//-----------------------------------------------------------------------------------
+u16 EncodeHalf( f32 value );
+
+//-----------------------------------------------------------------------------------
+//! @brief      半精度浮動小数を単精度浮動小数に変換します.
+//-----------------------------------------------------------------------------------
+f32 DecodeHalf( u16 value );
+
+//-----------------------------------------------------------------------------------
+//! @brief      位置座標の逆量子化行列を求めます.
+//!
+//! @param [in]     mini        量子化に用いたAABBの最小値です.
+//! @param [in]     maxi        量子化に用いたAABBの最大値です.
+//! @return     [0, 1]の位置座標を元の座標に戻す行列を返却します.
+//! @note       ワールド行列の前に掛けることで, シェーダ側で逆量子化する必要がなくなります.
+//-----------------------------------------------------------------------------------
+asdx::Matrix ComputeDequantizeMatrix( const asdx::Vector3& mini, const asdx::Vector3& maxi );
+
+//-----------------------------------------------------------------------------------
+//! @brief      位置座標を圧縮します.
+//!
+//! @param [in]     value       圧縮する位置座標です.
+//! @param [in]     mini        量子化に用いるAABBの最小値です.
+//! @param [in]     maxi        量子化に用いるAABBの最大値です.
+//! @param [out]    result      圧縮結果(UNORM16 x 4)です. w には正の従法線の符号が入ります.
+//! @note       PackVertex() の位置座標と同じ値になります.
+//-----------------------------------------------------------------------------------
+void PackPosition(
+    const asdx::Vector3&    value,
+    const asdx::Vector3&    mini,
+    const asdx::Vector3&    maxi,
+    u16*                    result );
+
+//-----------------------------------------------------------------------------------
+//! @brief      頂点を圧縮します.
+//!
+//! @param [in]     value       圧縮する頂点です.
+//! @param [in]     mini        位置座標の量子化に用いるAABBの最小値です.
+//! @param [in]     maxi        位置座標の量子化に用いるAABBの最大値です.
+//! @param [out]    result      圧縮結果です.
+//! @note       asdx::ResMesh::Vertex は従法線の符号を持たないため, 符号は常に正になります.
+//-----------------------------------------------------------------------------------
+void PackVertex(
+    const asdx::ResMesh::Vertex&    value,
+    const asdx::Vector3&            mini,
+    const asdx::Vector3&            maxi,
+    PackedVertex&                   result );
+
+//-----------------------------------------------------------------------------------
+//! @brief      圧縮された頂点を展開します.
+//!
+//! @param [in]     value       圧縮された頂点です.
+//! @param [in]     mini        位置座標の量子化に用いたAABBの最小値です.
+//! @param [in]     maxi        位置座標の量子化に用いたAABBの最大値です.
+//! @param [out]    result      展開結果です.
+//-----------------------------------------------------------------------------------
+void UnpackVertex(
+    const PackedVertex&         value,
+    const asdx::Vector3&        mini,
+    const asdx::Vector3&        maxi,
+    asdx::ResMesh::Vertex&      result );
+
+//-----------------------------------------------------------------------------------
+//! @brief      頂点をまとめて圧縮します.
+//!
+//! @param [in]     pVertices   圧縮する頂点です.
+//! @param [in]     count       頂点数です.
+//! @param [in]     mini        位置座標の量子化に用いるAABBの最小値です.
+//! @param [in]     maxi        位置座標の量子化に用いるAABBの最大値です.
+//! @param [out]    pResult     圧縮結果です.
+//! @note       SSE2 が使える場合は4頂点ずつまとめて処理します. 結果は PackVertex() と一致します.
+//-----------------------------------------------------------------------------------
+void PackVertices(
+    const asdx::ResMesh::Vertex*    pVertices,
+    u32                             count,
+    const asdx::Vector3&            mini,
+    const asdx::Vector3&            maxi,
+    PackedVertex*                   pResult );
+
+#endif//__PACKED_VERTEX_H__
@@ -0,0 +1,127 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ProgressiveMeshBuilder.h
+// Desc : Progressive Streaming Mesh Builder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __PROGRESSIVE_MESH_BUILDER_H__
+#define __PROGRESSIVE_MESH_BUILDER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <StreamingMeshFormat.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// ProgressiveMeshBuilder class
+//////////////////////////////////////////////////////////////////////////////////////
+class ProgressiveMeshBuilder
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        u32     GridResolution;     //!< 基本LODを作る格子の, メッシュの最も長い軸方向の分割数です.
+
+        Config()
+        : GridResolution( 64 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Block structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Block
+    {
+        std::vector< MshVertex >    Vertices;       //!< チャンクが参照する頂点です.
+        std::vector< u32 >          Indices;        //!< ブロック内の頂点番号です.
+        std::vector< MshSubset >    Subsets;        //!< ブロック内のオフセットで表したサブセットです.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Result structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Result
+    {
+        std::vector< MshVertex >        BaseVertices;   //!< 基本LODの頂点です.
+        std::vector< u32 >              BaseIndices;    //!< 基本LODの頂点インデックスです.
+        std::vector< MshSubset >        BaseSubsets;    //!< 基本LODのサブセットです(チャンクの順に並びます).
+        std::vector< StreamingChunk >   Chunks;         //!< チャンクです(BlockOffset, BlockSize は書き出し時に設定します).
+        std::vector< Block >            Blocks;         //!< チャンクごとの詳細化ブロックです.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     ChunkCount;             //!< チャンク数です.
+        u32     SourceTriangleCount;    //!< 元のメッシュの三角形数です.
+        u32     BaseTriangleCount;      //!< 基本LODの三角形数です.
+        u32     BaseVertexCount;        //!< 基本LODの頂点数です.
+        f32     MaxBaseError;           //!< 基本LODの最大誤差です.
+
+        Statistics()
+        : ChunkCount          ( 0 )
+        , SourceTriangleCount ( 0 )
+        , BaseTriangleCount   ( 0 )
+        , BaseVertexCount     ( 0 )
+        , MaxBaseError        ( 0.0f )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      粗い基本LODとチャンクごとの詳細化ブロックを作成します.
+    //!
+    //! @param [in]     vertices    頂点です.
+    //! @param [in]     indices     頂点インデックスです.
+    //! @param [in]     subsets     サブセットです.
+    //! @param [in]     chunks      MeshChunker で分割したチャンクです(空の場合は全体を1つのチャンクとします).
+    //! @param [in]     config      設定です.
+    //! @param [out]    result      作成結果です.
+    //! @param [out]    pStats      統計情報です(nullptrの場合は出力しません).
+    //! @note       基本LODは頂点クラスタリングで作ります. メッシュ全体で共通の格子を使い,
+    //!             セルごとに1つの代表位置へ頂点をまとめるので, チャンクの境界にひび割れができません.
+    //!             基本LODの大きさは格子の分割数で決まり, 元のメッシュの三角形数にはほとんど依存しません.
+    //-------------------------------------------------------------------------------
+    static void Build(
+        const std::vector< MshVertex >&     vertices,
+        const std::vector< u32 >&           indices,
+        const std::vector< MshSubset >&     subsets,
+        const std::vector< CookedChunk >&   chunks,
+        const Config&                       config,
+        Result&                             result,
+        Statistics*                         pStats = nullptr );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    ProgressiveMeshBuilder  ();                                 // アクセス禁止.
+    ProgressiveMeshBuilder  ( const ProgressiveMeshBuilder& );  // アクセス禁止.
+    void operator =         ( const ProgressiveMeshBuilder& );  // アクセス禁止.
+};
+
+#endif//__PROGRESSIVE_MESH_BUILDER_H__
@@ -18,11 +18,43 @@
 #include <asdxCameraUpdater.h>
 #include <asdxGeometry.h>
 #include <asdxOnb.h>
+#include <ShadowCasterCuller.h>
+#include <OcclusionCuller.h>
+#include <CascadeCoverage.h>
+#include <MappedResMesh.h>
+#include <CookedResMesh.h>
+#include <MeshOptimizer.h>
+#include <ClusteredMesh.h>
+#include <InstanceBuffer.h>
+#include <StaticBatch.h>
+#include <StaticBatchBuilder.h>
+#include <StreamingMesh.h>
+#include <LodSelector.h>
+#include <ThreadPool.h>
+#include <AsyncLoader.h>
+#include <memory>
 
 
 // カスケードの段数です.
 static const int MAX_CASCADE = 4;
 
+// 視点の最大数です.
+static const int MAX_EYE = 2;
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// EyeFrustum structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct EyeFrustum
+{
+    asdx::Vector3       Position;       //!< 視点位置です.
+    asdx::Vector3       Forward;        //!< 視線方向です(正規化済み).
+    asdx::Vector3       Right;          //!< 右方向です(正規化済み).
+    asdx::Vector3       Upward;         //!< 上方向です(正規化済み).
+    f32                 Fov;            //!< 垂直画角です.
+    f32                 Aspect;         //!< アスペクト比です.
+};
+
 
 //////////////////////////////////////////////////////////////////////////////////////
 // ShadowState structure
@@ -33,9 +65,12 @@ struct ShadowState
     ID3D11Texture2D*            pDepthTex[ MAX_CASCADE ];       //!< 深度テクスチャ.
     ID3D11ShaderResourceView*   pDepthSRV[ MAX_CASCADE ];       //!< 深度シェーダリソースビュー.
     ID3D11VertexShader*         pVS;                            //!< シャドウマップ描画用頂点シェーダ.
+    ID3D11VertexShader*         pInstancedVS;                   //!< インスタンス描画用頂点シェーダ.
     ID3D11Buffer*               pCB;                            //!< 定数バッファ.
     ID3D11DepthStencilState*    pDSS;                           //!< 深度ステンシルステート.
     ID3D11SamplerState*         pSmp;                           //!< シャドウマップフェッチ用サンプラーステート.
+    ID3D11RasterizerState*      pRS;                            //!< シザー矩形を有効にしたラスタライザーステート.
+    D3D11_RECT                  Scissor[ MAX_CASCADE ];         //!< カスケードごとのシザー矩形.
     D3D11_VIEWPORT              Viewport;                       //!< ビューポート.
 
     //-------------------------------------------------------------------------------
@@ -43,15 +78,22 @@ struct ShadowState
     //-------------------------------------------------------------------------------
     ShadowState()
     : pVS       ( nullptr )
+    , pInstancedVS( nullptr )
     , pCB       ( nullptr )
     , pDSS      ( nullptr )
     , pSmp      ( nullptr )
+    , pRS       ( nullptr )
     {
         for( int i=0; i<MAX_CASCADE; ++i )
         {
             pDSV[i]      = nullptr;
             pDepthTex[i] = nullptr;
             pDepthSRV[i] = nullptr;
+
+            Scissor[i].left   = 0;
+            Scissor[i].top    = 0;
+            Scissor[i].right  = 0;
+            Scissor[i].bottom = 0;
         }
     }
 
@@ -68,13 +110,73 @@ struct ShadowState
         }
 
         ASDX_RELEASE( pVS );
+        ASDX_RELEASE( pInstancedVS );
         ASDX_RELEASE( pCB );
         ASDX_RELEASE( pDSS );
         ASDX_RELEASE( pSmp );
+        ASDX_RELEASE( pRS );
     }
 };
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+// SceneData structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct SceneData
+{
+    ID3DBlob*                       pVSBlob;                //!< 頂点シェーダのバイトコード.
+    ID3DBlob*                       pDepthBlob;             //!< 深度描画用頂点シェーダのバイトコード.
+    ID3DBlob*                       pInstancedBlob;         //!< インスタンス描画用頂点シェーダのバイトコード.
+    ID3DBlob*                       pDepthInstancedBlob;    //!< インスタンス描画用の深度描画頂点シェーダのバイトコード.
+    ID3DBlob*                       pPSBlob;                //!< ピクセルシェーダのバイトコード.
+    ID3DBlob*                       pPSCoverageBlob;        //!< カバレッジでカスケードを選択するピクセルシェーダのバイトコード.
+    CookedResMesh                   CookedMesh;             //!< クック済みメッシュ.
+    MappedResMesh                   MappedMesh;             //!< クック済みメッシュが無い場合にマップするメッシュ.
+    const asdx::ResMesh*            pResMesh;               //!< 使用するメッシュ.
+    const MaterialTable*            pMaterials;             //!< クック済みのマテリアルテーブル.
+    asdx::BoundingBox               Box;                    //!< メッシュのAABB.
+    MeshOptimizer::CacheStatistics  CacheStats;             //!< 頂点キャッシュの統計情報.
+    std::vector<asdx::Matrix>       InstanceWorlds;         //!< 格子状に並べたワールド行列.
+    std::vector<asdx::BoundingBox>  InstanceBoxes;          //!< インスタンスごとのワールド空間のAABB.
+    asdx::BoundingBox               InstanceBox;            //!< 全インスタンスを覆うAABB.
+    std::vector<asdx::Vector3>      OccluderPositions;      //!< 遮蔽物の位置座標.
+    std::vector<u32>                OccluderIndices;        //!< 遮蔽物の頂点インデックス.
+    MeshSimplifier::LodChain        LodChain;               //!< 詳細度.
+    StaticBatchBuilder              Batch;                  //!< 静的バッチ.
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    SceneData()
+    : pVSBlob               ( nullptr )
+    , pDepthBlob            ( nullptr )
+    , pInstancedBlob        ( nullptr )
+    , pDepthInstancedBlob   ( nullptr )
+    , pPSBlob               ( nullptr )
+    , pPSCoverageBlob       ( nullptr )
+    , pResMesh              ( nullptr )
+    , pMaterials            ( nullptr )
+    { memset( &CacheStats, 0, sizeof( CacheStats ) ); }
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~SceneData()
+    {
+        ASDX_RELEASE( pVSBlob );
+        ASDX_RELEASE( pDepthBlob );
+        ASDX_RELEASE( pInstancedBlob );
+        ASDX_RELEASE( pDepthInstancedBlob );
+        ASDX_RELEASE( pPSBlob );
+        ASDX_RELEASE( pPSCoverageBlob );
+    }
+
+private:
+    SceneData       ( const SceneData& );   // アクセス禁止.
+    void operator = ( const SceneData& );   // アクセス禁止.
+};
+
+
 //////////////////////////////////////////////////////////////////////////////////////
 // CBForward structure
 //////////////////////////////////////////////////////////////////////////////////////
@@ -138,6 +240,8 @@ protected:
     bool InitQuad();
     void TermQuad();
     void DrawQuad( ID3D11ShaderResourceView** ppSRV );
+    void DrawLoading( asdx::FrameEventParam& param );
+
     bool InitShadowState();
     void TermShadowState();
     void DrawToShadowMap();
@@ -145,6 +249,12 @@ protected:
     void TermMesh();
     bool InitForward();
     void TermForward();
+    bool LoadPixelShaders( SceneData& data );
+    bool CreatePixelShaders( SceneData& data );
+    bool LoadScene( SceneData& data );
+    bool CreateScene( SceneData& data );
+    void SubmitSceneDetails( const std::shared_ptr< SceneData >& data );
+    bool IsSceneReady() const;
 
     void ComputeShadowMatrixPSSM();
 
@@ -160,6 +270,11 @@ protected:
 
     asdx::Matrix CreateCropMatrix( asdx::BoundingBox& box );
 
+    u32 SelectLod(
+        const asdx::Matrix& worldViewProj,
+        f32 width,
+        f32 height );
+
     void AdjustClipPlanes(
         const asdx::BoundingBox& casterBox,
         const asdx::Vector3& cameraPos,
@@ -179,6 +294,30 @@ protected:
         f32 farClip,
         asdx::Matrix& viewProj );
 
+    u32 CalculateFrustumCorners(
+        f32 nearClip,
+        f32 farClip,
+        asdx::Vector3* pCorners );
+
+    void CalculateFrustumCorners(
+        const EyeFrustum& eye,
+        f32 nearClip,
+        f32 farClip,
+        asdx::Vector3* pCorners );
+
+    u32 GetEyeFrustums( EyeFrustum* pEyes );
+
+    f32 ComputeStereoTexelRatio(
+        f32 nearClip,
+        f32 farClip,
+        const asdx::Matrix& shadowMatrix );
+
+    bool ComputeLiSPSMMatrix(
+        f32 nearClip,
+        f32 farClip,
+        const asdx::Vector3x8& casterHull,
+        asdx::Matrix& result );
+
     void OnFrameMove  ( asdx::FrameEventParam& param );
     void OnMouse      ( const asdx::MouseEventParam&  param );
     void OnKey        ( const asdx::KeyEventParam& param );
@@ -198,11 +337,35 @@ private:
     ShadowState                 m_ShadowState;
 
     ID3D11VertexShader*         m_pVS;
+    ID3D11VertexShader*         m_pInstancedVS;
     ID3D11PixelShader*          m_pPS;
+    ID3D11PixelShader*          m_pPSCoverage;
     ID3D11Buffer*               m_pCBMatrixForward;
 
-    asdx::Mesh                  m_Dosei;
+    ClusteredMesh               m_Dosei;
     asdx::BoundingBox           m_Box_Dosei;
+    asdx::BoundingBox           m_Box_Instances;
+    InstanceBuffer              m_InstanceBuffer;
+    std::vector<asdx::Matrix>   m_InstanceWorlds;
+    std::vector<asdx::BoundingBox>  m_InstanceBoxes;
+    bool                        m_EnableInstancing;
+    InstanceBuffer::Statistics  m_MainInstanceStats;
+    InstanceBuffer::Statistics  m_ShadowInstanceStats[ MAX_CASCADE ];
+    StaticBatch                 m_StaticBatch;
+    bool                        m_EnableStaticBatch;
+    StaticBatch::Statistics     m_MainBatchStats;
+    StaticBatch::Statistics     m_ShadowBatchStats[ MAX_CASCADE ];
+    bool                        m_EnableChunkCulling;
+    std::vector<asdx::BoundingBox>  m_ChunkBoxes;
+    std::vector<u8>             m_ChunkCaster;
+    std::vector<u8>             m_MainChunkMask;
+    std::vector<u8>             m_ShadowChunkMask[ MAX_CASCADE ];
+    u32                         m_MainChunkVisible;
+    u32                         m_ShadowChunkVisible[ MAX_CASCADE ];
+    StreamingMesh               m_StreamingMesh;
+    bool                        m_EnableStreaming;
+    StreamingMesh::Statistics   m_MainStreamStats;
+
 
     asdx::Matrix                m_View;
     asdx::Matrix                m_Proj;
@@ -213,6 +376,42 @@ private:
     asdx::OrthonormalBasis      m_LightBasis;
     asdx::Matrix                m_ShadowMatrix[ MAX_CASCADE ];
     f32                         m_SplitPos[ MAX_CASCADE ];
+    ShadowCasterCuller          m_CasterCuller;
+    bool                        m_IsCasterVisible;
+    bool                        m_EnableCasterCulling;
+    OcclusionCuller             m_OcclusionCuller;
+    bool                        m_EnableOcclusionCulling;
+    OcclusionCuller::Statistics m_OcclusionStats;
+    std::vector<asdx::Vector3>  m_OccluderPositions;
+    std::vector<u32>            m_OccluderIndices;
+    std::vector<asdx::BoundingBox>  m_OcclusionBoxes;
+    std::vector<u8>             m_OcclusionVisible;
+    std::vector<asdx::Matrix>   m_OcclusionWorlds;
+    bool                        m_EnableLiSPSM;
+    s32                         m_SplitCount;
+    CascadeCoverage             m_Coverage;
+    bool                        m_EnableCoverage;
+    bool                        m_DrawCasterInCascade[ MAX_CASCADE ];
+    bool                        m_EnableStereo;
+    f32                         m_EyeSeparation;
+    f32                         m_StereoTexelRatio[ MAX_CASCADE ];
+    MeshOptimizer::CacheStatistics  m_MeshCacheStats;
+    bool                        m_EnableMeshletCulling;
+    bool                        m_EnableMeshletCone;
+    bool                        m_IsFrontCounterClockwise;
+    MeshClusterizer::CullResult m_MainCullResult;
+    MeshClusterizer::CullResult m_ShadowCullResult[ MAX_CASCADE ];
+    ThreadPool                  m_ThreadPool;
+    AsyncLoader                 m_AsyncLoader;
+    AsyncLoader::Future         m_ShaderFuture;
+    AsyncLoader::Future         m_SceneFuture;
+    asdx::StopWatch             m_LoadWatch;
+    f64                         m_LoadTimeMsec;
+
+    LodSelector                 m_LodSelector;
+    bool                        m_EnableLod;
+    u32                         m_MainLod;
+    u32                         m_ShadowLod[ MAX_CASCADE ];
 
     f32                         m_LightRotX;
     f32                         m_LightRotY;
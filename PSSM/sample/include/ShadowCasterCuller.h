@@ -0,0 +1,140 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ShadowCasterCuller.h
+// Desc : Receiver Driven Shadow Caster Culling Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __SHADOW_CASTER_CULLER_H__
+#define __SHADOW_CASTER_CULLER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// ShadowCasterCuller class
+//////////////////////////////////////////////////////////////////////////////////////
+class ShadowCasterCuller
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     ReceiverCount;      //!< 有効なレシーバー数です.
+        u32     TestedCasters;      //!< テストしたキャスター数です.
+        u32     CulledCasters;      //!< カリングされたキャスター数です.
+
+        Statistics()
+        : ReceiverCount( 0 )
+        , TestedCasters( 0 )
+        , CulledCasters( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    ShadowCasterCuller();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~ShadowCasterCuller();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      フレームの開始処理です.
+    //!
+    //! @param [in]     lightView       ライトのビュー行列です(右手系, -Z方向がライトの向き).
+    //! @param [in]     pRegion         可視レシーバー領域を囲む凸包の頂点です(ワールド空間).
+    //! @param [in]     count           頂点数です.
+    //! @note       pRegion には視錐台の8角を渡します. 深度範囲が分かっている場合は
+    //!             ニア・ファーを詰めた視錐台を渡すことで領域が狭くなります.
+    //-------------------------------------------------------------------------------
+    void Begin( const asdx::Matrix& lightView, const asdx::Vector3* pRegion, u32 count );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      可視レシーバーを追加します.
+    //!
+    //! @param [in]     box         レシーバーのAABBです(ワールド空間).
+    //! @note       1つも追加しなかった場合は, 可視レシーバー領域全体をレシーバーとみなします.
+    //-------------------------------------------------------------------------------
+    void AddReceiver( const asdx::BoundingBox& box );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      キャスターの影が可視レシーバーに落ちるかどうか判定します.
+    //!
+    //! @param [in]     box         キャスターのAABBです(ワールド空間).
+    //! @retval true    影が可視レシーバーに落ちる可能性があります.
+    //! @retval false   影が可視レシーバーに落ちることはありません.
+    //-------------------------------------------------------------------------------
+    bool TestCaster( const asdx::BoundingBox& box );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @return     統計情報を返却します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+protected:
+    //////////////////////////////////////////////////////////////////////////////////
+    // Rect structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Rect
+    {
+        f32     MinX;       //!< ライト空間でのX方向の最小値です.
+        f32     MinY;       //!< ライト空間でのY方向の最小値です.
+        f32     MaxX;       //!< ライト空間でのX方向の最大値です.
+        f32     MaxY;       //!< ライト空間でのY方向の最大値です.
+        f32     MinZ;       //!< ライト空間での深度の最小値です.
+        f32     MaxZ;       //!< ライト空間での深度の最大値です.
+    };
+
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    asdx::Matrix            m_LightView;    //!< ライトのビュー行列です.
+    Rect                    m_Region;       //!< 可視レシーバー領域です.
+    std::vector< Rect >     m_Receivers;    //!< 可視レシーバーです.
+    Statistics              m_Statistics;   //!< 統計情報です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    void ComputeRect( const asdx::Vector3* pPoints, u32 count, Rect& result ) const;
+    void ComputeRect( const asdx::BoundingBox& box, Rect& result ) const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    ShadowCasterCuller  ( const ShadowCasterCuller& );  // アクセス禁止.
+    void operator =     ( const ShadowCasterCuller& );  // アクセス禁止.
+};
+
+#endif//__SHADOW_CASTER_CULLER_H__
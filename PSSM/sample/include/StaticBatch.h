@@ -0,0 +1,162 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StaticBatch.h
+// Desc : Static Geometry Batch Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __STATIC_BATCH_H__
+#define __STATIC_BATCH_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <d3d11.h>
+#include <StaticBatchBuilder.h>
+#include <functional>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StaticBatch class
+//////////////////////////////////////////////////////////////////////////////////////
+class StaticBatch
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    typedef std::function< void( ID3D11DeviceContext*, u32 ) >  MaterialBinder;    //!< マテリアルを設定する関数です(デバイスコンテキスト, マテリアル番号).
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     TestedCount;            //!< カリングでテストした描画数です.
+        u32     VisibleCount;           //!< 視錐台に入った描画数です.
+        u32     DrawCallCount;          //!< 隣り合う描画をまとめた後の描画コール数です.
+        u32     MaterialChangeCount;    //!< マテリアルの切り替え回数です.
+
+        Statistics()
+        : TestedCount           ( 0 )
+        , VisibleCount          ( 0 )
+        , DrawCallCount         ( 0 )
+        , MaterialChangeCount   ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    StaticBatch();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~StaticBatch();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     pDevice                 デバイスです.
+    //! @param [in]     builder                 Build() を済ませたビルダーです.
+    //! @param [in]     usePackedVertex         頂点を PackedVertex に圧縮するかどうか.
+    //! @param [in]     pShaderBytecode         頂点シェーダのバイトコードです.
+    //! @param [in]     byteCodeLength          バイトコードの長さです.
+    //! @param [in]     pDepthShaderBytecode    深度描画用頂点シェーダのバイトコードです.
+    //! @param [in]     depthByteCodeLength     バイトコードの長さです.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       圧縮する場合は全体のAABBで量子化するので, GetDequantizeMatrix() を定数バッファに設定します.
+    //-------------------------------------------------------------------------------
+    bool Init(
+        ID3D11Device*               pDevice,
+        const StaticBatchBuilder&   builder,
+        bool                        usePackedVertex,
+        const void*                 pShaderBytecode,
+        const u32                   byteCodeLength,
+        const void*                 pDepthShaderBytecode,
+        const u32                   depthByteCodeLength );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視錐台に入る描画をまとめて描画します.
+    //!
+    //! @param [in]     pDeviceContext  デバイスコンテキストです.
+    //! @param [in]     viewProj        ビュー射影行列です(頂点はワールド空間で格納済みです).
+    //! @param [in]     binder          マテリアルを設定する関数です.
+    //! @note       頂点バッファ・インデックスバッファは1回だけ設定し, 描画はマテリアル順に続けて発行します.
+    //!             頂点シェーダ・定数バッファは呼び出し側で設定しておく必要があります.
+    //-------------------------------------------------------------------------------
+    void Draw(
+        ID3D11DeviceContext*    pDeviceContext,
+        const asdx::Matrix&     viewProj,
+        const MaterialBinder&   binder );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視錐台に入るメッシュの深度のみを描画します.
+    //!
+    //! @param [in]     pDeviceContext  デバイスコンテキストです.
+    //! @param [in]     viewProj        ビュー射影行列です.
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const asdx::Matrix& viewProj );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      位置座標の逆量子化行列を取得します.
+    //!
+    //! @note       圧縮しない場合は単位行列を返却します.
+    //-------------------------------------------------------------------------------
+    const asdx::Matrix& GetDequantizeMatrix() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全体のAABBを取得します(ワールド空間).
+    //-------------------------------------------------------------------------------
+    const asdx::BoundingBox& GetBounds() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      最後に行った描画の統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    ID3D11Buffer*                               m_pVB;              //!< 頂点プールです.
+    ID3D11Buffer*                               m_pDepthVB;         //!< 位置座標だけの頂点プールです.
+    ID3D11Buffer*                               m_pIB;              //!< インデックスプールです.
+    ID3D11InputLayout*                          m_pIL;              //!< 入力レイアウトです.
+    ID3D11InputLayout*                          m_pDepthIL;         //!< 深度描画用の入力レイアウトです.
+    u32                                         m_Stride;           //!< 頂点のサイズです.
+    u32                                         m_DepthStride;      //!< 深度描画用の頂点のサイズです.
+    DXGI_FORMAT                                 m_IndexFormat;      //!< インデックスのフォーマットです.
+    std::vector< StaticBatchBuilder::Draw >     m_Draws;            //!< 描画です(マテリアル順).
+    std::vector< StaticBatchBuilder::Draw >     m_DepthDraws;       //!< 深度描画用の描画です.
+    asdx::Matrix                                m_Dequantize;       //!< 逆量子化行列です.
+    asdx::BoundingBox                           m_Bounds;           //!< 全体のAABBです.
+    Statistics                                  m_Statistics;       //!< 統計情報です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    StaticBatch     ( const StaticBatch& );     // アクセス禁止.
+    void operator = ( const StaticBatch& );     // アクセス禁止.
+
+    bool CreateBuffer( ID3D11Device* pDevice, UINT bindFlags, const void* pData, u32 size, ID3D11Buffer** ppBuffer );
+    void Bind( ID3D11DeviceContext* pDeviceContext, ID3D11Buffer* pVB, u32 stride, ID3D11InputLayout* pIL );
+};
+
+#endif//__STATIC_BATCH_H__
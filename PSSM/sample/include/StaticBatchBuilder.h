@@ -0,0 +1,166 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StaticBatchBuilder.h
+// Desc : Static Geometry Batch Builder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __STATIC_BATCH_BUILDER_H__
+#define __STATIC_BATCH_BUILDER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxResMesh.h>
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StaticBatchBuilder class
+//////////////////////////////////////////////////////////////////////////////////////
+class StaticBatchBuilder
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Draw structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Draw
+    {
+        u32                 IndexCount;     //!< 頂点インデックス数です.
+        u32                 StartIndex;     //!< インデックスプール内の開始位置です.
+        s32                 BaseVertex;     //!< 頂点プール内の開始位置です.
+        u32                 MaterialID;     //!< マテリアル番号です.
+        u32                 SourceID;       //!< 追加したメッシュの番号です.
+        asdx::BoundingBox   Bounds;         //!< ワールド空間でのAABBです.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     SourceCount;        //!< 追加したメッシュ数です.
+        u32     DrawCount;          //!< 描画数です.
+        u32     DepthDrawCount;     //!< 深度描画の描画数です.
+        u32     VertexCount;        //!< 頂点数です.
+        u32     IndexCount;         //!< 頂点インデックス数です.
+
+        Statistics()
+        : SourceCount   ( 0 )
+        , DrawCount     ( 0 )
+        , DepthDrawCount( 0 )
+        , VertexCount   ( 0 )
+        , IndexCount    ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    StaticBatchBuilder();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~StaticBatchBuilder();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      追加したメッシュを全て削除します.
+    //-------------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュを追加します.
+    //!
+    //! @param [in]     mesh            追加するメッシュです.
+    //! @param [in]     world           ワールド行列です. 頂点はワールド空間に変換して格納します.
+    //! @param [in]     materialOffset  マテリアル番号に加算する値です.
+    //! @retval true    追加に成功.
+    //! @retval false   追加に失敗.
+    //! @note       サブセットが無いメッシュは全体を1つの描画として扱います.
+    //-------------------------------------------------------------------------------
+    bool Add( const asdx::ResMesh& mesh, const asdx::Matrix& world, u32 materialOffset = 0 );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画を並べ替えて確定します.
+    //!
+    //! @note       描画はマテリアル順に並べ替えます. 同じマテリアルの中では追加した順を保ちます.
+    //-------------------------------------------------------------------------------
+    void Build();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点プールを取得します.
+    //-------------------------------------------------------------------------------
+    const std::vector< asdx::ResMesh::Vertex >& GetVertices() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      インデックスプールを取得します.
+    //!
+    //! @note       頂点番号は各メッシュの BaseVertex からの相対値です.
+    //-------------------------------------------------------------------------------
+    const std::vector< u32 >& GetIndices() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      描画を取得します(マテリアル順).
+    //-------------------------------------------------------------------------------
+    const std::vector< Draw >& GetDraws() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      深度描画用の描画を取得します(メッシュごとに1つ).
+    //!
+    //! @note       マテリアルを切り替えないので, メッシュのインデックス範囲全体を1回で描画します.
+    //-------------------------------------------------------------------------------
+    const std::vector< Draw >& GetDepthDraws() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全ての頂点を覆うAABBを取得します(ワールド空間).
+    //-------------------------------------------------------------------------------
+    const asdx::BoundingBox& GetBounds() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      16bitインデックスで表せるかどうかを取得します.
+    //!
+    //! @retval true    全てのメッシュの頂点数が65536以下です.
+    //! @retval false   32bitインデックスが必要です.
+    //-------------------------------------------------------------------------------
+    bool CanUse16BitIndex() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< asdx::ResMesh::Vertex >    m_Vertices;         //!< 頂点プールです.
+    std::vector< u32 >                      m_Indices;          //!< インデックスプールです.
+    std::vector< Draw >                     m_Draws;            //!< 描画です.
+    std::vector< Draw >                     m_DepthDraws;       //!< 深度描画用の描画です.
+    asdx::BoundingBox                       m_Bounds;           //!< 全体のAABBです.
+    u32                                     m_MaxSourceVertex;  //!< メッシュあたりの最大頂点数です.
+    Statistics                              m_Statistics;       //!< 統計情報です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    StaticBatchBuilder  ( const StaticBatchBuilder& );  // アクセス禁止.
+    void operator =     ( const StaticBatchBuilder& );  // アクセス禁止.
+};
+
+#endif//__STATIC_BATCH_BUILDER_H__
@@ -0,0 +1,263 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StreamingMesh.h
+// Desc : Progressive Streaming Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __STREAMING_MESH_H__
+#define __STREAMING_MESH_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <d3d11.h>
+#include <asdxMath.h>
+#include <asdxGeometry.h>
+#include <StreamingMeshFormat.h>
+#include <ChunkResidency.h>
+#include <MappedFile.h>
+#include <ThreadPool.h>
+#include <functional>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StreamingMesh class
+//////////////////////////////////////////////////////////////////////////////////////
+class StreamingMesh
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    typedef std::function< void( ID3D11DeviceContext*, u32 ) >  MaterialBinder;    //!< マテリアルを設定する関数です(デバイスコンテキスト, マテリアル番号).
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        ChunkResidency::Config  Residency;          //!< 常駐管理の設定です.
+        u32                     MaxUploadsPerFrame; //!< 1フレームにGPUバッファを生成するチャンク数の上限です.
+
+        Config()
+        : Residency         ()
+        , MaxUploadsPerFrame( 2 )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     VisibleCount;           //!< 視錐台に入ったチャンク数です.
+        u32     BaseCount;              //!< 基本LODで描画したチャンク数です.
+        u32     DrawCallCount;          //!< 描画コール数です.
+        u32     TriangleCount;          //!< 描画した三角形数です.
+
+        Statistics()
+        : VisibleCount  ( 0 )
+        , BaseCount     ( 0 )
+        , DrawCallCount ( 0 )
+        , TriangleCount ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    StreamingMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~StreamingMesh();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     pDevice                 デバイスです.
+    //! @param [in]     filename                MeshCooker で出力した .smsh ファイル名です.
+    //! @param [in]     usePackedVertex         頂点を PackedVertex に圧縮するかどうか.
+    //! @param [in]     pShaderBytecode         頂点シェーダのバイトコードです.
+    //! @param [in]     byteCodeLength          バイトコードの長さです.
+    //! @param [in]     pDepthShaderBytecode    深度描画用頂点シェーダのバイトコードです.
+    //! @param [in]     depthByteCodeLength     バイトコードの長さです.
+    //! @param [in]     pPool                   詳細化ブロックを読み込むスレッドプールです(nullptrの場合は Update() 内で読み込みます).
+    //! @param [in]     config                  設定です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       ファイルの先頭部分(基本LOD)だけを読んでGPUバッファを生成するので, 処理時間はメッシュの大きさにほとんど依存しません.
+    //!             圧縮する場合はメッシュ全体のAABBで量子化するので, GetDequantizeMatrix() をワールド行列の前に掛けます.
+    //-------------------------------------------------------------------------------
+    bool Init(
+        ID3D11Device*   pDevice,
+        const char*     filename,
+        bool            usePackedVertex,
+        const void*     pShaderBytecode,
+        const u32       byteCodeLength,
+        const void*     pDepthShaderBytecode,
+        const u32       depthByteCodeLength,
+        ThreadPool*     pPool,
+        const Config&   config = Config() );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //!
+    //! @note       読み込み中のブロックがあれば完了を待ちます.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      読み込みが完了したチャンクを常駐させ, 次に読み込むチャンクを決めます.
+    //!
+    //! @param [in]     pDevice         デバイスです.
+    //! @param [in]     worldViewProj   優先度の評価に使うワールドビュー射影行列です(逆量子化は含めません).
+    //! @param [in]     width           ビューポートの横幅(ピクセル数)です.
+    //! @param [in]     height          ビューポートの縦幅(ピクセル数)です.
+    //! @note       GPUバッファの生成と解放はこのメソッド内でのみ行うので, メインスレッドから毎フレーム呼び出します.
+    //-------------------------------------------------------------------------------
+    void Update(
+        ID3D11Device*           pDevice,
+        const asdx::Matrix&     worldViewProj,
+        f32                     width,
+        f32                     height );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視錐台に入るチャンクを描画します.
+    //!
+    //! @param [in]     pDeviceContext  デバイスコンテキストです.
+    //! @param [in]     worldViewProj   ワールドビュー射影行列です(逆量子化は含めません).
+    //! @param [in]     binder          マテリアルを設定する関数です.
+    //! @note       詳細化データが常駐していないチャンクは基本LODで描画します.
+    //!             頂点シェーダ・定数バッファは呼び出し側で設定しておく必要があります.
+    //-------------------------------------------------------------------------------
+    void Draw(
+        ID3D11DeviceContext*    pDeviceContext,
+        const asdx::Matrix&     worldViewProj,
+        const MaterialBinder&   binder );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      視錐台に入るチャンクの深度のみを描画します.
+    //!
+    //! @param [in]     pDeviceContext  デバイスコンテキストです.
+    //! @param [in]     worldViewProj   ワールドビュー射影行列です(逆量子化は含めません).
+    //-------------------------------------------------------------------------------
+    void DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const asdx::Matrix& worldViewProj );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化済みかどうか判定します.
+    //-------------------------------------------------------------------------------
+    bool IsValid() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      チャンク数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetChunkCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアル数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetMaterialCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      位置座標の逆量子化行列を取得します.
+    //!
+    //! @note       圧縮しない場合は単位行列を返却します.
+    //-------------------------------------------------------------------------------
+    const asdx::Matrix& GetDequantizeMatrix() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      メッシュ全体のAABBを取得します.
+    //-------------------------------------------------------------------------------
+    const asdx::BoundingBox& GetBoundingBox() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      常駐管理を取得します.
+    //-------------------------------------------------------------------------------
+    const ChunkResidency& GetResidency() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      最後に行った描画の統計情報を取得します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+private:
+    //////////////////////////////////////////////////////////////////////////////////
+    // Chunk structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Chunk
+    {
+        asdx::BoundingBox           Box;                //!< AABBです(ローカル座標系).
+        StreamingChunk              Info;               //!< ファイル上のチャンク情報です.
+        ID3D11Buffer*               pVB;                //!< 詳細化データの頂点バッファです.
+        ID3D11Buffer*               pIB;                //!< 詳細化データのインデックスバッファです.
+        DXGI_FORMAT                 IndexFormat;        //!< インデックスのフォーマットです.
+        std::vector< MshSubset >    Subsets;            //!< 詳細化データのサブセットです.
+        std::vector< u8 >           Vertices;           //!< ワーカースレッドで変換した頂点データです.
+        std::vector< u8 >           Indices;            //!< ワーカースレッドで変換したインデックスデータです.
+        bool                        Loaded;             //!< ワーカースレッドでの読み込みに成功したかどうか.
+    };
+
+    //================================================================================
+    // private variables.
+    //================================================================================
+    MappedFile                  m_File;             //!< マップしたファイルです.
+    ThreadPool*                 m_pPool;            //!< スレッドプールです.
+    Config                      m_Config;           //!< 設定です.
+    ID3D11Buffer*               m_pBaseVB;          //!< 基本LODの頂点バッファです.
+    ID3D11Buffer*               m_pBaseIB;          //!< 基本LODのインデックスバッファです.
+    DXGI_FORMAT                 m_BaseIndexFormat;  //!< 基本LODのインデックスのフォーマットです.
+    ID3D11InputLayout*          m_pIL;              //!< 入力レイアウトです.
+    ID3D11InputLayout*          m_pDepthIL;         //!< 深度描画用の入力レイアウトです.
+    u32                         m_Stride;           //!< 頂点のサイズです.
+    bool                        m_UsePackedVertex;  //!< 頂点を圧縮するかどうか.
+    u32                         m_MaterialCount;    //!< マテリアル数です.
+    std::vector< MshSubset >    m_BaseSubsets;      //!< 基本LODのサブセットです.
+    std::vector< Chunk >        m_Chunks;           //!< チャンクです.
+    ChunkResidency              m_Residency;        //!< 常駐管理です.
+    asdx::Matrix                m_Dequantize;       //!< 逆量子化行列です.
+    asdx::BoundingBox           m_Bounds;           //!< メッシュ全体のAABBです.
+    Statistics                  m_Statistics;       //!< 統計情報です.
+    std::vector< u32 >          m_Requests;         //!< 読み込みを要求するチャンクの作業領域です.
+    std::vector< u32 >          m_Evictions;        //!< 解放するチャンクの作業領域です.
+    std::vector< u32 >          m_Uploads;          //!< GPUバッファの生成を待つチャンクです.
+    std::vector< u32 >          m_ResidentVisible;  //!< 視錐台に入った常駐チャンクの作業領域です.
+
+    std::mutex                  m_Mutex;            //!< 読み込み完了の通知を保護するミューテックスです.
+    std::condition_variable     m_Condition;        //!< 読み込み完了を待つ条件変数です.
+    std::vector< u32 >          m_Completed;        //!< ワーカースレッドで読み込みが完了したチャンクです.
+    u32                         m_PendingCount;     //!< 読み込み中のブロック数です.
+    bool                        m_Cancel;           //!< 読み込みを中止するかどうか.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    StreamingMesh   ( const StreamingMesh& );   // アクセス禁止.
+    void operator = ( const StreamingMesh& );   // アクセス禁止.
+
+    bool Validate( const StreamingMeshHeader& header, const char* filename ) const;
+    void LoadBlock( u32 index );
+    void Evict( u32 index );
+    bool CreateBuffer( ID3D11Device* pDevice, UINT bindFlags, const void* pData, u32 size, ID3D11Buffer** ppBuffer );
+    void ConvertVertices( const MshVertex* pVertices, u32 count, std::vector< u8 >& result ) const;
+    void ConvertIndices( const u32* pIndices, u32 count, u32 vertexCount, std::vector< u8 >& result, DXGI_FORMAT& format ) const;
+    void Bind( ID3D11DeviceContext* pDeviceContext, ID3D11Buffer* pVB, ID3D11Buffer* pIB, DXGI_FORMAT format, ID3D11InputLayout* pIL );
+    void DrawChunks( ID3D11DeviceContext* pDeviceContext, const asdx::Matrix& worldViewProj, const MaterialBinder* pBinder, ID3D11InputLayout* pIL );
+    void DrawSubsets( ID3D11DeviceContext* pDeviceContext, const MshSubset* pSubsets, u32 count, const MaterialBinder* pBinder, u32& boundMaterial );
+
+};
+
+#endif//__STREAMING_MESH_H__
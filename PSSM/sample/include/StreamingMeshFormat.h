@@ -0,0 +1,80 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StreamingMeshFormat.h
+// Desc : Streaming Mesh File Format Definition.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __STREAMING_MESH_FORMAT_H__
+#define __STREAMING_MESH_FORMAT_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <CookedMeshFormat.h>
+
+
+// SMSHファイルのバージョン番号です.
+static const u32 SMSH_VERSION = 0x00000001;
+
+// SMSHファイルの先頭部分の各セクションのアライメントです.
+static const u32 SMSH_ALIGNMENT = 16;
+
+// 詳細化ブロックのアライメントです.
+// ページ境界に揃えておき, ブロック単位で読み込んだときに余分なページに触れないようにする.
+static const u32 SMSH_BLOCK_ALIGNMENT = 4096;
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StreamingMeshHeader structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct StreamingMeshHeader
+{
+    u8      Magic[ 4 ];             //!< マジックです('S', 'M', 'S', 'H').
+    u32     Version;                //!< ファイルバージョンです.
+    u32     HeaderSize;             //!< ヘッダのサイズです.
+    u32     Flags;                  //!< フラグです(CMSH_FLAG_XXX と同じ値を使います).
+    u64     SourceHash;             //!< 元ファイルのハッシュ値です.
+    u64     FileSize;               //!< ファイルサイズです.
+    f32     BoundsMin[ 3 ];         //!< メッシュ全体のAABBの最小値です.
+    f32     BoundsMax[ 3 ];         //!< メッシュ全体のAABBの最大値です.
+    u32     MaterialCount;          //!< マテリアル数です.
+    u32     MaterialOffset;         //!< マテリアルデータの開始位置です.
+    u32     StringTableSize;        //!< 文字列テーブルのサイズです.
+    u32     StringTableOffset;      //!< 文字列テーブルの開始位置です.
+    u32     ChunkCount;             //!< チャンク数です.
+    u32     ChunkOffset;            //!< チャンクデータの開始位置です.
+    u32     BaseVertexCount;        //!< 基本LODの頂点数です.
+    u32     BaseVertexOffset;       //!< 基本LODの頂点データの開始位置です.
+    u32     BaseIndexCount;         //!< 基本LODの頂点インデックス数です.
+    u32     BaseIndexOffset;        //!< 基本LODの頂点インデックスデータの開始位置です.
+    u32     BaseSubsetCount;        //!< 基本LODのサブセット数です.
+    u32     BaseSubsetOffset;       //!< 基本LODのサブセットデータの開始位置です.
+    u32     BaseSize;               //!< 最初のフレームの描画に必要な先頭部分のサイズです.
+    u32     Reserved;               //!< 予約領域です.
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StreamingChunk structure
+//////////////////////////////////////////////////////////////////////////////////////
+struct StreamingChunk
+{
+    f32     Min[ 3 ];               //!< AABBの最小値です.
+    f32     Max[ 3 ];               //!< AABBの最大値です.
+    f32     BaseError;              //!< 基本LODの元のメッシュからの誤差です(メッシュのローカル座標系での距離).
+    u32     BaseSubsetOffset;       //!< 基本LODの先頭のサブセット番号です.
+    u32     BaseSubsetCount;        //!< 基本LODのサブセット数です.
+    u32     BlockOffset;            //!< 詳細化ブロックの開始位置です.
+    u32     BlockSize;              //!< 詳細化ブロックのサイズです.
+    u32     VertexCount;            //!< 詳細化ブロックの頂点数です.
+    u32     IndexCount;             //!< 詳細化ブロックの頂点インデックス数です.
+    u32     SubsetCount;            //!< 詳細化ブロックのサブセット数です.
+    u32     Reserved[ 2 ];          //!< 予約領域です.
+};
+
+// ファイルの先頭から BaseSize までにヘッダ・マテリアル・文字列テーブル・チャンク・基本LODを格納し,
+// その後ろにチャンクごとの詳細化ブロックを並べる. 基本LODの頂点インデックスは基本LODの頂点データ全体に対する番号.
+// 詳細化ブロックは MshVertex x VertexCount, u32 x IndexCount, MshSubset x SubsetCount を
+// SMSH_ALIGNMENT に揃えて続けたもので, 頂点インデックスとサブセットのオフセットはブロック内の相対値.
+
+#endif//__STREAMING_MESH_FORMAT_H__
@@ -0,0 +1,125 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StringTable.h
+// Desc : Interned String Table Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __STRING_TABLE_H__
+#define __STRING_TABLE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// StringTable class
+//////////////////////////////////////////////////////////////////////////////////////
+class StringTable
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+    static const u32 INVALID_ID = 0xffffffff;      //!< 文字列が無いことを表すIDです.
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    StringTable();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~StringTable();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コピーコンストラクタです.
+    //-------------------------------------------------------------------------------
+    StringTable( const StringTable& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      代入演算子です.
+    //-------------------------------------------------------------------------------
+    StringTable& operator = ( const StringTable& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列を登録します.
+    //!
+    //! @param [in]     value       登録する文字列です.
+    //! @return     文字列のIDを返却します. 同じ文字列には常に同じIDを返却します.
+    //!             nullptr または空文字列の場合は INVALID_ID を返却します.
+    //-------------------------------------------------------------------------------
+    u32 Intern( const char* value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      長さを指定して文字列を登録します.
+    //!
+    //! @param [in]     value       登録する文字列です(終端文字は不要です).
+    //! @param [in]     length      文字列の長さです.
+    //! @return     文字列のIDを返却します.
+    //-------------------------------------------------------------------------------
+    u32 Intern( const char* value, u32 length );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      登録済みの文字列を検索します.
+    //!
+    //! @return     文字列のIDを返却します. 見つからない場合は INVALID_ID を返却します.
+    //-------------------------------------------------------------------------------
+    u32 Find( const char* value ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列を取得します.
+    //!
+    //! @return     IDに対応する文字列を返却します. INVALID_ID の場合は空文字列です.
+    //-------------------------------------------------------------------------------
+    const char* GetString( u32 id ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      登録されている文字列数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列の格納に使っているバイト数を取得します(終端文字を含みます).
+    //-------------------------------------------------------------------------------
+    u32 GetByteSize() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全ての文字列を破棄します.
+    //-------------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( StringTable& value );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< char >     m_Chars;        //!< 全ての文字列を終端文字付きで詰めたものです.
+    std::vector< u32 >      m_Offsets;      //!< 文字列ごとの m_Chars 上の開始位置です.
+    std::vector< u32 >      m_Hashes;       //!< 文字列ごとのハッシュ値です.
+    std::vector< u32 >      m_Slots;        //!< ハッシュテーブルです(ID + 1, 0 は空き).
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    u32  FindSlot( const char* value, u32 length, u32 hash ) const;
+    void Rehash  ( u32 slotCount );
+};
+
+#endif//__STRING_TABLE_H__
@@ -0,0 +1,110 @@
+﻿//-----------------------------------------------------------------------------------
+// File : SubsetBatcher.h
+// Desc : Material Sorted Subset Batcher Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __SUBSET_BATCHER_H__
+#define __SUBSET_BATCHER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <MshFormat.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// SubsetBatcher class
+//////////////////////////////////////////////////////////////////////////////////////
+class SubsetBatcher
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     SubsetCountBefore;      //!< 結合前のサブセット数です.
+        u32     SubsetCountAfter;       //!< 結合後のサブセット数です.
+        u32     MaterialChangesBefore;  //!< 並び替え前のマテリアルの切り替え回数です.
+        u32     MaterialChangesAfter;   //!< 並び替え後のマテリアルの切り替え回数です.
+
+        Statistics()
+        : SubsetCountBefore     ( 0 )
+        , SubsetCountAfter      ( 0 )
+        , MaterialChangesBefore ( 0 )
+        , MaterialChangesAfter  ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      サブセットをマテリアル順に並び替えて結合します.
+    //!
+    //! @param [in,out] indices     頂点インデックスです.
+    //! @param [in,out] subsets     サブセットです.
+    //! @param [out]    pStats      統計情報です(nullptrの場合は出力しません).
+    //! @note       同じマテリアルのサブセットが連続したインデックス範囲になるように
+    //!             頂点インデックスを並べ直し, 1つのサブセットにまとめます.
+    //!             同じマテリアル内ではファイルでの順番を保ちます.
+    //!             どのサブセットからも参照されない頂点インデックスは取り除かれます.
+    //-------------------------------------------------------------------------------
+    static void SortAndMerge(
+        std::vector< u32 >&         indices,
+        std::vector< MshSubset >&   subsets,
+        Statistics*                 pStats = nullptr );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアル順の描画順を求めます.
+    //!
+    //! @param [in]     pSubsets        サブセットです.
+    //! @param [in]     subsetCount     サブセット数です.
+    //! @param [out]    order           描画するサブセット番号の並びです.
+    //! @note       頂点インデックスを並べ直せない場合に, 描画順だけをマテリアル順にします.
+    //-------------------------------------------------------------------------------
+    static void ComputeDrawOrder(
+        const MshSubset*            pSubsets,
+        u32                         subsetCount,
+        std::vector< u32 >&         order );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      マテリアルの切り替え回数を求めます.
+    //!
+    //! @param [in]     pSubsets        サブセットです.
+    //! @param [in]     pOrder          描画順です(nullptrの場合はサブセットの並び順).
+    //! @param [in]     subsetCount     サブセット数です.
+    //! @return     直前と同じマテリアルの設定を省いた場合の切り替え回数を返却します.
+    //-------------------------------------------------------------------------------
+    static u32 CountMaterialChanges(
+        const MshSubset*            pSubsets,
+        const u32*                  pOrder,
+        u32                         subsetCount );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    SubsetBatcher   ();                         // アクセス禁止.
+    SubsetBatcher   ( const SubsetBatcher& );   // アクセス禁止.
+    void operator = ( const SubsetBatcher& );   // アクセス禁止.
+};
+
+#endif//__SUBSET_BATCHER_H__
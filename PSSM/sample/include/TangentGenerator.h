@@ -0,0 +1,89 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TangentGenerator.h
+// Desc : Tangent Frame Generator Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __TANGENT_GENERATOR_H__
+#define __TANGENT_GENERATOR_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <MshFormat.h>
+#include <ThreadPool.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// TangentGenerator class
+//////////////////////////////////////////////////////////////////////////////////////
+class TangentGenerator
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     TriangleCount;          //!< 三角形数です.
+        u32     DegenerateTriangles;    //!< テクスチャ座標が縮退していた三角形数です.
+        u32     SplitVertices;          //!< 表裏の向きが混在していたため分割した頂点数です.
+        u32     FallbackVertices;       //!< 接ベクトルが求まらず法線から決めた頂点数です.
+
+        Statistics()
+        : TriangleCount         ( 0 )
+        , DegenerateTriangles   ( 0 )
+        , SplitVertices         ( 0 )
+        , FallbackVertices      ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      接ベクトルを生成します.
+    //!
+    //! @param [in,out] vertices    頂点データです.
+    //! @param [in,out] indices     頂点インデックスです.
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @param [out]    pStats      統計情報です(nullptrの場合は出力しません).
+    //! @note       MikkTSpace と同じく, 三角形ごとの接ベクトルを頂点の法線に垂直な平面に射影し,
+    //!             角の大きさで重み付けして頂点ごとに合計します. 頂点の共有は頂点番号で判定するので,
+    //!             先に VertexWelder で重複する頂点を結合しておきます.
+    //!             テクスチャ座標の向きが反転した三角形とそうでない三角形が共有する頂点は,
+    //!             MikkTSpace と同様に別の頂点に分割します. 分割した頂点は末尾に追加されます.
+    //!             頂点フォーマットに従接ベクトルの符号が無いため, 従接ベクトルは法線と接ベクトルの外積になります.
+    //-------------------------------------------------------------------------------
+    static void Generate(
+        std::vector< MshVertex >&   vertices,
+        std::vector< u32 >&         indices,
+        ThreadPool*                 pPool  = nullptr,
+        Statistics*                 pStats = nullptr );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    TangentGenerator();                             // アクセス禁止.
+    TangentGenerator( const TangentGenerator& );    // アクセス禁止.
+    void operator = ( const TangentGenerator& );    // アクセス禁止.
+};
+
+#endif//__TANGENT_GENERATOR_H__
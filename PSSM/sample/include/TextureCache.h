@@ -0,0 +1,163 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TextureCache.h
+// Desc : Texture Cache Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTexture.h>
+#include <StringTable.h>
+#include <ThreadPool.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// TextureCache class
+//////////////////////////////////////////////////////////////////////////////////////
+class TextureCache
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // DUMMY_TYPE enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum DUMMY_TYPE
+    {
+        DUMMY_DIFFUSE = 0,      //!< ディフューズマップの代わりです.
+        DUMMY_SPECULAR,         //!< スペキュラーマップの代わりです.
+        DUMMY_BUMP,             //!< 凹凸マップの代わりです.
+        NUM_DUMMY_TYPE          //!< 種類数です.
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    TextureCache();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~TextureCache();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     pDevice             デバイスです.
+    //! @param [in]     resFolderPath       テクスチャを読み込むフォルダです.
+    //! @param [in]     dummyFolderPath     ダミーテクスチャのあるフォルダです.
+    //! @param [in]     pPool               ファイルの読み込みを並列に行うスレッドプールです(nullptrの場合は逐次).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       ダミーテクスチャはここで読み込んでおきます.
+    //-------------------------------------------------------------------------------
+    bool Init( ID3D11Device* pDevice, const char* resFolderPath, const char* dummyFolderPath, ThreadPool* pPool = nullptr );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列IDに対応するテクスチャを取得します.
+    //!
+    //! @param [in]     strings     IDを発行した文字列テーブルです.
+    //! @param [in]     id          テクスチャ名の文字列IDです.
+    //! @param [in]     fallback    テクスチャが無い場合に使うダミーの種類です.
+    //! @return     シェーダリソースビューを返却します.
+    //! @note       同じIDは初回だけ読み込み, 以降は読み込み済みのものを返却します.
+    //!             読み込みに失敗したIDも記録しておき, 何度もファイルを探さないようにします.
+    //!             キャッシュは1つの文字列テーブルのIDに対して使います.
+    //-------------------------------------------------------------------------------
+    ID3D11ShaderResourceView* Resolve( const StringTable& strings, u32 id, DUMMY_TYPE fallback );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      文字列IDに対応するテクスチャをまとめて読み込んでおきます.
+    //!
+    //! @param [in]     strings     IDを発行した文字列テーブルです.
+    //! @param [in]     pIds        テクスチャ名の文字列IDです(INVALID_ID や重複を含んでも構いません).
+    //! @param [in]     count       IDの数です.
+    //! @param [in]     pPool       ファイルの読み込みを並列に行うスレッドプールです(nullptrの場合は逐次).
+    //! @note       ファイルの読み込みと解析はスレッドプールで並列に行い,
+    //!             テクスチャの生成だけを呼び出しスレッドで行います.
+    //!             以降の Resolve() は読み込み済みのものを返却するだけになります.
+    //!             別のスレッドが同じファイルを読み込み中の場合は, その読み込みが終わるまで待ちます.
+    //-------------------------------------------------------------------------------
+    void Prefetch( const StringTable& strings, const u32* pIds, u32 count, ThreadPool* pPool );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      読み込んだテクスチャ数を取得します(ダミーを除きます).
+    //-------------------------------------------------------------------------------
+    u32 GetLoadedCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      Resolve() の呼び出し回数を取得します.
+    //-------------------------------------------------------------------------------
+    u32 GetRequestCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      内容を交換します.
+    //-------------------------------------------------------------------------------
+    void Swap( TextureCache& value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全てのキャッシュで共有しているテクスチャ数を取得します(ダミーを含みます).
+    //-------------------------------------------------------------------------------
+    static u32 GetSharedCount();
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    struct SharedTexture;
+    struct Registry;
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        SharedTexture*      pTexture;       //!< 共有テクスチャです(まだ読み込んでいない場合はnullptr).
+        bool                IsResolved;     //!< 読み込みを試したかどうか.
+    };
+
+    ID3D11Device*           m_pDevice;                      //!< デバイスです.
+    std::string             m_ResFolderPath;                //!< テクスチャを読み込むフォルダです.
+    std::vector< Entry >    m_Entries;                      //!< 文字列IDごとのテクスチャです.
+    SharedTexture*          m_pDummy[ NUM_DUMMY_TYPE ];     //!< ダミーテクスチャです.
+    u32                     m_LoadedCount;                  //!< 読み込んだテクスチャ数です.
+    u32                     m_RequestCount;                 //!< Resolve() の呼び出し回数です.
+
+    static Registry         s_Registry;                     //!< 全てのキャッシュで共有するテクスチャの登録先です.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    static void Acquire( ID3D11Device* pDevice, const std::vector< std::string >& paths, ThreadPool* pPool, SharedTexture** ppResults );
+    static void Load( ID3D11Device* pDevice, const std::vector< SharedTexture* >& created, ThreadPool* pPool );
+    static void Release( SharedTexture* pTexture );
+    static ID3D11ShaderResourceView* GetSRV( const SharedTexture* pTexture );
+
+    TextureCache    ( const TextureCache& );    // アクセス禁止.
+    void operator = ( const TextureCache& );    // アクセス禁止.
+};
+
+#endif//__TEXTURE_CACHE_H__
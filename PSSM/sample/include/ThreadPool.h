@@ -0,0 +1,167 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ThreadPool.h
+// Desc : Thread Pool Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <asdxTypedef.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool class
+//////////////////////////////////////////////////////////////////////////////////////
+class ThreadPool
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // Type definition.
+    //================================================================================
+    typedef std::function< void() >                 Job;        //!< ジョブです.
+    typedef std::function< void( u32, u32, u32 ) >  RangeJob;   //!< 範囲ジョブです(開始, 終了, スロット番号).
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    ThreadPool();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~ThreadPool();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      初期化処理です.
+    //!
+    //! @param [in]     threadCount     ワーカースレッド数です(0の場合はハードウェアスレッド数-1).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------------
+    bool Init( u32 threadCount = 0 );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      終了処理です.
+    //!
+    //! @note       キューに残っているジョブは全て実行してから終了します.
+    //-------------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ジョブを追加します.
+    //!
+    //! @param [in]     job         実行するジョブです.
+    //! @note       ワーカースレッドが無い場合は呼び出しスレッドで即座に実行します.
+    //-------------------------------------------------------------------------------
+    void Push( const Job& job );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      全てのジョブの完了を待機します.
+    //-------------------------------------------------------------------------------
+    void Wait();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      範囲を分割して並列実行します.
+    //!
+    //! @param [in]     count       要素数です.
+    //! @param [in]     grain       1ジョブあたりの最小要素数です.
+    //! @param [in]     job         実行する範囲ジョブです.
+    //! @note       呼び出しスレッドもジョブを処理するため, ジョブ内から呼び出しても
+    //!             デッドロックしません. スロット番号は GetSlotCount() 未満の値で,
+    //!             同時に実行される範囲ジョブ同士で重複しません.
+    //-------------------------------------------------------------------------------
+    void ParallelFor( u32 count, u32 grain, const RangeJob& job );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ワーカースレッド数を取得します.
+    //!
+    //! @return     ワーカースレッド数を返却します.
+    //-------------------------------------------------------------------------------
+    u32 GetThreadCount() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ParallelFor() で渡されるスロット番号の最大数を取得します.
+    //!
+    //! @return     スロット数を返却します.
+    //-------------------------------------------------------------------------------
+    u32 GetSlotCount( u32 count, u32 grain ) const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      スレッドプールがあれば並列に, 無ければ呼び出しスレッドで範囲ジョブを実行します.
+    //!
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @param [in]     count       要素数です.
+    //! @param [in]     grain       1ジョブあたりの最小要素数です.
+    //! @param [in]     job         実行する範囲ジョブです.
+    //! @note       スレッドプールが無い場合は, 全範囲をスロット番号0で1回だけ呼び出します.
+    //-------------------------------------------------------------------------------
+    static void RunRange( ThreadPool* pPool, u32 count, u32 grain, const RangeJob& job );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      RunRange() で渡されるスロット番号の最大数を取得します.
+    //!
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は1を返します).
+    //! @param [in]     count       要素数です.
+    //! @param [in]     grain       1ジョブあたりの最小要素数です.
+    //! @return     スロット数を返却します.
+    //-------------------------------------------------------------------------------
+    static u32 GetRangeSlotCount( ThreadPool* pPool, u32 count, u32 grain );
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    /* NOTHING */
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    std::vector< std::thread >  m_Threads;          //!< ワーカースレッドです.
+    std::deque< Job >           m_Queue;            //!< ジョブキューです.
+    std::mutex                  m_Mutex;            //!< ミューテックスです.
+    std::condition_variable     m_WakeCond;         //!< ワーカー起床用の条件変数です.
+    std::condition_variable     m_DoneCond;         //!< 完了通知用の条件変数です.
+    u32                         m_BusyCount;        //!< 実行中のジョブ数です.
+    bool                        m_IsTerm;           //!< 終了フラグです.
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    void WorkerMain();
+    bool TryRunOne( std::unique_lock< std::mutex >& lock );
+
+    ThreadPool      ( const ThreadPool& );      // アクセス禁止.
+    void operator = ( const ThreadPool& );      // アクセス禁止.
+};
+
+#endif//__THREAD_POOL_H__
@@ -0,0 +1,106 @@
+﻿//-----------------------------------------------------------------------------------
+// File : VertexWelder.h
+// Desc : Vertex Welder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __VERTEX_WELDER_H__
+#define __VERTEX_WELDER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <MshFormat.h>
+#include <ThreadPool.h>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// VertexWelder class
+//////////////////////////////////////////////////////////////////////////////////////
+class VertexWelder
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Config structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Config
+    {
+        f32     PositionTolerance;  //!< 位置座標の許容誤差です(各成分の差の最大値).
+        f32     NormalTolerance;    //!< 法線・接ベクトルの許容誤差です(なす角の余弦の下限).
+        f32     TexCoordTolerance;  //!< テクスチャ座標の許容誤差です(各成分の差の最大値).
+
+        Config()
+        : PositionTolerance ( 1e-5f )
+        , NormalTolerance   ( 0.999f )
+        , TexCoordTolerance ( 1e-5f )
+        { /* DO_NOTHING */ }
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     VertexCountBefore;  //!< 結合前の頂点数です.
+        u32     VertexCountAfter;   //!< 結合後の頂点数です.
+        u32     BucketCount;        //!< ハッシュテーブルのバケット数です.
+        u32     MaxBucketSize;      //!< バケットあたりの最大頂点数です.
+
+        Statistics()
+        : VertexCountBefore ( 0 )
+        , VertexCountAfter  ( 0 )
+        , BucketCount       ( 0 )
+        , MaxBucketSize     ( 0 )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      重複する頂点を結合します.
+    //!
+    //! @param [in,out] vertices    頂点データです.
+    //! @param [in,out] indices     頂点インデックスです.
+    //! @param [in]     config      設定です.
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @param [out]    pStats      統計情報です(nullptrの場合は出力しません).
+    //! @note       位置座標を許容誤差の4倍の大きさのグリッドに量子化したハッシュでバケットに分け,
+    //!             各軸で近い側の隣のセルまで含めた最大8つのバケットと並列に比較します.
+    //!             セルの境界をまたいでいても, 許容誤差内の頂点は結合されます.
+    //!             結合した頂点は番号の最も小さい頂点の属性を使い, 頂点の順番は元の順番を保ちます.
+    //!             接ベクトルは両方に設定されている場合だけ比較し, 片方だけの場合は別の頂点とみなします.
+    //-------------------------------------------------------------------------------
+    static void Weld(
+        std::vector< MshVertex >&   vertices,
+        std::vector< u32 >&         indices,
+        const Config&               config,
+        ThreadPool*                 pPool  = nullptr,
+        Statistics*                 pStats = nullptr );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    VertexWelder    ();                         // アクセス禁止.
+    VertexWelder    ( const VertexWelder& );    // アクセス禁止.
+    void operator = ( const VertexWelder& );    // アクセス禁止.
+};
+
+#endif//__VERTEX_WELDER_H__
@@ -7,6 +7,10 @@
 // ~ł.
 #define PI          3.1415926535f
 
+// JobWŃJXP[hIۂɏOVhE}bv̉̕(eNX`W)ł.
+// CPUōׂJXP[ḧ̗(2eNZ)ĂKv܂.
+#define SHADOW_MAP_BORDER   ( 1.5f / 1024.0f )
+
 //////////////////////////////////////////////////////////////////////////////////////////
 // VSOutput structure
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -97,9 +101,24 @@ float3 NormalizedPhong( float3 specular, float power, float3 viewDir, float3 nor
 
 
 //------------------------------------------------------------------------------------------------
-//! @brief      sNZVF[_̃Gg[|Cgł.
+//! @brief      VhE}bv͈͓̔ǂ肵܂.
+//!
+//! @param [in]     coord       VhE}bṽeNX`Wł.
+//! @return     ͈͓łtrueԋp܂.
 //------------------------------------------------------------------------------------------------
-PSOutput PSFunc( VSOutput input )
+bool IsInsideShadowMap( float2 coord )
+{
+    return all( coord > SHADOW_MAP_BORDER ) && all( coord < 1.0f - SHADOW_MAP_BORDER );
+}
+
+//------------------------------------------------------------------------------------------------
+//! @brief      tH[hVF[fBOs܂.
+//!
+//! @param [in]     input               _VF[_̓͂ł.
+//! @param [in]     selectByCoverage    VhE}bv͈̔͂ŃJXP[hIꍇtrue.
+//! @return     VF[fBOʂԋp܂.
+//------------------------------------------------------------------------------------------------
+PSOutput Shade( VSOutput input, bool selectByCoverage )
 {
     PSOutput output = (PSOutput)0;
 
@@ -119,38 +138,72 @@ PSOutput PSFunc( VSOutput input )
     // esNZʒu܂ł̋.
     float dist = input.Position.w;  // r[ԂłZW.
 
-    //int index = 0;
-    if ( dist < input.SplitPos.x )
+    if ( selectByCoverage )
     {
-        //index = 0;
-        float2 coord = input.SdwCoord[0].xy / input.SdwCoord[0].w;
-        float  depth = input.SdwCoord[0].z  / input.SdwCoord[0].w;
-        sdwThreshold = ShadowMap0.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
-        sdwThreshold = saturate( sdwThreshold + sdwColor );
-    }
-    else if ( dist < input.SplitPos.y )
-    {
-        //index = 1;
-        float2 coord = input.SdwCoord[1].xy / input.SdwCoord[1].w;
-        float  depth = input.SdwCoord[1].z  / input.SdwCoord[1].w;
-        sdwThreshold = ShadowMap1.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
-        sdwThreshold = saturate( sdwThreshold + sdwColor );
-    }
-    else if ( dist < input.SplitPos.z )
-    {
-        //index = 2;
-        float2 coord = input.SdwCoord[2].xy / input.SdwCoord[2].w;
-        float  depth = input.SdwCoord[2].z  / input.SdwCoord[2].w;
-        sdwThreshold = ShadowMap2.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+        // ׂJXP[h珇, VhE}bv͈̔͂Ɏ܂̂I.
+        // eJXP[hׂ͍JXP[ḧ`悵ĂȂ, ł͑IłȂ.
+        float2 coord0 = input.SdwCoord[0].xy / input.SdwCoord[0].w;
+        float2 coord1 = input.SdwCoord[1].xy / input.SdwCoord[1].w;
+        float2 coord2 = input.SdwCoord[2].xy / input.SdwCoord[2].w;
+
+        if ( IsInsideShadowMap( coord0 ) )
+        {
+            float depth = input.SdwCoord[0].z / input.SdwCoord[0].w;
+            sdwThreshold = ShadowMap0.SampleCmpLevelZero( ShadowSmp, coord0, depth - sdwBias );
+        }
+        else if ( IsInsideShadowMap( coord1 ) )
+        {
+            float depth = input.SdwCoord[1].z / input.SdwCoord[1].w;
+            sdwThreshold = ShadowMap1.SampleCmpLevelZero( ShadowSmp, coord1, depth - sdwBias );
+        }
+        else if ( IsInsideShadowMap( coord2 ) )
+        {
+            float depth = input.SdwCoord[2].z / input.SdwCoord[2].w;
+            sdwThreshold = ShadowMap2.SampleCmpLevelZero( ShadowSmp, coord2, depth - sdwBias );
+        }
+        else
+        {
+            float2 coord = input.SdwCoord[3].xy / input.SdwCoord[3].w;
+            float  depth = input.SdwCoord[3].z  / input.SdwCoord[3].w;
+            sdwThreshold = ShadowMap3.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+        }
         sdwThreshold = saturate( sdwThreshold + sdwColor );
     }
     else
     {
-        //index = 3;
-        float2 coord = input.SdwCoord[3].xy / input.SdwCoord[3].w;
-        float  depth = input.SdwCoord[3].z  / input.SdwCoord[3].w;
-        sdwThreshold = ShadowMap3.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
-        sdwThreshold = saturate( sdwThreshold + sdwColor );
+        //int index = 0;
+        if ( dist < input.SplitPos.x )
+        {
+            //index = 0;
+            float2 coord = input.SdwCoord[0].xy / input.SdwCoord[0].w;
+            float  depth = input.SdwCoord[0].z  / input.SdwCoord[0].w;
+            sdwThreshold = ShadowMap0.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+            sdwThreshold = saturate( sdwThreshold + sdwColor );
+        }
+        else if ( dist < input.SplitPos.y )
+        {
+            //index = 1;
+            float2 coord = input.SdwCoord[1].xy / input.SdwCoord[1].w;
+            float  depth = input.SdwCoord[1].z  / input.SdwCoord[1].w;
+            sdwThreshold = ShadowMap1.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+            sdwThreshold = saturate( sdwThreshold + sdwColor );
+        }
+        else if ( dist < input.SplitPos.z )
+        {
+            //index = 2;
+            float2 coord = input.SdwCoord[2].xy / input.SdwCoord[2].w;
+            float  depth = input.SdwCoord[2].z  / input.SdwCoord[2].w;
+            sdwThreshold = ShadowMap2.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+            sdwThreshold = saturate( sdwThreshold + sdwColor );
+        }
+        else
+        {
+            //index = 3;
+            float2 coord = input.SdwCoord[3].xy / input.SdwCoord[3].w;
+            float  depth = input.SdwCoord[3].z  / input.SdwCoord[3].w;
+            sdwThreshold = ShadowMap3.SampleCmpLevelZero( ShadowSmp, coord, depth - sdwBias );
+            sdwThreshold = saturate( sdwThreshold + sdwColor );
+        }
     }
 
     // XyL[}bvtFb`.
@@ -180,4 +233,20 @@ PSOutput PSFunc( VSOutput input )
     }
 
     return output;
+}
+
+//------------------------------------------------------------------------------------------------
+//! @brief      sNZVF[_̃Gg[|Cgł.
+//------------------------------------------------------------------------------------------------
+PSOutput PSFunc( VSOutput input )
+{
+    return Shade( input, false );
+}
+
+//------------------------------------------------------------------------------------------------
+//! @brief      VhE}bv͈̔͂ŃJXP[hIsNZVF[_̃Gg[|Cgł.
+//------------------------------------------------------------------------------------------------
+PSOutput PSFuncCoverage( VSOutput input )
+{
+    return Shade( input, true );
 }
\ No newline at end of file
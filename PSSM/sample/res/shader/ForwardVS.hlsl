@@ -15,6 +15,27 @@ struct VSInput
     float2  TexCoord    : TEXCOORD;         //!< eNX`Wł.
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////
+// VSInputPacked structure
+///////////////////////////////////////////////////////////////////////////////////////////
+struct VSInputPacked
+{
+    float4  Position    : POSITION;         //!< AABBŐKʒuW(xyz)Ə]@̕(w)ł.
+    float2  Normal      : NORMAL;           //!< ʑ̃GR[h@xNgł.
+    float2  Tangent     : TANGENT;          //!< ʑ̃GR[hڃxNgł.
+    float2  TexCoord    : TEXCOORD;         //!< eNX`Wł.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// VSInstance structure
+///////////////////////////////////////////////////////////////////////////////////////////
+struct VSInstance
+{
+    float4  World0      : INSTANCE_WORLD0;  //!< [hsX߂sł.
+    float4  World1      : INSTANCE_WORLD1;  //!< [hsY߂sł.
+    float4  World2      : INSTANCE_WORLD2;  //!< [hsZ߂sł.
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 // VSOutput structure
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -49,14 +70,39 @@ cbuffer CBMatrix : register( b1 )
 
 
 //-----------------------------------------------------------------------------------------
-//! @brief      _VF[_CGg[|Cg.
+//! @brief      ʑ̃GR[hꂽPʃxNgfR[h܂.
 //-----------------------------------------------------------------------------------------
-VSOutput VSFunc( VSInput input )
+float3 DecodeOctahedral( float2 value )
+{
+    float3 n = float3( value.x, value.y, 1.0f - abs( value.x ) - abs( value.y ) );
+    float  t = saturate( -n.z );
+    n.x += ( n.x >= 0.0f ) ? -t : t;
+    n.y += ( n.y >= 0.0f ) ? -t : t;
+    return normalize( n );
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      kꂽ_WJ܂.
+//!
+//! @note       ʒuW̋tʎq̓[hsɊ܂߂Ă܂.
+//-----------------------------------------------------------------------------------------
+VSInput UnpackVertex( VSInputPacked input )
+{
+    VSInput output;
+    output.Position = input.Position.xyz;
+    output.Normal   = DecodeOctahedral( input.Normal );
+    output.Tangent  = DecodeOctahedral( input.Tangent );
+    output.TexCoord = input.TexCoord;
+    return output;
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      [hԂ̈ʒuWo͂߂܂.
+//-----------------------------------------------------------------------------------------
+VSOutput ComputeOutput( float4 worldPos, float3 normal, float2 texcoord )
 {
     VSOutput output = (VSOutput)0;
 
-    float4 localPos = float4( input.Position, 1.0f );
-    float4 worldPos = mul( World, localPos );
     float4 viewPos  = mul( View,  worldPos );
     float4 projPos  = mul( Proj,  viewPos );
 
@@ -64,8 +110,8 @@ VSOutput VSFunc( VSInput input )
     output.WorldPos = worldPos;
     output.LightDir = -LightDir.xyz;
 
-    output.Normal   = input.Normal;
-    output.TexCoord = input.TexCoord;
+    output.Normal   = normal;
+    output.TexCoord = texcoord;
 
     output.CameraPos = CameraPos.xyz;
 
@@ -77,4 +123,76 @@ VSOutput VSFunc( VSInput input )
     output.SdwCoord[3] = mul( Shadow3, worldPos );
 
     return output;
-}
\ No newline at end of file
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      CX^X̃[hsKp܂.
+//-----------------------------------------------------------------------------------------
+float4 ApplyInstance( VSInstance instance, float4 localPos )
+{
+    return float4(
+        dot( instance.World0, localPos ),
+        dot( instance.World1, localPos ),
+        dot( instance.World2, localPos ),
+        1.0f );
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      CX^X̃[hs̋t]usŖ@xNgϊ܂.
+//!
+//! @note       t]us̑ɗ]qsĝ, ʂ͐KĂ܂.
+//!             ϊ̏ꍇ\ɂȂ悤, s񎮂̕|܂.
+//-----------------------------------------------------------------------------------------
+float3 TransformNormal( VSInstance instance, float3 normal )
+{
+    // [hs̗xNg.
+    float3 c0 = float3( instance.World0.x, instance.World1.x, instance.World2.x );
+    float3 c1 = float3( instance.World0.y, instance.World1.y, instance.World2.y );
+    float3 c2 = float3( instance.World0.z, instance.World1.z, instance.World2.z );
+
+    float3 x = cross( c1, c2 );
+    float3 y = cross( c2, c0 );
+    float3 z = cross( c0, c1 );
+    float  s = ( dot( c0, x ) < 0.0f ) ? -1.0f : 1.0f;
+
+    return ( x * normal.x + y * normal.y + z * normal.z ) * s;
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_CGg[|Cg.
+//-----------------------------------------------------------------------------------------
+VSOutput VSFunc( VSInput input )
+{
+    float4 localPos = float4( input.Position, 1.0f );
+    float4 worldPos = mul( World, localPos );
+
+    return ComputeOutput( worldPos, input.Normal, input.TexCoord );
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(k_p).
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncPacked( VSInputPacked input )
+{ return VSFunc( UnpackVertex( input ) ); }
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(CX^X`p).
+//!
+//! @note       萔obt@̃[hs, CX^X̃[hsOɊ|܂.
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncInstanced( VSInput input, VSInstance instance )
+{
+    float4 localPos = mul( World, float4( input.Position, 1.0f ) );
+    float4 worldPos = ApplyInstance( instance, localPos );
+
+    // gksψł@ʂɐɂȂ悤, t]usŕϊ.
+    float3 normal = normalize( TransformNormal( instance, input.Normal ) );
+
+    return ComputeOutput( worldPos, normal, input.TexCoord );
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(k_ECX^X`p).
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncPackedInstanced( VSInputPacked input, VSInstance instance )
+{ return VSFuncInstanced( UnpackVertex( input ), instance ); }
@@ -10,9 +10,24 @@
 struct VSInput
 {
     float3  Position    : POSITION;         //!< ʒuWł([JWn).
-    float3  Normal      : NORMAL;           //!< @xNgł([JWn).
-    float3  Tangent     : TANGENT;          //!< ڃxNgł([JWn).
-    float2  TexCoord    : TEXCOORD;         //!< eNX`Wł.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// VSInputPacked structure
+///////////////////////////////////////////////////////////////////////////////////////////
+struct VSInputPacked
+{
+    float4  Position    : POSITION;         //!< AABBŐKʒuW(xyz)Ə]@̕(w)ł.
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// VSInstance structure
+///////////////////////////////////////////////////////////////////////////////////////////
+struct VSInstance
+{
+    float4  World0      : INSTANCE_WORLD0;  //!< [hsX߂sł.
+    float4  World1      : INSTANCE_WORLD1;  //!< [hsY߂sł.
+    float4  World2      : INSTANCE_WORLD2;  //!< [hsZ߂sł.
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -49,4 +64,68 @@ VSOutput VSFunc( VSInput input )
     return output;
 }
 
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(k_p).
+//!
+//! @note       ʒuW̋tʎq̓[hsɊ܂߂Ă܂.
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncPacked( VSInputPacked input )
+{
+    VSOutput output = (VSOutput)0;
+
+    float4 localPos    = float4( input.Position.xyz, 1.0f );
+    float4 worldPos    = mul( World,    localPos );
+    float4 viewProjPos = mul( ViewProj, worldPos );
+
+    output.Position = viewProjPos;
+
+    return output;
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      CX^X̃[hsKp܂.
+//-----------------------------------------------------------------------------------------
+float4 ApplyInstance( VSInstance instance, float4 localPos )
+{
+    return float4(
+        dot( instance.World0, localPos ),
+        dot( instance.World1, localPos ),
+        dot( instance.World2, localPos ),
+        1.0f );
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(CX^X`p).
+//!
+//! @note       萔obt@̃[hs, CX^X̃[hsOɊ|܂.
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncInstanced( VSInput input, VSInstance instance )
+{
+    VSOutput output = (VSOutput)0;
+
+    float4 localPos    = mul( World, float4( input.Position, 1.0f ) );
+    float4 worldPos    = ApplyInstance( instance, localPos );
+    float4 viewProjPos = mul( ViewProj, worldPos );
+
+    output.Position = viewProjPos;
+
+    return output;
+}
+
+//-----------------------------------------------------------------------------------------
+//! @brief      _VF[_Gg[|Cgł(k_ECX^X`p).
+//-----------------------------------------------------------------------------------------
+VSOutput VSFuncPackedInstanced( VSInputPacked input, VSInstance instance )
+{
+    VSOutput output = (VSOutput)0;
+
+    float4 localPos    = mul( World, float4( input.Position.xyz, 1.0f ) );
+    float4 worldPos    = ApplyInstance( instance, localPos );
+    float4 viewProjPos = mul( ViewProj, worldPos );
+
+    output.Position = viewProjPos;
+
+    return output;
+}
+
 /* ̒_VF[_ɑΉsNZVF[_͂܂.*/
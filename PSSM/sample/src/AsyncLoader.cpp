@@ -0,0 +1,452 @@
+﻿//-----------------------------------------------------------------------------------
+// File : AsyncLoader.cpp
+// Desc : Asynchronous Loader Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <AsyncLoader.h>
+#include <asdxLog.h>
+#include <algorithm>
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// AsyncLoader::Future class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+AsyncLoader::Future::Future()
+: m_Request()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      引数付きコンストラクタです.
+//-----------------------------------------------------------------------------------
+AsyncLoader::Future::Future( const std::shared_ptr< Request >& request )
+: m_Request( request )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      要求に対応しているかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::Future::IsValid() const
+{ return ( m_Request != nullptr ); }
+
+//-----------------------------------------------------------------------------------
+//      状態を取得します.
+//-----------------------------------------------------------------------------------
+AsyncLoader::STATE AsyncLoader::Future::GetState() const
+{
+    if ( m_Request == nullptr )
+    { return STATE_CANCELED; }
+
+    std::lock_guard< std::mutex > locker( m_Request->Mutex );
+    if ( m_Request->IsCanceled )
+    { return STATE_CANCELED; }
+
+    return m_Request->State;
+}
+
+//-----------------------------------------------------------------------------------
+//      完了・失敗・キャンセルのいずれかで終わったかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::Future::IsDone() const
+{
+    if ( m_Request == nullptr )
+    { return true; }
+
+    std::lock_guard< std::mutex > locker( m_Request->Mutex );
+    return ( m_Request->State >= STATE_COMPLETED );
+}
+
+//-----------------------------------------------------------------------------------
+//      キャンセルされたかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::Future::IsCanceled() const
+{
+    if ( m_Request == nullptr )
+    { return true; }
+
+    std::lock_guard< std::mutex > locker( m_Request->Mutex );
+    return m_Request->IsCanceled;
+}
+
+//-----------------------------------------------------------------------------------
+//      キャンセルします.
+//-----------------------------------------------------------------------------------
+void AsyncLoader::Future::Cancel()
+{
+    if ( m_Request == nullptr )
+    { return; }
+
+    // 終わった要求の結果は変えない.
+    std::lock_guard< std::mutex > locker( m_Request->Mutex );
+    if ( m_Request->State < STATE_COMPLETED )
+    { m_Request->IsCanceled = true; }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// AsyncLoader class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+AsyncLoader::AsyncLoader()
+: m_pPool        ( nullptr )
+, m_Config       ()
+, m_Pending      ()
+, m_Loading      ()
+, m_Loaded       ()
+, m_DispatchCount( 0 )
+, m_Sequence     ( 0 )
+, m_Statistics   ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+AsyncLoader::~AsyncLoader()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::Init( ThreadPool* pPool, const Config& config )
+{
+    Term();
+
+    if ( pPool == nullptr || config.MaxCreatePerUpdate == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pPool  = pPool;
+    m_Config = config;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void AsyncLoader::Term()
+{
+    std::unique_lock< std::mutex > lock( m_Mutex );
+
+    // 読み込み待ちの要求は捨てる. スレッドプールに積んだジョブは空振りして終わる.
+    for( size_t i=0; i<m_Pending.size(); ++i )
+    {
+        std::lock_guard< std::mutex > locker( m_Pending[i]->Mutex );
+        m_Pending[i]->IsCanceled = true;
+        m_Pending[i]->State      = STATE_CANCELED;
+    }
+    m_Pending.clear();
+
+    // 読み込み中の要求は途中で打ち切れるように通知してから, 終わるのを待つ.
+    for( size_t i=0; i<m_Loading.size(); ++i )
+    {
+        std::lock_guard< std::mutex > locker( m_Loading[i]->Mutex );
+        m_Loading[i]->IsCanceled = true;
+    }
+
+    while( m_DispatchCount > 0 )
+    { m_Cond.wait( lock ); }
+
+    for( size_t i=0; i<m_Loaded.size(); ++i )
+    {
+        std::lock_guard< std::mutex > locker( m_Loaded[i]->Mutex );
+        m_Loaded[i]->IsCanceled = true;
+        m_Loaded[i]->State      = STATE_CANCELED;
+    }
+    m_Loaded.clear();
+
+    m_pPool      = nullptr;
+    m_Sequence   = 0;
+    m_Statistics = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込みを要求します.
+//-----------------------------------------------------------------------------------
+AsyncLoader::Future AsyncLoader::Submit( const Desc& desc )
+{
+    RequestPtr request( new Request() );
+    request->Name         = ( desc.pName != nullptr ) ? desc.pName : "";
+    request->Priority     = desc.Priority;
+    request->Sequence     = 0;
+    request->Load         = desc.Load;
+    request->Create       = desc.Create;
+    request->OnComplete   = desc.OnComplete;
+    request->State        = STATE_PENDING;
+    request->IsLoadFailed = false;
+    request->IsCanceled   = false;
+
+    ThreadPool* pPool = nullptr;
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        pPool = m_pPool;
+        if ( pPool == nullptr )
+        {
+            ELOG( "Error : AsyncLoader is not initialized. name = %s", request->Name.c_str() );
+            return Future();
+        }
+
+        request->Sequence = m_Sequence++;
+        m_Pending.push_back( request );
+        std::push_heap( m_Pending.begin(), m_Pending.end(), IsLowerPriority );
+        m_DispatchCount++;
+    }
+
+    // ジョブは要求を直接持たず, 実行された時点で最も優先度の高い要求を取り出す.
+    // ワーカースレッドが無い場合は, ここで読み込みまで済ませる.
+    pPool->Push( [this]() { Dispatch(); } );
+
+    return Future( request );
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込みが済んだ要求の生成処理と完了通知を実行します.
+//-----------------------------------------------------------------------------------
+void AsyncLoader::Update()
+{
+    u32 createCount = 0;
+    for( ;; )
+    {
+        RequestPtr request;
+        {
+            std::lock_guard< std::mutex > locker( m_Mutex );
+            if ( m_Loaded.empty() )
+            { break; }
+
+            // 生成処理はフレーム内の時間を使うので, 1回あたりの数を制限する.
+            // 失敗やキャンセルで生成しない要求は数えない.
+            bool needCreate = false;
+            {
+                const RequestPtr& front = m_Loaded.front();
+                std::lock_guard< std::mutex > requestLocker( front->Mutex );
+                needCreate = ( !front->IsCanceled && !front->IsLoadFailed && front->Create );
+            }
+            if ( needCreate )
+            {
+                if ( createCount >= m_Config.MaxCreatePerUpdate )
+                { break; }
+                createCount++;
+            }
+
+            request = m_Loaded.front();
+            m_Loaded.pop_front();
+        }
+
+        Finish( request );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      要求が終わるまで待機します.
+//-----------------------------------------------------------------------------------
+AsyncLoader::STATE AsyncLoader::Wait( const Future& future )
+{
+    RequestPtr request = future.m_Request;
+    if ( request == nullptr )
+    { return STATE_CANCELED; }
+
+    bool runHere = false;
+    {
+        std::unique_lock< std::mutex > lock( m_Mutex );
+
+        std::vector< RequestPtr >::iterator itr = std::find( m_Pending.begin(), m_Pending.end(), request );
+        if ( itr != m_Pending.end() )
+        {
+            // ワーカースレッドの空きを待たずに, 呼び出しスレッドで読み込む.
+            m_Pending.erase( itr );
+            std::make_heap( m_Pending.begin(), m_Pending.end(), IsLowerPriority );
+
+            std::lock_guard< std::mutex > requestLocker( request->Mutex );
+            if ( request->IsCanceled )
+            { request->State = STATE_LOADED; }
+            else
+            {
+                request->State = STATE_LOADING;
+                m_Loading.push_back( request );
+                runHere = true;
+            }
+        }
+        else
+        {
+            while( std::find( m_Loading.begin(), m_Loading.end(), request ) != m_Loading.end() )
+            { m_Cond.wait( lock ); }
+
+            std::deque< RequestPtr >::iterator loaded = std::find( m_Loaded.begin(), m_Loaded.end(), request );
+            if ( loaded == m_Loaded.end() )
+            {
+                // 既に終わっている.
+                lock.unlock();
+                return future.GetState();
+            }
+            m_Loaded.erase( loaded );
+        }
+    }
+
+    if ( runHere )
+    { RunLoad( request, false ); }
+
+    Finish( request );
+    return future.GetState();
+}
+
+//-----------------------------------------------------------------------------------
+//      全ての要求が終わったかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::IsIdle() const
+{
+    std::lock_guard< std::mutex > locker( m_Mutex );
+    return m_Pending.empty() && m_Loading.empty() && m_Loaded.empty();
+}
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+AsyncLoader::Statistics AsyncLoader::GetStatistics() const
+{
+    std::lock_guard< std::mutex > locker( m_Mutex );
+
+    Statistics result = m_Statistics;
+    result.PendingCount = u32( m_Pending.size() );
+    result.LoadingCount = u32( m_Loading.size() );
+    result.LoadedCount  = u32( m_Loaded .size() );
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      最も優先度の高い要求を1つ読み込みます(ワーカースレッド).
+//-----------------------------------------------------------------------------------
+void AsyncLoader::Dispatch()
+{
+    RequestPtr request;
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        while( !m_Pending.empty() && request == nullptr )
+        {
+            std::pop_heap( m_Pending.begin(), m_Pending.end(), IsLowerPriority );
+            RequestPtr top = m_Pending.back();
+            m_Pending.pop_back();
+
+            // キャンセルされた要求は読み込まずに完了通知だけを行う.
+            std::lock_guard< std::mutex > requestLocker( top->Mutex );
+            if ( top->IsCanceled )
+            {
+                top->State = STATE_LOADED;
+                m_Loaded.push_back( top );
+            }
+            else
+            {
+                top->State = STATE_LOADING;
+                m_Loading.push_back( top );
+                request = top;
+            }
+        }
+    }
+
+    if ( request != nullptr )
+    { RunLoad( request, true ); }
+
+    std::lock_guard< std::mutex > locker( m_Mutex );
+    m_DispatchCount--;
+    m_Cond.notify_all();
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込み処理を実行します.
+//-----------------------------------------------------------------------------------
+void AsyncLoader::RunLoad( const RequestPtr& request, bool enqueue )
+{
+    bool result = true;
+    if ( request->Load )
+    { result = request->Load( Future( request ) ); }
+
+    std::lock_guard< std::mutex > locker( m_Mutex );
+    m_Loading.erase( std::find( m_Loading.begin(), m_Loading.end(), request ) );
+    {
+        std::lock_guard< std::mutex > requestLocker( request->Mutex );
+        request->State        = STATE_LOADED;
+        request->IsLoadFailed = !result;
+    }
+
+    // 読み込み中にも生成待ちにも無い瞬間ができないように, 同じロックの中で積む.
+    if ( enqueue )
+    { m_Loaded.push_back( request ); }
+
+    m_Cond.notify_all();
+}
+
+//-----------------------------------------------------------------------------------
+//      生成処理と完了通知を実行します(メインスレッド).
+//-----------------------------------------------------------------------------------
+void AsyncLoader::Finish( const RequestPtr& request )
+{
+    bool isCanceled   = false;
+    bool isLoadFailed = false;
+    {
+        std::lock_guard< std::mutex > locker( request->Mutex );
+        isCanceled   = request->IsCanceled;
+        isLoadFailed = request->IsLoadFailed;
+    }
+
+    STATE state = STATE_COMPLETED;
+    if ( isCanceled )
+    { state = STATE_CANCELED; }
+    else if ( isLoadFailed )
+    {
+        ELOG( "Error : Load Failed. name = %s", request->Name.c_str() );
+        state = STATE_FAILED;
+    }
+    else if ( request->Create && !request->Create() )
+    {
+        ELOG( "Error : Create Failed. name = %s", request->Name.c_str() );
+        state = STATE_FAILED;
+    }
+
+    {
+        std::lock_guard< std::mutex > locker( request->Mutex );
+        request->State = state;
+    }
+
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        switch( state )
+        {
+        case STATE_COMPLETED: m_Statistics.CompletedCount++; break;
+        case STATE_FAILED:    m_Statistics.FailedCount++;    break;
+        default:              m_Statistics.CanceledCount++;  break;
+        }
+    }
+
+    // 関数が捕まえている読み込み途中のデータをここで手放す.
+    Callback callback;
+    callback.swap( request->OnComplete );
+    request->Load   = LoadFunc();
+    request->Create = CreateFunc();
+
+    if ( callback )
+    { callback( state ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      優先度を比較します.
+//-----------------------------------------------------------------------------------
+bool AsyncLoader::IsLowerPriority( const RequestPtr& lhs, const RequestPtr& rhs )
+{
+    if ( lhs->Priority != rhs->Priority )
+    { return lhs->Priority < rhs->Priority; }
+
+    // 同じ優先度なら先に要求したものを優先する.
+    return lhs->Sequence > rhs->Sequence;
+}
@@ -0,0 +1,1179 @@
+﻿//-----------------------------------------------------------------------------------
+// File : BlockCompressor.cpp
+// Desc : Block Compression Encoder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <BlockCompressor.h>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define BLOCK_COMPRESSOR_USE_SSE2   1
+    #include <emmintrin.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+// 1ブロックあたりの画素数です.
+static const u32 BLOCK_PIXELS = 16;
+
+// BC1 のインデックスごとの2番目の端点のウェイトです.
+static const f32 BC1_WEIGHTS[ 4 ] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+// BC7 の 4bit インデックスの補間ウェイトです(64で正規化).
+static const u32 BC7_WEIGHTS[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// BC7 のモード6を表すビットです.
+static const u32 BC7_MODE6 = 0x40;
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Block structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct Block
+{
+    f32     Values[ 4 ][ BLOCK_PIXELS ];    //!< チャンネルごとの画素値です(0～255).
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// BitWriter structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct BitWriter
+{
+    u8*     pData;      //!< 書き込み先です(0で初期化しておく必要があります).
+    u32     Offset;     //!< 書き込み位置(ビット)です.
+
+    void Write( u32 value, u32 bits )
+    {
+        for( u32 i=0; i<bits; ++i, ++Offset )
+        {
+            if ( ( value >> i ) & 0x1 )
+            { pData[ Offset >> 3 ] |= u8( 1 << ( Offset & 0x7 ) ); }
+        }
+    }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// BitReader structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct BitReader
+{
+    const u8*   pData;      //!< 読み込み元です.
+    u32         Offset;     //!< 読み込み位置(ビット)です.
+
+    u32 Read( u32 bits )
+    {
+        u32 result = 0;
+        for( u32 i=0; i<bits; ++i, ++Offset )
+        { result |= u32( ( pData[ Offset >> 3 ] >> ( Offset & 0x7 ) ) & 0x1 ) << i; }
+        return result;
+    }
+};
+
+//-----------------------------------------------------------------------------------
+//      値を範囲内に収めます.
+//-----------------------------------------------------------------------------------
+inline s32 Clamp( s32 value, s32 minValue, s32 maxValue )
+{ return ( value < minValue ) ? minValue : ( value > maxValue ) ? maxValue : value; }
+
+//-----------------------------------------------------------------------------------
+//      値を 0～255 に収めます.
+//-----------------------------------------------------------------------------------
+inline f32 Saturate255( f32 value )
+{ return ( value < 0.0f ) ? 0.0f : ( value > 255.0f ) ? 255.0f : value; }
+
+//-----------------------------------------------------------------------------------
+//      四捨五入して整数にします.
+//-----------------------------------------------------------------------------------
+inline s32 Round( f32 value )
+{ return s32( floorf( value + 0.5f ) ); }
+
+//-----------------------------------------------------------------------------------
+//      RGBA8 の16画素をチャンネルごとの並びに変換します.
+//-----------------------------------------------------------------------------------
+void ToBlock( const u8* pRGBA, Block& result )
+{
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        for( u32 c=0; c<4; ++c )
+        { result.Values[ c ][ i ] = f32( pRGBA[ i * 4 + c ] ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      各画素に最も近いパレットのインデックスを求めます.
+//-----------------------------------------------------------------------------------
+f32 FitIndices
+(
+    const f32   (*pChannels)[ BLOCK_PIXELS ],
+    u32         channelCount,
+    const f32   (*pPalette)[ 4 ],
+    u32         paletteCount,
+    u8*         pIndices
+)
+{
+#if BLOCK_COMPRESSOR_USE_SSE2
+    // 4画素ずつまとめて全てのパレットとの距離を求める.
+    __m128 total = _mm_setzero_ps();
+    for( u32 i=0; i<BLOCK_PIXELS; i+=4 )
+    {
+        __m128 bestError = _mm_set1_ps( FLT_MAX );
+        __m128 bestIndex = _mm_setzero_ps();
+
+        for( u32 j=0; j<paletteCount; ++j )
+        {
+            __m128 error = _mm_setzero_ps();
+            for( u32 c=0; c<channelCount; ++c )
+            {
+                __m128 diff = _mm_sub_ps( _mm_loadu_ps( &pChannels[ c ][ i ] ), _mm_set1_ps( pPalette[ j ][ c ] ) );
+                error = _mm_add_ps( error, _mm_mul_ps( diff, diff ) );
+            }
+
+            // 等しい場合は小さいインデックスを優先する.
+            __m128 mask = _mm_cmplt_ps( error, bestError );
+            bestError = _mm_min_ps( error, bestError );
+            bestIndex = _mm_or_ps( _mm_and_ps( mask, _mm_set1_ps( f32( j ) ) ), _mm_andnot_ps( mask, bestIndex ) );
+        }
+
+        total = _mm_add_ps( total, bestError );
+
+        __m128i index = _mm_cvttps_epi32( bestIndex );
+        pIndices[ i + 0 ] = u8( _mm_cvtsi128_si32( index ) );
+        pIndices[ i + 1 ] = u8( _mm_cvtsi128_si32( _mm_srli_si128( index, 4 ) ) );
+        pIndices[ i + 2 ] = u8( _mm_cvtsi128_si32( _mm_srli_si128( index, 8 ) ) );
+        pIndices[ i + 3 ] = u8( _mm_cvtsi128_si32( _mm_srli_si128( index, 12 ) ) );
+    }
+
+    f32 sum[ 4 ];
+    _mm_storeu_ps( sum, total );
+    return sum[0] + sum[1] + sum[2] + sum[3];
+#else
+    f32 total = 0.0f;
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        f32 bestError = FLT_MAX;
+        u32 bestIndex = 0;
+
+        for( u32 j=0; j<paletteCount; ++j )
+        {
+            f32 error = 0.0f;
+            for( u32 c=0; c<channelCount; ++c )
+            {
+                f32 diff = pChannels[ c ][ i ] - pPalette[ j ][ c ];
+                error += diff * diff;
+            }
+
+            if ( error < bestError )
+            {
+                bestError = error;
+                bestIndex = j;
+            }
+        }
+
+        total += bestError;
+        pIndices[ i ] = u8( bestIndex );
+    }
+
+    return total;
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+//      主軸を求めます.
+//-----------------------------------------------------------------------------------
+void ComputeAxis( const Block& block, u32 channelCount, u32 iterations, f32* pMean, f32* pAxis )
+{
+    for( u32 c=0; c<channelCount; ++c )
+    {
+        f32 sum = 0.0f;
+        for( u32 i=0; i<BLOCK_PIXELS; ++i )
+        { sum += block.Values[ c ][ i ]; }
+        pMean[ c ] = sum / f32( BLOCK_PIXELS );
+    }
+
+    f32 covariance[ 4 ][ 4 ];
+    for( u32 a=0; a<channelCount; ++a )
+    {
+        for( u32 b=a; b<channelCount; ++b )
+        {
+            f32 sum = 0.0f;
+            for( u32 i=0; i<BLOCK_PIXELS; ++i )
+            { sum += ( block.Values[ a ][ i ] - pMean[ a ] ) * ( block.Values[ b ][ i ] - pMean[ b ] ); }
+            covariance[ a ][ b ] = sum;
+            covariance[ b ][ a ] = sum;
+        }
+    }
+
+    // 分散が最も大きいチャンネルの行を初期値にすると, 符号も含めて主軸に近い向きになる.
+    u32 largest = 0;
+    for( u32 c=1; c<channelCount; ++c )
+    {
+        if ( covariance[ c ][ c ] > covariance[ largest ][ largest ] )
+        { largest = c; }
+    }
+
+    for( u32 c=0; c<channelCount; ++c )
+    { pAxis[ c ] = covariance[ largest ][ c ]; }
+
+    // べき乗法で主軸に近づける.
+    for( u32 n=0; n<iterations; ++n )
+    {
+        f32 next[ 4 ];
+        f32 maxValue = 0.0f;
+        for( u32 a=0; a<channelCount; ++a )
+        {
+            next[ a ] = 0.0f;
+            for( u32 b=0; b<channelCount; ++b )
+            { next[ a ] += covariance[ a ][ b ] * pAxis[ b ]; }
+
+            maxValue = ( fabsf( next[ a ] ) > maxValue ) ? fabsf( next[ a ] ) : maxValue;
+        }
+
+        if ( maxValue <= FLT_EPSILON )
+        { break; }
+
+        for( u32 c=0; c<channelCount; ++c )
+        { pAxis[ c ] = next[ c ] / maxValue; }
+    }
+
+    f32 length = 0.0f;
+    for( u32 c=0; c<channelCount; ++c )
+    { length += pAxis[ c ] * pAxis[ c ]; }
+
+    length = sqrtf( length );
+    for( u32 c=0; c<channelCount; ++c )
+    { pAxis[ c ] = ( length > FLT_EPSILON ) ? pAxis[ c ] / length : 0.0f; }
+}
+
+//-----------------------------------------------------------------------------------
+//      主軸上の範囲から端点を求めます.
+//-----------------------------------------------------------------------------------
+void ComputeEndpoints
+(
+    const Block&    block,
+    u32             channelCount,
+    const f32*      pMean,
+    const f32*      pAxis,
+    f32             inset,
+    f32*            pE0,
+    f32*            pE1
+)
+{
+    f32 minT =  FLT_MAX;
+    f32 maxT = -FLT_MAX;
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        f32 t = 0.0f;
+        for( u32 c=0; c<channelCount; ++c )
+        { t += ( block.Values[ c ][ i ] - pMean[ c ] ) * pAxis[ c ]; }
+
+        minT = ( t < minT ) ? t : minT;
+        maxT = ( t > maxT ) ? t : maxT;
+    }
+
+    // 量子化で端に寄りすぎないように少し内側に寄せる.
+    f32 range = ( maxT - minT ) * inset;
+    minT += range;
+    maxT -= range;
+
+    for( u32 c=0; c<channelCount; ++c )
+    {
+        pE0[ c ] = Saturate255( pMean[ c ] + pAxis[ c ] * minT );
+        pE1[ c ] = Saturate255( pMean[ c ] + pAxis[ c ] * maxT );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      インデックスを固定して最小二乗法で端点を求めます.
+//-----------------------------------------------------------------------------------
+bool SolveEndpoints( const Block& block, u32 channelCount, const f32* pWeights, f32* pE0, f32* pE1 )
+{
+    f32 aa = 0.0f;
+    f32 ab = 0.0f;
+    f32 bb = 0.0f;
+    f32 ax[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    f32 bx[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        f32 b = pWeights[ i ];
+        f32 a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for( u32 c=0; c<channelCount; ++c )
+        {
+            ax[ c ] += a * block.Values[ c ][ i ];
+            bx[ c ] += b * block.Values[ c ][ i ];
+        }
+    }
+
+    // 全ての画素が同じインデックスの場合は解けない.
+    f32 det = aa * bb - ab * ab;
+    if ( fabsf( det ) <= FLT_EPSILON )
+    { return false; }
+
+    f32 inv = 1.0f / det;
+    for( u32 c=0; c<channelCount; ++c )
+    {
+        pE0[ c ] = Saturate255( ( ax[ c ] * bb - bx[ c ] * ab ) * inv );
+        pE1[ c ] = Saturate255( ( bx[ c ] * aa - ax[ c ] * ab ) * inv );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      RGB565 に量子化します.
+//-----------------------------------------------------------------------------------
+u16 Pack565( const f32* pColor )
+{
+    u32 r = u32( Clamp( Round( pColor[0] * 31.0f / 255.0f ), 0, 31 ) );
+    u32 g = u32( Clamp( Round( pColor[1] * 63.0f / 255.0f ), 0, 63 ) );
+    u32 b = u32( Clamp( Round( pColor[2] * 31.0f / 255.0f ), 0, 31 ) );
+    return u16( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+//-----------------------------------------------------------------------------------
+//      RGB565 を 8bit に展開します.
+//-----------------------------------------------------------------------------------
+void Unpack565( u16 value, u32* pColor )
+{
+    u32 r = ( value >> 11 ) & 0x1f;
+    u32 g = ( value >> 5  ) & 0x3f;
+    u32 b = ( value       ) & 0x1f;
+    pColor[0] = ( r << 3 ) | ( r >> 2 );
+    pColor[1] = ( g << 2 ) | ( g >> 4 );
+    pColor[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+//-----------------------------------------------------------------------------------
+//      RGB565 の1チャンネルを1段階ずらします.
+//-----------------------------------------------------------------------------------
+bool Step565( u16 value, u32 channel, s32 delta, u16& result )
+{
+    static const u32 SHIFT[ 3 ] = { 11, 5, 0 };
+    static const u32 MASK [ 3 ] = { 0x1f, 0x3f, 0x1f };
+
+    s32 v = s32( ( value >> SHIFT[ channel ] ) & MASK[ channel ] ) + delta;
+    if ( v < 0 || v > s32( MASK[ channel ] ) )
+    { return false; }
+
+    result = u16( ( value & ~( MASK[ channel ] << SHIFT[ channel ] ) ) | ( u32( v ) << SHIFT[ channel ] ) );
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      BC1 の端点での誤差とインデックスを求めます.
+//-----------------------------------------------------------------------------------
+f32 EvaluateBC1( const Block& block, u16 c0, u16 c1, u8* pIndices )
+{
+    u32 e0[ 3 ];
+    u32 e1[ 3 ];
+    Unpack565( c0, e0 );
+    Unpack565( c1, e1 );
+
+    f32 palette[ 4 ][ 4 ];
+    for( u32 c=0; c<3; ++c )
+    {
+        palette[ 0 ][ c ] = f32( e0[ c ] );
+        palette[ 1 ][ c ] = f32( e1[ c ] );
+        palette[ 2 ][ c ] = f32( ( 2 * e0[ c ] + e1[ c ] ) / 3 );
+        palette[ 3 ][ c ] = f32( ( e0[ c ] + 2 * e1[ c ] ) / 3 );
+    }
+
+    return FitIndices( block.Values, 3, palette, 4, pIndices );
+}
+
+//-----------------------------------------------------------------------------------
+//      BC1 のカラーブロックをエンコードします.
+//-----------------------------------------------------------------------------------
+void EncodeColorBlock( const Block& block, BlockCompressor::QUALITY quality, u8* pOutput )
+{
+    static const u32 AXIS_ITERATIONS [ 3 ] = { 0, 4, 8 };
+    static const u32 REFINE_COUNT    [ 3 ] = { 0, 2, 4 };
+    static const u32 NEIGHBOR_PASSES [ 3 ] = { 0, 0, 2 };
+
+    f32 mean[ 4 ];
+    f32 axis[ 4 ];
+    f32 e0  [ 4 ];
+    f32 e1  [ 4 ];
+    ComputeAxis( block, 3, AXIS_ITERATIONS[ quality ], mean, axis );
+    ComputeEndpoints( block, 3, mean, axis, 1.0f / 16.0f, e0, e1 );
+
+    u16 bestC0 = Pack565( e0 );
+    u16 bestC1 = Pack565( e1 );
+    u8  bestIndices[ BLOCK_PIXELS ];
+    f32 bestError = EvaluateBC1( block, bestC0, bestC1, bestIndices );
+
+    u8 indices[ BLOCK_PIXELS ];
+
+    // インデックスを固定して端点を求め直す.
+    for( u32 n=0; n<REFINE_COUNT[ quality ]; ++n )
+    {
+        f32 weights[ BLOCK_PIXELS ];
+        for( u32 i=0; i<BLOCK_PIXELS; ++i )
+        { weights[ i ] = BC1_WEIGHTS[ bestIndices[ i ] ]; }
+
+        if ( !SolveEndpoints( block, 3, weights, e0, e1 ) )
+        { break; }
+
+        u16 c0 = Pack565( e0 );
+        u16 c1 = Pack565( e1 );
+        f32 error = EvaluateBC1( block, c0, c1, indices );
+        if ( error >= bestError )
+        { break; }
+
+        bestError = error;
+        bestC0    = c0;
+        bestC1    = c1;
+        memcpy( bestIndices, indices, sizeof( indices ) );
+    }
+
+    // 量子化後の端点を1段階ずつ動かして改善するものを探す.
+    for( u32 n=0; n<NEIGHBOR_PASSES[ quality ]; ++n )
+    {
+        bool improved = false;
+        for( u32 k=0; k<6; ++k )
+        {
+            for( s32 delta=-1; delta<=1; delta+=2 )
+            {
+                u16 c0 = bestC0;
+                u16 c1 = bestC1;
+                if ( !Step565( ( k < 3 ) ? bestC0 : bestC1, k % 3, delta, ( k < 3 ) ? c0 : c1 ) )
+                { continue; }
+
+                f32 error = EvaluateBC1( block, c0, c1, indices );
+                if ( error < bestError )
+                {
+                    bestError = error;
+                    bestC0    = c0;
+                    bestC1    = c1;
+                    memcpy( bestIndices, indices, sizeof( indices ) );
+                    improved  = true;
+                }
+            }
+        }
+
+        if ( !improved )
+        { break; }
+    }
+
+    // 4色モードにするため, 1番目の端点の方を大きくする.
+    if ( bestC0 < bestC1 )
+    {
+        std::swap( bestC0, bestC1 );
+        for( u32 i=0; i<BLOCK_PIXELS; ++i )
+        { bestIndices[ i ] ^= 0x1; }
+    }
+    else if ( bestC0 == bestC1 )
+    { memset( bestIndices, 0, sizeof( bestIndices ) ); }
+
+    u32 bits = 0;
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    { bits |= u32( bestIndices[ i ] ) << ( i * 2 ); }
+
+    pOutput[0] = u8( bestC0 & 0xff );
+    pOutput[1] = u8( bestC0 >> 8 );
+    pOutput[2] = u8( bestC1 & 0xff );
+    pOutput[3] = u8( bestC1 >> 8 );
+    pOutput[4] = u8( ( bits       ) & 0xff );
+    pOutput[5] = u8( ( bits >> 8  ) & 0xff );
+    pOutput[6] = u8( ( bits >> 16 ) & 0xff );
+    pOutput[7] = u8( ( bits >> 24 ) & 0xff );
+}
+
+//-----------------------------------------------------------------------------------
+//      BC4 のパレットを求めます.
+//-----------------------------------------------------------------------------------
+void BuildBC4Palette( u32 e0, u32 e1, u32* pPalette )
+{
+    pPalette[0] = e0;
+    pPalette[1] = e1;
+
+    if ( e0 > e1 )
+    {
+        for( u32 i=2; i<8; ++i )
+        { pPalette[ i ] = ( ( 8 - i ) * e0 + ( i - 1 ) * e1 + 3 ) / 7; }
+    }
+    else
+    {
+        for( u32 i=2; i<6; ++i )
+        { pPalette[ i ] = ( ( 6 - i ) * e0 + ( i - 1 ) * e1 + 2 ) / 5; }
+        pPalette[6] = 0;
+        pPalette[7] = 255;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC4 の端点での誤差とインデックスを求めます.
+//-----------------------------------------------------------------------------------
+f32 EvaluateBC4( const f32 (*pValues)[ BLOCK_PIXELS ], u32 e0, u32 e1, u8* pIndices )
+{
+    u32 values[ 8 ];
+    BuildBC4Palette( e0, e1, values );
+
+    f32 palette[ 8 ][ 4 ];
+    for( u32 i=0; i<8; ++i )
+    { palette[ i ][ 0 ] = f32( values[ i ] ); }
+
+    return FitIndices( pValues, 1, palette, 8, pIndices );
+}
+
+//-----------------------------------------------------------------------------------
+//      BC4 の1チャンネルのブロックをエンコードします.
+//-----------------------------------------------------------------------------------
+void EncodeAlphaBlock( const f32 (*pValues)[ BLOCK_PIXELS ], BlockCompressor::QUALITY quality, u8* pOutput )
+{
+    static const s32 INSET_RANGE[ 3 ] = { 0, 2, 6 };
+
+    s32 lo = 255;
+    s32 hi = 0;
+    s32 innerLo = 255;
+    s32 innerHi = 0;
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        s32 v = Round( (*pValues)[ i ] );
+        lo = ( v < lo ) ? v : lo;
+        hi = ( v > hi ) ? v : hi;
+
+        // 6値モードでは 0 と 255 はパレットにあるので, 端点は残りの値から決める.
+        if ( v > 0 && v < 255 )
+        {
+            innerLo = ( v < innerLo ) ? v : innerLo;
+            innerHi = ( v > innerHi ) ? v : innerHi;
+        }
+    }
+
+    u32 bestE0 = u32( hi );
+    u32 bestE1 = u32( lo );
+    u8  bestIndices[ BLOCK_PIXELS ];
+    f32 bestError = EvaluateBC4( pValues, bestE0, bestE1, bestIndices );
+
+    u8 indices[ BLOCK_PIXELS ];
+
+    // 範囲を内側に狭めた端点も試す.
+    s32 range = INSET_RANGE[ quality ];
+    for( s32 a=0; a<=range && bestError > 0.0f; ++a )
+    {
+        for( s32 b=0; b<=range; ++b )
+        {
+            s32 e0 = hi - a;
+            s32 e1 = lo + b;
+            if ( ( a == 0 && b == 0 ) || e0 <= e1 )
+            { continue; }
+
+            f32 error = EvaluateBC4( pValues, u32( e0 ), u32( e1 ), indices );
+            if ( error < bestError )
+            {
+                bestError = error;
+                bestE0    = u32( e0 );
+                bestE1    = u32( e1 );
+                memcpy( bestIndices, indices, sizeof( indices ) );
+            }
+        }
+    }
+
+    if ( quality == BlockCompressor::QUALITY_HIGH && innerLo <= innerHi && bestError > 0.0f )
+    {
+        f32 error = EvaluateBC4( pValues, u32( innerLo ), u32( innerHi ), indices );
+        if ( error < bestError )
+        {
+            bestError = error;
+            bestE0    = u32( innerLo );
+            bestE1    = u32( innerHi );
+            memcpy( bestIndices, indices, sizeof( indices ) );
+        }
+    }
+
+    u64 bits = 0;
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    { bits |= u64( bestIndices[ i ] ) << ( i * 3 ); }
+
+    pOutput[0] = u8( bestE0 );
+    pOutput[1] = u8( bestE1 );
+    for( u32 i=0; i<6; ++i )
+    { pOutput[ 2 + i ] = u8( ( bits >> ( i * 8 ) ) & 0xff ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC7 の端点を7bit + Pビットに量子化します.
+//-----------------------------------------------------------------------------------
+void QuantizeBC7( const f32* pEndpoint, s32 pbit, u32* pResult )
+{
+    for( u32 c=0; c<4; ++c )
+    { pResult[ c ] = u32( Clamp( Round( ( pEndpoint[ c ] - f32( pbit ) ) * 0.5f ), 0, 127 ) ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC7 の量子化した端点での誤差とインデックスを求めます.
+//-----------------------------------------------------------------------------------
+f32 EvaluateBC7( const Block& block, const u32* q0, u32 p0, const u32* q1, u32 p1, u8* pIndices )
+{
+    f32 palette[ 16 ][ 4 ];
+    for( u32 c=0; c<4; ++c )
+    {
+        u32 e0 = ( q0[ c ] << 1 ) | p0;
+        u32 e1 = ( q1[ c ] << 1 ) | p1;
+        for( u32 i=0; i<16; ++i )
+        { palette[ i ][ c ] = f32( ( ( 64 - BC7_WEIGHTS[ i ] ) * e0 + BC7_WEIGHTS[ i ] * e1 + 32 ) >> 6 ); }
+    }
+
+    return FitIndices( block.Values, 4, palette, 16, pIndices );
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// BC7Endpoints structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct BC7Endpoints
+{
+    u32     Q0[ 4 ];                    //!< 1番目の端点(7bit)です.
+    u32     Q1[ 4 ];                    //!< 2番目の端点(7bit)です.
+    u32     P0;                         //!< 1番目の端点のPビットです.
+    u32     P1;                         //!< 2番目の端点のPビットです.
+    u8      Indices[ BLOCK_PIXELS ];    //!< インデックスです.
+    f32     Error;                      //!< 誤差です.
+};
+
+//-----------------------------------------------------------------------------------
+//      BC7 の端点を量子化して評価します.
+//-----------------------------------------------------------------------------------
+void QuantizeAndEvaluateBC7( const Block& block, const f32* e0, const f32* e1, bool searchAll, bool opaque, BC7Endpoints& result )
+{
+    result.Error = FLT_MAX;
+
+    // 不透明なブロックはアルファが 255 に復元されるように, 両端点のアルファを 127, Pビットを 1 に固定する.
+    // PビットはRGBAで共有されるので, RGB も Pビット 1 で量子化する.
+    if ( opaque )
+    {
+        result.P0 = 1;
+        result.P1 = 1;
+        QuantizeBC7( e0, 1, result.Q0 );
+        QuantizeBC7( e1, 1, result.Q1 );
+        result.Q0[3] = 127;
+        result.Q1[3] = 127;
+        result.Error = EvaluateBC7( block, result.Q0, result.P0, result.Q1, result.P1, result.Indices );
+        return;
+    }
+
+    // Pビットの全ての組み合わせを試すか, 端点ごとに近い方を選ぶ.
+    for( u32 p=0; p<4; ++p )
+    {
+        BC7Endpoints candidate;
+        candidate.P0 = p & 0x1;
+        candidate.P1 = ( p >> 1 ) & 0x1;
+        QuantizeBC7( e0, s32( candidate.P0 ), candidate.Q0 );
+        QuantizeBC7( e1, s32( candidate.P1 ), candidate.Q1 );
+
+        if ( !searchAll )
+        {
+            for( u32 k=0; k<2; ++k )
+            {
+                const f32* e = ( k == 0 ) ? e0 : e1;
+                f32 error[ 2 ] = { 0.0f, 0.0f };
+                for( u32 pbit=0; pbit<2; ++pbit )
+                {
+                    u32 q[ 4 ];
+                    QuantizeBC7( e, s32( pbit ), q );
+                    for( u32 c=0; c<4; ++c )
+                    {
+                        f32 diff = f32( ( q[ c ] << 1 ) | pbit ) - e[ c ];
+                        error[ pbit ] += diff * diff;
+                    }
+                }
+
+                u32 pbit = ( error[1] < error[0] ) ? 1 : 0;
+                if ( k == 0 )
+                {
+                    candidate.P0 = pbit;
+                    QuantizeBC7( e0, s32( pbit ), candidate.Q0 );
+                }
+                else
+                {
+                    candidate.P1 = pbit;
+                    QuantizeBC7( e1, s32( pbit ), candidate.Q1 );
+                }
+            }
+        }
+
+        candidate.Error = EvaluateBC7( block, candidate.Q0, candidate.P0, candidate.Q1, candidate.P1, candidate.Indices );
+        if ( candidate.Error < result.Error )
+        { result = candidate; }
+
+        if ( !searchAll )
+        { break; }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC7 のブロックをモード6でエンコードします.
+//-----------------------------------------------------------------------------------
+void EncodeBC7Block( const Block& block, BlockCompressor::QUALITY quality, u8* pOutput )
+{
+    static const u32 AXIS_ITERATIONS[ 3 ] = { 0, 4, 8 };
+    static const u32 REFINE_COUNT   [ 3 ] = { 0, 2, 4 };
+
+    bool searchAll = ( quality == BlockCompressor::QUALITY_HIGH );
+
+    bool opaque = true;
+    for( u32 i=0; i<BLOCK_PIXELS && opaque; ++i )
+    { opaque = ( block.Values[3][ i ] >= 255.0f ); }
+
+    f32 mean[ 4 ];
+    f32 axis[ 4 ];
+    f32 e0  [ 4 ];
+    f32 e1  [ 4 ];
+    ComputeAxis( block, 4, AXIS_ITERATIONS[ quality ], mean, axis );
+    ComputeEndpoints( block, 4, mean, axis, 0.0f, e0, e1 );
+
+    BC7Endpoints best;
+    QuantizeAndEvaluateBC7( block, e0, e1, searchAll, opaque, best );
+
+    for( u32 n=0; n<REFINE_COUNT[ quality ] && best.Error > 0.0f; ++n )
+    {
+        f32 weights[ BLOCK_PIXELS ];
+        for( u32 i=0; i<BLOCK_PIXELS; ++i )
+        { weights[ i ] = f32( BC7_WEIGHTS[ best.Indices[ i ] ] ) / 64.0f; }
+
+        if ( !SolveEndpoints( block, 4, weights, e0, e1 ) )
+        { break; }
+
+        BC7Endpoints candidate;
+        QuantizeAndEvaluateBC7( block, e0, e1, searchAll, opaque, candidate );
+        if ( candidate.Error >= best.Error )
+        { break; }
+
+        best = candidate;
+    }
+
+    // 先頭の画素のインデックスは最上位ビットを省略するので, 0 になるように端点を入れ替える.
+    if ( best.Indices[0] & 0x8 )
+    {
+        for( u32 c=0; c<4; ++c )
+        { std::swap( best.Q0[ c ], best.Q1[ c ] ); }
+        std::swap( best.P0, best.P1 );
+
+        for( u32 i=0; i<BLOCK_PIXELS; ++i )
+        { best.Indices[ i ] = u8( 15 - best.Indices[ i ] ); }
+    }
+
+    memset( pOutput, 0, 16 );
+
+    BitWriter writer;
+    writer.pData  = pOutput;
+    writer.Offset = 0;
+
+    writer.Write( BC7_MODE6, 7 );
+    for( u32 c=0; c<4; ++c )
+    {
+        writer.Write( best.Q0[ c ], 7 );
+        writer.Write( best.Q1[ c ], 7 );
+    }
+    writer.Write( best.P0, 1 );
+    writer.Write( best.P1, 1 );
+
+    writer.Write( best.Indices[0], 3 );
+    for( u32 i=1; i<BLOCK_PIXELS; ++i )
+    { writer.Write( best.Indices[ i ], 4 ); }
+
+    assert( writer.Offset == 128 );
+}
+
+//-----------------------------------------------------------------------------------
+//      BC1 のカラーブロックをデコードします.
+//-----------------------------------------------------------------------------------
+void DecodeColorBlock( const u8* pBlock, bool forceFourColor, u8* pRGBA )
+{
+    u16 c0 = u16( pBlock[0] | ( pBlock[1] << 8 ) );
+    u16 c1 = u16( pBlock[2] | ( pBlock[3] << 8 ) );
+    u32 bits = u32( pBlock[4] ) | ( u32( pBlock[5] ) << 8 ) | ( u32( pBlock[6] ) << 16 ) | ( u32( pBlock[7] ) << 24 );
+
+    u32 palette[ 4 ][ 4 ];
+    Unpack565( c0, palette[0] );
+    Unpack565( c1, palette[1] );
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+    palette[2][3] = 255;
+    palette[3][3] = 255;
+
+    if ( forceFourColor || c0 > c1 )
+    {
+        for( u32 c=0; c<3; ++c )
+        {
+            palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+            palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+        }
+    }
+    else
+    {
+        for( u32 c=0; c<3; ++c )
+        {
+            palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2;
+            palette[3][c] = 0;
+        }
+        palette[3][3] = 0;
+    }
+
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        u32 index = ( bits >> ( i * 2 ) ) & 0x3;
+        for( u32 c=0; c<4; ++c )
+        { pRGBA[ i * 4 + c ] = u8( palette[ index ][ c ] ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC4 の1チャンネルのブロックをデコードします.
+//-----------------------------------------------------------------------------------
+void DecodeAlphaBlock( const u8* pBlock, u8* pRGBA, u32 channel )
+{
+    u32 palette[ 8 ];
+    BuildBC4Palette( pBlock[0], pBlock[1], palette );
+
+    u64 bits = 0;
+    for( u32 i=0; i<6; ++i )
+    { bits |= u64( pBlock[ 2 + i ] ) << ( i * 8 ); }
+
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    { pRGBA[ i * 4 + channel ] = u8( palette[ ( bits >> ( i * 3 ) ) & 0x7 ] ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      BC7 のモード6のブロックをデコードします.
+//-----------------------------------------------------------------------------------
+bool DecodeBC7Block( const u8* pBlock, u8* pRGBA )
+{
+    BitReader reader;
+    reader.pData  = pBlock;
+    reader.Offset = 0;
+
+    if ( reader.Read( 7 ) != BC7_MODE6 )
+    {
+        memset( pRGBA, 0, BLOCK_PIXELS * 4 );
+        return false;
+    }
+
+    u32 q0[ 4 ];
+    u32 q1[ 4 ];
+    for( u32 c=0; c<4; ++c )
+    {
+        q0[ c ] = reader.Read( 7 );
+        q1[ c ] = reader.Read( 7 );
+    }
+    u32 p0 = reader.Read( 1 );
+    u32 p1 = reader.Read( 1 );
+
+    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+    {
+        u32 index = reader.Read( ( i == 0 ) ? 3 : 4 );
+        u32 w     = BC7_WEIGHTS[ index ];
+        for( u32 c=0; c<4; ++c )
+        {
+            u32 e0 = ( q0[ c ] << 1 ) | p0;
+            u32 e1 = ( q1[ c ] << 1 ) | p1;
+            pRGBA[ i * 4 + c ] = u8( ( ( 64 - w ) * e0 + w * e1 + 32 ) >> 6 );
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      誤差を求めるチャンネル数を取得します.
+//-----------------------------------------------------------------------------------
+u32 GetChannelCount( BlockCompressor::FORMAT format )
+{
+    switch( format )
+    {
+    case BlockCompressor::FORMAT_BC1:
+        return 3;
+
+    case BlockCompressor::FORMAT_BC4:
+        return 1;
+
+    case BlockCompressor::FORMAT_BC5:
+        return 2;
+
+    default:
+        break;
+    }
+
+    return 4;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// BlockCompressor class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      1ブロックあたりのバイト数を取得します.
+//-----------------------------------------------------------------------------------
+u32 BlockCompressor::GetBlockSize( FORMAT format )
+{ return ( format == FORMAT_BC1 || format == FORMAT_BC4 ) ? 8 : 16; }
+
+//-----------------------------------------------------------------------------------
+//      ブロック1行あたりのバイト数を取得します.
+//-----------------------------------------------------------------------------------
+u32 BlockCompressor::GetPitch( FORMAT format, u32 width )
+{
+    u32 blockX = ( width + 3 ) / 4;
+    return ( ( blockX > 0 ) ? blockX : 1 ) * GetBlockSize( format );
+}
+
+//-----------------------------------------------------------------------------------
+//      圧縮後のデータサイズを取得します.
+//-----------------------------------------------------------------------------------
+u32 BlockCompressor::GetSlicePitch( FORMAT format, u32 width, u32 height )
+{
+    u32 blockY = ( height + 3 ) / 4;
+    return GetPitch( format, width ) * ( ( blockY > 0 ) ? blockY : 1 );
+}
+
+//-----------------------------------------------------------------------------------
+//      1ブロックをエンコードします.
+//-----------------------------------------------------------------------------------
+void BlockCompressor::EncodeBlock( const u8* pRGBA, const Config& config, u8* pOutput )
+{
+    Block block;
+    ToBlock( pRGBA, block );
+
+    switch( config.Format )
+    {
+    case FORMAT_BC1:
+        EncodeColorBlock( block, config.Quality, pOutput );
+        break;
+
+    case FORMAT_BC3:
+        EncodeAlphaBlock( &block.Values[3], config.Quality, pOutput );
+        EncodeColorBlock( block, config.Quality, pOutput + 8 );
+        break;
+
+    case FORMAT_BC4:
+        EncodeAlphaBlock( &block.Values[0], config.Quality, pOutput );
+        break;
+
+    case FORMAT_BC5:
+        EncodeAlphaBlock( &block.Values[0], config.Quality, pOutput );
+        EncodeAlphaBlock( &block.Values[1], config.Quality, pOutput + 8 );
+        break;
+
+    case FORMAT_BC7:
+        EncodeBC7Block( block, config.Quality, pOutput );
+        break;
+
+    default:
+        assert( false );
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      1ブロックをデコードします.
+//-----------------------------------------------------------------------------------
+bool BlockCompressor::DecodeBlock( FORMAT format, const u8* pBlock, u8* pRGBA )
+{
+    switch( format )
+    {
+    case FORMAT_BC1:
+        DecodeColorBlock( pBlock, false, pRGBA );
+        return true;
+
+    case FORMAT_BC3:
+        DecodeColorBlock( pBlock + 8, true, pRGBA );
+        DecodeAlphaBlock( pBlock, pRGBA, 3 );
+        return true;
+
+    case FORMAT_BC4:
+    case FORMAT_BC5:
+        {
+            for( u32 i=0; i<BLOCK_PIXELS; ++i )
+            {
+                pRGBA[ i * 4 + 0 ] = 0;
+                pRGBA[ i * 4 + 1 ] = 0;
+                pRGBA[ i * 4 + 2 ] = 0;
+                pRGBA[ i * 4 + 3 ] = 255;
+            }
+
+            DecodeAlphaBlock( pBlock, pRGBA, 0 );
+            if ( format == FORMAT_BC5 )
+            { DecodeAlphaBlock( pBlock + 8, pRGBA, 1 ); }
+        }
+        return true;
+
+    case FORMAT_BC7:
+        return DecodeBC7Block( pBlock, pRGBA );
+
+    default:
+        break;
+    }
+
+    memset( pRGBA, 0, BLOCK_PIXELS * 4 );
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      画像をエンコードします.
+//-----------------------------------------------------------------------------------
+void BlockCompressor::Encode
+(
+    const u8*       pRGBA,
+    u32             width,
+    u32             height,
+    u32             pitch,
+    const Config&   config,
+    u8*             pOutput,
+    ThreadPool*     pPool,
+    Statistics*     pStats
+)
+{
+    u32 blockX    = ( width  + 3 ) / 4;
+    u32 blockY    = ( height + 3 ) / 4;
+    u32 tileSize  = ( config.TileSize > 0 ) ? config.TileSize : 1;
+    u32 tileX     = ( blockX + tileSize - 1 ) / tileSize;
+    u32 tileY     = ( blockY + tileSize - 1 ) / tileSize;
+    u32 tileCount = tileX * tileY;
+    u32 blockSize = GetBlockSize( config.Format );
+    u32 outPitch  = GetPitch( config.Format, width );
+    u32 channels  = GetChannelCount( config.Format );
+    u32 alphas    = ( channels == 4 ) ? 1 : 0;
+    u32 colors    = channels - alphas;
+
+    // スロットごとにカラーとアルファの誤差を別々に集計して, 最後にまとめる.
+    u32 slotCount = ThreadPool::GetRangeSlotCount( pPool, tileCount, 1 );
+    std::vector< f64 > colorErrors( ( slotCount > 0 ) ? slotCount : 1, 0.0 );
+    std::vector< f64 > alphaErrors( ( slotCount > 0 ) ? slotCount : 1, 0.0 );
+
+    ThreadPool::RangeJob job = [&]( u32 begin, u32 end, u32 slot )
+    {
+        u8 pixels [ BLOCK_PIXELS * 4 ];
+        u8 decoded[ BLOCK_PIXELS * 4 ];
+
+        for( u32 t=begin; t<end; ++t )
+        {
+            u32 startX = ( t % tileX ) * tileSize;
+            u32 startY = ( t / tileX ) * tileSize;
+            u32 endX   = ( startX + tileSize < blockX ) ? startX + tileSize : blockX;
+            u32 endY   = ( startY + tileSize < blockY ) ? startY + tileSize : blockY;
+
+            for( u32 by=startY; by<endY; ++by )
+            {
+                for( u32 bx=startX; bx<endX; ++bx )
+                {
+                    // 画像の外側は端の画素を繰り返す.
+                    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+                    {
+                        u32 x = bx * 4 + ( i & 0x3 );
+                        u32 y = by * 4 + ( i >> 2 );
+                        x = ( x < width  ) ? x : width  - 1;
+                        y = ( y < height ) ? y : height - 1;
+                        memcpy( &pixels[ i * 4 ], pRGBA + size_t( y ) * pitch + x * 4, 4 );
+                    }
+
+                    u8* pBlock = pOutput + size_t( by ) * outPitch + bx * blockSize;
+                    EncodeBlock( pixels, config, pBlock );
+
+                    if ( pStats == nullptr )
+                    { continue; }
+
+                    DecodeBlock( config.Format, pBlock, decoded );
+
+                    f64 colorError = 0.0;
+                    f64 alphaError = 0.0;
+                    for( u32 i=0; i<BLOCK_PIXELS; ++i )
+                    {
+                        if ( bx * 4 + ( i & 0x3 ) >= width || by * 4 + ( i >> 2 ) >= height )
+                        { continue; }
+
+                        for( u32 c=0; c<colors; ++c )
+                        {
+                            f64 diff = f64( pixels[ i * 4 + c ] ) - f64( decoded[ i * 4 + c ] );
+                            colorError += diff * diff;
+                        }
+
+                        if ( alphas > 0 )
+                        {
+                            f64 diff = f64( pixels[ i * 4 + 3 ] ) - f64( decoded[ i * 4 + 3 ] );
+                            alphaError += diff * diff;
+                        }
+                    }
+
+                    colorErrors[ slot ] += colorError;
+                    alphaErrors[ slot ] += alphaError;
+                }
+            }
+        }
+    };
+
+    ThreadPool::RunRange( pPool, tileCount, 1, job );
+
+    if ( pStats != nullptr )
+    {
+        pStats->BlockCount        = blockX * blockY;
+        pStats->TileCount         = tileCount;
+        pStats->PixelCount        = width * height;
+        pStats->ColorChannelCount = colors;
+        pStats->AlphaChannelCount = alphas;
+        pStats->ColorSquaredError = 0.0;
+        pStats->AlphaSquaredError = 0.0;
+        for( size_t i=0; i<colorErrors.size(); ++i )
+        {
+            pStats->ColorSquaredError += colorErrors[ i ];
+            pStats->AlphaSquaredError += alphaErrors[ i ];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      画像をデコードします.
+//-----------------------------------------------------------------------------------
+bool BlockCompressor::Decode
+(
+    FORMAT          format,
+    const u8*       pBlocks,
+    u32             width,
+    u32             height,
+    u32             blockPitch,
+    u8*             pRGBA,
+    u32             pitch
+)
+{
+    u32  blockX    = ( width  + 3 ) / 4;
+    u32  blockY    = ( height + 3 ) / 4;
+    u32  blockSize = GetBlockSize( format );
+    bool result    = true;
+
+    u8 decoded[ BLOCK_PIXELS * 4 ];
+    for( u32 by=0; by<blockY; ++by )
+    {
+        for( u32 bx=0; bx<blockX; ++bx )
+        {
+            if ( !DecodeBlock( format, pBlocks + size_t( by ) * blockPitch + bx * blockSize, decoded ) )
+            { result = false; }
+
+            for( u32 i=0; i<BLOCK_PIXELS; ++i )
+            {
+                u32 x = bx * 4 + ( i & 0x3 );
+                u32 y = by * 4 + ( i >> 2 );
+                if ( x < width && y < height )
+                { memcpy( pRGBA + size_t( y ) * pitch + x * 4, &decoded[ i * 4 ], 4 ); }
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,269 @@
+﻿//-----------------------------------------------------------------------------------
+// File : CascadeCoverage.cpp
+// Desc : Cascade Coverage Solver Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <CascadeCoverage.h>
+#include <cmath>
+#include <cassert>
+
+
+namespace /* anonymous */ {
+
+// 軸平行とみなす許容誤差.
+static const f32 AXIS_EPSILON = 1e-4f;
+
+//-----------------------------------------------------------------------------------
+//      透視成分を含まない行列かどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsAffine( const asdx::Matrix& value )
+{
+    return ( fabs( value._14 ) < AXIS_EPSILON )
+        && ( fabs( value._24 ) < AXIS_EPSILON )
+        && ( fabs( value._34 ) < AXIS_EPSILON )
+        && ( fabs( value._44 - 1.0f ) < AXIS_EPSILON );
+}
+
+//-----------------------------------------------------------------------------------
+//      矩形が空かどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsEmpty( const CascadeCoverage::Rect& value )
+{ return ( value.MinX >= value.MaxX ) || ( value.MinY >= value.MaxY ); }
+
+//-----------------------------------------------------------------------------------
+//      矩形同士が重なるかどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsOverlap( const CascadeCoverage::Rect& a, const CascadeCoverage::Rect& b )
+{
+    return ( a.MinX < b.MaxX ) && ( b.MinX < a.MaxX )
+        && ( a.MinY < b.MaxY ) && ( b.MinY < a.MaxY );
+}
+
+//-----------------------------------------------------------------------------------
+//      矩形を生成します.
+//-----------------------------------------------------------------------------------
+inline CascadeCoverage::Rect MakeRect( f32 minX, f32 minY, f32 maxX, f32 maxY )
+{
+    CascadeCoverage::Rect result;
+    result.MinX = minX;
+    result.MinY = minY;
+    result.MaxX = maxX;
+    result.MaxY = maxY;
+    return result;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CascadeCoverage class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+CascadeCoverage::CascadeCoverage()
+: m_CascadeCount( 0 )
+{
+    for( u32 i=0; i<MAX_CASCADE_COUNT; ++i )
+    {
+        m_ShadowMatrix[i].Identity();
+        m_RectCount[i] = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+CascadeCoverage::~CascadeCoverage()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      各カスケードで描画が必要な領域を求めます.
+//-----------------------------------------------------------------------------------
+void CascadeCoverage::Update( const asdx::Matrix* pShadowMatrices, u32 count, f32 border )
+{
+    m_CascadeCount = asdx::Min( count, MAX_CASCADE_COUNT );
+
+    for( u32 i=0; i<m_CascadeCount; ++i )
+    {
+        m_ShadowMatrix[i] = pShadowMatrices[i];
+
+        // 最初はシャドウマップ全体.
+        m_Rects    [i][0] = MakeRect( -1.0f, -1.0f, 1.0f, 1.0f );
+        m_RectCount[i]    = 1;
+
+        // 細かいカスケードが覆っている領域を差し引く.
+        for( u32 j=0; j<i; ++j )
+        {
+            Rect covered;
+            if ( ComputeCoveredRect( j, i, border, covered ) )
+            { SubtractRect( i, covered ); }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      描画が必要な矩形の数を取得します.
+//-----------------------------------------------------------------------------------
+u32 CascadeCoverage::GetRectCount( u32 cascade ) const
+{
+    assert( cascade < m_CascadeCount );
+    return m_RectCount[ cascade ];
+}
+
+//-----------------------------------------------------------------------------------
+//      描画が必要な矩形を取得します.
+//-----------------------------------------------------------------------------------
+const CascadeCoverage::Rect& CascadeCoverage::GetRect( u32 cascade, u32 index ) const
+{
+    assert( cascade < m_CascadeCount );
+    assert( index < m_RectCount[ cascade ] );
+    return m_Rects[ cascade ][ index ];
+}
+
+//-----------------------------------------------------------------------------------
+//      描画が必要な矩形全体を囲む矩形を取得します.
+//-----------------------------------------------------------------------------------
+bool CascadeCoverage::GetBoundingRect( u32 cascade, Rect& result ) const
+{
+    if ( cascade >= m_CascadeCount || m_RectCount[ cascade ] == 0 )
+    { return false; }
+
+    result = m_Rects[ cascade ][ 0 ];
+    for( u32 i=1; i<m_RectCount[ cascade ]; ++i )
+    {
+        const Rect& rect = m_Rects[ cascade ][ i ];
+        result.MinX = asdx::Min( result.MinX, rect.MinX );
+        result.MinY = asdx::Min( result.MinY, rect.MinY );
+        result.MaxX = asdx::Max( result.MaxX, rect.MaxX );
+        result.MaxY = asdx::Max( result.MaxY, rect.MaxY );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      AABBが描画が必要な領域に掛かるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool CascadeCoverage::TestBox( u32 cascade, const asdx::BoundingBox& box ) const
+{
+    if ( cascade >= m_CascadeCount )
+    { return true; }
+
+    // シャドウマップ上での範囲を求める.
+    asdx::Vector3 mini(  F32_MAX,  F32_MAX,  F32_MAX );
+    asdx::Vector3 maxi( -F32_MAX, -F32_MAX, -F32_MAX );
+    for( u32 i=0; i<8; ++i )
+    {
+        asdx::Vector3 corner(
+            ( i & 0x1 ) ? box.maxi.x : box.mini.x,
+            ( i & 0x2 ) ? box.maxi.y : box.mini.y,
+            ( i & 0x4 ) ? box.maxi.z : box.mini.z );
+
+        asdx::Vector4 clip;
+        asdx::Vector4::Transform( asdx::Vector4( corner, 1.0f ), m_ShadowMatrix[ cascade ], clip );
+
+        // 射影中心の後ろに回り込む場合は判定できないので描画する.
+        if ( clip.w <= 0.0f )
+        { return true; }
+
+        asdx::Vector3 point( clip.x / clip.w, clip.y / clip.w, clip.z / clip.w );
+        mini = asdx::Vector3::Min( mini, point );
+        maxi = asdx::Vector3::Max( maxi, point );
+    }
+
+    Rect rect = MakeRect( mini.x, mini.y, maxi.x, maxi.y );
+    for( u32 i=0; i<m_RectCount[ cascade ]; ++i )
+    {
+        if ( IsOverlap( rect, m_Rects[ cascade ][ i ] ) )
+        { return true; }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      細かいカスケードが覆う領域を粗いカスケードの座標系で求めます.
+//-----------------------------------------------------------------------------------
+bool CascadeCoverage::ComputeCoveredRect( u32 finer, u32 coarser, f32 border, Rect& result ) const
+{
+    const asdx::Matrix& finerMatrix   = m_ShadowMatrix[ finer ];
+    const asdx::Matrix& coarserMatrix = m_ShadowMatrix[ coarser ];
+
+    // 透視変換を含む場合は軸平行な矩形に写らない.
+    if ( !IsAffine( finerMatrix ) || !IsAffine( coarserMatrix ) )
+    { return false; }
+
+    // 細かいカスケードのデバイス座標から粗いカスケードのデバイス座標への変換.
+    asdx::Matrix mapping = asdx::Matrix::Invert( finerMatrix ) * coarserMatrix;
+
+    // XYが回転せず, 深度にも依存しない場合のみ扱う.
+    if ( fabs( mapping._12 ) > AXIS_EPSILON || fabs( mapping._21 ) > AXIS_EPSILON
+      || fabs( mapping._31 ) > AXIS_EPSILON || fabs( mapping._32 ) > AXIS_EPSILON )
+    { return false; }
+
+    f32 minX = ( -1.0f + border ) * mapping._11 + mapping._41;
+    f32 maxX = (  1.0f - border ) * mapping._11 + mapping._41;
+    f32 minY = ( -1.0f + border ) * mapping._22 + mapping._42;
+    f32 maxY = (  1.0f - border ) * mapping._22 + mapping._42;
+
+    result = MakeRect(
+        asdx::Min( minX, maxX ),
+        asdx::Min( minY, maxY ),
+        asdx::Max( minX, maxX ),
+        asdx::Max( minY, maxY ) );
+
+    return !IsEmpty( result );
+}
+
+//-----------------------------------------------------------------------------------
+//      描画が必要な領域から矩形を差し引きます.
+//-----------------------------------------------------------------------------------
+void CascadeCoverage::SubtractRect( u32 cascade, const Rect& value )
+{
+    Rect pieces[ MAX_RECT_COUNT ];
+    u32  count = 0;
+
+    for( u32 i=0; i<m_RectCount[ cascade ]; ++i )
+    {
+        const Rect& rect = m_Rects[ cascade ][ i ];
+
+        if ( !IsOverlap( rect, value ) )
+        {
+            if ( count >= MAX_RECT_COUNT )
+            { return; }
+
+            pieces[ count++ ] = rect;
+            continue;
+        }
+
+        // 上下左右の最大4つに分割する.
+        Rect candidates[ 4 ];
+        candidates[0] = MakeRect( rect.MinX, rect.MinY, rect.MaxX, value.MinY );
+        candidates[1] = MakeRect( rect.MinX, value.MaxY, rect.MaxX, rect.MaxY );
+        candidates[2] = MakeRect( rect.MinX, asdx::Max( rect.MinY, value.MinY ), value.MinX, asdx::Min( rect.MaxY, value.MaxY ) );
+        candidates[3] = MakeRect( value.MaxX, asdx::Max( rect.MinY, value.MinY ), rect.MaxX, asdx::Min( rect.MaxY, value.MaxY ) );
+
+        for( u32 j=0; j<4; ++j )
+        {
+            if ( IsEmpty( candidates[j] ) )
+            { continue; }
+
+            // 矩形数が上限を超える場合は差し引かずに保守的な結果を残す.
+            if ( count >= MAX_RECT_COUNT )
+            { return; }
+
+            pieces[ count++ ] = candidates[j];
+        }
+    }
+
+    for( u32 i=0; i<count; ++i )
+    { m_Rects[ cascade ][ i ] = pieces[i]; }
+
+    m_RectCount[ cascade ] = count;
+}
@@ -0,0 +1,229 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ChunkResidency.cpp
+// Desc : Streaming Chunk Residency Manager Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ChunkResidency.h>
+#include <LodSelector.h>
+#include <algorithm>
+#include <cassert>
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ChunkResidency class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+ChunkResidency::ChunkResidency()
+: m_Chunks      ()
+, m_Candidates  ()
+, m_Victims     ()
+, m_Config      ()
+, m_LoadingSize ( 0 )
+, m_Statistics  ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+ChunkResidency::~ChunkResidency()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+void ChunkResidency::Init( u32 chunkCount, const Config& config )
+{
+    Term();
+
+    Chunk chunk;
+    chunk.Center    = asdx::Vector3( 0.0f, 0.0f, 0.0f );
+    chunk.Radius    = 0.0f;
+    chunk.BaseError = 0.0f;
+    chunk.Size      = 0;
+    chunk.State     = STATE_EVICTED;
+    chunk.Priority  = 0.0f;
+
+    m_Chunks.assign( chunkCount, chunk );
+    m_Candidates.reserve( chunkCount );
+    m_Victims   .reserve( chunkCount );
+    m_Config = config;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void ChunkResidency::Term()
+{
+    m_Chunks    .clear();
+    m_Candidates.clear();
+    m_Victims   .clear();
+    m_Config      = Config();
+    m_LoadingSize = 0;
+    m_Statistics  = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンクの情報を設定します.
+//-----------------------------------------------------------------------------------
+void ChunkResidency::SetChunk
+(
+    u32                     index,
+    const asdx::Vector3&    mini,
+    const asdx::Vector3&    maxi,
+    f32                     baseError,
+    u64                     size
+)
+{
+    assert( index < m_Chunks.size() );
+
+    Chunk& chunk = m_Chunks[ index ];
+    chunk.Center    = ( mini + maxi ) * 0.5f;
+    chunk.Radius    = asdx::Vector3::Distance( mini, maxi ) * 0.5f;
+    chunk.BaseError = baseError;
+    chunk.Size      = size;
+}
+
+//-----------------------------------------------------------------------------------
+//      優先度を求めて, 読み込むチャンクと解放するチャンクを決めます.
+//-----------------------------------------------------------------------------------
+void ChunkResidency::Update
+(
+    const asdx::Matrix&     worldViewProj,
+    f32                     width,
+    f32                     height,
+    std::vector< u32 >&     requests,
+    std::vector< u32 >&     evictions
+)
+{
+    requests .clear();
+    evictions.clear();
+    m_Candidates.clear();
+    m_Victims   .clear();
+
+    m_Statistics.WantedCount  = 0;
+    m_Statistics.RequestCount = 0;
+    m_Statistics.EvictCount   = 0;
+
+    // 基本LODの誤差を画面に投影して優先度とする. 視点がスフィアの内側にある場合は最優先.
+    for( u32 i=0; i<u32( m_Chunks.size() ); ++i )
+    {
+        Chunk& chunk = m_Chunks[i];
+
+        f32 pixelsPerUnit = LodSelector::ComputePixelsPerUnit( worldViewProj, chunk.Center, chunk.Radius, width, height );
+        chunk.Priority = ( pixelsPerUnit >= F32_MAX ) ? F32_MAX : chunk.BaseError * pixelsPerUnit;
+
+        if ( chunk.State == STATE_RESIDENT )
+        { m_Victims.push_back( i ); }
+
+        if ( chunk.Priority <= m_Config.PixelError )
+        { continue; }
+
+        m_Statistics.WantedCount++;
+        if ( chunk.State == STATE_EVICTED )
+        { m_Candidates.push_back( i ); }
+    }
+
+    const std::vector< Chunk >& chunks = m_Chunks;
+    std::sort( m_Candidates.begin(), m_Candidates.end(), [&chunks]( u32 lhs, u32 rhs )
+    { return chunks[ lhs ].Priority > chunks[ rhs ].Priority; } );
+    std::sort( m_Victims.begin(), m_Victims.end(), [&chunks]( u32 lhs, u32 rhs )
+    { return chunks[ lhs ].Priority < chunks[ rhs ].Priority; } );
+
+    // 優先度の高い順に, 同時読み込み数と予算の範囲で要求する.
+    u64    committed = m_Statistics.ResidentSize + m_LoadingSize;
+    size_t victim    = 0;
+    for( size_t i=0; i<m_Candidates.size(); ++i )
+    {
+        if ( m_Statistics.LoadingCount >= m_Config.MaxLoadingCount )
+        { break; }
+
+        Chunk& chunk = m_Chunks[ m_Candidates[i] ];
+
+        // 予算を超える場合は, 優先度の低い常駐チャンクから解放する.
+        while( committed + chunk.Size > m_Config.MemoryBudget
+            && victim < m_Victims.size()
+            && m_Chunks[ m_Victims[ victim ] ].Priority < chunk.Priority )
+        {
+            Chunk& target = m_Chunks[ m_Victims[ victim ] ];
+            target.State = STATE_EVICTED;
+            committed                  -= target.Size;
+            m_Statistics.ResidentSize  -= target.Size;
+            m_Statistics.ResidentCount--;
+            m_Statistics.EvictCount++;
+            evictions.push_back( m_Victims[ victim ] );
+            victim++;
+        }
+
+        // 残りの候補は優先度が低いので, 入らなければ打ち切る.
+        if ( committed + chunk.Size > m_Config.MemoryBudget )
+        { break; }
+
+        chunk.State = STATE_LOADING;
+        committed     += chunk.Size;
+        m_LoadingSize += chunk.Size;
+        m_Statistics.LoadingCount++;
+        m_Statistics.RequestCount++;
+        requests.push_back( m_Candidates[i] );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込みが完了したことを通知します.
+//-----------------------------------------------------------------------------------
+void ChunkResidency::OnLoaded( u32 index, bool success )
+{
+    assert( index < m_Chunks.size() );
+
+    Chunk& chunk = m_Chunks[ index ];
+    if ( chunk.State != STATE_LOADING )
+    { return; }
+
+    m_LoadingSize -= chunk.Size;
+    m_Statistics.LoadingCount--;
+
+    if ( success )
+    {
+        chunk.State = STATE_RESIDENT;
+        m_Statistics.ResidentSize += chunk.Size;
+        m_Statistics.ResidentCount++;
+    }
+    else
+    { chunk.State = STATE_FAILED; }
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンク数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ChunkResidency::GetChunkCount() const
+{ return u32( m_Chunks.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      チャンクの状態を取得します.
+//-----------------------------------------------------------------------------------
+ChunkResidency::STATE ChunkResidency::GetState( u32 index ) const
+{
+    assert( index < m_Chunks.size() );
+    return m_Chunks[ index ].State;
+}
+
+//-----------------------------------------------------------------------------------
+//      直前の更新で求めたチャンクの優先度を取得します.
+//-----------------------------------------------------------------------------------
+f32 ChunkResidency::GetPriority( u32 index ) const
+{
+    assert( index < m_Chunks.size() );
+    return m_Chunks[ index ].Priority;
+}
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const ChunkResidency::Statistics& ChunkResidency::GetStatistics() const
+{ return m_Statistics; }
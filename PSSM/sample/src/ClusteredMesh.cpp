@@ -0,0 +1,1478 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ClusteredMesh.cpp
+// Desc : Clustered Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ClusteredMesh.h>
+#include <FrustumCulling.h>
+#include <asdxLog.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <utility>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//! @brief      頂点データをバイト列で比較します.
+//-----------------------------------------------------------------------------------
+struct VertexLess
+{
+    const u8*   pData;      //!< 頂点データです.
+    u32         Stride;     //!< 頂点ストライドです.
+
+    VertexLess( const u8* data, u32 stride )
+    : pData ( data )
+    , Stride( stride )
+    { /* DO_NOTHING */ }
+
+    bool operator () ( u32 lhs, u32 rhs ) const
+    { return memcmp( pData + lhs * Stride, pData + rhs * Stride, Stride ) < 0; }
+};
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です.
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT =
+{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です(圧縮頂点用).
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT_PACKED =
+{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      マテリアルが未設定であることを表す番号です.
+//-----------------------------------------------------------------------------------
+static const u32 INVALID_MATERIAL = 0xffffffff;
+
+///////////////////////////////////////////////////////////////////////////////////
+// MaterialParam structure
+///////////////////////////////////////////////////////////////////////////////////
+struct MaterialParam
+{
+    asdx::Vector3   Diffuse;        //!< 拡散反射色です.
+    f32             Alpha;          //!< 透過度です.
+    asdx::Vector3   Specular;       //!< 鏡面反射色です.
+    f32             Power;          //!< 鏡面反射強度です.
+    asdx::Vector3   Emissive;       //!< 自己照明色です.
+    f32             Bump;           //!< バンプマッピングフラグです.
+};
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ClusteredMesh class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+ClusteredMesh::ClusteredMesh()
+: asdx::Mesh         ()
+, m_Clusterizer      ()
+, m_pCullResult      ( nullptr )
+, m_Dequantize       ()
+, m_IsPacked         ( false )
+, m_QuantizeMin      ( 0.0f, 0.0f, 0.0f )
+, m_QuantizeMax      ( 0.0f, 0.0f, 0.0f )
+, m_pDepthVB         ( nullptr )
+, m_pDepthIB         ( nullptr )
+, m_pDepthIL         ( nullptr )
+, m_DepthStride      ( 0 )
+, m_DepthVertexCount ( 0 )
+, m_IndexFormat      ( DXGI_FORMAT_R32_UINT )
+, m_DepthIndexFormat ( DXGI_FORMAT_R32_UINT )
+, m_IndexChunks      ()
+, m_DepthIndexChunks ()
+, m_DepthRemap       ()
+, m_LodLevels        ()
+, m_LodErrors        ()
+, m_pLodIB           ( nullptr )
+, m_pDepthLodIB      ( nullptr )
+, m_LodIndexFormat   ( DXGI_FORMAT_R32_UINT )
+, m_DepthLodFormat   ( DXGI_FORMAT_R32_UINT )
+, m_LodIndexChunks   ()
+, m_DepthLodChunks   ()
+, m_CurrentLod       ( 0 )
+, m_Materials        ()
+, m_TextureCache     ()
+, m_Bindings         ()
+, m_pSourceMaterials ( nullptr )
+, m_pSourcePool      ( nullptr )
+, m_DrawOrder        ()
+, m_BoundMaterial    ( INVALID_MATERIAL )
+, m_BindStats        ()
+, m_pInstanceIL      ( nullptr )
+, m_pDepthInstanceIL ( nullptr )
+, m_pInstances       ( nullptr )
+, m_ChunkBounds      ()
+, m_SubsetChunk      ()
+, m_pChunkMask       ( nullptr )
+{ m_Dequantize.Identity(); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+ClusteredMesh::~ClusteredMesh()
+{
+    TermInstancing();
+    TermBindings();
+    TermLod();
+    TermDepthStream();
+    m_Clusterizer.Release();
+}
+
+//-----------------------------------------------------------------------------------
+//      ムーブコンストラクタです.
+//-----------------------------------------------------------------------------------
+ClusteredMesh::ClusteredMesh( ClusteredMesh&& value )
+: asdx::Mesh         ()
+, m_Clusterizer      ()
+, m_pCullResult      ( nullptr )
+, m_Dequantize       ()
+, m_IsPacked         ( false )
+, m_QuantizeMin      ( 0.0f, 0.0f, 0.0f )
+, m_QuantizeMax      ( 0.0f, 0.0f, 0.0f )
+, m_pDepthVB         ( nullptr )
+, m_pDepthIB         ( nullptr )
+, m_pDepthIL         ( nullptr )
+, m_DepthStride      ( 0 )
+, m_DepthVertexCount ( 0 )
+, m_IndexFormat      ( DXGI_FORMAT_R32_UINT )
+, m_DepthIndexFormat ( DXGI_FORMAT_R32_UINT )
+, m_IndexChunks      ()
+, m_DepthIndexChunks ()
+, m_DepthRemap       ()
+, m_LodLevels        ()
+, m_LodErrors        ()
+, m_pLodIB           ( nullptr )
+, m_pDepthLodIB      ( nullptr )
+, m_LodIndexFormat   ( DXGI_FORMAT_R32_UINT )
+, m_DepthLodFormat   ( DXGI_FORMAT_R32_UINT )
+, m_LodIndexChunks   ()
+, m_DepthLodChunks   ()
+, m_CurrentLod       ( 0 )
+, m_Materials        ()
+, m_TextureCache     ()
+, m_Bindings         ()
+, m_pSourceMaterials ( nullptr )
+, m_pSourcePool      ( nullptr )
+, m_DrawOrder        ()
+, m_BoundMaterial    ( INVALID_MATERIAL )
+, m_BindStats        ()
+, m_pInstanceIL      ( nullptr )
+, m_pDepthInstanceIL ( nullptr )
+, m_pInstances       ( nullptr )
+, m_ChunkBounds      ()
+, m_SubsetChunk      ()
+, m_pChunkMask       ( nullptr )
+{
+    m_Dequantize.Identity();
+    Swap( value );
+}
+
+//-----------------------------------------------------------------------------------
+//      ムーブ代入演算子です.
+//-----------------------------------------------------------------------------------
+ClusteredMesh& ClusteredMesh::operator = ( ClusteredMesh&& value )
+{
+    if ( this != &value )
+    {
+        Term();
+        Swap( value );
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::Init
+(
+    ID3D11Device*        pDevice,
+    const asdx::ResMesh& mesh,
+    const void*          pShaderBytecode,
+    const u32            byteCodeLength,
+    const char*          resFolderPath,
+    const char*          dummyFolderPath,
+    bool                 usePackedVertex,
+    const MaterialTable* pMaterials,
+    ThreadPool*          pPool
+)
+{
+    // OnCreateIL(), OnCreateVB(), OnCreateMaterial() で参照するので先に設定しておく.
+    m_IsPacked         = usePackedVertex;
+    m_pSourceMaterials = pMaterials;
+    m_pSourcePool      = pPool;
+    m_Dequantize.Identity();
+
+    bool result = asdx::Mesh::Init( pDevice, mesh, pShaderBytecode, byteCodeLength, resFolderPath, dummyFolderPath );
+    m_pSourceMaterials = nullptr;
+    m_pSourcePool      = nullptr;
+    if ( !result )
+    { return false; }
+
+    // 既定の初期化でストライドが上書きされても良いように設定し直す.
+    if ( m_IsPacked )
+    {
+        m_Stride = sizeof( PackedVertex );
+        m_Offset = 0;
+    }
+
+    if ( !m_Clusterizer.Build( mesh ) )
+    {
+        ELOG( "Error : MeshClusterizer::Build() Failed." );
+        asdx::Mesh::Term();
+        return false;
+    }
+
+    // インデックスの並びはクック時にしか変えられないので, ここでは描画順だけをマテリアル順にする.
+    SubsetBatcher::ComputeDrawOrder(
+        reinterpret_cast<const MshSubset*>( m_pSubset ),
+        m_SubsetCount,
+        m_DrawOrder );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      深度のみの描画に使う位置座標だけの頂点ストリームを生成します.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::InitDepthStream
+(
+    ID3D11Device*        pDevice,
+    const asdx::ResMesh& mesh,
+    const void*          pShaderBytecode,
+    const u32            byteCodeLength,
+    bool                 weldPositions
+)
+{
+    TermDepthStream();
+
+    const asdx::ResMesh::Vertex* pVertices   = mesh.GetVertices();
+    const asdx::ResMesh::Index*  pIndices    = mesh.GetIndices();
+    u32                          vertexCount = mesh.GetVertexCount();
+    u32                          indexCount  = mesh.GetIndexCount();
+    if ( pVertices == nullptr || pIndices == nullptr || vertexCount == 0 || indexCount == 0 )
+    {
+        ELOG( "Error : Invalid Mesh Data." );
+        return false;
+    }
+
+    // メイン描画と同じ形式の位置座標を作る. 深度の値を一致させるため圧縮方法も揃える.
+    const D3D11_INPUT_ELEMENT_DESC& element = ( m_IsPacked ) ? DEPTH_INPUT_ELEMENT_PACKED : DEPTH_INPUT_ELEMENT;
+    u32 stride = ( m_IsPacked ) ? sizeof( u16 ) * 4 : sizeof( asdx::Vector3 );
+
+    std::vector< u8 > positions( vertexCount * stride );
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        u8* ptr = &positions[ i * stride ];
+        if ( m_IsPacked )
+        { PackPosition( pVertices[i].Position, m_QuantizeMin, m_QuantizeMax, reinterpret_cast<u16*>( ptr ) ); }
+        else
+        { memcpy( ptr, &pVertices[i].Position, stride ); }
+    }
+
+    // 位置座標が同じ頂点を1つにまとめ, インデックスを振り直す.
+    std::vector< u8 >                    welded;
+    std::vector< asdx::ResMesh::Index >  remapped;
+    if ( weldPositions )
+    {
+        std::vector< u32 > order( vertexCount );
+        for( u32 i=0; i<vertexCount; ++i )
+        { order[i] = i; }
+
+        std::sort( order.begin(), order.end(), VertexLess( &positions[0], stride ) );
+
+        std::vector< u32 > remap( vertexCount );
+        welded.reserve( positions.size() );
+
+        u32 uniqueCount = 0;
+        for( u32 i=0; i<vertexCount; ++i )
+        {
+            const u8* ptr = &positions[ order[i] * stride ];
+            if ( i == 0 || memcmp( ptr, &positions[ order[ i - 1 ] * stride ], stride ) != 0 )
+            {
+                welded.insert( welded.end(), ptr, ptr + stride );
+                uniqueCount++;
+            }
+            remap[ order[i] ] = uniqueCount - 1;
+        }
+
+        remapped.resize( indexCount );
+        for( u32 i=0; i<indexCount; ++i )
+        { remapped[i] = remap[ pIndices[i] ]; }
+
+        positions.swap( welded );
+        vertexCount = uniqueCount;
+
+        // 詳細度のインデックスも振り直せるように変換表を残しておく.
+        m_DepthRemap.swap( remap );
+    }
+
+    HRESULT hr = S_OK;
+
+    // 頂点バッファの生成.
+    {
+        D3D11_BUFFER_DESC desc;
+        ZeroMemory( &desc, sizeof( desc ) );
+        desc.Usage          = D3D11_USAGE_IMMUTABLE;
+        desc.ByteWidth      = stride * vertexCount;
+        desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+        desc.CPUAccessFlags = 0;
+
+        D3D11_SUBRESOURCE_DATA res;
+        ZeroMemory( &res, sizeof( res ) );
+        res.pSysMem = &positions[0];
+
+        hr = pDevice->CreateBuffer( &desc, &res, &m_pDepthVB );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            return false;
+        }
+    }
+
+    // インデックスバッファの生成. まとめない場合は通常のものを共有する.
+    if ( weldPositions )
+    {
+        if ( !CreateIndexBuffer( pDevice, &remapped[0], indexCount, mesh.GetSubsets(), mesh.GetSubsetCount(), &m_pDepthIB, m_DepthIndexFormat, m_DepthIndexChunks ) )
+        {
+            TermDepthStream();
+            return false;
+        }
+    }
+
+    // 入力レイアウトの生成.
+    hr = pDevice->CreateInputLayout( &element, 1, pShaderBytecode, byteCodeLength, &m_pDepthIL );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+        TermDepthStream();
+        return false;
+    }
+
+    m_DepthStride      = stride;
+    m_DepthVertexCount = vertexCount;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細度(LOD)のインデックスバッファを生成します.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::InitLod( ID3D11Device* pDevice, MeshSimplifier::LodChain&& chain )
+{
+    TermLod();
+
+    // 詳細度が作れなかった場合は元のメッシュだけで描画する.
+    if ( chain.Levels.empty() || chain.Indices.empty() )
+    { return true; }
+
+    const asdx::ResMesh::Index* pIndices   = &chain.Indices[0];
+    u32                         indexCount = u32( chain.Indices.size() );
+
+    // 全ての詳細度のサブセットを並べて, まとめて16bit化する.
+    std::vector< asdx::ResMesh::Subset > subsets;
+    for( size_t i=0; i<chain.Levels.size(); ++i )
+    {
+        if ( chain.Levels[i].Subsets.size() != m_SubsetCount )
+        {
+            ELOG( "Error : Subset Count Mismatch." );
+            return false;
+        }
+        subsets.insert( subsets.end(), chain.Levels[i].Subsets.begin(), chain.Levels[i].Subsets.end() );
+    }
+
+    if ( !CreateIndexBuffer( pDevice, pIndices, indexCount, &subsets[0], u32( subsets.size() ), &m_pLodIB, m_LodIndexFormat, m_LodIndexChunks ) )
+    {
+        TermLod();
+        return false;
+    }
+
+    // 位置座標をまとめた深度描画用の頂点ストリームに合わせて振り直す.
+    if ( !m_DepthRemap.empty() )
+    {
+        std::vector< asdx::ResMesh::Index > remapped( indexCount );
+        for( u32 i=0; i<indexCount; ++i )
+        { remapped[i] = m_DepthRemap[ pIndices[i] ]; }
+
+        if ( !CreateIndexBuffer( pDevice, &remapped[0], indexCount, &subsets[0], u32( subsets.size() ), &m_pDepthLodIB, m_DepthLodFormat, m_DepthLodChunks ) )
+        {
+            TermLod();
+            return false;
+        }
+    }
+
+    // サブセットの配列はコピーせずに引き取る.
+    m_LodLevels.swap( chain.Levels );
+
+    m_LodErrors.resize( m_LodLevels.size() + 1 );
+    m_LodErrors[0] = 0.0f;
+    for( size_t i=0; i<m_LodLevels.size(); ++i )
+    { m_LodErrors[ i + 1 ] = m_LodLevels[i].Error; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      インスタンス描画用の入力レイアウトを生成します.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::InitInstancing
+(
+    ID3D11Device*   pDevice,
+    const void*     pShaderBytecode,
+    const u32       byteCodeLength,
+    const void*     pDepthShaderBytecode,
+    const u32       depthByteCodeLength
+)
+{
+    TermInstancing();
+
+    if ( pDevice == nullptr || pShaderBytecode == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    // 頂点データの入力要素の後ろにインスタンスデータの入力要素を並べる.
+    std::vector< D3D11_INPUT_ELEMENT_DESC > elements;
+    if ( m_IsPacked )
+    { elements.assign( PackedVertex::INPUT_ELEMENTS, PackedVertex::INPUT_ELEMENTS + PackedVertex::NUM_INPUT_ELEMENT ); }
+    else
+    { elements.assign( asdx::ResMesh::INPUT_ELEMENTS, asdx::ResMesh::INPUT_ELEMENTS + asdx::ResMesh::NUM_INPUT_ELEMENT ); }
+    elements.insert( elements.end(), InstanceBuffer::INPUT_ELEMENTS, InstanceBuffer::INPUT_ELEMENTS + InstanceBuffer::NUM_INPUT_ELEMENT );
+
+    HRESULT hr = pDevice->CreateInputLayout(
+        &elements[0],
+        u32( elements.size() ),
+        pShaderBytecode,
+        byteCodeLength,
+        &m_pInstanceIL );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+        return false;
+    }
+
+    // 深度描画用の頂点ストリームが無い場合は通常の入力レイアウトで描画する.
+    if ( pDepthShaderBytecode == nullptr || m_pDepthVB == nullptr )
+    { return true; }
+
+    elements.clear();
+    elements.push_back( ( m_IsPacked ) ? DEPTH_INPUT_ELEMENT_PACKED : DEPTH_INPUT_ELEMENT );
+    elements.insert( elements.end(), InstanceBuffer::INPUT_ELEMENTS, InstanceBuffer::INPUT_ELEMENTS + InstanceBuffer::NUM_INPUT_ELEMENT );
+
+    hr = pDevice->CreateInputLayout(
+        &elements[0],
+        u32( elements.size() ),
+        pDepthShaderBytecode,
+        depthByteCodeLength,
+        &m_pDepthInstanceIL );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+        TermInstancing();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      空間分割のチャンクを設定します.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::InitChunks( const CookedChunk* pChunks, u32 chunkCount )
+{
+    m_ChunkBounds.clear();
+    m_SubsetChunk.clear();
+    m_pChunkMask = nullptr;
+
+    if ( pChunks == nullptr || chunkCount == 0 )
+    { return true; }
+
+    // チャンクに含まれないサブセットは常に描画するように, 範囲外の番号にしておく.
+    std::vector< u32 > subsetChunk( m_SubsetCount, chunkCount );
+    std::vector< asdx::BoundingBox > bounds( chunkCount );
+    for( u32 i=0; i<chunkCount; ++i )
+    {
+        const CookedChunk& chunk = pChunks[i];
+        if ( u64( chunk.SubsetOffset ) + chunk.SubsetCount > m_SubsetCount )
+        {
+            ELOG( "Error : Invalid Chunk. index = %u", i );
+            return false;
+        }
+
+        for( u32 j=0; j<chunk.SubsetCount; ++j )
+        { subsetChunk[ chunk.SubsetOffset + j ] = i; }
+
+        bounds[i].mini = asdx::Vector3( chunk.Min[0], chunk.Min[1], chunk.Min[2] );
+        bounds[i].maxi = asdx::Vector3( chunk.Max[0], chunk.Max[1], chunk.Max[2] );
+    }
+
+    m_ChunkBounds.swap( bounds );
+    m_SubsetChunk.swap( subsetChunk );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::Term()
+{
+    TermInstancing();
+    TermBindings();
+    TermLod();
+    TermDepthStream();
+    m_Clusterizer.Release();
+    asdx::Mesh::Term();
+
+    m_IndexChunks.clear();
+    m_IndexFormat = DXGI_FORMAT_R32_UINT;
+
+    m_Dequantize.Identity();
+    m_IsPacked   = false;
+
+    m_DrawOrder.clear();
+    m_BoundMaterial = INVALID_MATERIAL;
+    m_BindStats     = BindStatistics();
+
+    m_ChunkBounds.clear();
+    m_SubsetChunk.clear();
+    m_pChunkMask = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      カリング結果の描画範囲だけを描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::Draw( ID3D11DeviceContext* pDeviceContext, const MeshClusterizer::CullResult& result )
+{
+    m_pCullResult = &result;
+    asdx::Mesh::Draw( pDeviceContext );
+    m_pCullResult = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      深度のみを描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawDepthOnly( ID3D11DeviceContext* pDeviceContext )
+{
+    if ( !CanUseDepthStream() )
+    {
+        asdx::Mesh::Draw( pDeviceContext );
+        return;
+    }
+
+    if ( m_pDepthIB != nullptr )
+    { BindDepthStream( pDeviceContext, m_pDepthIB, m_DepthIndexFormat ); }
+    else
+    { BindDepthStream( pDeviceContext, m_pIB, m_IndexFormat ); }
+
+    const std::vector< IndexCompactor::Chunk >& chunks = ( m_pDepthIB != nullptr ) ? m_DepthIndexChunks : m_IndexChunks;
+
+    // マテリアルの切り替えが無いので, 連続するサブセットは1回の描画にまとめる.
+    u32 offset = 0;
+    u32 count  = 0;
+    for( u32 i=0; i<m_SubsetCount; ++i )
+    {
+        if ( !IsSubsetVisible( i ) )
+        { continue; }
+
+        const Mesh::Subset& subset = m_pSubset[i];
+        if ( count > 0 && offset + count == subset.IndexOffset )
+        {
+            count += subset.IndexCount;
+            continue;
+        }
+
+        if ( count > 0 )
+        { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+
+        offset = subset.IndexOffset;
+        count  = subset.IndexCount;
+    }
+
+    if ( count > 0 )
+    { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      カリング結果の描画範囲だけ深度のみを描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const MeshClusterizer::CullResult& result )
+{
+    if ( !CanUseDepthStream() )
+    {
+        Draw( pDeviceContext, result );
+        return;
+    }
+
+    if ( m_pDepthIB != nullptr )
+    { BindDepthStream( pDeviceContext, m_pDepthIB, m_DepthIndexFormat ); }
+    else
+    { BindDepthStream( pDeviceContext, m_pIB, m_IndexFormat ); }
+
+    const std::vector< IndexCompactor::Chunk >& chunks = ( m_pDepthIB != nullptr ) ? m_DepthIndexChunks : m_IndexChunks;
+
+    // サブセットをまたいで連続する範囲も1回の描画にまとめる. ベース頂点が変わる所では分割される.
+    // 見えないチャンクのサブセットの範囲は飛ばす.
+    u32 offset = 0;
+    u32 count  = 0;
+    u32 index  = 0;
+    for( size_t i=0; i<result.Ranges.size(); ++i )
+    {
+        while( index + 1 < result.SubsetRangeOffset.size() && result.SubsetRangeOffset[ index + 1 ] <= i )
+        { index++; }
+
+        if ( !IsSubsetVisible( index ) )
+        { continue; }
+
+        const MeshClusterizer::DrawRange& range = result.Ranges[i];
+        if ( count > 0 && offset + count == range.IndexOffset )
+        {
+            count += range.IndexCount;
+            continue;
+        }
+
+        if ( count > 0 )
+        { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+
+        offset = range.IndexOffset;
+        count  = range.IndexCount;
+    }
+
+    if ( count > 0 )
+    { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細度を指定して描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawLod( ID3D11DeviceContext* pDeviceContext, u32 lod )
+{
+    if ( lod == 0 || lod >= GetLodCount() )
+    {
+        asdx::Mesh::Draw( pDeviceContext );
+        return;
+    }
+
+    m_CurrentLod = lod;
+    asdx::Mesh::Draw( pDeviceContext );
+    m_CurrentLod = 0;
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細度を指定して深度のみを描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawDepthOnlyLod( ID3D11DeviceContext* pDeviceContext, u32 lod )
+{
+    if ( lod == 0 || lod >= GetLodCount() )
+    {
+        DrawDepthOnly( pDeviceContext );
+        return;
+    }
+
+    if ( !CanUseDepthStream() )
+    {
+        DrawLod( pDeviceContext, lod );
+        return;
+    }
+
+    if ( m_pDepthLodIB != nullptr )
+    { BindDepthStream( pDeviceContext, m_pDepthLodIB, m_DepthLodFormat ); }
+    else
+    { BindDepthStream( pDeviceContext, m_pLodIB, m_LodIndexFormat ); }
+
+    const std::vector< IndexCompactor::Chunk >& chunks = ( m_pDepthLodIB != nullptr ) ? m_DepthLodChunks : m_LodIndexChunks;
+    const std::vector< asdx::ResMesh::Subset >& subsets = m_LodLevels[ lod - 1 ].Subsets;
+
+    // 詳細度のサブセットは LodChain::Indices 内に詰めて並んでいるので, 連続する範囲をまとめる.
+    u32 offset = 0;
+    u32 count  = 0;
+    for( size_t i=0; i<subsets.size(); ++i )
+    {
+        // 詳細度のサブセットは元のメッシュと同じ番号なので, 同じチャンクに属する.
+        if ( !IsSubsetVisible( u32( i ) ) )
+        { continue; }
+
+        const asdx::ResMesh::Subset& subset = subsets[i];
+        if ( count > 0 && offset + count == subset.IndexOffset )
+        {
+            count += subset.IndexCount;
+            continue;
+        }
+
+        if ( count > 0 )
+        { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+
+        offset = subset.IndexOffset;
+        count  = subset.IndexCount;
+    }
+
+    if ( count > 0 )
+    { DrawIndexedRange( pDeviceContext, chunks, offset, count ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      インスタンス描画を行います.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawInstanced( ID3D11DeviceContext* pDeviceContext, const InstanceBuffer& instances, u32 lod )
+{
+    if ( m_pInstanceIL == nullptr || instances.GetCount() == 0 )
+    { return; }
+
+    m_pInstances = &instances;
+    DrawLod( pDeviceContext, lod );
+    m_pInstances = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      深度のみのインスタンス描画を行います.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawDepthOnlyInstanced( ID3D11DeviceContext* pDeviceContext, const InstanceBuffer& instances, u32 lod )
+{
+    // 深度描画用の入力レイアウトが無い場合は, 通常の頂点ストリームで描画する.
+    if ( m_pInstanceIL == nullptr || instances.GetCount() == 0 )
+    { return; }
+
+    m_pInstances = &instances;
+    DrawDepthOnlyLod( pDeviceContext, lod );
+    m_pInstances = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンクを視錐台でカリングします.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::CullChunks( const asdx::Matrix& worldViewProj, u8* pVisible ) const
+{
+    if ( pVisible == nullptr )
+    { return 0; }
+
+    asdx::BoundingFrustum frustum( worldViewProj );
+
+    u32 visibleCount = 0;
+    for( size_t i=0; i<m_ChunkBounds.size(); ++i )
+    {
+        if ( pVisible[i] == 0 )
+        { continue; }
+
+        if ( IsOutside( frustum, m_ChunkBounds[i] ) )
+        {
+            pVisible[i] = 0;
+            continue;
+        }
+
+        visibleCount++;
+    }
+
+    return visibleCount;
+}
+
+//-----------------------------------------------------------------------------------
+//      描画するチャンクを設定します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::SetChunkMask( const u8* pVisible )
+{ m_pChunkMask = pVisible; }
+
+//-----------------------------------------------------------------------------------
+//      チャンク数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetChunkCount() const
+{ return u32( m_ChunkBounds.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      チャンクのAABBを取得します.
+//-----------------------------------------------------------------------------------
+const asdx::BoundingBox& ClusteredMesh::GetChunkBoundingBox( u32 idx ) const
+{
+    assert( idx < m_ChunkBounds.size() );
+    return m_ChunkBounds[ idx ];
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュレットを取得します.
+//-----------------------------------------------------------------------------------
+const MeshClusterizer& ClusteredMesh::GetClusterizer() const
+{ return m_Clusterizer; }
+
+//-----------------------------------------------------------------------------------
+//      位置座標の逆量子化行列を取得します.
+//-----------------------------------------------------------------------------------
+const asdx::Matrix& ClusteredMesh::GetDequantizeMatrix() const
+{ return m_Dequantize; }
+
+//-----------------------------------------------------------------------------------
+//      圧縮頂点を使っているかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::IsPackedVertex() const
+{ return m_IsPacked; }
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の頂点数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetDepthVertexCount() const
+{ return m_DepthVertexCount; }
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の頂点ストライドを取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetDepthStride() const
+{ return m_DepthStride; }
+
+//-----------------------------------------------------------------------------------
+//      インデックスのサイズ(バイト数)を取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetIndexStride() const
+{ return ( m_IndexFormat == DXGI_FORMAT_R16_UINT ) ? sizeof( u16 ) : sizeof( u32 ); }
+
+//-----------------------------------------------------------------------------------
+//      ベース頂点ごとのチャンク数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetIndexChunkCount() const
+{ return u32( m_IndexChunks.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      詳細度の数を取得します(元のメッシュを含みます).
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetLodCount() const
+{ return u32( m_LodLevels.size() ) + 1; }
+
+//-----------------------------------------------------------------------------------
+//      詳細度ごとの誤差を取得します(ローカル座標系での距離).
+//-----------------------------------------------------------------------------------
+const f32* ClusteredMesh::GetLodErrors() const
+{
+    static const f32 s_Zero = 0.0f;
+    return ( m_LodErrors.empty() ) ? &s_Zero : &m_LodErrors[0];
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細度ごとの三角形数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ClusteredMesh::GetLodTriangleCount( u32 lod ) const
+{
+    if ( lod == 0 )
+    {
+        u32 count = 0;
+        for( u32 i=0; i<m_SubsetCount; ++i )
+        { count += m_pSubset[i].IndexCount; }
+        return count / 3;
+    }
+
+    if ( lod >= GetLodCount() )
+    { return 0; }
+
+    return m_LodLevels[ lod - 1 ].IndexCount / 3;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルテーブルを取得します.
+//-----------------------------------------------------------------------------------
+const MaterialTable& ClusteredMesh::GetMaterialTable() const
+{ return m_Materials; }
+
+//-----------------------------------------------------------------------------------
+//      テクスチャキャッシュを取得します.
+//-----------------------------------------------------------------------------------
+const TextureCache& ClusteredMesh::GetTextureCache() const
+{ return m_TextureCache; }
+
+//-----------------------------------------------------------------------------------
+//      マテリアル設定の統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const ClusteredMesh::BindStatistics& ClusteredMesh::GetBindStatistics() const
+{ return m_BindStats; }
+
+//-----------------------------------------------------------------------------------
+//      マテリアル設定の統計情報をリセットします.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::ResetBindStatistics()
+{ m_BindStats = BindStatistics(); }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::Swap( ClusteredMesh& value )
+{
+    // asdx::Mesh の管理するリソース.
+    std::swap( m_pVB,           value.m_pVB );
+    std::swap( m_pIB,           value.m_pIB );
+    std::swap( m_pMB,           value.m_pMB );
+    std::swap( m_pIL,           value.m_pIL );
+    std::swap( m_pDiffuseSmp,   value.m_pDiffuseSmp );
+    std::swap( m_pSpecularSmp,  value.m_pSpecularSmp );
+    std::swap( m_pNormalSmp,    value.m_pNormalSmp );
+    std::swap( m_Stride,        value.m_Stride );
+    std::swap( m_Offset,        value.m_Offset );
+    std::swap( m_SubsetCount,   value.m_SubsetCount );
+    std::swap( m_MaterialCount, value.m_MaterialCount );
+    std::swap( m_pSubset,       value.m_pSubset );
+    std::swap( m_pMaterial,     value.m_pMaterial );
+
+    // メッシュレット・圧縮頂点.
+    m_Clusterizer.Swap( value.m_Clusterizer );
+    std::swap( m_pCullResult,   value.m_pCullResult );
+    std::swap( m_Dequantize,    value.m_Dequantize );
+    std::swap( m_IsPacked,      value.m_IsPacked );
+    std::swap( m_QuantizeMin,   value.m_QuantizeMin );
+    std::swap( m_QuantizeMax,   value.m_QuantizeMax );
+
+    // 深度描画用のストリーム.
+    std::swap( m_pDepthVB,         value.m_pDepthVB );
+    std::swap( m_pDepthIB,         value.m_pDepthIB );
+    std::swap( m_pDepthIL,         value.m_pDepthIL );
+    std::swap( m_DepthStride,      value.m_DepthStride );
+    std::swap( m_DepthVertexCount, value.m_DepthVertexCount );
+    std::swap( m_IndexFormat,      value.m_IndexFormat );
+    std::swap( m_DepthIndexFormat, value.m_DepthIndexFormat );
+    m_IndexChunks     .swap( value.m_IndexChunks );
+    m_DepthIndexChunks.swap( value.m_DepthIndexChunks );
+    m_DepthRemap      .swap( value.m_DepthRemap );
+
+    // 詳細度.
+    m_LodLevels.swap( value.m_LodLevels );
+    m_LodErrors.swap( value.m_LodErrors );
+    std::swap( m_pLodIB,         value.m_pLodIB );
+    std::swap( m_pDepthLodIB,    value.m_pDepthLodIB );
+    std::swap( m_LodIndexFormat, value.m_LodIndexFormat );
+    std::swap( m_DepthLodFormat, value.m_DepthLodFormat );
+    std::swap( m_CurrentLod,     value.m_CurrentLod );
+    m_LodIndexChunks.swap( value.m_LodIndexChunks );
+    m_DepthLodChunks.swap( value.m_DepthLodChunks );
+
+    // マテリアル.
+    m_Materials   .Swap( value.m_Materials );
+    m_TextureCache.Swap( value.m_TextureCache );
+    m_Bindings    .swap( value.m_Bindings );
+    m_DrawOrder   .swap( value.m_DrawOrder );
+    std::swap( m_pSourceMaterials, value.m_pSourceMaterials );
+    std::swap( m_pSourcePool,      value.m_pSourcePool );
+    std::swap( m_BoundMaterial,    value.m_BoundMaterial );
+    std::swap( m_BindStats,        value.m_BindStats );
+
+    // インスタンス描画.
+    std::swap( m_pInstanceIL,      value.m_pInstanceIL );
+    std::swap( m_pDepthInstanceIL, value.m_pDepthInstanceIL );
+    std::swap( m_pInstances,       value.m_pInstances );
+
+    // 空間分割のチャンク.
+    m_ChunkBounds.swap( value.m_ChunkBounds );
+    m_SubsetChunk.swap( value.m_SubsetChunk );
+    std::swap( m_pChunkMask, value.m_pChunkMask );
+}
+
+//-----------------------------------------------------------------------------------
+//      入力レイアウト生成時の処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::OnCreateIL( ID3D11Device* pDevice, const void* shaderByteCode, const u32 byteCodeLength )
+{
+    if ( !m_IsPacked )
+    { return DefOnCreateIL( pDevice, shaderByteCode, byteCodeLength ); }
+
+    HRESULT hr = pDevice->CreateInputLayout(
+        PackedVertex::INPUT_ELEMENTS,
+        PackedVertex::NUM_INPUT_ELEMENT,
+        shaderByteCode,
+        byteCodeLength,
+        &m_pIL );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点バッファ生成時の処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::OnCreateVB( ID3D11Device* pDevice, const asdx::ResMesh& mesh )
+{
+    if ( !m_IsPacked )
+    { return DefOnCreateVB( pDevice, mesh ); }
+
+    const asdx::ResMesh::Vertex* pVertices   = mesh.GetVertices();
+    u32                          vertexCount = mesh.GetVertexCount();
+    if ( pVertices == nullptr || vertexCount == 0 )
+    {
+        ELOG( "Error : Invalid Vertex Data." );
+        return false;
+    }
+
+    // 位置座標はメッシュのAABBで量子化する.
+    asdx::Vector3 mini = pVertices[0].Position;
+    asdx::Vector3 maxi = pVertices[0].Position;
+    for( u32 i=1; i<vertexCount; ++i )
+    {
+        mini = asdx::Vector3::Min( mini, pVertices[i].Position );
+        maxi = asdx::Vector3::Max( maxi, pVertices[i].Position );
+    }
+
+    std::vector< PackedVertex > packed( vertexCount );
+    PackVertices( pVertices, vertexCount, mini, maxi, &packed[0] );
+
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Usage          = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth      = sizeof( PackedVertex ) * vertexCount;
+    desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA res;
+    ZeroMemory( &res, sizeof( res ) );
+    res.pSysMem = &packed[0];
+
+    HRESULT hr = pDevice->CreateBuffer( &desc, &res, &m_pVB );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+        return false;
+    }
+
+    m_Stride      = sizeof( PackedVertex );
+    m_Offset      = 0;
+    m_Dequantize  = ComputeDequantizeMatrix( mini, maxi );
+    m_QuantizeMin = mini;
+    m_QuantizeMax = maxi;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      インデックスバッファ生成時の処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::OnCreateIB( ID3D11Device* pDevice, const asdx::ResMesh& mesh )
+{
+    return CreateIndexBuffer(
+        pDevice,
+        mesh.GetIndices(),
+        mesh.GetIndexCount(),
+        mesh.GetSubsets(),
+        mesh.GetSubsetCount(),
+        &m_pIB,
+        m_IndexFormat,
+        m_IndexChunks );
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルバッファ生成時の処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::OnCreateMB( ID3D11Device*, const asdx::ResMesh& )
+{
+    // マテリアルごとに変更しない定数バッファを持つので, 共有の定数バッファは使わない.
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアル生成時の処理です.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::OnCreateMaterial
+(
+    ID3D11Device*           pDevice,
+    const asdx::ResMesh&    mesh,
+    const char*             resPath,
+    const char*             dummyPath
+)
+{
+    if ( m_pSourceMaterials != nullptr )
+    { m_Materials = (*m_pSourceMaterials); }
+    else if ( !m_Materials.Build( mesh ) )
+    {
+        ELOG( "Error : MaterialTable::Build() Failed." );
+        return false;
+    }
+
+    if ( !m_TextureCache.Init( pDevice, resPath, dummyPath, m_pSourcePool ) )
+    {
+        ELOG( "Error : TextureCache::Init() Failed." );
+        return false;
+    }
+
+    const StringTable& strings = m_Materials.GetStrings();
+    u32 count = m_Materials.GetCount();
+
+    // 参照されるテクスチャを先にまとめて読み込んでおき, Resolve() はキャッシュを引くだけにする.
+    if ( count > 0 )
+    {
+        std::vector< u32 > ids;
+        ids.reserve( count * MAX_TEXTURE_SLOT );
+        for( u32 i=0; i<count; ++i )
+        {
+            const MaterialTable::CompactMaterial& material = m_Materials.GetMaterial( i );
+            ids.push_back( material.DiffuseMap );
+            ids.push_back( material.SpecularMap );
+            ids.push_back( material.BumpMap );
+        }
+
+        m_TextureCache.Prefetch( strings, &ids[0], u32( ids.size() ), m_pSourcePool );
+    }
+
+    m_Bindings.resize( count );
+    for( u32 i=0; i<count; ++i )
+    {
+        const MaterialTable::CompactMaterial& material = m_Materials.GetMaterial( i );
+        MaterialBinding& binding = m_Bindings[i];
+
+        binding.pCB = nullptr;
+        binding.pSRV[ TEXTURE_SLOT_DIFFUSE  ] = m_TextureCache.Resolve( strings, material.DiffuseMap,  TextureCache::DUMMY_DIFFUSE );
+        binding.pSRV[ TEXTURE_SLOT_SPECULAR ] = m_TextureCache.Resolve( strings, material.SpecularMap, TextureCache::DUMMY_SPECULAR );
+        binding.pSRV[ TEXTURE_SLOT_NORMAL   ] = m_TextureCache.Resolve( strings, material.BumpMap,     TextureCache::DUMMY_BUMP );
+
+        MaterialParam param;
+        param.Diffuse  = material.Diffuse;
+        param.Alpha    = material.Alpha;
+        param.Specular = material.Specular;
+        param.Power    = material.Power;
+        param.Emissive = material.Emissive;
+        param.Bump     = ( material.BumpMap != StringTable::INVALID_ID ) ? 1.0f : 0.0f;
+
+        D3D11_BUFFER_DESC desc;
+        ZeroMemory( &desc, sizeof( desc ) );
+        desc.Usage          = D3D11_USAGE_IMMUTABLE;
+        desc.ByteWidth      = sizeof( MaterialParam );
+        desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+        desc.CPUAccessFlags = 0;
+
+        D3D11_SUBRESOURCE_DATA res;
+        ZeroMemory( &res, sizeof( res ) );
+        res.pSysMem = &param;
+
+        HRESULT hr = pDevice->CreateBuffer( &desc, &res, &binding.pCB );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            return false;
+        }
+    }
+
+    // 既定のマテリアル配列は使わない. マテリアル数は MaterialTable が持つので,
+    // DefOnTermMaterial() が空の配列を辿らないように数も 0 にしておく.
+    m_MaterialCount = 0;
+    m_pMaterial     = nullptr;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアル破棄時の処理です.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::OnTermMaterial()
+{
+    TermBindings();
+    DefOnTermMaterial();
+}
+
+//-----------------------------------------------------------------------------------
+//      描画開始時の処理です.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::OnDrawBegin( ID3D11DeviceContext* pDeviceContext )
+{
+    DefOnDrawBegin( pDeviceContext );
+    BeginMaterialBinding( pDeviceContext );
+
+    if ( m_pInstances != nullptr )
+    { BindInstanceStream( pDeviceContext, m_pInstanceIL ); }
+
+    // 既定の処理は32bitで設定するので, 実際のフォーマットで設定し直す.
+    if ( m_CurrentLod > 0 )
+    { pDeviceContext->IASetIndexBuffer( m_pLodIB, m_LodIndexFormat, 0 ); }
+    else
+    { pDeviceContext->IASetIndexBuffer( m_pIB, m_IndexFormat, 0 ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセット描画時の処理です.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::OnDrawSubset( ID3D11DeviceContext* pDeviceContext, const u32 order )
+{
+    // 同じマテリアルのサブセットが続くように描画順を入れ替える.
+    const u32 index = ( order < m_DrawOrder.size() ) ? m_DrawOrder[ order ] : order;
+    const Mesh::Subset& subset = m_pSubset[ index ];
+
+    // 見えないチャンクのサブセットはマテリアルの設定も行わない.
+    if ( !IsSubsetVisible( index ) )
+    { return; }
+
+    // 詳細度を指定した場合は, 同じ番号のサブセットを詳細度のインデックスバッファから描画する.
+    if ( m_CurrentLod > 0 )
+    {
+        const asdx::ResMesh::Subset& lodSubset = m_LodLevels[ m_CurrentLod - 1 ].Subsets[ index ];
+        if ( lodSubset.IndexCount == 0 )
+        { return; }
+
+        BindMaterial( pDeviceContext, subset.MaterialID );
+        DrawIndexedRange( pDeviceContext, m_LodIndexChunks, lodSubset.IndexOffset, lodSubset.IndexCount );
+        return;
+    }
+
+    bool useCullResult = ( m_pCullResult != nullptr && index + 1 < m_pCullResult->SubsetRangeOffset.size() );
+
+    u32 begin = 0;
+    u32 end   = 0;
+    if ( useCullResult )
+    {
+        begin = m_pCullResult->SubsetRangeOffset[ index + 0 ];
+        end   = m_pCullResult->SubsetRangeOffset[ index + 1 ];
+
+        // 全て見えない場合はマテリアルの設定も行わない.
+        if ( begin == end )
+        { return; }
+    }
+
+    BindMaterial( pDeviceContext, subset.MaterialID );
+
+    if ( !useCullResult )
+    {
+        DrawIndexedRange( pDeviceContext, m_IndexChunks, subset.IndexOffset, subset.IndexCount );
+        return;
+    }
+
+    for( u32 i=begin; i<end; ++i )
+    {
+        const MeshClusterizer::DrawRange& range = m_pCullResult->Ranges[i];
+        DrawIndexedRange( pDeviceContext, m_IndexChunks, range.IndexOffset, range.IndexCount );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルの設定を開始します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::BeginMaterialBinding( ID3D11DeviceContext* pDeviceContext )
+{
+    ID3D11SamplerState* pSmps[ MAX_TEXTURE_SLOT ] = {
+        m_pDiffuseSmp,
+        m_pSpecularSmp,
+        m_pNormalSmp
+    };
+    pDeviceContext->PSSetSamplers( 0, MAX_TEXTURE_SLOT, pSmps );
+
+    // 描画の間に他の処理で設定が変わっているかもしれないので, 描画ごとに設定し直す.
+    m_BoundMaterial = INVALID_MATERIAL;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルを設定します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::BindMaterial( ID3D11DeviceContext* pDeviceContext, u32 materialId )
+{
+    if ( materialId >= m_Bindings.size() )
+    { return; }
+
+    m_BindStats.RequestCount++;
+    if ( materialId == m_BoundMaterial )
+    { return; }
+
+    m_BoundMaterial = materialId;
+    m_BindStats.BindCount++;
+
+    const MaterialBinding& binding = m_Bindings[ materialId ];
+    pDeviceContext->PSSetConstantBuffers( 0, 1, &binding.pCB );
+    pDeviceContext->PSSetShaderResources( 0, MAX_TEXTURE_SLOT, binding.pSRV );
+}
+
+//-----------------------------------------------------------------------------------
+//      インデックスバッファを生成します.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::CreateIndexBuffer
+(
+    ID3D11Device*                           pDevice,
+    const asdx::ResMesh::Index*             pIndices,
+    u32                                     indexCount,
+    const asdx::ResMesh::Subset*            pSubsets,
+    u32                                     subsetCount,
+    ID3D11Buffer**                          ppBuffer,
+    DXGI_FORMAT&                            format,
+    std::vector< IndexCompactor::Chunk >&   chunks
+)
+{
+    if ( pIndices == nullptr || indexCount == 0 )
+    {
+        ELOG( "Error : Invalid Index Data." );
+        return false;
+    }
+
+    // 16bitに収まらない場合は32bitのまま使う.
+    IndexCompactor compactor;
+    bool is16Bit = compactor.Build( pIndices, indexCount, pSubsets, subsetCount );
+
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Usage          = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth      = ( ( is16Bit ) ? sizeof( u16 ) : sizeof( asdx::ResMesh::Index ) ) * indexCount;
+    desc.BindFlags      = D3D11_BIND_INDEX_BUFFER;
+    desc.CPUAccessFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA res;
+    ZeroMemory( &res, sizeof( res ) );
+    if ( is16Bit )
+    { res.pSysMem = compactor.GetIndices(); }
+    else
+    { res.pSysMem = pIndices; }
+
+    HRESULT hr = pDevice->CreateBuffer( &desc, &res, ppBuffer );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+        return false;
+    }
+
+    format = ( is16Bit ) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    chunks = compactor.GetChunks();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンクの境界で分割してインデックス範囲を描画します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::DrawIndexedRange
+(
+    ID3D11DeviceContext*                        pDeviceContext,
+    const std::vector< IndexCompactor::Chunk >& chunks,
+    u32                                         indexOffset,
+    u32                                         indexCount
+)
+{
+    u32 id = IndexCompactor::FindChunk( chunks, indexOffset );
+    while( indexCount > 0 && id < chunks.size() )
+    {
+        const IndexCompactor::Chunk& chunk = chunks[ id ];
+        if ( indexOffset < chunk.IndexOffset )
+        { break; }
+
+        u32 count = asdx::Min( indexCount, chunk.IndexOffset + chunk.IndexCount - indexOffset );
+        if ( m_pInstances != nullptr )
+        { pDeviceContext->DrawIndexedInstanced( count, m_pInstances->GetCount(), indexOffset, INT( chunk.BaseVertex ), 0 ); }
+        else
+        { pDeviceContext->DrawIndexed( count, indexOffset, INT( chunk.BaseVertex ) ); }
+
+        indexOffset += count;
+        indexCount  -= count;
+        id++;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      深度描画用のパイプラインを設定します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::BindDepthStream( ID3D11DeviceContext* pDeviceContext, ID3D11Buffer* pIB, DXGI_FORMAT format )
+{
+    u32 stride = m_DepthStride;
+    u32 offset = 0;
+
+    pDeviceContext->IASetInputLayout( m_pDepthIL );
+    pDeviceContext->IASetVertexBuffers( 0, 1, &m_pDepthVB, &stride, &offset );
+    pDeviceContext->IASetIndexBuffer( pIB, format, 0 );
+    pDeviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+
+    if ( m_pInstances != nullptr )
+    { BindInstanceStream( pDeviceContext, m_pDepthInstanceIL ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      深度描画用のストリームで描画できるかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::CanUseDepthStream() const
+{
+    if ( m_pDepthVB == nullptr )
+    { return false; }
+
+    // インスタンス描画では, 深度描画用の入力レイアウトも必要になる.
+    return ( m_pInstances == nullptr ) || ( m_pDepthInstanceIL != nullptr );
+}
+
+//-----------------------------------------------------------------------------------
+//      インスタンスデータの頂点ストリームを設定します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::BindInstanceStream( ID3D11DeviceContext* pDeviceContext, ID3D11InputLayout* pIL )
+{
+    ID3D11Buffer* pVB    = m_pInstances->GetBuffer();
+    u32           stride = sizeof( InstanceBuffer::Transform );
+    u32           offset = 0;
+
+    pDeviceContext->IASetInputLayout( pIL );
+    pDeviceContext->IASetVertexBuffers( InstanceBuffer::INPUT_SLOT, 1, &pVB, &stride, &offset );
+}
+
+//-----------------------------------------------------------------------------------
+//      深度描画用のストリームを破棄します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::TermDepthStream()
+{
+    ASDX_RELEASE( m_pDepthVB );
+    ASDX_RELEASE( m_pDepthIB );
+    ASDX_RELEASE( m_pDepthIL );
+    m_DepthStride      = 0;
+    m_DepthVertexCount = 0;
+    m_DepthIndexFormat = DXGI_FORMAT_R32_UINT;
+    m_DepthIndexChunks.clear();
+    m_DepthRemap.clear();
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細度のインデックスバッファを破棄します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::TermLod()
+{
+    ASDX_RELEASE( m_pLodIB );
+    ASDX_RELEASE( m_pDepthLodIB );
+    m_LodIndexFormat = DXGI_FORMAT_R32_UINT;
+    m_DepthLodFormat = DXGI_FORMAT_R32_UINT;
+    m_LodIndexChunks.clear();
+    m_DepthLodChunks.clear();
+    m_LodLevels.clear();
+    m_LodErrors.clear();
+    m_CurrentLod = 0;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルの描画設定を破棄します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::TermBindings()
+{
+    for( size_t i=0; i<m_Bindings.size(); ++i )
+    { ASDX_RELEASE( m_Bindings[i].pCB ); }
+    m_Bindings.clear();
+
+    m_TextureCache.Term();
+    m_Materials.Release();
+}
+
+//-----------------------------------------------------------------------------------
+//      インスタンス描画用の入力レイアウトを破棄します.
+//-----------------------------------------------------------------------------------
+void ClusteredMesh::TermInstancing()
+{
+    ASDX_RELEASE( m_pInstanceIL );
+    ASDX_RELEASE( m_pDepthInstanceIL );
+
+    m_pInstances = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセットの属するチャンクが描画対象かどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool ClusteredMesh::IsSubsetVisible( u32 index ) const
+{
+    // インスタンスごとにはチャンクを判定できないので, インスタンス描画では全て描画する.
+    if ( m_pChunkMask == nullptr || m_pInstances != nullptr || index >= m_SubsetChunk.size() )
+    { return true; }
+
+    u32 chunk = m_SubsetChunk[ index ];
+    if ( chunk >= m_ChunkBounds.size() )
+    { return true; }
+
+    return m_pChunkMask[ chunk ] != 0;
+}
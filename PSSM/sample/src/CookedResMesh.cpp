@@ -0,0 +1,409 @@
+﻿//-----------------------------------------------------------------------------------
+// File : CookedResMesh.cpp
+// Desc : Cooked Resource Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <CookedResMesh.h>
+#include <asdxLog.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      セクションがファイル内に収まっているかどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsValidSection( u32 offset, u32 count, u32 stride, u64 fileSize )
+{
+    if ( count == 0 )
+    { return true; }
+
+    return ( offset % CMSH_ALIGNMENT == 0 )
+        && ( u64( offset ) + u64( count ) * stride <= fileSize );
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列テーブルから文字列をコピーします.
+//-----------------------------------------------------------------------------------
+inline void CopyString( const char* pTable, u32 tableSize, u32 offset, char* result, u32 length )
+{
+    result[0] = '\0';
+    if ( offset == CMSH_INVALID_STRING || offset >= tableSize )
+    { return; }
+
+    u32 count = 0;
+    while( count + 1 < length && offset + count < tableSize && pTable[ offset + count ] != '\0' )
+    {
+        result[ count ] = pTable[ offset + count ];
+        count++;
+    }
+    result[ count ] = '\0';
+}
+
+//-----------------------------------------------------------------------------------
+//      AABBに変換します.
+//-----------------------------------------------------------------------------------
+inline asdx::BoundingBox ToBoundingBox( const f32* mini, const f32* maxi )
+{
+    return asdx::BoundingBox(
+        asdx::Vector3( mini[0], mini[1], mini[2] ),
+        asdx::Vector3( maxi[0], maxi[1], maxi[2] ) );
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CookedResMesh class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+CookedResMesh::CookedResMesh()
+: asdx::ResMesh     ()
+, m_Buffer          ()
+, m_Materials       ()
+, m_MaterialTable   ()
+, m_pSubsetBounds   ( nullptr )
+, m_pChunks         ( nullptr )
+{ memset( &m_Header, 0, sizeof( m_Header ) ); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+CookedResMesh::~CookedResMesh()
+{
+    // 基底クラスで解放しないように外しておく.
+    DetachViews();
+}
+
+//-----------------------------------------------------------------------------------
+//      ムーブコンストラクタです.
+//-----------------------------------------------------------------------------------
+CookedResMesh::CookedResMesh( CookedResMesh&& value )
+: asdx::ResMesh     ()
+, m_Buffer          ()
+, m_Materials       ()
+, m_MaterialTable   ()
+, m_pSubsetBounds   ( nullptr )
+, m_pChunks         ( nullptr )
+{
+    memset( &m_Header, 0, sizeof( m_Header ) );
+    Swap( value );
+}
+
+//-----------------------------------------------------------------------------------
+//      ムーブ代入演算子です.
+//-----------------------------------------------------------------------------------
+CookedResMesh& CookedResMesh::operator = ( CookedResMesh&& value )
+{
+    if ( this != &value )
+    {
+        Release();
+        Swap( value );
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      MeshCooker で出力した .cmsh ファイルをロードします.
+//-----------------------------------------------------------------------------------
+bool CookedResMesh::LoadFromFile( const char* filename, bool verifyHash )
+{
+    Release();
+
+    FILE* pFile = fopen( filename, "rb" );
+    if ( pFile == nullptr )
+    {
+        ELOG( "Error : File Open Failed. filename = %s", filename );
+        return false;
+    }
+
+    fseek( pFile, 0, SEEK_END );
+    long size = ftell( pFile );
+    fseek( pFile, 0, SEEK_SET );
+
+    if ( size < long( sizeof( CookedMeshHeader ) ) )
+    {
+        ELOG( "Error : Invalid File Size. filename = %s", filename );
+        fclose( pFile );
+        return false;
+    }
+
+    // 1回で全て読み込み, そのバッファをそのまま引き取る.
+    std::vector< u8 > buffer( static_cast<size_t>( size ) );
+    size_t read = fread( &buffer[0], 1, buffer.size(), pFile );
+    fclose( pFile );
+
+    if ( read != buffer.size() )
+    {
+        ELOG( "Error : File Read Failed. filename = %s", filename );
+        return false;
+    }
+
+    return Attach( buffer, filename, verifyHash );
+}
+
+//-----------------------------------------------------------------------------------
+//      メモリ上の .cmsh データをロードします.
+//-----------------------------------------------------------------------------------
+bool CookedResMesh::LoadFromMemory( std::vector< u8 >&& buffer, bool verifyHash )
+{
+    Release();
+
+    if ( buffer.size() < sizeof( CookedMeshHeader ) )
+    {
+        ELOG( "Error : Invalid Buffer Size." );
+        return false;
+    }
+
+    return Attach( buffer, "(memory)", verifyHash );
+}
+
+//-----------------------------------------------------------------------------------
+//      メモリを解放します.
+//-----------------------------------------------------------------------------------
+void CookedResMesh::Release()
+{
+    DetachViews();
+
+    m_Buffer.clear();
+    m_Materials.clear();
+    m_MaterialTable.Release();
+    memset( &m_Header, 0, sizeof( m_Header ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュ全体のAABBを取得します.
+//-----------------------------------------------------------------------------------
+asdx::BoundingBox CookedResMesh::GetBoundingBox() const
+{ return ToBoundingBox( m_Header.BoundsMin, m_Header.BoundsMax ); }
+
+//-----------------------------------------------------------------------------------
+//      サブセットのAABBを取得します.
+//-----------------------------------------------------------------------------------
+asdx::BoundingBox CookedResMesh::GetSubsetBoundingBox( const u32 idx ) const
+{
+    assert( idx < m_SubsetCount );
+    return ToBoundingBox( m_pSubsetBounds[ idx ].Min, m_pSubsetBounds[ idx ].Max );
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンク数を取得します.
+//-----------------------------------------------------------------------------------
+u32 CookedResMesh::GetChunkCount() const
+{ return ( m_pChunks != nullptr ) ? m_Header.ChunkCount : 0; }
+
+//-----------------------------------------------------------------------------------
+//      チャンクを取得します.
+//-----------------------------------------------------------------------------------
+const CookedChunk* CookedResMesh::GetChunks() const
+{ return m_pChunks; }
+
+//-----------------------------------------------------------------------------------
+//      ファイルのヘッダを取得します.
+//-----------------------------------------------------------------------------------
+const CookedMeshHeader& CookedResMesh::GetHeader() const
+{ return m_Header; }
+
+//-----------------------------------------------------------------------------------
+//      マテリアルテーブルを取得します.
+//-----------------------------------------------------------------------------------
+const MaterialTable& CookedResMesh::GetMaterialTable() const
+{ return m_MaterialTable; }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void CookedResMesh::Swap( CookedResMesh& value )
+{
+    // バッファ自体は移動しないので, 参照しているポインタもそのまま交換すれば良い.
+    std::swap( m_VertexCount,   value.m_VertexCount );
+    std::swap( m_IndexCount,    value.m_IndexCount );
+    std::swap( m_MaterialCount, value.m_MaterialCount );
+    std::swap( m_SubsetCount,   value.m_SubsetCount );
+    std::swap( m_pVertex,       value.m_pVertex );
+    std::swap( m_pIndex,        value.m_pIndex );
+    std::swap( m_pMaterial,     value.m_pMaterial );
+    std::swap( m_pSubset,       value.m_pSubset );
+    std::swap( m_Header,        value.m_Header );
+    std::swap( m_pSubsetBounds, value.m_pSubsetBounds );
+    std::swap( m_pChunks,       value.m_pChunks );
+
+    m_Buffer   .swap( value.m_Buffer );
+    m_Materials.swap( value.m_Materials );
+    m_MaterialTable.Swap( value.m_MaterialTable );
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込んだバッファを引き取って参照を設定します.
+//-----------------------------------------------------------------------------------
+bool CookedResMesh::Attach( std::vector< u8 >& buffer, const char* filename, bool verifyHash )
+{
+    m_Buffer.swap( buffer );
+    memcpy( &m_Header, &m_Buffer[0], sizeof( m_Header ) );
+
+    if ( !Validate( filename, verifyHash ) )
+    {
+        Release();
+        return false;
+    }
+
+    // GPUにそのまま渡せる形式なので, 読み込んだバッファを直接参照する.
+    u8* pData = &m_Buffer[0];
+    m_VertexCount   = m_Header.VertexCount;
+    m_IndexCount    = m_Header.IndexCount;
+    m_SubsetCount   = m_Header.SubsetCount;
+    m_pVertex       = reinterpret_cast<asdx::ResMesh::Vertex*>( pData + m_Header.VertexOffset );
+    m_pIndex        = reinterpret_cast<asdx::ResMesh::Index* >( pData + m_Header.IndexOffset  );
+    m_pSubset       = reinterpret_cast<asdx::ResMesh::Subset*>( pData + m_Header.SubsetOffset );
+    m_pSubsetBounds = reinterpret_cast<const CookedBounds*>   ( pData + m_Header.SubsetBoundsOffset );
+    m_pChunks       = ( m_Header.ChunkCount > 0 )
+                    ? reinterpret_cast<const CookedChunk*>( pData + m_Header.ChunkOffset )
+                    : nullptr;
+
+    // マテリアルは固定長の文字列配列には展開せず, 文字列テーブルを共有する形式で保持する.
+    if ( !m_MaterialTable.Build(
+        reinterpret_cast<const CookedMaterial*>( pData + m_Header.MaterialOffset ),
+        m_Header.MaterialCount,
+        reinterpret_cast<const char*>( pData ) + m_Header.StringTableOffset,
+        m_Header.StringTableSize ) )
+    {
+        ELOG( "Error : MaterialTable::Build() Failed. filename = %s", filename );
+        Release();
+        return false;
+    }
+    m_MaterialCount = m_Header.MaterialCount;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      ヘッダを検証します.
+//-----------------------------------------------------------------------------------
+bool CookedResMesh::Validate( const char* filename, bool verifyHash ) const
+{
+    const CookedMeshHeader& header = m_Header;
+    u64 size = m_Buffer.size();
+
+    if ( header.Magic[0] != 'C' || header.Magic[1] != 'M' || header.Magic[2] != 'S' || header.Magic[3] != 'H' )
+    {
+        ELOG( "Error : Invalid File Magic. filename = %s", filename );
+        return false;
+    }
+
+    if ( header.Version != CMSH_VERSION || header.HeaderSize != sizeof( CookedMeshHeader ) )
+    {
+        ELOG( "Error : Unsupported File Version. filename = %s", filename );
+        return false;
+    }
+
+    if ( header.FileSize != size
+      || header.VertexStride != sizeof( asdx::ResMesh::Vertex )
+      || header.IndexStride  != sizeof( asdx::ResMesh::Index  ) )
+    {
+        ELOG( "Error : Invalid Header. filename = %s", filename );
+        return false;
+    }
+
+    if ( !IsValidSection( header.VertexOffset,       header.VertexCount,   sizeof( asdx::ResMesh::Vertex ), size )
+      || !IsValidSection( header.IndexOffset,        header.IndexCount,    sizeof( asdx::ResMesh::Index  ), size )
+      || !IsValidSection( header.MaterialOffset,     header.MaterialCount, sizeof( CookedMaterial ),        size )
+      || !IsValidSection( header.SubsetOffset,       header.SubsetCount,   sizeof( asdx::ResMesh::Subset ), size )
+      || !IsValidSection( header.SubsetBoundsOffset, header.SubsetCount,   sizeof( CookedBounds ),          size )
+      || !IsValidSection( header.ChunkOffset,        header.ChunkCount,    sizeof( CookedChunk ),           size )
+      || u64( header.StringTableOffset ) + header.StringTableSize > size )
+    {
+        ELOG( "Error : Data Out Of Range. filename = %s", filename );
+        return false;
+    }
+
+    // チャンクが参照するサブセットが範囲内にあるか確認する.
+    if ( header.ChunkCount > 0 )
+    {
+        const CookedChunk* pChunks = reinterpret_cast<const CookedChunk*>( &m_Buffer[ header.ChunkOffset ] );
+        for( u32 i=0; i<header.ChunkCount; ++i )
+        {
+            if ( u64( pChunks[i].SubsetOffset ) + pChunks[i].SubsetCount > header.SubsetCount )
+            {
+                ELOG( "Error : Invalid Chunk. filename = %s, index = %u", filename, i );
+                return false;
+            }
+        }
+    }
+
+    if ( verifyHash )
+    {
+        u64 hash = ComputeFnv1a64( &m_Buffer[ header.HeaderSize ], m_Buffer.size() - header.HeaderSize );
+        if ( hash != header.ContentHash )
+        {
+            ELOG( "Error : Content Hash Mismatch. filename = %s", filename );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルを展開します.
+//-----------------------------------------------------------------------------------
+void CookedResMesh::ExpandMaterials()
+{
+    if ( m_Buffer.empty() || !m_Materials.empty() )
+    { return; }
+
+    const CookedMaterial* pSrc   = reinterpret_cast<const CookedMaterial*>( &m_Buffer[ m_Header.MaterialOffset ] );
+    const char*           pTable = reinterpret_cast<const char*>( &m_Buffer[0] ) + m_Header.StringTableOffset;
+    u32                   size   = m_Header.StringTableSize;
+
+    m_Materials.resize( m_Header.MaterialCount );
+    for( u32 i=0; i<m_Header.MaterialCount; ++i )
+    {
+        const CookedMaterial&     src = pSrc[i];
+        asdx::ResMesh::Material&  dst = m_Materials[i];
+
+        dst.Ambient  = asdx::Vector3( src.Ambient [0], src.Ambient [1], src.Ambient [2] );
+        dst.Diffuse  = asdx::Vector3( src.Diffuse [0], src.Diffuse [1], src.Diffuse [2] );
+        dst.Specular = asdx::Vector3( src.Specular[0], src.Specular[1], src.Specular[2] );
+        dst.Emissive = asdx::Vector3( src.Emissive[0], src.Emissive[1], src.Emissive[2] );
+        dst.Alpha    = src.Alpha;
+        dst.Power    = src.Power;
+
+        CopyString( pTable, size, src.AmbientMap,      dst.AmbientMap,      NUM_FILENAME );
+        CopyString( pTable, size, src.DiffuseMap,      dst.DiffuseMap,      NUM_FILENAME );
+        CopyString( pTable, size, src.SpecularMap,     dst.SpecularMap,     NUM_FILENAME );
+        CopyString( pTable, size, src.BumpMap,         dst.BumpMap,         NUM_FILENAME );
+        CopyString( pTable, size, src.DisplacementMap, dst.DisplacementMap, NUM_FILENAME );
+    }
+
+    m_MaterialCount = m_Header.MaterialCount;
+    m_pMaterial     = ( m_Materials.empty() ) ? nullptr : &m_Materials[0];
+}
+
+//-----------------------------------------------------------------------------------
+//      バッファを参照しているポインタを外します.
+//-----------------------------------------------------------------------------------
+void CookedResMesh::DetachViews()
+{
+    m_VertexCount   = 0;
+    m_IndexCount    = 0;
+    m_MaterialCount = 0;
+    m_SubsetCount   = 0;
+
+    m_pVertex       = nullptr;
+    m_pIndex        = nullptr;
+    m_pMaterial     = nullptr;
+    m_pSubset       = nullptr;
+    m_pSubsetBounds = nullptr;
+    m_pChunks       = nullptr;
+}
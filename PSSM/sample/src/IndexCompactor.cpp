@@ -0,0 +1,235 @@
+﻿//-----------------------------------------------------------------------------------
+// File : IndexCompactor.cpp
+// Desc : 16bit Index Compactor Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <IndexCompactor.h>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      インデックスオフセットでチャンクを比較します.
+//-----------------------------------------------------------------------------------
+inline bool ChunkLess( const IndexCompactor::Chunk& lhs, const IndexCompactor::Chunk& rhs )
+{ return lhs.IndexOffset < rhs.IndexOffset; }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// IndexCompactor class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+IndexCompactor::IndexCompactor()
+: m_Indices     ()
+, m_Chunks      ()
+, m_IndexCount  ( 0 )
+, m_Is16Bit     ( false )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+IndexCompactor::~IndexCompactor()
+{ Release(); }
+
+//-----------------------------------------------------------------------------------
+//      32bitインデックスを16bitインデックスに変換します.
+//-----------------------------------------------------------------------------------
+bool IndexCompactor::Build
+(
+    const asdx::ResMesh::Index*     pIndices,
+    u32                             indexCount,
+    const asdx::ResMesh::Subset*    pSubsets,
+    u32                             subsetCount
+)
+{
+    Release();
+
+    if ( pIndices == nullptr || pSubsets == nullptr || indexCount == 0 )
+    {
+        Fallback( indexCount );
+        return false;
+    }
+
+    // どのサブセットにも含まれないインデックスは描画されないので 0 のままにしておく.
+    m_Indices.resize( indexCount, 0 );
+
+    for( u32 i=0; i<subsetCount; ++i )
+    {
+        const asdx::ResMesh::Subset& subset = pSubsets[i];
+        if ( u64( subset.IndexOffset ) + subset.IndexCount > indexCount )
+        {
+            Fallback( indexCount );
+            return false;
+        }
+
+        Chunk chunk;
+        chunk.IndexOffset = subset.IndexOffset;
+        chunk.IndexCount  = 0;
+        chunk.BaseVertex  = 0;
+
+        u32 mini = 0xffffffff;
+        u32 maxi = 0;
+
+        // 三角形単位で範囲を広げていき, 16bitに収まらなくなったら新しいチャンクを始める.
+        u32 end = subset.IndexOffset + subset.IndexCount;
+        for( u32 j=subset.IndexOffset; j<end; j+=3 )
+        {
+            u32 count   = asdx::Min( 3u, end - j );
+            u32 triMin  = pIndices[j];
+            u32 triMax  = pIndices[j];
+            for( u32 k=1; k<count; ++k )
+            {
+                triMin = asdx::Min( triMin, pIndices[ j + k ] );
+                triMax = asdx::Max( triMax, pIndices[ j + k ] );
+            }
+
+            if ( triMax - triMin > MAX_INDEX_RANGE )
+            { break; }
+
+            u32 newMin = asdx::Min( mini, triMin );
+            u32 newMax = asdx::Max( maxi, triMax );
+            if ( chunk.IndexCount > 0 && newMax - newMin > MAX_INDEX_RANGE )
+            {
+                chunk.BaseVertex = mini;
+                m_Chunks.push_back( chunk );
+
+                chunk.IndexOffset += chunk.IndexCount;
+                chunk.IndexCount   = 0;
+                newMin = triMin;
+                newMax = triMax;
+            }
+
+            mini = newMin;
+            maxi = newMax;
+            chunk.IndexCount += count;
+        }
+
+        // 1つの三角形で16bitを超える場合は変換できない.
+        if ( chunk.IndexOffset + chunk.IndexCount != end )
+        {
+            Fallback( indexCount );
+            return false;
+        }
+
+        if ( chunk.IndexCount > 0 )
+        {
+            chunk.BaseVertex = mini;
+            m_Chunks.push_back( chunk );
+        }
+    }
+
+    std::sort( m_Chunks.begin(), m_Chunks.end(), ChunkLess );
+
+    // サブセット同士が重なっているとベース頂点が決まらないので変換しない.
+    for( size_t i=1; i<m_Chunks.size(); ++i )
+    {
+        if ( m_Chunks[ i - 1 ].IndexOffset + m_Chunks[ i - 1 ].IndexCount > m_Chunks[i].IndexOffset )
+        {
+            Fallback( indexCount );
+            return false;
+        }
+    }
+
+    for( size_t i=0; i<m_Chunks.size(); ++i )
+    {
+        const Chunk& chunk = m_Chunks[i];
+        for( u32 j=0; j<chunk.IndexCount; ++j )
+        {
+            u32 index = chunk.IndexOffset + j;
+            m_Indices[ index ] = u16( pIndices[ index ] - chunk.BaseVertex );
+        }
+    }
+
+    m_IndexCount = indexCount;
+    m_Is16Bit    = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      変換結果を破棄します.
+//-----------------------------------------------------------------------------------
+void IndexCompactor::Release()
+{
+    m_Indices.clear();
+    m_Chunks.clear();
+    m_IndexCount = 0;
+    m_Is16Bit    = false;
+}
+
+//-----------------------------------------------------------------------------------
+//      16bitインデックスに変換できたかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool IndexCompactor::Is16Bit() const
+{ return m_Is16Bit; }
+
+//-----------------------------------------------------------------------------------
+//      16bitインデックスを取得します.
+//-----------------------------------------------------------------------------------
+const u16* IndexCompactor::GetIndices() const
+{ return ( m_Indices.empty() ) ? nullptr : &m_Indices[0]; }
+
+//-----------------------------------------------------------------------------------
+//      頂点インデックス数を取得します.
+//-----------------------------------------------------------------------------------
+u32 IndexCompactor::GetIndexCount() const
+{ return m_IndexCount; }
+
+//-----------------------------------------------------------------------------------
+//      チャンクを取得します.
+//-----------------------------------------------------------------------------------
+const std::vector< IndexCompactor::Chunk >& IndexCompactor::GetChunks() const
+{ return m_Chunks; }
+
+//-----------------------------------------------------------------------------------
+//      インデックスオフセットを含むチャンクを検索します.
+//-----------------------------------------------------------------------------------
+u32 IndexCompactor::FindChunk( const std::vector< Chunk >& chunks, u32 indexOffset )
+{
+    // 開始位置が indexOffset より後ろになる最初のチャンクの1つ前が候補.
+    u32 lo = 0;
+    u32 hi = u32( chunks.size() );
+    while( lo < hi )
+    {
+        u32 mid = ( lo + hi ) / 2;
+        if ( chunks[ mid ].IndexOffset <= indexOffset )
+        { lo = mid + 1; }
+        else
+        { hi = mid; }
+    }
+
+    if ( lo == 0 )
+    { return u32( chunks.size() ); }
+
+    const Chunk& chunk = chunks[ lo - 1 ];
+    if ( indexOffset >= chunk.IndexOffset + chunk.IndexCount )
+    { return u32( chunks.size() ); }
+
+    return lo - 1;
+}
+
+//-----------------------------------------------------------------------------------
+//      32bitのまま全体を1つのチャンクで覆います.
+//-----------------------------------------------------------------------------------
+void IndexCompactor::Fallback( u32 indexCount )
+{
+    Release();
+
+    Chunk chunk;
+    chunk.IndexOffset = 0;
+    chunk.IndexCount  = indexCount;
+    chunk.BaseVertex  = 0;
+    m_Chunks.push_back( chunk );
+
+    m_IndexCount = indexCount;
+}
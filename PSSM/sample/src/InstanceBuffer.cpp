@@ -0,0 +1,227 @@
+﻿//-----------------------------------------------------------------------------------
+// File : InstanceBuffer.cpp
+// Desc : Per-Instance Transform Buffer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <InstanceBuffer.h>
+#include <asdxLog.h>
+#include <cstring>
+#include <cmath>
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// InstanceBuffer class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      入力要素です.
+//-----------------------------------------------------------------------------------
+const D3D11_INPUT_ELEMENT_DESC InstanceBuffer::INPUT_ELEMENTS[ InstanceBuffer::NUM_INPUT_ELEMENT ] = {
+    { "INSTANCE_WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, InstanceBuffer::INPUT_SLOT, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, InstanceBuffer::INPUT_SLOT, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "INSTANCE_WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, InstanceBuffer::INPUT_SLOT, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+InstanceBuffer::InstanceBuffer()
+: m_pVB             ( nullptr )
+, m_Capacity        ( 0 )
+, m_UploadedCount   ( 0 )
+, m_Transforms      ()
+, m_Statistics      ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+InstanceBuffer::~InstanceBuffer()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool InstanceBuffer::Init( ID3D11Device* pDevice, u32 maxCount )
+{
+    Term();
+
+    if ( pDevice == nullptr || maxCount == 0 )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Usage          = D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth      = sizeof( Transform ) * maxCount;
+    desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+    HRESULT hr = pDevice->CreateBuffer( &desc, nullptr, &m_pVB );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+        return false;
+    }
+
+    m_Capacity = maxCount;
+    m_Transforms.reserve( maxCount );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void InstanceBuffer::Term()
+{
+    if ( m_pVB != nullptr )
+    {
+        m_pVB->Release();
+        m_pVB = nullptr;
+    }
+
+    m_Capacity      = 0;
+    m_UploadedCount = 0;
+    m_Transforms.clear();
+    m_Statistics    = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      追加したインスタンスを全て削除します.
+//-----------------------------------------------------------------------------------
+void InstanceBuffer::Clear()
+{ m_Transforms.clear(); }
+
+//-----------------------------------------------------------------------------------
+//      インスタンスを追加します.
+//-----------------------------------------------------------------------------------
+bool InstanceBuffer::Add( const asdx::Matrix& world )
+{
+    if ( m_Transforms.size() >= m_Capacity )
+    { return false; }
+
+    m_Transforms.push_back( ToTransform( world ) );
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入るインスタンスだけを詰めて追加し直します.
+//-----------------------------------------------------------------------------------
+u32 InstanceBuffer::Cull
+(
+    const asdx::Matrix*         pWorlds,
+    u32                         count,
+    const asdx::BoundingSphere& sphere,
+    const asdx::Matrix&         viewProj
+)
+{
+    m_Transforms.clear();
+    m_Statistics.TestedCount  = count;
+    m_Statistics.VisibleCount = 0;
+
+    if ( pWorlds == nullptr )
+    { return 0; }
+
+    asdx::BoundingFrustum frustum( viewProj );
+
+    for( u32 i=0; i<count; ++i )
+    {
+        const asdx::Matrix& world = pWorlds[i];
+
+        // 拡大縮小が不均一でも覆えるように, 最も大きい軸の倍率で半径を広げる.
+        f32 scaleX = asdx::Vector3( world._11, world._12, world._13 ).LengthSq();
+        f32 scaleY = asdx::Vector3( world._21, world._22, world._23 ).LengthSq();
+        f32 scaleZ = asdx::Vector3( world._31, world._32, world._33 ).LengthSq();
+        f32 radius = sphere.radius * sqrtf( asdx::Max( scaleX, asdx::Max( scaleY, scaleZ ) ) );
+
+        asdx::Vector3 center = asdx::Vector3::TransformCoord( sphere.center, world );
+
+        bool culled = false;
+        for( u32 j=0; j<6 && !culled; ++j )
+        {
+            const asdx::Plane& plane = frustum.plane[j];
+            culled = ( asdx::Vector3::Dot( plane.normal, center ) + plane.d < -radius );
+        }
+
+        if ( culled )
+        { continue; }
+
+        if ( !Add( world ) )
+        { break; }
+    }
+
+    m_Statistics.VisibleCount = u32( m_Transforms.size() );
+    return m_Statistics.VisibleCount;
+}
+
+//-----------------------------------------------------------------------------------
+//      追加したインスタンスをGPUに転送します.
+//-----------------------------------------------------------------------------------
+bool InstanceBuffer::Upload( ID3D11DeviceContext* pDeviceContext )
+{
+    m_UploadedCount = 0;
+
+    if ( m_pVB == nullptr )
+    { return false; }
+
+    if ( m_Transforms.empty() )
+    { return true; }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = pDeviceContext->Map( m_pVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11DeviceContext::Map() Failed." );
+        return false;
+    }
+
+    memcpy( mapped.pData, &m_Transforms[0], sizeof( Transform ) * m_Transforms.size() );
+    pDeviceContext->Unmap( m_pVB, 0 );
+
+    m_UploadedCount = u32( m_Transforms.size() );
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点バッファを取得します.
+//-----------------------------------------------------------------------------------
+ID3D11Buffer* InstanceBuffer::GetBuffer() const
+{ return m_pVB; }
+
+//-----------------------------------------------------------------------------------
+//      転送済みのインスタンス数を取得します.
+//-----------------------------------------------------------------------------------
+u32 InstanceBuffer::GetCount() const
+{ return m_UploadedCount; }
+
+//-----------------------------------------------------------------------------------
+//      最大インスタンス数を取得します.
+//-----------------------------------------------------------------------------------
+u32 InstanceBuffer::GetCapacity() const
+{ return m_Capacity; }
+
+//-----------------------------------------------------------------------------------
+//      最後に行ったカリングの統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const InstanceBuffer::Statistics& InstanceBuffer::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      ワールド行列を3x4行列に変換します.
+//-----------------------------------------------------------------------------------
+InstanceBuffer::Transform InstanceBuffer::ToTransform( const asdx::Matrix& world )
+{
+    // 行ベクトルに掛ける行列なので, 列を取り出して行にする.
+    Transform result;
+    result.Row0 = asdx::Vector4( world._11, world._21, world._31, world._41 );
+    result.Row1 = asdx::Vector4( world._12, world._22, world._32, world._42 );
+    result.Row2 = asdx::Vector4( world._13, world._23, world._33, world._43 );
+    return result;
+}
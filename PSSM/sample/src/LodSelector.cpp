@@ -0,0 +1,113 @@
+﻿//-----------------------------------------------------------------------------------
+// File : LodSelector.cpp
+// Desc : Level of Detail Selector Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <LodSelector.h>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+// 既定の許容誤差(ピクセル).
+static const f32 DEFAULT_PIXEL_ERROR = 1.0f;
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// LodSelector class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+LodSelector::LodSelector()
+: m_PixelError( DEFAULT_PIXEL_ERROR )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+LodSelector::~LodSelector()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      許容する誤差をピクセル(テクセル)単位で設定します.
+//-----------------------------------------------------------------------------------
+void LodSelector::SetPixelError( f32 value )
+{ m_PixelError = asdx::Max( value, 0.0f ); }
+
+//-----------------------------------------------------------------------------------
+//      許容する誤差をピクセル(テクセル)単位で取得します.
+//-----------------------------------------------------------------------------------
+f32 LodSelector::GetPixelError() const
+{ return m_PixelError; }
+
+//-----------------------------------------------------------------------------------
+//      詳細度を選択します.
+//-----------------------------------------------------------------------------------
+u32 LodSelector::Select
+(
+    const f32*              pErrors,
+    u32                     levelCount,
+    const asdx::Matrix&     worldViewProj,
+    const asdx::Vector3&    center,
+    f32                     radius,
+    f32                     width,
+    f32                     height
+) const
+{
+    if ( pErrors == nullptr || levelCount <= 1 )
+    { return 0; }
+
+    f32 pixelsPerUnit = ComputePixelsPerUnit( worldViewProj, center, radius, width, height );
+    if ( pixelsPerUnit >= F32_MAX )
+    { return 0; }
+
+    // 誤差は詳細度が下がるほど大きくなるので, 許容値を超える手前で止める.
+    u32 result = 0;
+    for( u32 i=1; i<levelCount; ++i )
+    {
+        if ( pErrors[i] * pixelsPerUnit > m_PixelError )
+        { break; }
+
+        result = i;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      ローカル座標系の長さ1がビューポート上で何ピクセルになるかを求めます.
+//-----------------------------------------------------------------------------------
+f32 LodSelector::ComputePixelsPerUnit
+(
+    const asdx::Matrix&     worldViewProj,
+    const asdx::Vector3&    center,
+    f32                     radius,
+    f32                     width,
+    f32                     height
+)
+{
+    const asdx::Matrix& m = worldViewProj;
+
+    // 行ベクトルを掛ける規約なので, 列ごとにクリップ座標の各成分への寄与になる.
+    f32 scaleX = sqrtf( m._11 * m._11 + m._21 * m._21 + m._31 * m._31 );
+    f32 scaleY = sqrtf( m._12 * m._12 + m._22 * m._22 + m._32 * m._32 );
+    f32 scaleW = sqrtf( m._14 * m._14 + m._24 * m._24 + m._34 * m._34 );
+
+    // 正射影では w は一定, 透視投影ではスフィアの最も手前の点で評価する.
+    f32 w = center.x * m._14 + center.y * m._24 + center.z * m._34 + m._44;
+    w -= radius * scaleW;
+    if ( w <= F32_EPSILON )
+    { return F32_MAX; }
+
+    f32 pixelsX = scaleX * width  * 0.5f;
+    f32 pixelsY = scaleY * height * 0.5f;
+    return asdx::Max( pixelsX, pixelsY ) / w;
+}
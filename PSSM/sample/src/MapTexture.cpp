@@ -0,0 +1,317 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MapTexture.cpp
+// Desc : MAP Texture Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MapTexture.h>
+#include <BlockCompressor.h>
+#include <cstring>
+#include <cassert>
+
+
+namespace /* anonymous */ {
+
+// 縦横の最大サイズです(D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION と同じ値).
+static const u32 MAX_DIMENSION = 16384;
+
+// 最大サーフェイス数です(D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION と同じ値).
+static const u32 MAX_SURFACE_COUNT = 2048;
+
+//-----------------------------------------------------------------------------------
+//      最大ミップマップ数を求めます.
+//-----------------------------------------------------------------------------------
+u32 ComputeMaxMipMapCount( u32 width, u32 height )
+{
+    u32 size  = ( width > height ) ? width : height;
+    u32 count = 1;
+    while( size > 1 )
+    {
+        size >>= 1;
+        count++;
+    }
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------------
+//      フォーマットに必要な最小のピッチを求めます.
+//-----------------------------------------------------------------------------------
+bool ComputeMinPitch( u32 format, u32 width, u32 height, u32& pitch, u32& slicePitch )
+{
+    BlockCompressor::FORMAT compressorFormat;
+    switch( format )
+    {
+    case MAP_FORMAT_R8:
+        {
+            pitch      = width;
+            slicePitch = width * height;
+        }
+        return true;
+
+    case MAP_FORMAT_BC1: compressorFormat = BlockCompressor::FORMAT_BC1; break;
+    case MAP_FORMAT_BC3: compressorFormat = BlockCompressor::FORMAT_BC3; break;
+    case MAP_FORMAT_BC4: compressorFormat = BlockCompressor::FORMAT_BC4; break;
+    case MAP_FORMAT_BC5: compressorFormat = BlockCompressor::FORMAT_BC5; break;
+    case MAP_FORMAT_BC7: compressorFormat = BlockCompressor::FORMAT_BC7; break;
+
+    default:
+        return false;
+    }
+
+    pitch      = BlockCompressor::GetPitch( compressorFormat, width );
+    slicePitch = BlockCompressor::GetSlicePitch( compressorFormat, width, height );
+    return true;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MapTexture class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MapTexture::MapTexture()
+: m_File    ()
+, m_Surfaces()
+, m_pError  ( nullptr )
+{ memset( &m_Header, 0, sizeof( m_Header ) ); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MapTexture::~MapTexture()
+{ Release(); }
+
+//-----------------------------------------------------------------------------------
+//      .map ファイルを読み込みます.
+//-----------------------------------------------------------------------------------
+bool MapTexture::LoadFromFile( const char* filename )
+{
+    Release();
+    m_pError = nullptr;
+
+    // ピクセルデータは読み込まず, サーフェイスはマップした領域を直接指す.
+    if ( !m_File.Open( filename ) )
+    {
+        m_pError = "file open failed.";
+        return false;
+    }
+
+    if ( m_File.GetSize() < u64( sizeof( MapFileHeader ) ) )
+    {
+        m_pError = "invalid file size.";
+        Release();
+        return false;
+    }
+
+    if ( !Parse() )
+    {
+        Release();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      メモリを解放します.
+//-----------------------------------------------------------------------------------
+void MapTexture::Release()
+{
+    m_File.Close();
+    m_Surfaces.clear();
+    memset( &m_Header, 0, sizeof( m_Header ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      ピクセルデータのページを先に読み込んでおきます.
+//-----------------------------------------------------------------------------------
+void MapTexture::Touch() const
+{
+    // 4KBごとに1バイト読めば全てのページが読み込まれる.
+    const size_t PAGE_SIZE = 4096;
+
+    volatile u8 sum = 0;
+    for( size_t i=0; i<m_Surfaces.size(); ++i )
+    {
+        const Surface& surface = m_Surfaces[i];
+        for( size_t j=0; j<surface.SlicePitch; j+=PAGE_SIZE )
+        { sum += surface.pPixels[j]; }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      横幅を取得します.
+//-----------------------------------------------------------------------------------
+u32 MapTexture::GetWidth() const
+{ return m_Header.Width; }
+
+//-----------------------------------------------------------------------------------
+//      縦幅を取得します.
+//-----------------------------------------------------------------------------------
+u32 MapTexture::GetHeight() const
+{ return m_Header.Height; }
+
+//-----------------------------------------------------------------------------------
+//      フォーマットを取得します.
+//-----------------------------------------------------------------------------------
+u32 MapTexture::GetFormat() const
+{ return m_Header.Format; }
+
+//-----------------------------------------------------------------------------------
+//      ミップマップ数を取得します.
+//-----------------------------------------------------------------------------------
+u32 MapTexture::GetMipMapCount() const
+{ return m_Header.MipMapCount; }
+
+//-----------------------------------------------------------------------------------
+//      サーフェイス数を取得します.
+//-----------------------------------------------------------------------------------
+u32 MapTexture::GetSurfaceCount() const
+{ return m_Header.SurfaceCount; }
+
+//-----------------------------------------------------------------------------------
+//      エラーメッセージを取得します.
+//-----------------------------------------------------------------------------------
+const char* MapTexture::GetError() const
+{ return ( m_pError != nullptr ) ? m_pError : ""; }
+
+//-----------------------------------------------------------------------------------
+//      サーフェイスを取得します.
+//-----------------------------------------------------------------------------------
+const MapTexture::Surface& MapTexture::GetSurface( u32 idx ) const
+{
+    assert( idx < m_Surfaces.size() );
+    return m_Surfaces[ idx ];
+}
+
+//-----------------------------------------------------------------------------------
+//      サーフェイスを取得します.
+//-----------------------------------------------------------------------------------
+const MapTexture::Surface& MapTexture::GetSurface( u32 mipLevel, u32 slice ) const
+{
+    assert( mipLevel < m_Header.MipMapCount );
+    assert( slice    < m_Header.SurfaceCount );
+    return m_Surfaces[ mipLevel + slice * m_Header.MipMapCount ];
+}
+
+//-----------------------------------------------------------------------------------
+//      ヘッダを検証し, サーフェイスを切り出します.
+//-----------------------------------------------------------------------------------
+bool MapTexture::Parse()
+{
+    const u8* pData = m_File.GetData();
+    size_t    size  = size_t( m_File.GetSize() );
+
+    MapFileHeader header;
+    memcpy( &header, pData, sizeof( header ) );
+
+    if ( header.Magic[0] != 'M' || header.Magic[1] != 'A' || header.Magic[2] != 'P' || header.Magic[3] != '\0' )
+    {
+        m_pError = "invalid file magic.";
+        return false;
+    }
+
+    if ( header.Version != MAP_VERSION )
+    {
+        m_pError = "unsupported file version.";
+        return false;
+    }
+
+    if ( header.DataHeaderSize < MAP_DATA_HEADER_SIZE || size < 12 + size_t( header.DataHeaderSize ) )
+    {
+        m_pError = "invalid data header size.";
+        return false;
+    }
+
+    const MapDataHeader& data = header.DataHeader;
+    if ( data.Width == 0 || data.Height == 0 || data.MipMapCount == 0 || data.SurfaceCount == 0 )
+    {
+        m_pError = "invalid texture size.";
+        return false;
+    }
+
+    // 縦横が上限以下なので, ピッチの計算は u32 で溢れない.
+    if ( data.Width > MAX_DIMENSION || data.Height > MAX_DIMENSION
+      || data.MipMapCount  > ComputeMaxMipMapCount( data.Width, data.Height )
+      || data.SurfaceCount > MAX_SURFACE_COUNT )
+    {
+        m_pError = "texture size out of range.";
+        return false;
+    }
+
+    u32 minPitch;
+    u32 minSlicePitch;
+    if ( !ComputeMinPitch( data.Format, 1, 1, minPitch, minSlicePitch ) )
+    {
+        m_pError = "unsupported format.";
+        return false;
+    }
+
+    // 確保する前に, 全てのサーフェイスヘッダがファイルに収まるか確認する.
+    size_t offset       = 12 + size_t( header.DataHeaderSize );
+    u64    surfaceCount = u64( data.MipMapCount ) * u64( data.SurfaceCount );
+    if ( surfaceCount * sizeof( MapSurfaceHeader ) > u64( size - offset ) )
+    {
+        m_pError = "surface header out of range.";
+        return false;
+    }
+
+    m_Surfaces.resize( size_t( surfaceCount ) );
+
+    for( u32 i=0; i<data.SurfaceCount; ++i )
+    {
+        for( u32 j=0; j<data.MipMapCount; ++j )
+        {
+            if ( size - offset < sizeof( MapSurfaceHeader ) )
+            {
+                m_pError = "surface header out of range.";
+                return false;
+            }
+
+            MapSurfaceHeader surface;
+            memcpy( &surface, pData + offset, sizeof( surface ) );
+            offset += sizeof( surface );
+
+            // ミップレベルに対応したサイズになっているか確認する.
+            u32 width  = ( data.Width  >> j ) > 0 ? ( data.Width  >> j ) : 1;
+            u32 height = ( data.Height >> j ) > 0 ? ( data.Height >> j ) : 1;
+            // 行(ブロック圧縮の場合はブロックの行)ごとに Pitch バイトずつ読まれるので, 全ての行が収まる必要がある.
+            ComputeMinPitch( data.Format, width, height, minPitch, minSlicePitch );
+            u32 rowCount = minSlicePitch / minPitch;
+            if ( surface.Width != width || surface.Height != height
+              || surface.Pitch < minPitch
+              || u64( surface.Pitch ) * rowCount > u64( surface.SlicePitch ) )
+            {
+                m_pError = "invalid surface size.";
+                return false;
+            }
+
+            if ( size - offset < surface.SlicePitch )
+            {
+                m_pError = "pixel data out of range.";
+                return false;
+            }
+
+            Surface& dst = m_Surfaces[ j + i * data.MipMapCount ];
+            dst.pPixels    = pData + offset;
+            dst.Width      = surface.Width;
+            dst.Height     = surface.Height;
+            dst.Pitch      = surface.Pitch;
+            dst.SlicePitch = surface.SlicePitch;
+
+            offset += surface.SlicePitch;
+        }
+    }
+
+    m_Header = data;
+
+    return true;
+}
@@ -0,0 +1,194 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MappedFile.cpp
+// Desc : Memory Mapped File Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MappedFile.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MappedFile class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MappedFile::MappedFile()
+: m_pFile   ( nullptr )
+, m_pMapping( nullptr )
+, m_pData   ( nullptr )
+, m_Size    ( 0 )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{ Close(); }
+
+//-----------------------------------------------------------------------------------
+//      ムーブコンストラクタです.
+//-----------------------------------------------------------------------------------
+MappedFile::MappedFile( MappedFile&& value )
+: m_pFile   ( nullptr )
+, m_pMapping( nullptr )
+, m_pData   ( nullptr )
+, m_Size    ( 0 )
+{ Swap( value ); }
+
+//-----------------------------------------------------------------------------------
+//      ムーブ代入演算子です.
+//-----------------------------------------------------------------------------------
+MappedFile& MappedFile::operator = ( MappedFile&& value )
+{
+    if ( this != &value )
+    {
+        Close();
+        Swap( value );
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイルを読み取り専用でメモリにマップします.
+//-----------------------------------------------------------------------------------
+bool MappedFile::Open( const char* filename )
+{
+    Close();
+
+    if ( filename == nullptr )
+    { return false; }
+
+#if defined(_WIN32)
+    HANDLE hFile = CreateFileA(
+        filename,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr );
+    if ( hFile == INVALID_HANDLE_VALUE )
+    { return false; }
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx( hFile, &size ) || size.QuadPart == 0 )
+    {
+        CloseHandle( hFile );
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if ( hMapping == nullptr )
+    {
+        CloseHandle( hFile );
+        return false;
+    }
+
+    void* pView = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( pView == nullptr )
+    {
+        CloseHandle( hMapping );
+        CloseHandle( hFile );
+        return false;
+    }
+
+    m_pFile    = hFile;
+    m_pMapping = hMapping;
+    m_pData    = static_cast<const u8*>( pView );
+    m_Size     = u64( size.QuadPart );
+#else
+    int fd = open( filename, O_RDONLY );
+    if ( fd < 0 )
+    { return false; }
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size <= 0 )
+    {
+        close( fd );
+        return false;
+    }
+
+    void* pView = mmap( nullptr, size_t( info.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( pView == MAP_FAILED )
+    {
+        close( fd );
+        return false;
+    }
+
+    m_pFile    = reinterpret_cast<void*>( intptr_t( fd ) );
+    m_pMapping = nullptr;
+    m_pData    = static_cast<const u8*>( pView );
+    m_Size     = u64( info.st_size );
+#endif
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      マップを解除してファイルを閉じます.
+//-----------------------------------------------------------------------------------
+void MappedFile::Close()
+{
+    if ( m_pData == nullptr )
+    { return; }
+
+#if defined(_WIN32)
+    UnmapViewOfFile( m_pData );
+    CloseHandle( m_pMapping );
+    CloseHandle( m_pFile );
+#else
+    munmap( const_cast<u8*>( m_pData ), size_t( m_Size ) );
+    close( int( reinterpret_cast<intptr_t>( m_pFile ) ) );
+#endif
+
+    m_pFile    = nullptr;
+    m_pMapping = nullptr;
+    m_pData    = nullptr;
+    m_Size     = 0;
+}
+
+//-----------------------------------------------------------------------------------
+//      マップされているかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool MappedFile::IsOpen() const
+{ return ( m_pData != nullptr ); }
+
+//-----------------------------------------------------------------------------------
+//      マップされたデータの先頭を取得します.
+//-----------------------------------------------------------------------------------
+const u8* MappedFile::GetData() const
+{ return m_pData; }
+
+//-----------------------------------------------------------------------------------
+//      ファイルサイズを取得します.
+//-----------------------------------------------------------------------------------
+u64 MappedFile::GetSize() const
+{ return m_Size; }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void MappedFile::Swap( MappedFile& value )
+{
+    std::swap( m_pFile,    value.m_pFile );
+    std::swap( m_pMapping, value.m_pMapping );
+    std::swap( m_pData,    value.m_pData );
+    std::swap( m_Size,     value.m_Size );
+}
@@ -0,0 +1,242 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MappedResMesh.cpp
+// Desc : Memory Mapped Resource Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MappedResMesh.h>
+#include <MshFormat.h>
+#include <asdxLog.h>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+// 配列を直接参照するために必要なアライメント(構造体の要素は全て4バイト).
+static const u32 MSH_DATA_ALIGNMENT = 4;
+
+//-----------------------------------------------------------------------------------
+//      アライメントされているかどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsAligned( const u8* ptr )
+{ return ( reinterpret_cast<size_t>( ptr ) % MSH_DATA_ALIGNMENT ) == 0; }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MappedResMesh class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MappedResMesh::MappedResMesh()
+: asdx::ResMesh ()
+, m_File        ()
+, m_Arena       ()
+, m_IsMapped    ( false )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MappedResMesh::~MappedResMesh()
+{
+    // 配列は全てマップ先かコピー先のバッファを指すので, 基底クラスで解放しないように外しておく.
+    DetachViews();
+}
+
+//-----------------------------------------------------------------------------------
+//      ムーブコンストラクタです.
+//-----------------------------------------------------------------------------------
+MappedResMesh::MappedResMesh( MappedResMesh&& value )
+: asdx::ResMesh ()
+, m_File        ()
+, m_Arena       ()
+, m_IsMapped    ( false )
+{ Swap( value ); }
+
+//-----------------------------------------------------------------------------------
+//      ムーブ代入演算子です.
+//-----------------------------------------------------------------------------------
+MappedResMesh& MappedResMesh::operator = ( MappedResMesh&& value )
+{
+    if ( this != &value )
+    {
+        Release();
+        Swap( value );
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイルをメモリにマップしてロードします.
+//-----------------------------------------------------------------------------------
+bool MappedResMesh::LoadFromFile( const char* filename )
+{
+    Release();
+
+    if ( !m_File.Open( filename ) )
+    {
+        ELOG( "Error : File Open Failed. filename = %s", filename );
+        return false;
+    }
+
+    const u8* pData = m_File.GetData();
+    u64       size  = m_File.GetSize();
+
+    // ヘッダを検証.
+    MshFileHeader header;
+    if ( size < sizeof( header ) )
+    {
+        ELOG( "Error : Invalid File Size. filename = %s", filename );
+        m_File.Close();
+        return false;
+    }
+    memcpy( &header, pData, sizeof( header ) );
+
+    if ( header.Magic[0] != 'M' || header.Magic[1] != 'S' || header.Magic[2] != 'H' || header.Magic[3] != '\0' )
+    {
+        ELOG( "Error : Invalid File Magic. filename = %s", filename );
+        m_File.Close();
+        return false;
+    }
+
+    if ( header.Version != MSH_VERSION || header.DataHeaderSize < MSH_DATA_HEADER_SIZE )
+    {
+        ELOG( "Error : Unsupported File Version. filename = %s", filename );
+        m_File.Close();
+        return false;
+    }
+
+    const MshDataHeader& info = header.DataHeader;
+    if ( info.VertexStructureSize   != sizeof( asdx::ResMesh::Vertex   )
+      || info.IndexStructureSize    != sizeof( asdx::ResMesh::Index    )
+      || info.MaterialStructureSize != sizeof( asdx::ResMesh::Material )
+      || info.SubsetStructureSize   != sizeof( asdx::ResMesh::Subset   ) )
+    {
+        ELOG( "Error : Structure Size Mismatch. filename = %s", filename );
+        m_File.Close();
+        return false;
+    }
+
+    // 各配列の開始位置を求める.
+    u64 vertexOffset   = offsetof( MshFileHeader, DataHeader ) + u64( header.DataHeaderSize );
+    u64 indexOffset    = vertexOffset   + u64( info.NumVertices  ) * info.VertexStructureSize;
+    u64 materialOffset = indexOffset    + u64( info.NumIndices   ) * info.IndexStructureSize;
+    u64 subsetOffset   = materialOffset + u64( info.NumMaterials ) * info.MaterialStructureSize;
+    u64 endOffset      = subsetOffset   + u64( info.NumSubsets   ) * info.SubsetStructureSize;
+
+    if ( endOffset > size )
+    {
+        ELOG( "Error : Data Out Of Range. filename = %s", filename );
+        m_File.Close();
+        return false;
+    }
+
+    const u8* pVertex   = pData + vertexOffset;
+    const u8* pIndex    = pData + indexOffset;
+    const u8* pMaterial = pData + materialOffset;
+    const u8* pSubset   = pData + subsetOffset;
+
+    // 各構造体のサイズは4の倍数なので, 先頭さえ揃えば残りの配列も揃う.
+    bool isAligned = IsAligned( pVertex ) && IsAligned( pIndex ) && IsAligned( pMaterial ) && IsAligned( pSubset );
+    if ( !isAligned )
+    {
+        // アライメントされていない古いファイルは, 配列をまとめて1つのバッファにコピーして扱う.
+        size_t size = size_t( endOffset - vertexOffset );
+        m_Arena.resize( ( size + sizeof( u32 ) - 1 ) / sizeof( u32 ) );
+
+        u8* pArena = nullptr;
+        if ( size > 0 )
+        {
+            pArena = reinterpret_cast<u8*>( &m_Arena[0] );
+            memcpy( pArena, pVertex, size );
+        }
+
+        pVertex   = pArena;
+        pIndex    = pArena + ( indexOffset    - vertexOffset );
+        pMaterial = pArena + ( materialOffset - vertexOffset );
+        pSubset   = pArena + ( subsetOffset   - vertexOffset );
+    }
+
+    m_VertexCount   = info.NumVertices;
+    m_IndexCount    = info.NumIndices;
+    m_MaterialCount = info.NumMaterials;
+    m_SubsetCount   = info.NumSubsets;
+
+    // マップしたファイルを直接参照する. 読み取り専用なので書き換えないこと.
+    m_pVertex   = ( m_VertexCount   > 0 ) ? reinterpret_cast<asdx::ResMesh::Vertex*>  ( const_cast<u8*>( pVertex   ) ) : nullptr;
+    m_pIndex    = ( m_IndexCount    > 0 ) ? reinterpret_cast<asdx::ResMesh::Index*>   ( const_cast<u8*>( pIndex    ) ) : nullptr;
+    m_pMaterial = ( m_MaterialCount > 0 ) ? reinterpret_cast<asdx::ResMesh::Material*>( const_cast<u8*>( pMaterial ) ) : nullptr;
+    m_pSubset   = ( m_SubsetCount   > 0 ) ? reinterpret_cast<asdx::ResMesh::Subset*>  ( const_cast<u8*>( pSubset   ) ) : nullptr;
+    m_IsMapped  = isAligned;
+
+    // コピーした場合はファイルを開いておく必要はない.
+    if ( !isAligned )
+    { m_File.Close(); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      メモリを解放します.
+//-----------------------------------------------------------------------------------
+void MappedResMesh::Release()
+{
+    DetachViews();
+    m_File.Close();
+    m_IsMapped = false;
+
+    // 確保したメモリも返しておく.
+    std::vector< u32 >().swap( m_Arena );
+}
+
+//-----------------------------------------------------------------------------------
+//      マップしたファイルを直接参照しているかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool MappedResMesh::IsMapped() const
+{ return m_IsMapped; }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void MappedResMesh::Swap( MappedResMesh& value )
+{
+    // マップ先・コピー先のバッファは移動しないので, 参照しているポインタもそのまま交換すれば良い.
+    std::swap( m_VertexCount,   value.m_VertexCount );
+    std::swap( m_IndexCount,    value.m_IndexCount );
+    std::swap( m_MaterialCount, value.m_MaterialCount );
+    std::swap( m_SubsetCount,   value.m_SubsetCount );
+    std::swap( m_pVertex,       value.m_pVertex );
+    std::swap( m_pIndex,        value.m_pIndex );
+    std::swap( m_pMaterial,     value.m_pMaterial );
+    std::swap( m_pSubset,       value.m_pSubset );
+    std::swap( m_IsMapped,      value.m_IsMapped );
+
+    m_File .Swap( value.m_File );
+    m_Arena.swap( value.m_Arena );
+}
+
+//-----------------------------------------------------------------------------------
+//      マップ先を参照しているポインタを外します.
+//-----------------------------------------------------------------------------------
+void MappedResMesh::DetachViews()
+{
+    m_VertexCount   = 0;
+    m_IndexCount    = 0;
+    m_MaterialCount = 0;
+    m_SubsetCount   = 0;
+
+    m_pVertex   = nullptr;
+    m_pIndex    = nullptr;
+    m_pMaterial = nullptr;
+    m_pSubset   = nullptr;
+}
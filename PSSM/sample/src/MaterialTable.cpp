@@ -0,0 +1,216 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MaterialTable.cpp
+// Desc : Compact Material Table Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MaterialTable.h>
+#include <asdxLog.h>
+#include <cassert>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      固定長の文字列配列の長さを求めます.
+//-----------------------------------------------------------------------------------
+inline u32 GetLength( const char* value, u32 maxLength )
+{
+    u32 length = 0;
+    while( length < maxLength && value[ length ] != '\0' )
+    { length++; }
+    return length;
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列テーブル上の文字列を登録します.
+//-----------------------------------------------------------------------------------
+inline u32 InternFromTable( StringTable& strings, const char* pTable, u32 tableSize, u32 offset )
+{
+    if ( offset == CMSH_INVALID_STRING || offset >= tableSize )
+    { return StringTable::INVALID_ID; }
+
+    return strings.Intern( pTable + offset, GetLength( pTable + offset, tableSize - offset ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      3要素のベクトルに変換します.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ToVector3( const f32* value )
+{ return asdx::Vector3( value[0], value[1], value[2] ); }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MaterialTable class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MaterialTable::MaterialTable()
+: m_Materials   ()
+, m_Strings     ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MaterialTable::~MaterialTable()
+{ Release(); }
+
+//-----------------------------------------------------------------------------------
+//      コピーコンストラクタです.
+//-----------------------------------------------------------------------------------
+MaterialTable::MaterialTable( const MaterialTable& value )
+: m_Materials   ( value.m_Materials )
+, m_Strings     ( value.m_Strings )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      代入演算子です.
+//-----------------------------------------------------------------------------------
+MaterialTable& MaterialTable::operator = ( const MaterialTable& value )
+{
+    if ( this != &value )
+    {
+        m_Materials = value.m_Materials;
+        m_Strings   = value.m_Strings;
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュのマテリアルから構築します.
+//-----------------------------------------------------------------------------------
+bool MaterialTable::Build( const asdx::ResMesh& mesh )
+{
+    Release();
+
+    u32 count = mesh.GetMaterialCount();
+    const asdx::ResMesh::Material* pSrc = mesh.GetMaterials();
+    if ( count > 0 && pSrc == nullptr )
+    {
+        ELOG( "Error : Invalid Material Data." );
+        return false;
+    }
+
+    m_Materials.resize( count );
+    for( u32 i=0; i<count; ++i )
+    {
+        const asdx::ResMesh::Material&  src = pSrc[i];
+        CompactMaterial&                dst = m_Materials[i];
+
+        dst.Ambient  = src.Ambient;
+        dst.Diffuse  = src.Diffuse;
+        dst.Specular = src.Specular;
+        dst.Emissive = src.Emissive;
+        dst.Alpha    = src.Alpha;
+        dst.Power    = src.Power;
+
+        // ファイルの文字列は終端されているとは限らないので長さを制限して登録する.
+        const u32 N = asdx::ResMesh::NUM_FILENAME;
+        dst.AmbientMap      = m_Strings.Intern( src.AmbientMap,      GetLength( src.AmbientMap,      N ) );
+        dst.DiffuseMap      = m_Strings.Intern( src.DiffuseMap,      GetLength( src.DiffuseMap,      N ) );
+        dst.SpecularMap     = m_Strings.Intern( src.SpecularMap,     GetLength( src.SpecularMap,     N ) );
+        dst.BumpMap         = m_Strings.Intern( src.BumpMap,         GetLength( src.BumpMap,         N ) );
+        dst.DisplacementMap = m_Strings.Intern( src.DisplacementMap, GetLength( src.DisplacementMap, N ) );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      クック済みのマテリアルから構築します.
+//-----------------------------------------------------------------------------------
+bool MaterialTable::Build
+(
+    const CookedMaterial*   pMaterials,
+    u32                     count,
+    const char*             pTable,
+    u32                     tableSize
+)
+{
+    Release();
+
+    if ( count > 0 && pMaterials == nullptr )
+    {
+        ELOG( "Error : Invalid Material Data." );
+        return false;
+    }
+
+    if ( pTable == nullptr )
+    { tableSize = 0; }
+
+    m_Materials.resize( count );
+    for( u32 i=0; i<count; ++i )
+    {
+        const CookedMaterial&   src = pMaterials[i];
+        CompactMaterial&        dst = m_Materials[i];
+
+        dst.Ambient  = ToVector3( src.Ambient  );
+        dst.Diffuse  = ToVector3( src.Diffuse  );
+        dst.Specular = ToVector3( src.Specular );
+        dst.Emissive = ToVector3( src.Emissive );
+        dst.Alpha    = src.Alpha;
+        dst.Power    = src.Power;
+
+        dst.AmbientMap      = InternFromTable( m_Strings, pTable, tableSize, src.AmbientMap      );
+        dst.DiffuseMap      = InternFromTable( m_Strings, pTable, tableSize, src.DiffuseMap      );
+        dst.SpecularMap     = InternFromTable( m_Strings, pTable, tableSize, src.SpecularMap     );
+        dst.BumpMap         = InternFromTable( m_Strings, pTable, tableSize, src.BumpMap         );
+        dst.DisplacementMap = InternFromTable( m_Strings, pTable, tableSize, src.DisplacementMap );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      破棄します.
+//-----------------------------------------------------------------------------------
+void MaterialTable::Release()
+{
+    m_Materials.clear();
+    m_Strings.Clear();
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアル数を取得します.
+//-----------------------------------------------------------------------------------
+u32 MaterialTable::GetCount() const
+{ return u32( m_Materials.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      マテリアルを取得します.
+//-----------------------------------------------------------------------------------
+const MaterialTable::CompactMaterial& MaterialTable::GetMaterial( u32 index ) const
+{
+    assert( index < m_Materials.size() );
+    return m_Materials[ index ];
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列テーブルを取得します.
+//-----------------------------------------------------------------------------------
+const StringTable& MaterialTable::GetStrings() const
+{ return m_Strings; }
+
+//-----------------------------------------------------------------------------------
+//      マテリアルと文字列の格納に使っているバイト数を取得します.
+//-----------------------------------------------------------------------------------
+u32 MaterialTable::GetByteSize() const
+{ return u32( m_Materials.size() * sizeof( CompactMaterial ) ) + m_Strings.GetByteSize(); }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void MaterialTable::Swap( MaterialTable& value )
+{
+    m_Materials.swap( value.m_Materials );
+    m_Strings  .Swap( value.m_Strings );
+}
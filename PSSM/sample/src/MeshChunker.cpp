@@ -0,0 +1,246 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshChunker.cpp
+// Desc : Spatial Mesh Chunker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshChunker.h>
+#include <asdxMath.h>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+///////////////////////////////////////////////////////////////////////////////////
+// TriangleRef structure
+///////////////////////////////////////////////////////////////////////////////////
+struct TriangleRef
+{
+    f32     Centroid[ 3 ];      //!< 重心です.
+    u32     MaterialID;         //!< マテリアル番号です.
+    u32     IndexOffset;        //!< 元の頂点インデックス上の位置です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Node structure
+///////////////////////////////////////////////////////////////////////////////////
+struct Node
+{
+    u32     Begin;              //!< 三角形の開始番号です.
+    u32     End;                //!< 三角形の終了番号です.
+    u32     Depth;              //!< 深さです.
+};
+
+//-----------------------------------------------------------------------------------
+//! @brief      三角形を重心の座標で比較します.
+//-----------------------------------------------------------------------------------
+struct CentroidLess
+{
+    u32     Axis;       //!< 比較する軸です.
+
+    explicit CentroidLess( u32 axis )
+    : Axis( axis )
+    { /* DO_NOTHING */ }
+
+    bool operator () ( const TriangleRef& lhs, const TriangleRef& rhs ) const
+    { return lhs.Centroid[ Axis ] < rhs.Centroid[ Axis ]; }
+};
+
+//-----------------------------------------------------------------------------------
+//! @brief      三角形をマテリアル番号, 元の順番で比較します.
+//-----------------------------------------------------------------------------------
+bool MaterialLess( const TriangleRef& lhs, const TriangleRef& rhs )
+{
+    if ( lhs.MaterialID != rhs.MaterialID )
+    { return lhs.MaterialID < rhs.MaterialID; }
+
+    return lhs.IndexOffset < rhs.IndexOffset;
+}
+
+//-----------------------------------------------------------------------------------
+//! @brief      位置座標を取得します.
+//-----------------------------------------------------------------------------------
+inline const f32* GetPosition( const void* pPositions, u32 stride, u32 index )
+{ return reinterpret_cast<const f32*>( static_cast<const u8*>( pPositions ) + size_t( stride ) * index ); }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MeshChunker class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      メッシュを空間的なチャンクに分割します.
+//-----------------------------------------------------------------------------------
+void MeshChunker::Split
+(
+    const void*                     pPositions,
+    u32                             stride,
+    u32                             vertexCount,
+    const Config&                   config,
+    std::vector< u32 >&             indices,
+    std::vector< MshSubset >&       subsets,
+    std::vector< CookedChunk >&     chunks,
+    Statistics*                     pStats
+)
+{
+    chunks.clear();
+
+    if ( pStats != nullptr )
+    {
+        *pStats = Statistics();
+        pStats->SubsetCountBefore = u32( subsets.size() );
+    }
+
+    if ( pPositions == nullptr || vertexCount == 0 )
+    { return; }
+
+    // サブセットが参照する三角形を集める.
+    std::vector< TriangleRef > triangles;
+    triangles.reserve( indices.size() / 3 );
+    for( size_t i=0; i<subsets.size(); ++i )
+    {
+        const MshSubset& subset = subsets[i];
+        u64 end = asdx::Min( u64( subset.IndexOffset ) + subset.IndexCount, u64( indices.size() ) );
+
+        for( u64 j=subset.IndexOffset; j + 3 <= end; j+=3 )
+        {
+            const u32* pTri = &indices[ size_t( j ) ];
+            if ( pTri[0] >= vertexCount || pTri[1] >= vertexCount || pTri[2] >= vertexCount )
+            { continue; }
+
+            const f32* p0 = GetPosition( pPositions, stride, pTri[0] );
+            const f32* p1 = GetPosition( pPositions, stride, pTri[1] );
+            const f32* p2 = GetPosition( pPositions, stride, pTri[2] );
+
+            TriangleRef tri;
+            tri.Centroid[0] = ( p0[0] + p1[0] + p2[0] ) / 3.0f;
+            tri.Centroid[1] = ( p0[1] + p1[1] + p2[1] ) / 3.0f;
+            tri.Centroid[2] = ( p0[2] + p1[2] + p2[2] ) / 3.0f;
+            tri.MaterialID  = subset.MaterialID;
+            tri.IndexOffset = u32( j );
+            triangles.push_back( tri );
+        }
+    }
+
+    if ( triangles.empty() )
+    { return; }
+
+    std::vector< u32 >       chunkIndices;
+    std::vector< MshSubset > chunkSubsets;
+    chunkIndices.reserve( triangles.size() * 3 );
+
+    // 左の子から順に葉を出力するので, チャンクの並びも空間的に近いもの同士が隣り合う.
+    std::vector< Node > stack;
+    Node root = { 0, u32( triangles.size() ), 0 };
+    stack.push_back( root );
+
+    while( !stack.empty() )
+    {
+        Node node = stack.back();
+        stack.pop_back();
+
+        u32 count = node.End - node.Begin;
+        if ( count > config.MaxTriangles && node.Depth < config.MaxDepth )
+        {
+            // 重心のAABBが最も長い軸で分割する.
+            f32 mini[ 3 ];
+            f32 maxi[ 3 ];
+            for( u32 k=0; k<3; ++k )
+            { mini[k] = maxi[k] = triangles[ node.Begin ].Centroid[k]; }
+
+            for( u32 i=node.Begin + 1; i<node.End; ++i )
+            {
+                for( u32 k=0; k<3; ++k )
+                {
+                    mini[k] = asdx::Min( mini[k], triangles[i].Centroid[k] );
+                    maxi[k] = asdx::Max( maxi[k], triangles[i].Centroid[k] );
+                }
+            }
+
+            u32 axis = 0;
+            for( u32 k=1; k<3; ++k )
+            {
+                if ( maxi[k] - mini[k] > maxi[ axis ] - mini[ axis ] )
+                { axis = k; }
+            }
+
+            // 全ての重心が一致する場合は分割できない.
+            if ( maxi[ axis ] > mini[ axis ] )
+            {
+                u32 middle = node.Begin + count / 2;
+                std::nth_element(
+                    triangles.begin() + node.Begin,
+                    triangles.begin() + middle,
+                    triangles.begin() + node.End,
+                    CentroidLess( axis ) );
+
+                Node left  = { node.Begin, middle,   node.Depth + 1 };
+                Node right = { middle,     node.End, node.Depth + 1 };
+                stack.push_back( right );
+                stack.push_back( left );
+                continue;
+            }
+        }
+
+        // 葉をチャンクとして出力する. チャンク内ではマテリアル順に並べてサブセットを作る.
+        std::sort( triangles.begin() + node.Begin, triangles.begin() + node.End, MaterialLess );
+
+        CookedChunk chunk;
+        chunk.SubsetOffset = u32( chunkSubsets.size() );
+        chunk.SubsetCount  = 0;
+        chunk.Reserved[0]  = 0;
+        chunk.Reserved[1]  = 0;
+
+        const f32* pFirst = GetPosition( pPositions, stride, indices[ triangles[ node.Begin ].IndexOffset ] );
+        for( u32 k=0; k<3; ++k )
+        { chunk.Min[k] = chunk.Max[k] = pFirst[k]; }
+
+        for( u32 i=node.Begin; i<node.End; ++i )
+        {
+            const TriangleRef& tri = triangles[i];
+            if ( i == node.Begin || tri.MaterialID != triangles[ i - 1 ].MaterialID )
+            {
+                MshSubset subset;
+                subset.IndexOffset = u32( chunkIndices.size() );
+                subset.IndexCount  = 0;
+                subset.MaterialID  = tri.MaterialID;
+                chunkSubsets.push_back( subset );
+                chunk.SubsetCount++;
+            }
+
+            for( u32 j=0; j<3; ++j )
+            {
+                u32 index = indices[ tri.IndexOffset + j ];
+                chunkIndices.push_back( index );
+
+                const f32* pos = GetPosition( pPositions, stride, index );
+                for( u32 k=0; k<3; ++k )
+                {
+                    chunk.Min[k] = asdx::Min( chunk.Min[k], pos[k] );
+                    chunk.Max[k] = asdx::Max( chunk.Max[k], pos[k] );
+                }
+            }
+
+            chunkSubsets.back().IndexCount += 3;
+        }
+
+        chunks.push_back( chunk );
+
+        if ( pStats != nullptr )
+        { pStats->MaxChunkTriangles = asdx::Max( pStats->MaxChunkTriangles, count ); }
+    }
+
+    indices.swap( chunkIndices );
+    subsets.swap( chunkSubsets );
+
+    if ( pStats != nullptr )
+    {
+        pStats->ChunkCount       = u32( chunks.size() );
+        pStats->SubsetCountAfter = u32( subsets.size() );
+    }
+}
@@ -0,0 +1,313 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshClusterizer.cpp
+// Desc : Mesh Clusterizer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshClusterizer.h>
+#include <FrustumCulling.h>
+#include <cmath>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+// 無効な番号です.
+static const u32 INVALID_INDEX = 0xffffffff;
+
+// 法線コーンが広すぎてカリングに使えないとみなす値(コーンの半角 約84度).
+static const f32 CONE_MIN_DOT = 0.1f;
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MeshClusterizer class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MeshClusterizer::MeshClusterizer()
+: m_Meshlets        ()
+, m_SubsetCount     ( 0 )
+, m_TriangleCount   ( 0 )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MeshClusterizer::~MeshClusterizer()
+{ Release(); }
+
+//-----------------------------------------------------------------------------------
+//      サブセットをメッシュレットに分割します.
+//-----------------------------------------------------------------------------------
+bool MeshClusterizer::Build( const asdx::ResMesh& mesh )
+{
+    Release();
+
+    const asdx::ResMesh::Index*  pIndices   = mesh.GetIndices();
+    const asdx::ResMesh::Subset* pSubsets   = mesh.GetSubsets();
+    u32                          indexCount = mesh.GetIndexCount();
+
+    if ( pIndices == nullptr || pSubsets == nullptr )
+    { return false; }
+
+    // 頂点が現在のメッシュレットに含まれているかを, メッシュレット番号で判定する.
+    std::vector< u32 > stamps( mesh.GetVertexCount(), INVALID_INDEX );
+
+    m_SubsetCount = mesh.GetSubsetCount();
+    for( u32 i=0; i<m_SubsetCount; ++i )
+    {
+        const asdx::ResMesh::Subset& subset = pSubsets[i];
+        if ( u64( subset.IndexOffset ) + subset.IndexCount > indexCount )
+        { return false; }
+
+        u32 triangleCount = subset.IndexCount / 3;
+        m_TriangleCount += triangleCount;
+
+        Meshlet meshlet;
+        meshlet.SubsetID    = i;
+        meshlet.IndexOffset = subset.IndexOffset;
+        meshlet.IndexCount  = 0;
+        meshlet.VertexCount = 0;
+
+        u32 id = u32( m_Meshlets.size() );
+
+        for( u32 j=0; j<triangleCount; ++j )
+        {
+            const asdx::ResMesh::Index* tri = &pIndices[ subset.IndexOffset + j * 3 ];
+
+            u32 newVertices = 0;
+            for( u32 k=0; k<3; ++k )
+            {
+                if ( stamps[ tri[k] ] != id && ( k < 1 || tri[k] != tri[0] ) && ( k < 2 || tri[k] != tri[1] ) )
+                { newVertices++; }
+            }
+
+            // 上限を超える場合は新しいメッシュレットを始める.
+            if ( meshlet.VertexCount + newVertices > MAX_MESHLET_VERTEX_COUNT
+              || meshlet.IndexCount / 3 + 1        > MAX_MESHLET_TRIANGLE_COUNT )
+            {
+                ComputeBounds( mesh, meshlet );
+                m_Meshlets.push_back( meshlet );
+
+                id++;
+                meshlet.IndexOffset += meshlet.IndexCount;
+                meshlet.IndexCount   = 0;
+                meshlet.VertexCount  = 0;
+
+                newVertices = 0;
+                for( u32 k=0; k<3; ++k )
+                {
+                    if ( ( k < 1 || tri[k] != tri[0] ) && ( k < 2 || tri[k] != tri[1] ) )
+                    { newVertices++; }
+                }
+            }
+
+            for( u32 k=0; k<3; ++k )
+            { stamps[ tri[k] ] = id; }
+
+            meshlet.VertexCount += newVertices;
+            meshlet.IndexCount  += 3;
+        }
+
+        if ( meshlet.IndexCount > 0 )
+        {
+            ComputeBounds( mesh, meshlet );
+            m_Meshlets.push_back( meshlet );
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュレットを破棄します.
+//-----------------------------------------------------------------------------------
+void MeshClusterizer::Release()
+{
+    m_Meshlets.clear();
+    m_SubsetCount   = 0;
+    m_TriangleCount = 0;
+}
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void MeshClusterizer::Swap( MeshClusterizer& value )
+{
+    m_Meshlets.swap( value.m_Meshlets );
+    std::swap( m_SubsetCount,   value.m_SubsetCount );
+    std::swap( m_TriangleCount, value.m_TriangleCount );
+}
+
+//-----------------------------------------------------------------------------------
+//      カリングを行い, 描画範囲を求めます.
+//-----------------------------------------------------------------------------------
+void MeshClusterizer::Cull( const CullView& view, CullResult& result ) const
+{
+    result.Ranges.clear();
+    result.SubsetRangeOffset.assign( m_SubsetCount + 1, 0 );
+    result.TestedMeshlets   = u32( m_Meshlets.size() );
+    result.VisibleMeshlets  = 0;
+    result.FrustumCulled    = 0;
+    result.ConeCulled       = 0;
+    result.TotalTriangles   = m_TriangleCount;
+    result.VisibleTriangles = 0;
+
+    asdx::BoundingFrustum frustum( view.WorldViewProj );
+
+    // 右手系のビュー空間で反時計回りの三角形は, 画面上でも反時計回りになる.
+    // 時計回りが表面の場合は, 巻き順の法線の反対側が表になる.
+    f32 frontSign = ( view.FrontCounterClockwise ) ? 1.0f : -1.0f;
+
+    for( size_t i=0; i<m_Meshlets.size(); ++i )
+    {
+        const Meshlet& meshlet = m_Meshlets[i];
+
+        // 視錐台カリング(バウンディングスフィアで粗く判定してからAABBで判定).
+        bool culled = false;
+        for( u32 j=0; j<6 && !culled; ++j )
+        {
+            const asdx::Plane& plane = frustum.plane[j];
+            culled = ( asdx::Vector3::Dot( plane.normal, meshlet.Center ) + plane.d < -meshlet.Radius )
+                  || IsOutside( plane, meshlet.BoxMin, meshlet.BoxMax );
+        }
+
+        if ( culled )
+        {
+            result.FrustumCulled++;
+            continue;
+        }
+
+        // 全ての三角形がカメラに対して裏向きならカリング.
+        if ( view.EnableCone && meshlet.ConeCutoff < 1.0f )
+        {
+            asdx::Vector3 dir = meshlet.Center - view.CameraPosition;
+            f32 dist = sqrtf( dir.LengthSq() );
+            if ( asdx::Vector3::Dot( dir, meshlet.ConeAxis ) * frontSign >= meshlet.ConeCutoff * dist + meshlet.Radius )
+            {
+                result.ConeCulled++;
+                continue;
+            }
+        }
+
+        result.VisibleMeshlets++;
+        result.VisibleTriangles += meshlet.IndexCount / 3;
+
+        // 同じサブセットで連続していれば1回の描画にまとめる.
+        if ( !result.Ranges.empty() )
+        {
+            DrawRange& last = result.Ranges.back();
+            if ( last.SubsetID == meshlet.SubsetID
+              && last.IndexOffset + last.IndexCount == meshlet.IndexOffset )
+            {
+                last.IndexCount += meshlet.IndexCount;
+                continue;
+            }
+        }
+
+        DrawRange range;
+        range.SubsetID    = meshlet.SubsetID;
+        range.IndexOffset = meshlet.IndexOffset;
+        range.IndexCount  = meshlet.IndexCount;
+        result.Ranges.push_back( range );
+
+        result.SubsetRangeOffset[ meshlet.SubsetID + 1 ] = u32( result.Ranges.size() );
+    }
+
+    // 描画範囲が無いサブセットは直前のサブセットの終端に合わせる.
+    for( u32 i=1; i<=m_SubsetCount; ++i )
+    { result.SubsetRangeOffset[i] = asdx::Max( result.SubsetRangeOffset[i], result.SubsetRangeOffset[ i - 1 ] ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュレット数を取得します.
+//-----------------------------------------------------------------------------------
+u32 MeshClusterizer::GetMeshletCount() const
+{ return u32( m_Meshlets.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      メッシュレットを取得します.
+//-----------------------------------------------------------------------------------
+const MeshClusterizer::Meshlet& MeshClusterizer::GetMeshlet( u32 index ) const
+{
+    assert( index < m_Meshlets.size() );
+    return m_Meshlets[ index ];
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュレットのバウンディングスフィア・AABB・法線コーンを求めます.
+//-----------------------------------------------------------------------------------
+void MeshClusterizer::ComputeBounds( const asdx::ResMesh& mesh, Meshlet& meshlet ) const
+{
+    const asdx::ResMesh::Vertex* pVertices = mesh.GetVertices();
+    const asdx::ResMesh::Index*  pIndices  = mesh.GetIndices() + meshlet.IndexOffset;
+
+    // AABB.
+    asdx::Vector3 mini = pVertices[ pIndices[0] ].Position;
+    asdx::Vector3 maxi = mini;
+    for( u32 i=1; i<meshlet.IndexCount; ++i )
+    {
+        const asdx::Vector3& pos = pVertices[ pIndices[i] ].Position;
+        mini = asdx::Vector3::Min( mini, pos );
+        maxi = asdx::Vector3::Max( maxi, pos );
+    }
+    meshlet.BoxMin = mini;
+    meshlet.BoxMax = maxi;
+
+    // バウンディングスフィアはAABBの中心から最も遠い頂点までとする.
+    meshlet.Center = ( mini + maxi ) * 0.5f;
+    f32 radiusSq = 0.0f;
+    for( u32 i=0; i<meshlet.IndexCount; ++i )
+    {
+        asdx::Vector3 diff = pVertices[ pIndices[i] ].Position - meshlet.Center;
+        radiusSq = asdx::Max( radiusSq, diff.LengthSq() );
+    }
+    meshlet.Radius = sqrtf( radiusSq );
+
+    // 法線コーン. ラスタライザーの裏面判定と同じく, 面の向きは巻き順だけで決める.
+    std::vector< asdx::Vector3 > normals;
+    normals.reserve( meshlet.IndexCount / 3 );
+
+    asdx::Vector3 axis( 0.0f, 0.0f, 0.0f );
+    for( u32 i=0; i + 2<meshlet.IndexCount; i+=3 )
+    {
+        const asdx::ResMesh::Vertex& v0 = pVertices[ pIndices[ i + 0 ] ];
+        const asdx::ResMesh::Vertex& v1 = pVertices[ pIndices[ i + 1 ] ];
+        const asdx::ResMesh::Vertex& v2 = pVertices[ pIndices[ i + 2 ] ];
+
+        asdx::Vector3 n = asdx::Vector3::Cross( v1.Position - v0.Position, v2.Position - v0.Position );
+        f32 lengthSq = n.LengthSq();
+        if ( lengthSq <= F32_EPSILON * F32_EPSILON )
+        { continue; }
+
+        n *= ( 1.0f / sqrtf( lengthSq ) );
+        normals.push_back( n );
+        axis += n;
+    }
+
+    meshlet.ConeAxis   = asdx::Vector3( 0.0f, 0.0f, 1.0f );
+    meshlet.ConeCutoff = 1.0f;
+
+    if ( normals.empty() || axis.LengthSq() <= F32_EPSILON )
+    { return; }
+
+    axis.Normalize();
+
+    f32 minDot = 1.0f;
+    for( size_t i=0; i<normals.size(); ++i )
+    { minDot = asdx::Min( minDot, asdx::Vector3::Dot( axis, normals[i] ) ); }
+
+    if ( minDot <= CONE_MIN_DOT )
+    { return; }
+
+    // コーンの半角の正弦を判定値とする.
+    meshlet.ConeAxis   = axis;
+    meshlet.ConeCutoff = sqrtf( 1.0f - minDot * minDot );
+}
@@ -0,0 +1,575 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshOptimizer.cpp
+// Desc : Mesh Optimizer Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshOptimizer.h>
+#include <asdxMath.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+// 無効な番号です.
+static const u32 INVALID_INDEX = 0xffffffff;
+
+// Forsyth のスコア計算に用いるパラメータ.
+static const f32 CACHE_DECAY_POWER   = 1.5f;
+static const f32 LAST_TRIANGLE_SCORE = 0.75f;
+static const f32 VALENCE_BOOST_SCALE = 2.0f;
+static const f32 VALENCE_BOOST_POWER = 0.5f;
+
+// オーバードロー削減で許容するACMRの悪化率の既定値.
+static const f32 DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// VertexCacheSimulator class
+/////////////////////////////////////////////////////////////////////////////////////
+class VertexCacheSimulator
+{
+public:
+    //-------------------------------------------------------------------------------
+    //      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    VertexCacheSimulator( u32 vertexCount, u32 cacheSize )
+    : m_Stamps  ( vertexCount, 0 )
+    , m_Counter ( cacheSize + 1 )
+    , m_Size    ( cacheSize )
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------------
+    //      三角形を処理して, キャッシュミスした頂点数を返却します.
+    //-------------------------------------------------------------------------------
+    u32 Access( u32 a, u32 b, u32 c )
+    { return Access( a ) + Access( b ) + Access( c ); }
+
+    //-------------------------------------------------------------------------------
+    //      キャッシュを空にします.
+    //-------------------------------------------------------------------------------
+    void Reset()
+    { m_Counter += m_Size + 1; }
+
+private:
+    std::vector< u32 >  m_Stamps;       //!< キャッシュに入った時刻です.
+    u32                 m_Counter;      //!< 現在の時刻です.
+    u32                 m_Size;         //!< キャッシュサイズです.
+
+    //-------------------------------------------------------------------------------
+    //      頂点を処理して, キャッシュミスした場合は1を返却します.
+    //-------------------------------------------------------------------------------
+    u32 Access( u32 index )
+    {
+        // FIFOなのでヒットしても時刻は更新しない.
+        if ( m_Counter - m_Stamps[ index ] > m_Size )
+        {
+            m_Stamps[ index ] = m_Counter++;
+            return 1;
+        }
+
+        return 0;
+    }
+};
+
+//-----------------------------------------------------------------------------------
+//      頂点のスコアを求めます.
+//-----------------------------------------------------------------------------------
+inline f32 ComputeVertexScore( s32 cachePosition, u32 remaining )
+{
+    // 残りの三角形が無い頂点は選ばない.
+    if ( remaining == 0 )
+    { return -1.0f; }
+
+    f32 score = 0.0f;
+    if ( cachePosition >= 0 )
+    {
+        // 直前の三角形の頂点は, 次の三角形で使い切らないように少し下げる.
+        if ( cachePosition < 3 )
+        { score = LAST_TRIANGLE_SCORE; }
+        else
+        {
+            const f32 scale = 1.0f / f32( MeshOptimizer::OPTIMIZE_CACHE_SIZE - 3 );
+            score = powf( 1.0f - f32( cachePosition - 3 ) * scale, CACHE_DECAY_POWER );
+        }
+    }
+
+    // 残りの三角形が少ない頂点を優先して使い切る.
+    score += VALENCE_BOOST_SCALE * powf( f32( remaining ), -VALENCE_BOOST_POWER );
+
+    return score;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点の位置座標を取得します.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 GetPosition( const void* pVertices, u32 stride, u32 index )
+{
+    const f32* pPos = reinterpret_cast<const f32*>( static_cast<const u8*>( pVertices ) + size_t( stride ) * index );
+    return asdx::Vector3( pPos[0], pPos[1], pPos[2] );
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MeshOptimizer class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MeshOptimizer::MeshOptimizer()
+: m_OverdrawThreshold   ( DEFAULT_OVERDRAW_THRESHOLD )
+, m_Remap               ()
+, m_Work                ()
+, m_Output              ()
+{ memset( &m_Statistics, 0, sizeof( m_Statistics ) ); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MeshOptimizer::~MeshOptimizer()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      オーバードロー削減で許容するACMRの悪化率を設定します.
+//-----------------------------------------------------------------------------------
+void MeshOptimizer::SetOverdrawThreshold( f32 value )
+{ m_OverdrawThreshold = asdx::Max( value, 1.0f ); }
+
+//-----------------------------------------------------------------------------------
+//      全ての最適化を行います.
+//-----------------------------------------------------------------------------------
+void MeshOptimizer::Optimize
+(
+    void*           pVertices,
+    u32             vertexStride,
+    u32             vertexCount,
+    u32*            pIndices,
+    u32             indexCount,
+    const Range*    pRanges,
+    u32             rangeCount
+)
+{
+    m_Statistics.Before = AnalyzeVertexCache( pIndices, indexCount, vertexCount );
+
+    // サブセットをまたいで三角形を動かさないように範囲ごとに並び替える.
+    for( u32 i=0; i<rangeCount; ++i )
+    {
+        const Range& range = pRanges[i];
+        if ( u64( range.IndexOffset ) + range.IndexCount > indexCount )
+        { continue; }
+
+        OptimizeVertexCache( pIndices + range.IndexOffset, range.IndexCount, vertexCount );
+        OptimizeOverdraw   ( pIndices + range.IndexOffset, range.IndexCount, pVertices, vertexStride, vertexCount );
+    }
+
+    // 頂点バッファは全サブセットで共有しているので最後にまとめて並び替える.
+    OptimizeVertexFetch( pVertices, vertexStride, vertexCount, pIndices, indexCount );
+
+    m_Statistics.After = AnalyzeVertexCache( pIndices, indexCount, vertexCount );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点キャッシュの効率が良くなるように三角形を並び替えます.
+//-----------------------------------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache( u32* pIndices, u32 indexCount, u32 vertexCount )
+{
+    u32 triangleCount = indexCount / 3;
+    if ( triangleCount <= 1 )
+    { return; }
+
+    // 範囲内で使われている頂点だけに番号を振り直す.
+    if ( m_Remap.size() != vertexCount )
+    { m_Remap.assign( vertexCount, INVALID_INDEX ); }
+
+    std::vector< u32 > globalIndices;
+    std::vector< u32 > localIndices( triangleCount * 3 );
+    for( u32 i=0; i<triangleCount * 3; ++i )
+    {
+        u32 index = pIndices[i];
+        if ( m_Remap[ index ] == INVALID_INDEX )
+        {
+            m_Remap[ index ] = u32( globalIndices.size() );
+            globalIndices.push_back( index );
+        }
+        localIndices[i] = m_Remap[ index ];
+    }
+
+    // 次の呼び出しのために元に戻しておく.
+    for( size_t i=0; i<globalIndices.size(); ++i )
+    { m_Remap[ globalIndices[i] ] = INVALID_INDEX; }
+
+    u32 localCount = u32( globalIndices.size() );
+
+    // 頂点ごとに隣接する三角形のリストを作る.
+    std::vector< u32 > remaining( localCount, 0 );
+    std::vector< u32 > adjacencyOffset( localCount + 1, 0 );
+    std::vector< u32 > adjacency( triangleCount * 3 );
+
+    for( u32 i=0; i<triangleCount * 3; ++i )
+    { remaining[ localIndices[i] ]++; }
+
+    for( u32 i=0; i<localCount; ++i )
+    { adjacencyOffset[ i + 1 ] = adjacencyOffset[i] + remaining[i]; }
+
+    {
+        std::vector< u32 > cursor( adjacencyOffset.begin(), adjacencyOffset.end() - 1 );
+        for( u32 i=0; i<triangleCount * 3; ++i )
+        { adjacency[ cursor[ localIndices[i] ]++ ] = i / 3; }
+    }
+
+    // スコアの初期値を求める.
+    std::vector< s32 > cachePosition( localCount, -1 );
+    std::vector< f32 > vertexScore( localCount );
+    std::vector< f32 > triangleScore( triangleCount );
+    std::vector< u8  > emitted( triangleCount, 0 );
+
+    for( u32 i=0; i<localCount; ++i )
+    { vertexScore[i] = ComputeVertexScore( -1, remaining[i] ); }
+
+    u32 best      = 0;
+    f32 bestScore = -1.0f;
+    for( u32 i=0; i<triangleCount; ++i )
+    {
+        const u32* tri = &localIndices[ i * 3 ];
+        triangleScore[i] = vertexScore[ tri[0] ] + vertexScore[ tri[1] ] + vertexScore[ tri[2] ];
+        if ( triangleScore[i] > bestScore )
+        {
+            best      = i;
+            bestScore = triangleScore[i];
+        }
+    }
+
+    u32 cache   [ OPTIMIZE_CACHE_SIZE + 3 ];
+    u32 newCache[ OPTIMIZE_CACHE_SIZE + 3 ];
+    u32 cacheCount = 0;
+    u32 cursor     = 0;
+
+    m_Output.resize( triangleCount * 3 );
+
+    for( u32 i=0; i<triangleCount; ++i )
+    {
+        // 候補が無い場合は未出力の三角形を入力順に探す.
+        if ( best == INVALID_INDEX )
+        {
+            while( emitted[ cursor ] )
+            { cursor++; }
+            best = cursor;
+        }
+
+        const u32* tri = &localIndices[ best * 3 ];
+        m_Output[ i * 3 + 0 ] = tri[0];
+        m_Output[ i * 3 + 1 ] = tri[1];
+        m_Output[ i * 3 + 2 ] = tri[2];
+        emitted[ best ] = 1;
+
+        // 隣接リストから取り除く.
+        for( u32 j=0; j<3; ++j )
+        {
+            u32  v     = tri[j];
+            u32* pList = &adjacency[ adjacencyOffset[ v ] ];
+            u32  count = remaining[ v ];
+            for( u32 k=0; k<count; ++k )
+            {
+                if ( pList[k] == best )
+                {
+                    pList[k] = pList[ count - 1 ];
+                    break;
+                }
+            }
+            remaining[ v ]--;
+        }
+
+        // 出力した三角形の頂点をキャッシュの先頭に入れる(LRU).
+        u32 newCount = 0;
+        newCache[ newCount++ ] = tri[0];
+        newCache[ newCount++ ] = tri[1];
+        newCache[ newCount++ ] = tri[2];
+        for( u32 j=0; j<cacheCount; ++j )
+        {
+            u32 v = cache[j];
+            if ( v != tri[0] && v != tri[1] && v != tri[2] )
+            { newCache[ newCount++ ] = v; }
+        }
+
+        // 追い出された頂点.
+        for( u32 j=OPTIMIZE_CACHE_SIZE; j<newCount; ++j )
+        {
+            u32 v = newCache[j];
+            cachePosition[ v ] = -1;
+            vertexScore  [ v ] = ComputeVertexScore( -1, remaining[ v ] );
+        }
+
+        cacheCount = asdx::Min( newCount, OPTIMIZE_CACHE_SIZE );
+        for( u32 j=0; j<cacheCount; ++j )
+        {
+            u32 v = newCache[j];
+            cache        [j] = v;
+            cachePosition[ v ] = s32( j );
+            vertexScore  [ v ] = ComputeVertexScore( s32( j ), remaining[ v ] );
+        }
+
+        // スコアが変わった三角形を更新し, キャッシュ内から次の三角形を選ぶ.
+        best      = INVALID_INDEX;
+        bestScore = -1.0f;
+        for( u32 j=0; j<newCount; ++j )
+        {
+            u32        v     = newCache[j];
+            const u32* pList = &adjacency[ adjacencyOffset[ v ] ];
+            for( u32 k=0; k<remaining[ v ]; ++k )
+            {
+                u32        t = pList[k];
+                const u32* n = &localIndices[ t * 3 ];
+                f32 score = vertexScore[ n[0] ] + vertexScore[ n[1] ] + vertexScore[ n[2] ];
+                triangleScore[ t ] = score;
+
+                if ( j < cacheCount && score > bestScore )
+                {
+                    best      = t;
+                    bestScore = score;
+                }
+            }
+        }
+    }
+
+    for( u32 i=0; i<triangleCount * 3; ++i )
+    { pIndices[i] = globalIndices[ m_Output[i] ]; }
+}
+
+//-----------------------------------------------------------------------------------
+//      視点に依存しないオーバードロー削減のために三角形を並び替えます.
+//-----------------------------------------------------------------------------------
+void MeshOptimizer::OptimizeOverdraw
+(
+    u32*            pIndices,
+    u32             indexCount,
+    const void*     pVertices,
+    u32             vertexStride,
+    u32             vertexCount
+)
+{
+    u32 triangleCount = indexCount / 3;
+    if ( triangleCount <= 1 )
+    { return; }
+
+    VertexCacheSimulator cache( vertexCount, ANALYZE_CACHE_SIZE );
+
+    // 3頂点ともキャッシュミスする位置でクラスタを区切る.
+    std::vector< u32 > hardBoundaries;
+    for( u32 i=0; i<triangleCount; ++i )
+    {
+        const u32* tri = &pIndices[ i * 3 ];
+        if ( cache.Access( tri[0], tri[1], tri[2] ) == 3 )
+        { hardBoundaries.push_back( i ); }
+    }
+    hardBoundaries.push_back( triangleCount );
+
+    // ACMRの悪化が閾値以内に収まる位置でさらに細かく区切る.
+    std::vector< u32 >& clusters = m_Work;
+    clusters.clear();
+    for( size_t i=0; i + 1<hardBoundaries.size(); ++i )
+    {
+        u32 start = hardBoundaries[ i + 0 ];
+        u32 end   = hardBoundaries[ i + 1 ];
+
+        cache.Reset();
+        u32 clusterMisses = 0;
+        for( u32 j=start; j<end; ++j )
+        {
+            const u32* tri = &pIndices[ j * 3 ];
+            clusterMisses += cache.Access( tri[0], tri[1], tri[2] );
+        }
+
+        f32 threshold = m_OverdrawThreshold * f32( clusterMisses ) / f32( end - start );
+
+        clusters.push_back( start );
+
+        cache.Reset();
+        u32 misses = 0;
+        u32 faces  = 0;
+        for( u32 j=start; j<end; ++j )
+        {
+            const u32* tri = &pIndices[ j * 3 ];
+            misses += cache.Access( tri[0], tri[1], tri[2] );
+            faces++;
+
+            if ( j + 1 < end && f32( misses ) <= threshold * f32( faces ) )
+            {
+                clusters.push_back( j + 1 );
+                cache.Reset();
+                misses = 0;
+                faces  = 0;
+            }
+        }
+    }
+    clusters.push_back( triangleCount );
+
+    u32 clusterCount = u32( clusters.size() - 1 );
+    if ( clusterCount <= 1 )
+    { return; }
+
+    // 面積で重み付けした重心を求める.
+    asdx::Vector3 meshCentroid( 0.0f, 0.0f, 0.0f );
+    f32           meshArea = 0.0f;
+    for( u32 i=0; i<triangleCount; ++i )
+    {
+        const u32* tri = &pIndices[ i * 3 ];
+        asdx::Vector3 p0 = GetPosition( pVertices, vertexStride, tri[0] );
+        asdx::Vector3 p1 = GetPosition( pVertices, vertexStride, tri[1] );
+        asdx::Vector3 p2 = GetPosition( pVertices, vertexStride, tri[2] );
+
+        asdx::Vector3 n = asdx::Vector3::Cross( p1 - p0, p2 - p0 );
+        f32 area = sqrtf( n.LengthSq() );
+
+        meshCentroid += ( p0 + p1 + p2 ) * ( area / 3.0f );
+        meshArea     += area;
+    }
+    if ( meshArea > 0.0f )
+    { meshCentroid *= ( 1.0f / meshArea ); }
+
+    // 外側を向いているクラスタほど他を隠しやすいので先に描画する.
+    std::vector< std::pair< f32, u32 > > order( clusterCount );
+    for( u32 i=0; i<clusterCount; ++i )
+    {
+        asdx::Vector3 centroid( 0.0f, 0.0f, 0.0f );
+        asdx::Vector3 normal  ( 0.0f, 0.0f, 0.0f );
+        f32           area = 0.0f;
+
+        for( u32 j=clusters[i]; j<clusters[ i + 1 ]; ++j )
+        {
+            const u32* tri = &pIndices[ j * 3 ];
+            asdx::Vector3 p0 = GetPosition( pVertices, vertexStride, tri[0] );
+            asdx::Vector3 p1 = GetPosition( pVertices, vertexStride, tri[1] );
+            asdx::Vector3 p2 = GetPosition( pVertices, vertexStride, tri[2] );
+
+            asdx::Vector3 n = asdx::Vector3::Cross( p1 - p0, p2 - p0 );
+            f32 a = sqrtf( n.LengthSq() );
+
+            centroid += ( p0 + p1 + p2 ) * ( a / 3.0f );
+            normal   += n;
+            area     += a;
+        }
+
+        f32 key = 0.0f;
+        if ( area > 0.0f && normal.LengthSq() > 0.0f )
+        {
+            centroid *= ( 1.0f / area );
+            normal.Normalize();
+            key = asdx::Vector3::Dot( centroid - meshCentroid, normal );
+        }
+
+        // 降順に並べたいので符号を反転しておく.
+        order[i] = std::make_pair( -key, i );
+    }
+
+    std::stable_sort( order.begin(), order.end() );
+
+    m_Output.resize( triangleCount * 3 );
+    u32 offset = 0;
+    for( u32 i=0; i<clusterCount; ++i )
+    {
+        u32 cluster = order[i].second;
+        u32 start   = clusters[ cluster ] * 3;
+        u32 count   = ( clusters[ cluster + 1 ] * 3 ) - start;
+        memcpy( &m_Output[ offset ], &pIndices[ start ], sizeof( u32 ) * count );
+        offset += count;
+    }
+
+    memcpy( pIndices, &m_Output[0], sizeof( u32 ) * triangleCount * 3 );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点フェッチの局所性が良くなるように頂点を並び替えます.
+//-----------------------------------------------------------------------------------
+void MeshOptimizer::OptimizeVertexFetch
+(
+    void*           pVertices,
+    u32             vertexStride,
+    u32             vertexCount,
+    u32*            pIndices,
+    u32             indexCount
+)
+{
+    if ( vertexCount == 0 )
+    { return; }
+
+    // 最初に参照された順に番号を振る.
+    std::vector< u32 >& newIndex = m_Work;
+    newIndex.assign( vertexCount, INVALID_INDEX );
+
+    u32 next = 0;
+    for( u32 i=0; i<indexCount; ++i )
+    {
+        u32& index = pIndices[i];
+        if ( newIndex[ index ] == INVALID_INDEX )
+        { newIndex[ index ] = next++; }
+        index = newIndex[ index ];
+    }
+
+    // 参照されていない頂点は末尾に並べる.
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        if ( newIndex[i] == INVALID_INDEX )
+        { newIndex[i] = next++; }
+    }
+
+    u8* pData = static_cast<u8*>( pVertices );
+    std::vector< u8 > source( pData, pData + size_t( vertexStride ) * vertexCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    { memcpy( pData + size_t( vertexStride ) * newIndex[i], &source[ size_t( vertexStride ) * i ], vertexStride ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      最後に行った最適化の統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const MeshOptimizer::Statistics& MeshOptimizer::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      FIFOキャッシュを想定して頂点キャッシュの効率を解析します.
+//-----------------------------------------------------------------------------------
+MeshOptimizer::CacheStatistics MeshOptimizer::AnalyzeVertexCache
+(
+    const u32*      pIndices,
+    u32             indexCount,
+    u32             vertexCount,
+    u32             cacheSize
+)
+{
+    CacheStatistics result;
+    memset( &result, 0, sizeof( result ) );
+
+    VertexCacheSimulator cache( vertexCount, cacheSize );
+    std::vector< u8 >    used ( vertexCount, 0 );
+
+    result.TriangleCount = indexCount / 3;
+    for( u32 i=0; i<result.TriangleCount; ++i )
+    {
+        const u32* tri = &pIndices[ i * 3 ];
+        result.TransformCount += cache.Access( tri[0], tri[1], tri[2] );
+
+        for( u32 j=0; j<3; ++j )
+        {
+            if ( !used[ tri[j] ] )
+            {
+                used[ tri[j] ] = 1;
+                result.VertexCount++;
+            }
+        }
+    }
+
+    if ( result.TriangleCount > 0 )
+    { result.ACMR = f32( result.TransformCount ) / f32( result.TriangleCount ); }
+
+    if ( result.VertexCount > 0 )
+    { result.ATVR = f32( result.TransformCount ) / f32( result.VertexCount ); }
+
+    return result;
+}
@@ -0,0 +1,581 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshSimplifier.cpp
+// Desc : Quadric Error Metric Mesh Simplifier Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshSimplifier.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+// LODとして残すのに必要な, 1つ前の詳細度からの頂点インデックス数の削減率.
+static const f32 MIN_LEVEL_REDUCTION = 0.9f;
+
+// 面の向きが反転したとみなす法線の内積.
+static const f32 FLIP_THRESHOLD = 0.0f;
+
+///////////////////////////////////////////////////////////////////////////////////
+// Quadric structure
+///////////////////////////////////////////////////////////////////////////////////
+struct Quadric
+{
+    f32     A00, A11, A22;      //!< 対称行列の対角成分です.
+    f32     A01, A02, A12;      //!< 対称行列の非対角成分です.
+    f32     B0,  B1,  B2;       //!< 1次の項です.
+    f32     C;                  //!< 定数項です.
+    f32     Weight;             //!< 重み(面積の合計)です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Collapse structure
+///////////////////////////////////////////////////////////////////////////////////
+struct Collapse
+{
+    u32     From;               //!< 消す頂点です.
+    u32     To;                 //!< 移動先の頂点です.
+    f32     Error;              //!< 誤差(距離の2乗)です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// SubsetTask structure
+///////////////////////////////////////////////////////////////////////////////////
+struct SubsetTask
+{
+    u32     MeshIndex;          //!< メッシュ番号です.
+    u32     SubsetIndex;        //!< サブセット番号です.
+    f32     Extent;             //!< メッシュのAABBの対角線長です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// SubsetResult structure
+///////////////////////////////////////////////////////////////////////////////////
+struct SubsetResult
+{
+    std::vector< std::vector< asdx::ResMesh::Index > >  Levels;     //!< 詳細度ごとの頂点インデックスです.
+    std::vector< f32 >                                  Errors;     //!< 詳細度ごとの誤差です.
+};
+
+//-----------------------------------------------------------------------------------
+//      平面からクアドリックを生成します.
+//-----------------------------------------------------------------------------------
+inline void MakePlaneQuadric( const asdx::Vector3& n, f32 d, f32 weight, Quadric& q )
+{
+    q.A00 = n.x * n.x * weight;
+    q.A11 = n.y * n.y * weight;
+    q.A22 = n.z * n.z * weight;
+    q.A01 = n.x * n.y * weight;
+    q.A02 = n.x * n.z * weight;
+    q.A12 = n.y * n.z * weight;
+    q.B0  = n.x * d * weight;
+    q.B1  = n.y * d * weight;
+    q.B2  = n.z * d * weight;
+    q.C   = d * d * weight;
+    q.Weight = weight;
+}
+
+//-----------------------------------------------------------------------------------
+//      クアドリックを加算します.
+//-----------------------------------------------------------------------------------
+inline void AddQuadric( Quadric& dst, const Quadric& src )
+{
+    dst.A00 += src.A00;
+    dst.A11 += src.A11;
+    dst.A22 += src.A22;
+    dst.A01 += src.A01;
+    dst.A02 += src.A02;
+    dst.A12 += src.A12;
+    dst.B0  += src.B0;
+    dst.B1  += src.B1;
+    dst.B2  += src.B2;
+    dst.C   += src.C;
+    dst.Weight += src.Weight;
+}
+
+//-----------------------------------------------------------------------------------
+//      2つのクアドリックの和で位置の誤差(距離の2乗)を求めます.
+//-----------------------------------------------------------------------------------
+inline f32 EvaluateQuadric( const Quadric& a, const Quadric& b, const asdx::Vector3& p )
+{
+    Quadric q = a;
+    AddQuadric( q, b );
+
+    f32 r = q.A00 * p.x * p.x + q.A11 * p.y * p.y + q.A22 * p.z * p.z
+          + 2.0f * ( q.A01 * p.x * p.y + q.A02 * p.x * p.z + q.A12 * p.y * p.z )
+          + 2.0f * ( q.B0 * p.x + q.B1 * p.y + q.B2 * p.z )
+          + q.C;
+
+    // 丸め誤差で負になる場合がある.
+    r = asdx::Max( r, 0.0f );
+    return ( q.Weight > F32_EPSILON ) ? r / q.Weight : r;
+}
+
+//-----------------------------------------------------------------------------------
+//      位置座標を辞書順で比較します.
+//-----------------------------------------------------------------------------------
+struct PositionLess
+{
+    const std::vector< asdx::Vector3 >& Positions;
+
+    explicit PositionLess( const std::vector< asdx::Vector3 >& positions )
+    : Positions( positions )
+    { /* DO_NOTHING */ }
+
+    bool operator () ( u32 lhs, u32 rhs ) const
+    {
+        const asdx::Vector3& a = Positions[ lhs ];
+        const asdx::Vector3& b = Positions[ rhs ];
+        if ( a.x != b.x ) { return a.x < b.x; }
+        if ( a.y != b.y ) { return a.y < b.y; }
+        return a.z < b.z;
+    }
+
+private:
+    void operator = ( const PositionLess& );    // アクセス禁止.
+};
+
+//-----------------------------------------------------------------------------------
+//      誤差で辺の縮約を比較します.
+//-----------------------------------------------------------------------------------
+inline bool CollapseLess( const Collapse& lhs, const Collapse& rhs )
+{ return lhs.Error < rhs.Error; }
+
+//-----------------------------------------------------------------------------------
+//      面の法線(正規化しない)を求めます.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 FaceNormal( const asdx::Vector3& p0, const asdx::Vector3& p1, const asdx::Vector3& p2 )
+{ return asdx::Vector3::Cross( p1 - p0, p2 - p0 ); }
+
+//-----------------------------------------------------------------------------------
+//      サブセットを簡略化します.
+//-----------------------------------------------------------------------------------
+void SimplifySubset
+(
+    const asdx::ResMesh&            mesh,
+    const SubsetTask&               task,
+    const MeshSimplifier::Config&   config,
+    SubsetResult&                   result
+)
+{
+    const asdx::ResMesh::Subset& subset    = mesh.GetSubsets()[ task.SubsetIndex ];
+    const asdx::ResMesh::Vertex* pVertices = mesh.GetVertices();
+    const asdx::ResMesh::Index*  pIndices  = mesh.GetIndices() + subset.IndexOffset;
+    u32                          indexCount = subset.IndexCount / 3 * 3;
+
+    result.Levels.clear();
+    result.Levels.resize( config.LevelCount );
+    result.Errors.assign( config.LevelCount, 0.0f );
+
+    if ( indexCount == 0 )
+    { return; }
+
+    // サブセットが参照する頂点だけをローカル番号で扱う.
+    std::vector< u32 > globals( pIndices, pIndices + indexCount );
+    std::sort( globals.begin(), globals.end() );
+    globals.erase( std::unique( globals.begin(), globals.end() ), globals.end() );
+
+    u32 vertexCount = u32( globals.size() );
+
+    std::vector< u32 > indices( indexCount );
+    for( u32 i=0; i<indexCount; ++i )
+    { indices[i] = u32( std::lower_bound( globals.begin(), globals.end(), pIndices[i] ) - globals.begin() ); }
+
+    std::vector< asdx::Vector3 > positions( vertexCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    { positions[i] = pVertices[ globals[i] ].Position; }
+
+    // 位置座標が同じ頂点をグループにまとめる. 複数の頂点を持つグループはテクスチャ座標等の継ぎ目.
+    std::vector< u32 > groups( vertexCount );
+    std::vector< u32 > groupSizes;
+    {
+        std::vector< u32 > order( vertexCount );
+        for( u32 i=0; i<vertexCount; ++i )
+        { order[i] = i; }
+
+        PositionLess less( positions );
+        std::sort( order.begin(), order.end(), less );
+
+        for( u32 i=0; i<vertexCount; ++i )
+        {
+            if ( i == 0 || less( order[ i - 1 ], order[i] ) )
+            { groupSizes.push_back( 0 ); }
+
+            groups[ order[i] ] = u32( groupSizes.size() - 1 );
+            groupSizes.back()++;
+        }
+    }
+    u32 groupCount = u32( groupSizes.size() );
+
+    // 境界の辺(隣接する三角形が1つしかない辺)と非多様体の辺を求める.
+    std::vector< bool > lockedGroups( groupCount, false );
+    {
+        std::vector< u64 > edges;
+        edges.reserve( indexCount );
+        for( u32 i=0; i<indexCount; i+=3 )
+        {
+            for( u32 j=0; j<3; ++j )
+            {
+                u32 a = groups[ indices[ i + j ] ];
+                u32 b = groups[ indices[ i + ( j + 1 ) % 3 ] ];
+                if ( a == b )
+                { continue; }
+
+                u32 lo = asdx::Min( a, b );
+                u32 hi = asdx::Max( a, b );
+                edges.push_back( ( u64( lo ) << 32 ) | hi );
+            }
+        }
+        std::sort( edges.begin(), edges.end() );
+
+        for( size_t i=0; i<edges.size(); )
+        {
+            size_t j = i + 1;
+            while( j < edges.size() && edges[j] == edges[i] )
+            { j++; }
+
+            if ( j - i != 2 )
+            {
+                lockedGroups[ u32( edges[i] >> 32 ) ]         = true;
+                lockedGroups[ u32( edges[i] & 0xffffffff ) ]  = true;
+            }
+            i = j;
+        }
+    }
+
+    // 境界・継ぎ目の頂点は形を保つため動かさない(移動先にはなれる).
+    std::vector< bool > locked( vertexCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    { locked[i] = lockedGroups[ groups[i] ] || ( groupSizes[ groups[i] ] > 1 ); }
+
+    // 面積で重み付けした面のクアドリックをグループごとに集める.
+    Quadric zero;
+    memset( &zero, 0, sizeof( zero ) );
+    std::vector< Quadric > quadrics( groupCount, zero );
+    for( u32 i=0; i<indexCount; i+=3 )
+    {
+        const asdx::Vector3& p0 = positions[ indices[ i + 0 ] ];
+        const asdx::Vector3& p1 = positions[ indices[ i + 1 ] ];
+        const asdx::Vector3& p2 = positions[ indices[ i + 2 ] ];
+
+        asdx::Vector3 n = FaceNormal( p0, p1, p2 );
+        f32 length = sqrtf( n.LengthSq() );
+        if ( length <= F32_EPSILON )
+        { continue; }
+
+        n *= ( 1.0f / length );
+
+        Quadric q;
+        MakePlaneQuadric( n, -asdx::Vector3::Dot( n, p0 ), length * 0.5f, q );
+
+        AddQuadric( quadrics[ groups[ indices[ i + 0 ] ] ], q );
+        AddQuadric( quadrics[ groups[ indices[ i + 1 ] ] ], q );
+        AddQuadric( quadrics[ groups[ indices[ i + 2 ] ] ], q );
+    }
+
+    f32 maxError   = config.MaxError * task.Extent;
+    f32 maxErrorSq = maxError * maxError;
+    f32 currentErrorSq = 0.0f;
+
+    u32 triangleCount = indexCount / 3;
+    u32 level         = 0;
+    f32 ratio         = config.ReductionRatio;
+
+    std::vector< u32 >      offsets;
+    std::vector< u32 >      adjacency;
+    std::vector< Collapse > collapses;
+    std::vector< u32 >      remap( vertexCount );
+    std::vector< bool >     touched( vertexCount );
+
+    while( level < config.LevelCount )
+    {
+        u32 target = asdx::Max( u32( f32( indexCount / 3 ) * ratio ), config.MinTriangleCount );
+
+        // 目標に達したら記録して次の詳細度へ.
+        if ( triangleCount <= target )
+        {
+            std::vector< asdx::ResMesh::Index >& dst = result.Levels[ level ];
+            dst.resize( indices.size() );
+            for( size_t i=0; i<indices.size(); ++i )
+            { dst[i] = globals[ indices[i] ]; }
+            result.Errors[ level ] = sqrtf( currentErrorSq );
+
+            level++;
+            ratio *= config.ReductionRatio;
+            continue;
+        }
+
+        // 頂点から三角形への隣接情報.
+        offsets.assign( vertexCount + 1, 0 );
+        for( size_t i=0; i<indices.size(); ++i )
+        { offsets[ indices[i] + 1 ]++; }
+        for( u32 i=0; i<vertexCount; ++i )
+        { offsets[ i + 1 ] += offsets[i]; }
+
+        adjacency.resize( indices.size() );
+        {
+            std::vector< u32 > cursor( offsets.begin(), offsets.end() - 1 );
+            for( size_t i=0; i<indices.size(); ++i )
+            { adjacency[ cursor[ indices[i] ]++ ] = u32( i / 3 ); }
+        }
+
+        // 縮約の候補を誤差の小さい順に並べる.
+        collapses.clear();
+        for( size_t i=0; i<indices.size(); i+=3 )
+        {
+            for( u32 j=0; j<3; ++j )
+            {
+                u32 a = indices[ i + j ];
+                u32 b = indices[ i + ( j + 1 ) % 3 ];
+
+                for( u32 k=0; k<2; ++k )
+                {
+                    if ( !locked[a] && groups[a] != groups[b] )
+                    {
+                        Collapse collapse;
+                        collapse.From  = a;
+                        collapse.To    = b;
+                        collapse.Error = EvaluateQuadric( quadrics[ groups[a] ], quadrics[ groups[b] ], positions[b] );
+                        collapses.push_back( collapse );
+                    }
+                    std::swap( a, b );
+                }
+            }
+        }
+        std::sort( collapses.begin(), collapses.end(), CollapseLess );
+
+        // 内部の辺の縮約で三角形は2つ減る.
+        u32 maxCollapseCount = ( triangleCount - target + 1 ) / 2;
+        u32 collapseCount    = 0;
+
+        for( u32 i=0; i<vertexCount; ++i )
+        {
+            remap[i]   = i;
+            touched[i] = false;
+        }
+
+        for( size_t i=0; i<collapses.size() && collapseCount < maxCollapseCount; ++i )
+        {
+            const Collapse& collapse = collapses[i];
+            if ( collapse.Error > maxErrorSq )
+            { break; }
+
+            u32 a = collapse.From;
+            u32 b = collapse.To;
+            if ( touched[a] || touched[b] )
+            { continue; }
+
+            // 面が裏返る場合は縮約しない.
+            bool flipped = false;
+            for( u32 j=offsets[a]; j<offsets[ a + 1 ] && !flipped; ++j )
+            {
+                const u32* tri = &indices[ adjacency[j] * 3 ];
+                if ( tri[0] == b || tri[1] == b || tri[2] == b )
+                { continue; }
+
+                asdx::Vector3 p[3];
+                asdx::Vector3 q[3];
+                for( u32 k=0; k<3; ++k )
+                {
+                    p[k] = positions[ tri[k] ];
+                    q[k] = ( tri[k] == a ) ? positions[b] : p[k];
+                }
+
+                asdx::Vector3 n0 = FaceNormal( p[0], p[1], p[2] );
+                asdx::Vector3 n1 = FaceNormal( q[0], q[1], q[2] );
+                flipped = ( asdx::Vector3::Dot( n0, n1 ) <= FLIP_THRESHOLD * sqrtf( n0.LengthSq() * n1.LengthSq() ) );
+            }
+
+            if ( flipped )
+            { continue; }
+
+            // 周辺の頂点は, このパスでは隣接情報が古くなるので動かさない.
+            for( u32 j=offsets[a]; j<offsets[ a + 1 ]; ++j )
+            {
+                const u32* tri = &indices[ adjacency[j] * 3 ];
+                touched[ tri[0] ] = true;
+                touched[ tri[1] ] = true;
+                touched[ tri[2] ] = true;
+            }
+            touched[b] = true;
+
+            remap[a] = b;
+            AddQuadric( quadrics[ groups[b] ], quadrics[ groups[a] ] );
+            currentErrorSq = asdx::Max( currentErrorSq, collapse.Error );
+            collapseCount++;
+        }
+
+        // これ以上簡略化できない場合は, 残りの詳細度を現在の結果で埋める.
+        if ( collapseCount == 0 )
+        {
+            for( ; level < config.LevelCount; ++level )
+            {
+                std::vector< asdx::ResMesh::Index >& dst = result.Levels[ level ];
+                dst.resize( indices.size() );
+                for( size_t i=0; i<indices.size(); ++i )
+                { dst[i] = globals[ indices[i] ]; }
+                result.Errors[ level ] = sqrtf( currentErrorSq );
+            }
+            break;
+        }
+
+        // 縮約を適用して, 潰れた三角形を取り除く.
+        size_t writeCount = 0;
+        for( size_t i=0; i<indices.size(); i+=3 )
+        {
+            u32 i0 = remap[ indices[ i + 0 ] ];
+            u32 i1 = remap[ indices[ i + 1 ] ];
+            u32 i2 = remap[ indices[ i + 2 ] ];
+            if ( i0 == i1 || i1 == i2 || i2 == i0 )
+            { continue; }
+
+            indices[ writeCount + 0 ] = i0;
+            indices[ writeCount + 1 ] = i1;
+            indices[ writeCount + 2 ] = i2;
+            writeCount += 3;
+        }
+        indices.resize( writeCount );
+        triangleCount = u32( writeCount / 3 );
+    }
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MeshSimplifier class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      LODを生成します.
+//-----------------------------------------------------------------------------------
+bool MeshSimplifier::Build
+(
+    const asdx::ResMesh&    mesh,
+    const Config&           config,
+    LodChain&               result,
+    ThreadPool*             pPool
+)
+{
+    const asdx::ResMesh* pMesh = &mesh;
+    return BuildParallel( &pMesh, 1, config, &result, pPool );
+}
+
+//-----------------------------------------------------------------------------------
+//      複数のメッシュのLODをまとめて生成します.
+//-----------------------------------------------------------------------------------
+bool MeshSimplifier::BuildParallel
+(
+    const asdx::ResMesh* const* ppMeshes,
+    u32                         meshCount,
+    const Config&               config,
+    LodChain*                   pResults,
+    ThreadPool*                 pPool
+)
+{
+    if ( ppMeshes == nullptr || pResults == nullptr )
+    { return false; }
+
+    if ( config.LevelCount == 0 || config.LevelCount > MAX_LOD_LEVEL
+      || config.ReductionRatio <= 0.0f || config.ReductionRatio >= 1.0f )
+    { return false; }
+
+    // メッシュとサブセットの組をタスクにする.
+    std::vector< SubsetTask > tasks;
+    for( u32 i=0; i<meshCount; ++i )
+    {
+        const asdx::ResMesh& mesh = *ppMeshes[i];
+        pResults[i].Indices.clear();
+        pResults[i].Levels.clear();
+
+        if ( mesh.GetVertices() == nullptr || mesh.GetIndices() == nullptr || mesh.GetSubsets() == nullptr )
+        { return false; }
+
+        const asdx::ResMesh::Vertex* pVertices = mesh.GetVertices();
+        asdx::Vector3 mini = pVertices[0].Position;
+        asdx::Vector3 maxi = pVertices[0].Position;
+        for( u32 j=1; j<mesh.GetVertexCount(); ++j )
+        {
+            mini = asdx::Vector3::Min( mini, pVertices[j].Position );
+            maxi = asdx::Vector3::Max( maxi, pVertices[j].Position );
+        }
+        f32 extent = sqrtf( ( maxi - mini ).LengthSq() );
+
+        for( u32 j=0; j<mesh.GetSubsetCount(); ++j )
+        {
+            const asdx::ResMesh::Subset& subset = mesh.GetSubsets()[j];
+            if ( u64( subset.IndexOffset ) + subset.IndexCount > mesh.GetIndexCount() )
+            { return false; }
+
+            SubsetTask task;
+            task.MeshIndex   = i;
+            task.SubsetIndex = j;
+            task.Extent      = extent;
+            tasks.push_back( task );
+        }
+    }
+
+    std::vector< SubsetResult > results( tasks.size() );
+    ThreadPool::RunRange( pPool, u32( tasks.size() ), 1, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        { SimplifySubset( *ppMeshes[ tasks[i].MeshIndex ], tasks[i], config, results[i] ); }
+    });
+
+    // サブセットごとの結果を詳細度ごとにまとめる.
+    u32 taskIndex = 0;
+    for( u32 i=0; i<meshCount; ++i )
+    {
+        const asdx::ResMesh& mesh        = *ppMeshes[i];
+        LodChain&            chain       = pResults[i];
+        u32                  subsetCount = mesh.GetSubsetCount();
+
+        u32 prevCount = 0;
+        for( u32 j=0; j<subsetCount; ++j )
+        { prevCount += mesh.GetSubsets()[j].IndexCount; }
+
+        for( u32 k=0; k<config.LevelCount; ++k )
+        {
+            size_t offset = chain.Indices.size();
+
+            Level level;
+            level.Error      = 0.0f;
+            level.IndexCount = 0;
+            level.Subsets.resize( subsetCount );
+
+            for( u32 j=0; j<subsetCount; ++j )
+            {
+                const SubsetResult&                         src     = results[ taskIndex + j ];
+                const std::vector< asdx::ResMesh::Index >&  indices = src.Levels[k];
+
+                asdx::ResMesh::Subset& subset = level.Subsets[j];
+                subset.IndexOffset = u32( chain.Indices.size() );
+                subset.IndexCount  = u32( indices.size() );
+                subset.MaterialID  = mesh.GetSubsets()[j].MaterialID;
+
+                chain.Indices.insert( chain.Indices.end(), indices.begin(), indices.end() );
+                level.IndexCount += subset.IndexCount;
+                level.Error       = asdx::Max( level.Error, src.Errors[k] );
+            }
+
+            // ほとんど減っていない詳細度は描画コストが変わらないので作らない.
+            if ( f32( level.IndexCount ) > f32( prevCount ) * MIN_LEVEL_REDUCTION )
+            {
+                chain.Indices.resize( offset );
+                break;
+            }
+
+            prevCount = level.IndexCount;
+            chain.Levels.push_back( level );
+        }
+
+        taskIndex += subsetCount;
+    }
+
+    return true;
+}
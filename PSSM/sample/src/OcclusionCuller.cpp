@@ -0,0 +1,769 @@
+﻿//-----------------------------------------------------------------------------------
+// File : OcclusionCuller.cpp
+// Desc : Software Occlusion Culling Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <OcclusionCuller.h>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#if defined(__AVX2__)
+    #define OCCLUSION_USE_AVX2  1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define OCCLUSION_USE_SSE2  1
+    #include <emmintrin.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+// 除算を許容する最小のw値.
+static const f32 W_EPSILON = 1e-5f;
+
+// 全ピクセルを覆った場合のカバレッジマスク.
+static const u32 FULL_MASK = 0xffffffff;
+
+// 1ジョブあたりの最小要素数.
+static const u32 VERTEX_GRAIN   = 1024;
+static const u32 TRIANGLE_GRAIN = 256;
+static const u32 BOX_GRAIN      = 64;
+
+
+//-----------------------------------------------------------------------------------
+//      3値の最小値を求めます.
+//-----------------------------------------------------------------------------------
+inline f32 Min3( f32 a, f32 b, f32 c )
+{ return asdx::Min( a, asdx::Min( b, c ) ); }
+
+//-----------------------------------------------------------------------------------
+//      3値の最大値を求めます.
+//-----------------------------------------------------------------------------------
+inline f32 Max3( f32 a, f32 b, f32 c )
+{ return asdx::Max( a, asdx::Max( b, c ) ); }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// OcclusionCuller class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+OcclusionCuller::OcclusionCuller()
+: m_Width       ( 0 )
+, m_Height      ( 0 )
+, m_TileCountX  ( 0 )
+, m_TileCountY  ( 0 )
+, m_ZMax0       ()
+, m_ZMax1       ()
+, m_Mask        ()
+, m_CoarseCountX( 0 )
+, m_CoarseCountY( 0 )
+, m_CoarseZMax  ()
+, m_Slots       ()
+, m_ClipPos     ()
+, m_ViewProj    ()
+, m_pPool       ( nullptr )
+, m_Statistics  ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+OcclusionCuller::~OcclusionCuller()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::Init( u32 width, u32 height, ThreadPool* pPool )
+{
+    if ( width == 0 || height == 0 )
+    { return false; }
+
+    m_TileCountX = ( width  + TILE_WIDTH  - 1 ) / TILE_WIDTH;
+    m_TileCountY = ( height + TILE_HEIGHT - 1 ) / TILE_HEIGHT;
+    m_Width      = m_TileCountX * TILE_WIDTH;
+    m_Height     = m_TileCountY * TILE_HEIGHT;
+    m_pPool      = pPool;
+
+    u32 tileCount = m_TileCountX * m_TileCountY;
+    m_ZMax0.resize( tileCount, 1.0f );
+    m_ZMax1.resize( tileCount, 0.0f );
+    m_Mask .resize( tileCount, 0 );
+
+    m_CoarseCountX = ( m_TileCountX + COARSE_TILE_X - 1 ) / COARSE_TILE_X;
+    m_CoarseCountY = ( m_TileCountY + COARSE_TILE_Y - 1 ) / COARSE_TILE_Y;
+    m_CoarseZMax.resize( m_CoarseCountX * m_CoarseCountY, 1.0f );
+
+    m_Slots.resize( 1 );
+    m_ViewProj.Identity();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::Term()
+{
+    m_ZMax0  .clear();
+    m_ZMax1  .clear();
+    m_Mask   .clear();
+    m_Slots  .clear();
+    m_ClipPos.clear();
+    m_CoarseZMax.clear();
+
+    m_Width        = 0;
+    m_Height       = 0;
+    m_TileCountX   = 0;
+    m_TileCountY   = 0;
+    m_CoarseCountX = 0;
+    m_CoarseCountY = 0;
+    m_pPool        = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+//      フレームの開始処理です.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::Begin( const asdx::Matrix& viewProj )
+{
+    m_ViewProj   = viewProj;
+    m_Statistics = Statistics();
+
+    std::fill( m_ZMax0.begin(), m_ZMax0.end(), 1.0f );
+    std::fill( m_ZMax1.begin(), m_ZMax1.end(), 0.0f );
+    std::fill( m_Mask .begin(), m_Mask .end(), 0 );
+    std::fill( m_CoarseZMax.begin(), m_CoarseZMax.end(), 1.0f );
+
+    for( size_t i=0; i<m_Slots.size(); ++i )
+    {
+        m_Slots[i].Triangles.clear();
+        for( u32 j=0; j<BIN_COUNT_X * BIN_COUNT_Y; ++j )
+        { m_Slots[i].Bins[j].clear(); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      遮蔽物を投入します.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::AddOccluder
+(
+    const asdx::Matrix& world,
+    const void*         pPositions,
+    u32                 stride,
+    u32                 vertexCount,
+    const u32*          pIndices,
+    u32                 indexCount
+)
+{
+    if ( pPositions == nullptr || pIndices == nullptr || vertexCount == 0 || indexCount < 3 )
+    { return; }
+
+    if ( m_TileCountX == 0 || m_TileCountY == 0 )
+    { return; }
+
+    // 頂点をクリップ空間に変換.
+    asdx::Matrix wvp = world * m_ViewProj;
+    m_ClipPos.resize( vertexCount );
+    {
+        const u8* pBytes = static_cast< const u8* >( pPositions );
+        asdx::Vector4* pClip = &m_ClipPos[0];
+
+        ThreadPool::RunRange( m_pPool, vertexCount, VERTEX_GRAIN, [&]( u32 begin, u32 end, u32 )
+        {
+            for( u32 i=begin; i<end; ++i )
+            {
+                const asdx::Vector3* pPos = reinterpret_cast< const asdx::Vector3* >( pBytes + i * stride );
+                asdx::Vector4::Transform( asdx::Vector4( *pPos, 1.0f ), wvp, pClip[i] );
+            }
+        });
+    }
+
+    // 三角形のセットアップとビニング.
+    u32 triCount  = indexCount / 3;
+    u32 slotCount = ThreadPool::GetRangeSlotCount( m_pPool, triCount, TRIANGLE_GRAIN );
+    if ( m_Slots.size() < slotCount )
+    { m_Slots.resize( slotCount ); }
+
+    ThreadPool::RunRange( m_pPool, triCount, TRIANGLE_GRAIN, [&]( u32 begin, u32 end, u32 slot )
+    {
+        SlotData& data = m_Slots[slot];
+        asdx::Vector4 clip[ 3 ];
+
+        for( u32 i=begin; i<end; ++i )
+        {
+            u32 i0 = pIndices[ i * 3 + 0 ];
+            u32 i1 = pIndices[ i * 3 + 1 ];
+            u32 i2 = pIndices[ i * 3 + 2 ];
+            if ( i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount )
+            { continue; }
+
+            clip[0] = m_ClipPos[i0];
+            clip[1] = m_ClipPos[i1];
+            clip[2] = m_ClipPos[i2];
+
+            Triangle tri;
+            if ( !SetupTriangle( clip, tri ) )
+            { continue; }
+
+            u32 index = u32( data.Triangles.size() );
+            data.Triangles.push_back( tri );
+
+            // 重なるビンに登録.
+            for( u32 by=0; by<BIN_COUNT_Y; ++by )
+            {
+                for( u32 bx=0; bx<BIN_COUNT_X; ++bx )
+                {
+                    u32 binIndex = by * BIN_COUNT_X + bx;
+                    u32 minX, minY, maxX, maxY;
+                    if ( !GetBinRect( binIndex, minX, minY, maxX, maxY ) )
+                    { continue; }
+
+                    if ( tri.TileMaxX < minX || tri.TileMinX > maxX
+                      || tri.TileMaxY < minY || tri.TileMinY > maxY )
+                    { continue; }
+
+                    data.Bins[binIndex].push_back( index );
+                }
+            }
+        }
+    });
+
+    m_Statistics.SubmittedTriangles += triCount;
+}
+
+//-----------------------------------------------------------------------------------
+//      投入済みの遮蔽物をラスタライズします.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::Flush()
+{
+    for( size_t i=0; i<m_Slots.size(); ++i )
+    { m_Statistics.RasterizedTriangles += u32( m_Slots[i].Triangles.size() ); }
+
+    // ビン同士はタイルが重ならないので, ビン単位で並列に処理できる.
+    ThreadPool::RunRange( m_pPool, BIN_COUNT_X * BIN_COUNT_Y, 1, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        { RasterizeBin( i ); }
+    });
+
+    // 粗いレベルは行ごとに独立しているので, 行単位で並列に求める.
+    ThreadPool::RunRange( m_pPool, m_CoarseCountY, 1, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        { UpdateCoarse( i ); }
+    });
+
+    for( size_t i=0; i<m_Slots.size(); ++i )
+    {
+        m_Slots[i].Triangles.clear();
+        for( u32 j=0; j<BIN_COUNT_X * BIN_COUNT_Y; ++j )
+        { m_Slots[i].Bins[j].clear(); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      AABBが可視かどうか判定します.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::TestBox( const asdx::BoundingBox& box )
+{
+    bool visible = IsVisible( box );
+
+    m_Statistics.TestedObjects++;
+    if ( !visible )
+    { m_Statistics.OccludedObjects++; }
+
+    return visible;
+}
+
+//-----------------------------------------------------------------------------------
+//      複数のAABBを並列に判定します.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::TestBoxes( const asdx::BoundingBox* pBoxes, u32 count, u8* pVisible )
+{
+    if ( pBoxes == nullptr || pVisible == nullptr || count == 0 )
+    { return; }
+
+    ThreadPool::RunRange( m_pPool, count, BOX_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        { pVisible[i] = IsVisible( pBoxes[i] ) ? 1 : 0; }
+    });
+
+    m_Statistics.TestedObjects += count;
+    for( u32 i=0; i<count; ++i )
+    {
+        if ( pVisible[i] == 0 )
+        { m_Statistics.OccludedObjects++; }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const OcclusionCuller::Statistics& OcclusionCuller::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      深度バッファの横幅を取得します.
+//-----------------------------------------------------------------------------------
+u32 OcclusionCuller::GetWidth() const
+{ return m_Width; }
+
+//-----------------------------------------------------------------------------------
+//      深度バッファの縦幅を取得します.
+//-----------------------------------------------------------------------------------
+u32 OcclusionCuller::GetHeight() const
+{ return m_Height; }
+
+//-----------------------------------------------------------------------------------
+//      三角形のセットアップを行います.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::SetupTriangle( const asdx::Vector4* pClip, Triangle& result ) const
+{
+    // ニアクリップを跨ぐ遮蔽物は破棄する(遮蔽物を減らす分には保守的).
+    for( u32 i=0; i<3; ++i )
+    {
+        if ( pClip[i].w <= W_EPSILON || pClip[i].z < 0.0f )
+        { return false; }
+    }
+
+    // 視錐台の外側にあるものは破棄.
+    if ( ( pClip[0].x < -pClip[0].w && pClip[1].x < -pClip[1].w && pClip[2].x < -pClip[2].w )
+      || ( pClip[0].x >  pClip[0].w && pClip[1].x >  pClip[1].w && pClip[2].x >  pClip[2].w )
+      || ( pClip[0].y < -pClip[0].w && pClip[1].y < -pClip[1].w && pClip[2].y < -pClip[2].w )
+      || ( pClip[0].y >  pClip[0].w && pClip[1].y >  pClip[1].w && pClip[2].y >  pClip[2].w )
+      || ( pClip[0].z >  pClip[0].w && pClip[1].z >  pClip[1].w && pClip[2].z >  pClip[2].w ) )
+    { return false; }
+
+    // スクリーン座標に変換.
+    f32 sx[ 3 ];
+    f32 sy[ 3 ];
+    f32 sz[ 3 ];
+    for( u32 i=0; i<3; ++i )
+    {
+        f32 invW = 1.0f / pClip[i].w;
+        sx[i] = (  pClip[i].x * invW * 0.5f + 0.5f ) * f32( m_Width );
+        sy[i] = ( -pClip[i].y * invW * 0.5f + 0.5f ) * f32( m_Height );
+        sz[i] = asdx::Min( pClip[i].z * invW, 1.0f );
+    }
+
+    // 両面をラスタライズするため, 裏向きの場合は頂点を入れ替える.
+    f32 area = ( sx[1] - sx[0] ) * ( sy[2] - sy[0] ) - ( sx[2] - sx[0] ) * ( sy[1] - sy[0] );
+    if ( fabs( area ) < FLT_EPSILON )
+    { return false; }
+
+    if ( area < 0.0f )
+    {
+        std::swap( sx[1], sx[2] );
+        std::swap( sy[1], sy[2] );
+        std::swap( sz[1], sz[2] );
+        area = -area;
+    }
+
+    // ピクセル範囲を求める.
+    f32 minX = floorf( Min3( sx[0], sx[1], sx[2] ) );
+    f32 maxX = floorf( Max3( sx[0], sx[1], sx[2] ) );
+    f32 minY = floorf( Min3( sy[0], sy[1], sy[2] ) );
+    f32 maxY = floorf( Max3( sy[0], sy[1], sy[2] ) );
+
+    if ( maxX < 0.0f || maxY < 0.0f || minX >= f32( m_Width ) || minY >= f32( m_Height ) )
+    { return false; }
+
+    s32 pixelMinX = s32( asdx::Max( minX, 0.0f ) );
+    s32 pixelMinY = s32( asdx::Max( minY, 0.0f ) );
+    s32 pixelMaxX = s32( asdx::Min( maxX, f32( m_Width  - 1 ) ) );
+    s32 pixelMaxY = s32( asdx::Min( maxY, f32( m_Height - 1 ) ) );
+
+    result.TileMinX = u16( pixelMinX / TILE_WIDTH  );
+    result.TileMinY = u16( pixelMinY / TILE_HEIGHT );
+    result.TileMaxX = u16( pixelMaxX / TILE_WIDTH  );
+    result.TileMaxY = u16( pixelMaxY / TILE_HEIGHT );
+
+    // エッジ関数 E(p) = A * p.x + B * p.y + C を求める(内側が正).
+    for( u32 i=0; i<3; ++i )
+    {
+        u32 j = ( i + 1 ) % 3;
+        result.EdgeA[i] = sy[i] - sy[j];
+        result.EdgeB[i] = sx[j] - sx[i];
+        result.EdgeC[i] = ( sy[j] - sy[i] ) * sx[i] - ( sx[j] - sx[i] ) * sy[i];
+    }
+
+    // 深度平面 z(p) = A * p.x + B * p.y + C を求める.
+    f32 dx1 = sx[1] - sx[0];
+    f32 dy1 = sy[1] - sy[0];
+    f32 dz1 = sz[1] - sz[0];
+    f32 dx2 = sx[2] - sx[0];
+    f32 dy2 = sy[2] - sy[0];
+    f32 dz2 = sz[2] - sz[0];
+    f32 invDet = 1.0f / area;
+
+    result.DepthA   = ( dz1 * dy2 - dz2 * dy1 ) * invDet;
+    result.DepthB   = ( dz2 * dx1 - dz1 * dx2 ) * invDet;
+    result.DepthC   = sz[0] - result.DepthA * sx[0] - result.DepthB * sy[0];
+    result.DepthMax = Max3( sz[0], sz[1], sz[2] );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      ビンをラスタライズします.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::RasterizeBin( u32 binIndex )
+{
+    u32 minX, minY, maxX, maxY;
+    if ( !GetBinRect( binIndex, minX, minY, maxX, maxY ) )
+    { return; }
+
+    for( size_t i=0; i<m_Slots.size(); ++i )
+    {
+        const SlotData& data = m_Slots[i];
+        const std::vector< u32 >& bin = data.Bins[binIndex];
+
+        for( size_t j=0; j<bin.size(); ++j )
+        { RasterizeTriangle( data.Triangles[ bin[j] ], minX, minY, maxX, maxY ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      三角形をラスタライズします.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::RasterizeTriangle
+(
+    const Triangle& tri,
+    u32             tileMinX,
+    u32             tileMinY,
+    u32             tileMaxX,
+    u32             tileMaxY
+)
+{
+    u32 beginX = asdx::Max( u32( tri.TileMinX ), tileMinX );
+    u32 beginY = asdx::Max( u32( tri.TileMinY ), tileMinY );
+    u32 endX   = asdx::Min( u32( tri.TileMaxX ), tileMaxX );
+    u32 endY   = asdx::Min( u32( tri.TileMaxY ), tileMaxY );
+
+    for( u32 ty=beginY; ty<=endY; ++ty )
+    {
+        f32 y0 = f32( ty * TILE_HEIGHT );
+        f32 y1 = y0 + f32( TILE_HEIGHT );
+
+        for( u32 tx=beginX; tx<=endX; ++tx )
+        {
+            u32 index = ty * m_TileCountX + tx;
+
+            // タイル内での三角形の最大深度を保守的に求める.
+            f32 x0 = f32( tx * TILE_WIDTH );
+            f32 x1 = x0 + f32( TILE_WIDTH );
+            f32 zx = asdx::Max( tri.DepthA * x0, tri.DepthA * x1 );
+            f32 zy = asdx::Max( tri.DepthB * y0, tri.DepthB * y1 );
+            f32 z  = asdx::Min( zx + zy + tri.DepthC, tri.DepthMax );
+
+            // 既に手前で覆われている場合は何もしない.
+            if ( z >= m_ZMax0[index] )
+            { continue; }
+
+            u32 mask = ComputeCoverage( tri, tx, ty );
+            if ( mask == 0 )
+            { continue; }
+
+            if ( mask == FULL_MASK )
+            {
+                // タイル全体を覆ったので確定レイヤーを更新.
+                m_ZMax0[index] = z;
+                m_ZMax1[index] = 0.0f;
+                m_Mask [index] = 0;
+                continue;
+            }
+
+            // 作業レイヤーにマージ.
+            u32 merged = m_Mask[index] | mask;
+            f32 zMax1  = asdx::Max( m_ZMax1[index], z );
+
+            if ( merged == FULL_MASK )
+            {
+                m_ZMax0[index] = asdx::Min( m_ZMax0[index], zMax1 );
+                m_ZMax1[index] = 0.0f;
+                m_Mask [index] = 0;
+            }
+            else
+            {
+                m_ZMax1[index] = zMax1;
+                m_Mask [index] = merged;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      タイル内のカバレッジマスクを求めます.
+//-----------------------------------------------------------------------------------
+u32 OcclusionCuller::ComputeCoverage( const Triangle& tri, u32 tileX, u32 tileY ) const
+{
+    f32 baseX = f32( tileX * TILE_WIDTH );
+    f32 baseY = f32( tileY * TILE_HEIGHT ) + 0.5f;
+    u32 result = 0;
+
+#if defined(OCCLUSION_USE_AVX2)
+    const __m256 col  = _mm256_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f );
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 stepX[ 3 ];
+    for( u32 e=0; e<3; ++e )
+    { stepX[e] = _mm256_mul_ps( _mm256_set1_ps( tri.EdgeA[e] ), col ); }
+
+    for( u32 row=0; row<TILE_HEIGHT; ++row )
+    {
+        f32 py = baseY + f32( row );
+        __m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+        for( u32 e=0; e<3; ++e )
+        {
+            f32 rowValue = tri.EdgeA[e] * baseX + tri.EdgeB[e] * py + tri.EdgeC[e];
+            __m256 value = _mm256_add_ps( stepX[e], _mm256_set1_ps( rowValue ) );
+            inside = _mm256_and_ps( inside, _mm256_cmp_ps( value, zero, _CMP_GE_OQ ) );
+        }
+        result |= u32( _mm256_movemask_ps( inside ) ) << ( row * TILE_WIDTH );
+    }
+#elif defined(OCCLUSION_USE_SSE2)
+    const __m128 colLo = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+    const __m128 colHi = _mm_setr_ps( 4.5f, 5.5f, 6.5f, 7.5f );
+    const __m128 zero  = _mm_setzero_ps();
+
+    __m128 stepLo[ 3 ];
+    __m128 stepHi[ 3 ];
+    for( u32 e=0; e<3; ++e )
+    {
+        __m128 a = _mm_set1_ps( tri.EdgeA[e] );
+        stepLo[e] = _mm_mul_ps( a, colLo );
+        stepHi[e] = _mm_mul_ps( a, colHi );
+    }
+
+    for( u32 row=0; row<TILE_HEIGHT; ++row )
+    {
+        f32 py = baseY + f32( row );
+        __m128 insideLo = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+        __m128 insideHi = insideLo;
+        for( u32 e=0; e<3; ++e )
+        {
+            __m128 rowValue = _mm_set1_ps( tri.EdgeA[e] * baseX + tri.EdgeB[e] * py + tri.EdgeC[e] );
+            insideLo = _mm_and_ps( insideLo, _mm_cmpge_ps( _mm_add_ps( stepLo[e], rowValue ), zero ) );
+            insideHi = _mm_and_ps( insideHi, _mm_cmpge_ps( _mm_add_ps( stepHi[e], rowValue ), zero ) );
+        }
+        u32 bits = u32( _mm_movemask_ps( insideLo ) ) | ( u32( _mm_movemask_ps( insideHi ) ) << 4 );
+        result |= bits << ( row * TILE_WIDTH );
+    }
+#else
+    for( u32 row=0; row<TILE_HEIGHT; ++row )
+    {
+        f32 py = baseY + f32( row );
+        for( u32 col=0; col<TILE_WIDTH; ++col )
+        {
+            f32 px = baseX + f32( col ) + 0.5f;
+            bool inside = true;
+            for( u32 e=0; e<3; ++e )
+            { inside &= ( tri.EdgeA[e] * px + tri.EdgeB[e] * py + tri.EdgeC[e] >= 0.0f ); }
+
+            if ( inside )
+            { result |= 1u << ( row * TILE_WIDTH + col ); }
+        }
+    }
+#endif
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      ビンのタイル範囲を取得します.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::GetBinRect
+(
+    u32     binIndex,
+    u32&    tileMinX,
+    u32&    tileMinY,
+    u32&    tileMaxX,
+    u32&    tileMaxY
+) const
+{
+    u32 bx = binIndex % BIN_COUNT_X;
+    u32 by = binIndex / BIN_COUNT_X;
+
+    u32 beginX = ( bx + 0 ) * m_TileCountX / BIN_COUNT_X;
+    u32 endX   = ( bx + 1 ) * m_TileCountX / BIN_COUNT_X;
+    u32 beginY = ( by + 0 ) * m_TileCountY / BIN_COUNT_Y;
+    u32 endY   = ( by + 1 ) * m_TileCountY / BIN_COUNT_Y;
+
+    // タイル数がビン数より少ない場合は空のビンが出来る.
+    if ( beginX >= endX || beginY >= endY )
+    { return false; }
+
+    tileMinX = beginX;
+    tileMinY = beginY;
+    tileMaxX = endX - 1;
+    tileMaxY = endY - 1;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      粗いレベルの1行分の最大深度を求めます.
+//-----------------------------------------------------------------------------------
+void OcclusionCuller::UpdateCoarse( u32 coarseY )
+{
+    u32 tileMinY = coarseY * COARSE_TILE_Y;
+    u32 tileMaxY = asdx::Min( tileMinY + COARSE_TILE_Y, m_TileCountY );
+
+    for( u32 cx=0; cx<m_CoarseCountX; ++cx )
+    {
+        u32 tileMinX = cx * COARSE_TILE_X;
+        u32 tileMaxX = asdx::Min( tileMinX + COARSE_TILE_X, m_TileCountX );
+
+        // 確定レイヤーの最大深度は保守的なので, その最大値も保守的になる.
+        f32 zMax = 0.0f;
+        for( u32 ty=tileMinY; ty<tileMaxY; ++ty )
+        {
+            for( u32 tx=tileMinX; tx<tileMaxX; ++tx )
+            { zMax = asdx::Max( zMax, m_ZMax0[ ty * m_TileCountX + tx ] ); }
+        }
+
+        m_CoarseZMax[ coarseY * m_CoarseCountX + cx ] = zMax;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      AABBが可視かどうか判定します.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::IsVisible( const asdx::BoundingBox& box ) const
+{
+    if ( m_TileCountX == 0 || m_TileCountY == 0 )
+    { return true; }
+
+    f32 minX =  FLT_MAX;
+    f32 minY =  FLT_MAX;
+    f32 maxX = -FLT_MAX;
+    f32 maxY = -FLT_MAX;
+    f32 minZ =  FLT_MAX;
+
+    u32 outLeft   = 0;
+    u32 outRight  = 0;
+    u32 outTop    = 0;
+    u32 outBottom = 0;
+    u32 outFar    = 0;
+
+    for( u32 i=0; i<8; ++i )
+    {
+        asdx::Vector3 corner(
+            ( i & 0x1 ) ? box.maxi.x : box.mini.x,
+            ( i & 0x2 ) ? box.maxi.y : box.mini.y,
+            ( i & 0x4 ) ? box.maxi.z : box.mini.z );
+
+        asdx::Vector4 clip;
+        asdx::Vector4::Transform( asdx::Vector4( corner, 1.0f ), m_ViewProj, clip );
+
+        // ニアクリップを跨ぐものは可視扱い.
+        if ( clip.w <= W_EPSILON || clip.z < 0.0f )
+        { return true; }
+
+        if ( clip.x < -clip.w ) { outLeft++;   }
+        if ( clip.x >  clip.w ) { outRight++;  }
+        if ( clip.y < -clip.w ) { outBottom++; }
+        if ( clip.y >  clip.w ) { outTop++;    }
+        if ( clip.z >  clip.w ) { outFar++;    }
+
+        f32 invW = 1.0f / clip.w;
+        f32 sx = (  clip.x * invW * 0.5f + 0.5f ) * f32( m_Width );
+        f32 sy = ( -clip.y * invW * 0.5f + 0.5f ) * f32( m_Height );
+
+        minX = asdx::Min( minX, sx );
+        maxX = asdx::Max( maxX, sx );
+        minY = asdx::Min( minY, sy );
+        maxY = asdx::Max( maxY, sy );
+        minZ = asdx::Min( minZ, clip.z * invW );
+    }
+
+    // 視錐台の外側.
+    if ( outLeft == 8 || outRight == 8 || outTop == 8 || outBottom == 8 || outFar == 8 )
+    { return false; }
+
+    if ( maxX < 0.0f || maxY < 0.0f || minX >= f32( m_Width ) || minY >= f32( m_Height ) )
+    { return false; }
+
+    u32 tileMinX = u32( asdx::Max( minX, 0.0f ) ) / TILE_WIDTH;
+    u32 tileMinY = u32( asdx::Max( minY, 0.0f ) ) / TILE_HEIGHT;
+    u32 tileMaxX = u32( asdx::Min( maxX, f32( m_Width  - 1 ) ) ) / TILE_WIDTH;
+    u32 tileMaxY = u32( asdx::Min( maxY, f32( m_Height - 1 ) ) ) / TILE_HEIGHT;
+
+    // 粗いレベルで遮蔽されている範囲を除外し, 残った範囲だけをタイル単位で判定する.
+    u32 coarseMinX = tileMinX / COARSE_TILE_X;
+    u32 coarseMinY = tileMinY / COARSE_TILE_Y;
+    u32 coarseMaxX = tileMaxX / COARSE_TILE_X;
+    u32 coarseMaxY = tileMaxY / COARSE_TILE_Y;
+
+    for( u32 cy=coarseMinY; cy<=coarseMaxY; ++cy )
+    {
+        for( u32 cx=coarseMinX; cx<=coarseMaxX; ++cx )
+        {
+            if ( minZ >= m_CoarseZMax[ cy * m_CoarseCountX + cx ] )
+            { continue; }
+
+            bool visible = IsTileRangeVisible(
+                minZ,
+                asdx::Max( tileMinX, cx * COARSE_TILE_X ),
+                asdx::Max( tileMinY, cy * COARSE_TILE_Y ),
+                asdx::Min( tileMaxX, cx * COARSE_TILE_X + COARSE_TILE_X - 1 ),
+                asdx::Min( tileMaxY, cy * COARSE_TILE_Y + COARSE_TILE_Y - 1 ) );
+            if ( visible )
+            { return true; }
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      タイル範囲に最小深度より奥のタイルがあるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool OcclusionCuller::IsTileRangeVisible
+(
+    f32     minZ,
+    u32     tileMinX,
+    u32     tileMinY,
+    u32     tileMaxX,
+    u32     tileMaxY
+) const
+{
+    for( u32 ty=tileMinY; ty<=tileMaxY; ++ty )
+    {
+        const f32* pRow = &m_ZMax0[ ty * m_TileCountX ];
+
+#if defined(OCCLUSION_USE_AVX2) || defined(OCCLUSION_USE_SSE2)
+        __m128 z  = _mm_set1_ps( minZ );
+        u32    tx = tileMinX;
+        for( ; tx + 4 <= tileMaxX + 1; tx += 4 )
+        {
+            if ( _mm_movemask_ps( _mm_cmplt_ps( z, _mm_loadu_ps( pRow + tx ) ) ) != 0 )
+            { return true; }
+        }
+        for( ; tx<=tileMaxX; ++tx )
+        {
+            if ( minZ < pRow[tx] )
+            { return true; }
+        }
+#else
+        for( u32 tx=tileMinX; tx<=tileMaxX; ++tx )
+        {
+            if ( minZ < pRow[tx] )
+            { return true; }
+        }
+#endif
+    }
+
+    return false;
+}
@@ -0,0 +1,438 @@
+﻿//-----------------------------------------------------------------------------------
+// File : PackedVertex.cpp
+// Desc : Packed Vertex Format Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <PackedVertex.h>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define PACKED_VERTEX_USE_SSE2  1
+    #include <emmintrin.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+// 位置座標の量子化の最大値です.
+static const f32 UNORM16_MAX = 65535.0f;
+
+// 法線ベクトルの量子化の最大値です.
+static const f32 SNORM16_MAX = 32767.0f;
+
+// 従法線の符号が正であることを表す値です.
+static const u16 BITANGENT_SIGN_POSITIVE = 0xffff;
+
+//-----------------------------------------------------------------------------------
+//      単精度浮動小数のビット列を取得します.
+//-----------------------------------------------------------------------------------
+inline u32 AsUint( f32 value )
+{
+    u32 result;
+    memcpy( &result, &value, sizeof( result ) );
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      ビット列を単精度浮動小数として取得します.
+//-----------------------------------------------------------------------------------
+inline f32 AsFloat( u32 value )
+{
+    f32 result;
+    memcpy( &result, &value, sizeof( result ) );
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      [-1, 1]の値をSNORM16に変換します.
+//-----------------------------------------------------------------------------------
+inline s16 ToSnorm16( f32 value )
+{
+    value = ( value < -1.0f ) ? -1.0f : ( ( value > 1.0f ) ? 1.0f : value );
+    value *= SNORM16_MAX;
+    return s16( value + ( ( value >= 0.0f ) ? 0.5f : -0.5f ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      [0, 1]の値をUNORM16に変換します.
+//-----------------------------------------------------------------------------------
+inline u16 ToUnorm16( f32 value )
+{
+    value = ( value < 0.0f ) ? 0.0f : ( ( value > 1.0f ) ? 1.0f : value );
+    return u16( value * UNORM16_MAX + 0.5f );
+}
+
+//-----------------------------------------------------------------------------------
+//      量子化に用いるスケールを求めます.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ComputeQuantizeScale( const asdx::Vector3& mini, const asdx::Vector3& maxi )
+{
+    asdx::Vector3 extent = maxi - mini;
+    return asdx::Vector3(
+        ( extent.x > F32_EPSILON ) ? 1.0f / extent.x : 0.0f,
+        ( extent.y > F32_EPSILON ) ? 1.0f / extent.y : 0.0f,
+        ( extent.z > F32_EPSILON ) ? 1.0f / extent.z : 0.0f );
+}
+
+#if PACKED_VERTEX_USE_SSE2
+//-----------------------------------------------------------------------------------
+//      条件に応じて値を選択します.
+//-----------------------------------------------------------------------------------
+inline __m128 Select( __m128 mask, __m128 a, __m128 b )
+{ return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+
+//-----------------------------------------------------------------------------------
+//      絶対値を求めます.
+//-----------------------------------------------------------------------------------
+inline __m128 Abs( __m128 value )
+{ return _mm_andnot_ps( _mm_set1_ps( -0.0f ), value ); }
+
+//-----------------------------------------------------------------------------------
+//      [-1, 1]の値をSNORM16に変換します(4要素).
+//-----------------------------------------------------------------------------------
+inline __m128i ToSnorm16( __m128 value )
+{
+    value = _mm_min_ps( _mm_max_ps( value, _mm_set1_ps( -1.0f ) ), _mm_set1_ps( 1.0f ) );
+    value = _mm_mul_ps( value, _mm_set1_ps( SNORM16_MAX ) );
+    __m128 bias = Select( _mm_cmpge_ps( value, _mm_setzero_ps() ), _mm_set1_ps( 0.5f ), _mm_set1_ps( -0.5f ) );
+    return _mm_cvttps_epi32( _mm_add_ps( value, bias ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      [0, 1]の値をUNORM16に変換します(4要素).
+//-----------------------------------------------------------------------------------
+inline __m128i ToUnorm16( __m128 value )
+{
+    value = _mm_min_ps( _mm_max_ps( value, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+    return _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( value, _mm_set1_ps( UNORM16_MAX ) ), _mm_set1_ps( 0.5f ) ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      単位ベクトルを八面体エンコードします(4要素).
+//-----------------------------------------------------------------------------------
+inline void EncodeOctahedral( __m128 x, __m128 y, __m128 z, __m128i& resultX, __m128i& resultY )
+{
+    __m128 sum = _mm_add_ps( _mm_add_ps( Abs( x ), Abs( y ) ), Abs( z ) );
+    sum = _mm_max_ps( sum, _mm_set1_ps( FLT_MIN ) );
+
+    __m128 u = _mm_div_ps( x, sum );
+    __m128 v = _mm_div_ps( y, sum );
+
+    // 下半球は外側に折り返す.
+    __m128 one   = _mm_set1_ps(  1.0f );
+    __m128 mone  = _mm_set1_ps( -1.0f );
+    __m128 signU = Select( _mm_cmpge_ps( u, _mm_setzero_ps() ), one, mone );
+    __m128 signV = Select( _mm_cmpge_ps( v, _mm_setzero_ps() ), one, mone );
+    __m128 foldU = _mm_mul_ps( _mm_sub_ps( one, Abs( v ) ), signU );
+    __m128 foldV = _mm_mul_ps( _mm_sub_ps( one, Abs( u ) ), signV );
+
+    __m128 lower = _mm_cmplt_ps( z, _mm_setzero_ps() );
+    resultX = ToSnorm16( Select( lower, foldU, u ) );
+    resultY = ToSnorm16( Select( lower, foldV, v ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      単精度浮動小数を半精度浮動小数に変換します(4要素).
+//-----------------------------------------------------------------------------------
+inline __m128i EncodeHalf( __m128 value )
+{
+    // EncodeHalf( f32 ) と同じ手順をSIMDで行う.
+    const __m128i maskSign   = _mm_set1_epi32( 0x80000000 );
+    const __m128i maskRound  = _mm_set1_epi32( ~0xfff );
+    const __m128i f32Infinity= _mm_set1_epi32( 255 << 23 );
+    const __m128i magic      = _mm_set1_epi32( 15 << 23 );
+    const __m128i nanBit     = _mm_set1_epi32( 0x200 );
+    const __m128i f16Infinity= _mm_set1_epi32( 0x7c00 );
+    const __m128i clampValue = _mm_set1_epi32( ( 31 << 23 ) - 0x1000 );
+
+    __m128i bits     = _mm_castps_si128( value );
+    __m128i sign     = _mm_and_si128( bits, maskSign );
+    __m128i absBits  = _mm_xor_si128( bits, sign );
+
+    __m128i isNaN    = _mm_cmpgt_epi32( absBits, f32Infinity );
+    __m128i isNormal = _mm_cmpgt_epi32( f32Infinity, absBits );
+    __m128i special  = _mm_or_si128( _mm_and_si128( isNaN, nanBit ), f16Infinity );
+
+    __m128  rounded  = _mm_castsi128_ps( _mm_and_si128( absBits, maskRound ) );
+    __m128  scaled   = _mm_mul_ps( rounded, _mm_castsi128_ps( magic ) );
+    __m128  clamped  = _mm_min_ps( scaled, _mm_castsi128_ps( clampValue ) );
+    __m128i biased   = _mm_sub_epi32( _mm_castps_si128( clamped ), maskRound );
+    __m128i normal   = _mm_and_si128( _mm_srli_epi32( biased, 13 ), isNormal );
+
+    __m128i result   = _mm_or_si128( normal, _mm_andnot_si128( isNormal, special ) );
+    return _mm_or_si128( result, _mm_srli_epi32( sign, 16 ) );
+}
+#endif//PACKED_VERTEX_USE_SSE2
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------------
+//      入力要素です.
+//-----------------------------------------------------------------------------------
+const D3D11_INPUT_ELEMENT_DESC PackedVertex::INPUT_ELEMENTS[ PackedVertex::NUM_INPUT_ELEMENT ] = {
+    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TANGENT",  0, DXGI_FORMAT_R16G16_SNORM,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+//-----------------------------------------------------------------------------------
+//      単位ベクトルを八面体エンコードします.
+//-----------------------------------------------------------------------------------
+void EncodeOctahedral( const asdx::Vector3& value, s16* result )
+{
+    // SIMD版と結果を一致させるため, 途中の計算も全て単精度で行う.
+    f32 absX = f32( fabs( value.x ) );
+    f32 absY = f32( fabs( value.y ) );
+    f32 absZ = f32( fabs( value.z ) );
+    f32 sum  = absX + absY + absZ;
+    if ( sum < FLT_MIN )
+    { sum = FLT_MIN; }
+
+    f32 u = value.x / sum;
+    f32 v = value.y / sum;
+
+    // 下半球は外側に折り返す.
+    if ( value.z < 0.0f )
+    {
+        f32 absU  = f32( fabs( u ) );
+        f32 absV  = f32( fabs( v ) );
+        f32 foldU = ( 1.0f - absV ) * ( ( u >= 0.0f ) ? 1.0f : -1.0f );
+        f32 foldV = ( 1.0f - absU ) * ( ( v >= 0.0f ) ? 1.0f : -1.0f );
+        u = foldU;
+        v = foldV;
+    }
+
+    result[0] = ToSnorm16( u );
+    result[1] = ToSnorm16( v );
+}
+
+//-----------------------------------------------------------------------------------
+//      八面体エンコードされた単位ベクトルをデコードします.
+//-----------------------------------------------------------------------------------
+asdx::Vector3 DecodeOctahedral( const s16* value )
+{
+    f32 u = asdx::Max( f32( value[0] ) / SNORM16_MAX, -1.0f );
+    f32 v = asdx::Max( f32( value[1] ) / SNORM16_MAX, -1.0f );
+
+    asdx::Vector3 result( u, v, 1.0f - fabs( u ) - fabs( v ) );
+    if ( result.z < 0.0f )
+    {
+        result.x = ( 1.0f - fabs( v ) ) * ( ( u >= 0.0f ) ? 1.0f : -1.0f );
+        result.y = ( 1.0f - fabs( u ) ) * ( ( v >= 0.0f ) ? 1.0f : -1.0f );
+    }
+
+    return result.Normalize();
+}
+
+//-----------------------------------------------------------------------------------
+//      単精度浮動小数を半精度浮動小数に変換します.
+//-----------------------------------------------------------------------------------
+u16 EncodeHalf( f32 value )
+{
+    const u32 f32Infinity = 255 << 23;
+    const u32 f16Infinity = 31  << 23;
+    const u32 magic       = 15  << 23;
+    const u32 maskRound   = ~0xfffu;
+
+    u32 bits = AsUint( value );
+    u32 sign = bits & 0x80000000;
+    bits ^= sign;
+
+    u32 result;
+    if ( bits >= f32Infinity )
+    {
+        // 無限大と非数.
+        result = ( bits > f32Infinity ) ? 0x7e00 : 0x7c00;
+    }
+    else
+    {
+        // 非正規化数を含めて, 指数部の調整を乗算で行う.
+        bits &= maskRound;
+        bits  = AsUint( AsFloat( bits ) * AsFloat( magic ) );
+        bits -= maskRound;
+        if ( bits > f16Infinity )
+        { bits = f16Infinity; }
+
+        result = bits >> 13;
+    }
+
+    return u16( result | ( sign >> 16 ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      半精度浮動小数を単精度浮動小数に変換します.
+//-----------------------------------------------------------------------------------
+f32 DecodeHalf( u16 value )
+{
+    u32 sign     = u32( value & 0x8000 ) << 16;
+    u32 exponent = ( value >> 10 ) & 0x1f;
+    u32 mantissa = value & 0x3ff;
+
+    if ( exponent == 0 )
+    {
+        f32 result = f32( mantissa ) * ( 1.0f / 16777216.0f );
+        return ( sign ) ? -result : result;
+    }
+
+    if ( exponent == 31 )
+    { return AsFloat( sign | 0x7f800000 | ( mantissa << 13 ) ); }
+
+    return AsFloat( sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      位置座標の逆量子化行列を求めます.
+//-----------------------------------------------------------------------------------
+asdx::Matrix ComputeDequantizeMatrix( const asdx::Vector3& mini, const asdx::Vector3& maxi )
+{ return asdx::Matrix::CreateScale( maxi - mini ) * asdx::Matrix::CreateTranslation( mini ); }
+
+//-----------------------------------------------------------------------------------
+//      位置座標を圧縮します.
+//-----------------------------------------------------------------------------------
+void PackPosition
+(
+    const asdx::Vector3&    value,
+    const asdx::Vector3&    mini,
+    const asdx::Vector3&    maxi,
+    u16*                    result
+)
+{
+    asdx::Vector3 scale = ComputeQuantizeScale( mini, maxi );
+
+    result[0] = ToUnorm16( ( value.x - mini.x ) * scale.x );
+    result[1] = ToUnorm16( ( value.y - mini.y ) * scale.y );
+    result[2] = ToUnorm16( ( value.z - mini.z ) * scale.z );
+    result[3] = BITANGENT_SIGN_POSITIVE;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点を圧縮します.
+//-----------------------------------------------------------------------------------
+void PackVertex
+(
+    const asdx::ResMesh::Vertex&    value,
+    const asdx::Vector3&            mini,
+    const asdx::Vector3&            maxi,
+    PackedVertex&                   result
+)
+{
+    PackPosition( value.Position, mini, maxi, result.Position );
+
+    EncodeOctahedral( value.Normal,  result.Normal  );
+    EncodeOctahedral( value.Tangent, result.Tangent );
+
+    result.TexCoord[0] = EncodeHalf( value.TexCoord.x );
+    result.TexCoord[1] = EncodeHalf( value.TexCoord.y );
+}
+
+//-----------------------------------------------------------------------------------
+//      圧縮された頂点を展開します.
+//-----------------------------------------------------------------------------------
+void UnpackVertex
+(
+    const PackedVertex&         value,
+    const asdx::Vector3&        mini,
+    const asdx::Vector3&        maxi,
+    asdx::ResMesh::Vertex&      result
+)
+{
+    asdx::Vector3 extent = maxi - mini;
+
+    result.Position.x = mini.x + f32( value.Position[0] ) / UNORM16_MAX * extent.x;
+    result.Position.y = mini.y + f32( value.Position[1] ) / UNORM16_MAX * extent.y;
+    result.Position.z = mini.z + f32( value.Position[2] ) / UNORM16_MAX * extent.z;
+
+    result.Normal  = DecodeOctahedral( value.Normal  );
+    result.Tangent = DecodeOctahedral( value.Tangent );
+
+    result.TexCoord.x = DecodeHalf( value.TexCoord[0] );
+    result.TexCoord.y = DecodeHalf( value.TexCoord[1] );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点をまとめて圧縮します.
+//-----------------------------------------------------------------------------------
+void PackVertices
+(
+    const asdx::ResMesh::Vertex*    pVertices,
+    u32                             count,
+    const asdx::Vector3&            mini,
+    const asdx::Vector3&            maxi,
+    PackedVertex*                   pResult
+)
+{
+    u32 i = 0;
+
+#if PACKED_VERTEX_USE_SSE2
+    asdx::Vector3 scale = ComputeQuantizeScale( mini, maxi );
+
+    const __m128 miniX  = _mm_set1_ps( mini.x );
+    const __m128 miniY  = _mm_set1_ps( mini.y );
+    const __m128 miniZ  = _mm_set1_ps( mini.z );
+    const __m128 scaleX = _mm_set1_ps( scale.x );
+    const __m128 scaleY = _mm_set1_ps( scale.y );
+    const __m128 scaleZ = _mm_set1_ps( scale.z );
+
+    // 4頂点ずつ構造体の配列から配列の構造体に並べ替えて処理する.
+    for( ; i + 4 <= count; i += 4 )
+    {
+        const asdx::ResMesh::Vertex* v = pVertices + i;
+
+        #define LOAD4( member, component ) \
+            _mm_setr_ps( v[0].member.component, v[1].member.component, v[2].member.component, v[3].member.component )
+
+        __m128i px = ToUnorm16( _mm_mul_ps( _mm_sub_ps( LOAD4( Position, x ), miniX ), scaleX ) );
+        __m128i py = ToUnorm16( _mm_mul_ps( _mm_sub_ps( LOAD4( Position, y ), miniY ), scaleY ) );
+        __m128i pz = ToUnorm16( _mm_mul_ps( _mm_sub_ps( LOAD4( Position, z ), miniZ ), scaleZ ) );
+
+        __m128i nx, ny;
+        EncodeOctahedral( LOAD4( Normal, x ), LOAD4( Normal, y ), LOAD4( Normal, z ), nx, ny );
+
+        __m128i tx, ty;
+        EncodeOctahedral( LOAD4( Tangent, x ), LOAD4( Tangent, y ), LOAD4( Tangent, z ), tx, ty );
+
+        __m128i u = EncodeHalf( LOAD4( TexCoord, x ) );
+        __m128i w = EncodeHalf( LOAD4( TexCoord, y ) );
+
+        #undef LOAD4
+
+        s32 values[ 9 ][ 4 ];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[0] ), px );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[1] ), py );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[2] ), pz );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[3] ), nx );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[4] ), ny );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[5] ), tx );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[6] ), ty );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[7] ), u  );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( values[8] ), w  );
+
+        for( u32 j=0; j<4; ++j )
+        {
+            PackedVertex& dst = pResult[ i + j ];
+            dst.Position[0] = u16( values[0][j] );
+            dst.Position[1] = u16( values[1][j] );
+            dst.Position[2] = u16( values[2][j] );
+            dst.Position[3] = BITANGENT_SIGN_POSITIVE;
+            dst.Normal  [0] = s16( values[3][j] );
+            dst.Normal  [1] = s16( values[4][j] );
+            dst.Tangent [0] = s16( values[5][j] );
+            dst.Tangent [1] = s16( values[6][j] );
+            dst.TexCoord[0] = u16( values[7][j] );
+            dst.TexCoord[1] = u16( values[8][j] );
+        }
+    }
+#endif//PACKED_VERTEX_USE_SSE2
+
+    // 端数はスカラーで処理する.
+    for( ; i<count; ++i )
+    { PackVertex( pVertices[i], mini, maxi, pResult[i] ); }
+}
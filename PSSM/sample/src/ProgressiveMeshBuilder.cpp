@@ -0,0 +1,415 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ProgressiveMeshBuilder.cpp
+// Desc : Progressive Streaming Mesh Builder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ProgressiveMeshBuilder.h>
+#include <asdxMath.h>
+#include <algorithm>
+#include <map>
+#include <cmath>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+// 無効な番号です.
+static const u32 INVALID_INDEX = 0xffffffff;
+
+// 格子の分割数の上限です(セルの座標を 21bit x 3 で表すため).
+static const u32 MAX_GRID_RESOLUTION = ( 1u << 21 ) - 2;
+
+///////////////////////////////////////////////////////////////////////////////////
+// CellVertex structure
+///////////////////////////////////////////////////////////////////////////////////
+struct CellVertex
+{
+    u64     Key;        //!< セルのキーです.
+    u32     Index;      //!< 頂点番号です.
+
+    bool operator < ( const CellVertex& value ) const
+    {
+        if ( Key != value.Key )
+        { return Key < value.Key; }
+
+        return Index < value.Index;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Candidate structure
+///////////////////////////////////////////////////////////////////////////////////
+struct Candidate
+{
+    u32     Vertex;     //!< 属性を借りる頂点の番号です.
+    f32     DistSq;     //!< 代表位置までの距離の2乗です.
+    u32     Base;       //!< 基本LODでの頂点番号です.
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Triangle structure
+///////////////////////////////////////////////////////////////////////////////////
+struct Triangle
+{
+    u32     Index[ 3 ];     //!< 頂点番号です.
+
+    bool operator < ( const Triangle& value ) const
+    {
+        for( u32 i=0; i<3; ++i )
+        {
+            if ( Index[i] != value.Index[i] )
+            { return Index[i] < value.Index[i]; }
+        }
+        return false;
+    }
+
+    bool operator == ( const Triangle& value ) const
+    {
+        return ( Index[0] == value.Index[0] )
+            && ( Index[1] == value.Index[1] )
+            && ( Index[2] == value.Index[2] );
+    }
+};
+
+//-----------------------------------------------------------------------------------
+//      2点間の距離の2乗を求めます.
+//-----------------------------------------------------------------------------------
+inline f32 DistanceSq( const f32* a, const f32* b )
+{
+    f32 x = a[0] - b[0];
+    f32 y = a[1] - b[1];
+    f32 z = a[2] - b[2];
+    return x * x + y * y + z * z;
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセットの頂点インデックスの終了位置を求めます.
+//-----------------------------------------------------------------------------------
+inline u32 GetSubsetEnd( const MshSubset& subset, size_t indexCount )
+{ return u32( asdx::Min( u64( subset.IndexOffset ) + subset.IndexCount, u64( indexCount ) ) ); }
+
+//-----------------------------------------------------------------------------------
+//      基本LODの頂点を探すキーを求めます.
+//-----------------------------------------------------------------------------------
+inline u64 MakeBaseKey( u32 cell, u32 materialId )
+{ return ( u64( cell ) << 32 ) | u64( materialId ); }
+
+//-----------------------------------------------------------------------------------
+//      巻き順を保ったまま, 最小の頂点番号が先頭に来るように回転させます.
+//-----------------------------------------------------------------------------------
+inline Triangle MakeCanonical( u32 i0, u32 i1, u32 i2 )
+{
+    Triangle result;
+    if ( i0 <= i1 && i0 <= i2 )
+    { result.Index[0] = i0; result.Index[1] = i1; result.Index[2] = i2; }
+    else if ( i1 <= i0 && i1 <= i2 )
+    { result.Index[0] = i1; result.Index[1] = i2; result.Index[2] = i0; }
+    else
+    { result.Index[0] = i2; result.Index[1] = i0; result.Index[2] = i1; }
+    return result;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ProgressiveMeshBuilder class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      粗い基本LODとチャンクごとの詳細化ブロックを作成します.
+//-----------------------------------------------------------------------------------
+void ProgressiveMeshBuilder::Build
+(
+    const std::vector< MshVertex >&     vertices,
+    const std::vector< u32 >&           indices,
+    const std::vector< MshSubset >&     subsets,
+    const std::vector< CookedChunk >&   chunks,
+    const Config&                       config,
+    Result&                             result,
+    Statistics*                         pStats
+)
+{
+    result = Result();
+    if ( pStats != nullptr )
+    { *pStats = Statistics(); }
+
+    const u32 vertexCount = u32( vertices.size() );
+    if ( vertexCount == 0 || indices.empty() || subsets.empty() )
+    { return; }
+
+    // 参照されている頂点だけを対象にする.
+    std::vector< u8 > used( vertexCount, 0 );
+    u32 triangleCount = 0;
+    for( size_t i=0; i<subsets.size(); ++i )
+    {
+        u32 end = GetSubsetEnd( subsets[i], indices.size() );
+        for( u32 j=subsets[i].IndexOffset; j<end; ++j )
+        {
+            if ( indices[j] < vertexCount )
+            { used[ indices[j] ] = 1; }
+        }
+        if ( end > subsets[i].IndexOffset )
+        { triangleCount += ( end - subsets[i].IndexOffset ) / 3; }
+    }
+
+    // 全体のAABBを求める.
+    f32 mini[3] = {  F32_MAX,  F32_MAX,  F32_MAX };
+    f32 maxi[3] = { -F32_MAX, -F32_MAX, -F32_MAX };
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        if ( !used[i] )
+        { continue; }
+
+        for( u32 k=0; k<3; ++k )
+        {
+            mini[k] = asdx::Min( mini[k], vertices[i].Position[k] );
+            maxi[k] = asdx::Max( maxi[k], vertices[i].Position[k] );
+        }
+    }
+
+    if ( mini[0] > maxi[0] )
+    { return; }
+
+    // 最も長い軸を基準に立方体のセルに分ける.
+    u32 resolution = asdx::Clamp( config.GridResolution, 1u, MAX_GRID_RESOLUTION );
+    f32 extent     = asdx::Max( maxi[0] - mini[0], asdx::Max( maxi[1] - mini[1], maxi[2] - mini[2] ) );
+    f32 cellSize   = ( extent > 0.0f ) ? extent / f32( resolution ) : 1.0f;
+    f32 invCell    = 1.0f / cellSize;
+
+    std::vector< CellVertex > sorted;
+    sorted.reserve( vertexCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        if ( !used[i] )
+        { continue; }
+
+        u64 key = 0;
+        for( u32 k=0; k<3; ++k )
+        {
+            f32 t    = ( vertices[i].Position[k] - mini[k] ) * invCell;
+            u32 cell = ( t > 0.0f ) ? u32( asdx::Min( t, f32( resolution ) ) ) : 0;
+            key = ( key << 21 ) | u64( cell );
+        }
+
+        CellVertex item;
+        item.Key   = key;
+        item.Index = i;
+        sorted.push_back( item );
+    }
+    std::sort( sorted.begin(), sorted.end() );
+
+    // セルごとに平均に最も近い頂点を代表位置とする.
+    // 代表位置はセルで1つなので, 隣り合うチャンク・マテリアル間で位置がずれない.
+    std::vector< u32 > cellOf( vertexCount, INVALID_INDEX );
+    std::vector< f32 > cellPositions;
+    for( size_t begin=0; begin<sorted.size(); )
+    {
+        size_t end = begin + 1;
+        while( end < sorted.size() && sorted[end].Key == sorted[begin].Key )
+        { end++; }
+
+        f64 mean[3] = { 0.0, 0.0, 0.0 };
+        for( size_t i=begin; i<end; ++i )
+        {
+            for( u32 k=0; k<3; ++k )
+            { mean[k] += vertices[ sorted[i].Index ].Position[k]; }
+        }
+
+        f32 center[3];
+        for( u32 k=0; k<3; ++k )
+        { center[k] = f32( mean[k] / f64( end - begin ) ); }
+
+        u32 cell      = u32( cellPositions.size() / 3 );
+        u32 nearest   = sorted[begin].Index;
+        f32 nearestSq = F32_MAX;
+        for( size_t i=begin; i<end; ++i )
+        {
+            u32 index = sorted[i].Index;
+            f32 distSq = DistanceSq( vertices[ index ].Position, center );
+            if ( distSq < nearestSq )
+            {
+                nearest   = index;
+                nearestSq = distSq;
+            }
+            cellOf[ index ] = cell;
+        }
+
+        cellPositions.insert( cellPositions.end(), vertices[ nearest ].Position, vertices[ nearest ].Position + 3 );
+        begin = end;
+    }
+
+    // 法線・テクスチャ座標はセルとマテリアルの組ごとに, 代表位置に最も近い頂点のものを使う.
+    std::map< u64, Candidate > candidates;
+    for( size_t i=0; i<subsets.size(); ++i )
+    {
+        u32 end = GetSubsetEnd( subsets[i], indices.size() );
+        for( u32 j=subsets[i].IndexOffset; j<end; ++j )
+        {
+            u32 index = indices[j];
+            if ( index >= vertexCount )
+            { continue; }
+
+            u32 cell   = cellOf[ index ];
+            f32 distSq = DistanceSq( vertices[ index ].Position, &cellPositions[ cell * 3 ] );
+
+            u64 key = MakeBaseKey( cell, subsets[i].MaterialID );
+            std::map< u64, Candidate >::iterator itr = candidates.find( key );
+            if ( itr == candidates.end() )
+            {
+                Candidate candidate;
+                candidate.Vertex = index;
+                candidate.DistSq = distSq;
+                candidate.Base   = INVALID_INDEX;
+                candidates.insert( std::make_pair( key, candidate ) );
+            }
+            else if ( distSq < itr->second.DistSq )
+            {
+                itr->second.Vertex = index;
+                itr->second.DistSq = distSq;
+            }
+        }
+    }
+
+    result.BaseVertices.reserve( candidates.size() );
+    for( std::map< u64, Candidate >::iterator itr = candidates.begin(); itr != candidates.end(); ++itr )
+    {
+        u32 cell = u32( itr->first >> 32 );
+
+        MshVertex vertex = vertices[ itr->second.Vertex ];
+        memcpy( vertex.Position, &cellPositions[ cell * 3 ], sizeof( vertex.Position ) );
+
+        itr->second.Base = u32( result.BaseVertices.size() );
+        result.BaseVertices.push_back( vertex );
+    }
+
+    // 分割していない場合は全体を1つのチャンクとして扱う.
+    std::vector< CookedChunk > sourceChunks = chunks;
+    if ( sourceChunks.empty() )
+    {
+        CookedChunk chunk;
+        memset( &chunk, 0, sizeof( chunk ) );
+        memcpy( chunk.Min, mini, sizeof( chunk.Min ) );
+        memcpy( chunk.Max, maxi, sizeof( chunk.Max ) );
+        chunk.SubsetOffset = 0;
+        chunk.SubsetCount  = u32( subsets.size() );
+        sourceChunks.push_back( chunk );
+    }
+
+    result.Chunks.resize( sourceChunks.size() );
+    result.Blocks.resize( sourceChunks.size() );
+
+    std::vector< u32 >      remap( vertexCount, INVALID_INDEX );
+    std::vector< Triangle > triangles;
+
+    for( size_t c=0; c<sourceChunks.size(); ++c )
+    {
+        const CookedChunk& src   = sourceChunks[c];
+        StreamingChunk&    dst   = result.Chunks[c];
+        Block&             block = result.Blocks[c];
+
+        memset( &dst, 0, sizeof( dst ) );
+        memcpy( dst.Min, src.Min, sizeof( dst.Min ) );
+        memcpy( dst.Max, src.Max, sizeof( dst.Max ) );
+        dst.BaseSubsetOffset = u32( result.BaseSubsets.size() );
+
+        u32 subsetEnd = u32( asdx::Min( u64( src.SubsetOffset ) + src.SubsetCount, u64( subsets.size() ) ) );
+        f32 maxErrorSq = 0.0f;
+
+        for( u32 s=src.SubsetOffset; s<subsetEnd; ++s )
+        {
+            const MshSubset& subset = subsets[s];
+            u32 end = GetSubsetEnd( subset, indices.size() );
+            end = subset.IndexOffset + ( ( end > subset.IndexOffset ) ? ( end - subset.IndexOffset ) / 3 * 3 : 0 );
+
+            // 詳細化ブロック. 頂点は最初に参照された順に詰めるので, 頂点フェッチの最適化結果を保てる.
+            MshSubset local;
+            local.IndexOffset = u32( block.Indices.size() );
+            local.IndexCount  = 0;
+            local.MaterialID  = subset.MaterialID;
+
+            triangles.clear();
+            for( u32 j=subset.IndexOffset; j<end; j+=3 )
+            {
+                u32 base[3];
+                bool valid = true;
+                for( u32 k=0; k<3; ++k )
+                {
+                    u32 index = indices[ j + k ];
+                    if ( index >= vertexCount )
+                    { valid = false; break; }
+
+                    if ( remap[ index ] == INVALID_INDEX )
+                    {
+                        remap[ index ] = u32( block.Vertices.size() );
+                        block.Vertices.push_back( vertices[ index ] );
+                        maxErrorSq = asdx::Max( maxErrorSq, DistanceSq( vertices[ index ].Position, &cellPositions[ cellOf[ index ] * 3 ] ) );
+                    }
+
+                    base[k] = candidates.find( MakeBaseKey( cellOf[ index ], subset.MaterialID ) )->second.Base;
+                }
+
+                if ( !valid )
+                { continue; }
+
+                for( u32 k=0; k<3; ++k )
+                { block.Indices.push_back( remap[ indices[ j + k ] ] ); }
+                local.IndexCount += 3;
+
+                // 同じセルに潰れた三角形は基本LODから取り除く.
+                if ( base[0] == base[1] || base[1] == base[2] || base[2] == base[0] )
+                { continue; }
+
+                triangles.push_back( MakeCanonical( base[0], base[1], base[2] ) );
+            }
+
+            if ( local.IndexCount > 0 )
+            { block.Subsets.push_back( local ); }
+
+            // 同じセルの組に潰れた三角形は1つにまとめる.
+            std::sort( triangles.begin(), triangles.end() );
+            triangles.erase( std::unique( triangles.begin(), triangles.end() ), triangles.end() );
+            if ( triangles.empty() )
+            { continue; }
+
+            MshSubset baseSubset;
+            baseSubset.IndexOffset = u32( result.BaseIndices.size() );
+            baseSubset.IndexCount  = u32( triangles.size() * 3 );
+            baseSubset.MaterialID  = subset.MaterialID;
+            for( size_t t=0; t<triangles.size(); ++t )
+            { result.BaseIndices.insert( result.BaseIndices.end(), triangles[t].Index, triangles[t].Index + 3 ); }
+            result.BaseSubsets.push_back( baseSubset );
+        }
+
+        // 次のチャンクのために番号の対応を戻しておく.
+        for( u32 s=src.SubsetOffset; s<subsetEnd; ++s )
+        {
+            u32 end = GetSubsetEnd( subsets[s], indices.size() );
+            for( u32 j=subsets[s].IndexOffset; j<end; ++j )
+            {
+                if ( indices[j] < vertexCount )
+                { remap[ indices[j] ] = INVALID_INDEX; }
+            }
+        }
+
+        dst.BaseError       = sqrtf( maxErrorSq );
+        dst.BaseSubsetCount = u32( result.BaseSubsets.size() ) - dst.BaseSubsetOffset;
+        dst.VertexCount     = u32( block.Vertices.size() );
+        dst.IndexCount      = u32( block.Indices .size() );
+        dst.SubsetCount     = u32( block.Subsets .size() );
+    }
+
+    if ( pStats != nullptr )
+    {
+        pStats->ChunkCount          = u32( result.Chunks.size() );
+        pStats->SourceTriangleCount = triangleCount;
+        pStats->BaseTriangleCount   = u32( result.BaseIndices.size() / 3 );
+        pStats->BaseVertexCount     = u32( result.BaseVertices.size() );
+        for( size_t i=0; i<result.Chunks.size(); ++i )
+        { pStats->MaxBaseError = asdx::Max( pStats->MaxBaseError, result.Chunks[i].BaseError ); }
+    }
+}
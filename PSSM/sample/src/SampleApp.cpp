@@ -11,6 +11,8 @@
 #include <asdxShader.h>
 #include <asdxLog.h>
 #include <vector>
+#include <utility>
+#include <algorithm>
 
 // テクスチャバイアス.
 static const asdx::Matrix SHADOW_BIAS = asdx::Matrix(
@@ -19,6 +21,52 @@ static const asdx::Matrix SHADOW_BIAS = asdx::Matrix(
     0.0f,  0.0f, 1.0f, 0.0f,
     0.5f,  0.5f, 0.0f, 1.0f );
 
+// シャドウマップの解像度.
+static const u32 SHADOW_MAP_SIZE = 1024;
+
+// 細かいカスケードの縁から除外するテクセル数.
+// ピクセルシェーダ側の SHADOW_MAP_BORDER よりも大きくしておく必要がある.
+static const f32 SHADOW_COVERAGE_BORDER_TEXELS = 2.0f;
+
+// ステレオ時の両眼の間隔.
+// シーンの単位が大きいので, 違いが分かるように実際の瞳孔間距離よりも大きめにしてある.
+static const f32 STEREO_EYE_SEPARATION = 6.4f;
+
+// LiSPSMを適用するライトと視線のなす角の正弦の下限値.
+// これを下回る場合は平行に近く歪ませても効果が無いので, 正射影に戻す.
+static const f32 LISPSM_MIN_SIN_GAMMA = 0.01f;
+
+// メッシュの頂点を PackedVertex に圧縮して転送するかどうか.
+// 頂点サイズが44バイトから20バイトになり, 全パスの頂点フェッチ帯域が半分以下になる.
+static const bool ENABLE_PACKED_VERTEX = true;
+
+// 頂点シェーダのエントリーポイント名.
+static const char* VS_ENTRY_POINT = ( ENABLE_PACKED_VERTEX ) ? "VSFuncPacked" : "VSFunc";
+
+// インスタンス描画用の頂点シェーダのエントリーポイント名.
+static const char* VS_INSTANCED_ENTRY_POINT = ( ENABLE_PACKED_VERTEX ) ? "VSFuncPackedInstanced" : "VSFuncInstanced";
+
+// インスタンス描画でメッシュを格子状に並べるときの一辺あたりの数.
+static const u32 INSTANCE_GRID_SIZE = 3;
+
+// インスタンス同士の間隔(メッシュのAABBの大きさに対する比率).
+static const f32 INSTANCE_SPACING = 1.25f;
+
+// 詳細度の切り替えを許容する画面上の誤差(ピクセル, シャドウマップではテクセル).
+static const f32 LOD_PIXEL_ERROR = 1.0f;
+
+// オクルージョンカリング用の深度バッファの解像度.
+static const u32 OCCLUSION_BUFFER_WIDTH  = 320;
+static const u32 OCCLUSION_BUFFER_HEIGHT = 180;
+
+// 遮蔽物に使う三角形の最大数(メッシュ1つあたり).
+// 面積の大きい順に選ぶので, 細かい三角形は遮蔽物に含めない.
+static const u32 OCCLUDER_MAX_TRIANGLES = 4096;
+
+// 遮蔽判定に使うAABBを広げる比率(AABBの大きさに対する比率).
+// 自身の遮蔽物と深度が一致して, 画面に正対した平らなチャンクが自分自身で隠れないようにする.
+static const f32 OCCLUSION_BOX_MARGIN = 0.01f;
+
 /////////////////////////////////////////////////////////////////////////////////////
 // QuadParam structure
 /////////////////////////////////////////////////////////////////////////////////////
@@ -45,15 +93,59 @@ SampleApp::SampleApp()
 , m_pQuadSmp( nullptr )
 , m_ShadowState()
 , m_pVS     ( nullptr )
+, m_pInstancedVS( nullptr )
 , m_pPS     ( nullptr )
+, m_pPSCoverage( nullptr )
 , m_pCBMatrixForward( nullptr )
 , m_Dosei   ()
+, m_InstanceBuffer()
+, m_InstanceWorlds()
+, m_InstanceBoxes()
+, m_EnableInstancing( false )
+, m_StaticBatch()
+, m_EnableStaticBatch( false )
+, m_EnableChunkCulling( true )
+, m_MainChunkVisible( 0 )
+, m_StreamingMesh()
+, m_EnableStreaming( false )
 , m_LightRotX( asdx::F_PIDIV4 )
 , m_LightRotY( asdx::F_PIDIV2 )
 , m_Lamda( 0.5f )
 , m_ShowTexture( true )
+, m_IsCasterVisible( true )
+, m_EnableCasterCulling( true )
+, m_OcclusionCuller()
+, m_EnableOcclusionCulling( true )
+, m_OcclusionStats()
+, m_EnableLiSPSM( false )
+, m_SplitCount( MAX_CASCADE )
+, m_EnableCoverage( true )
+, m_EnableStereo( false )
+, m_EyeSeparation( STEREO_EYE_SEPARATION )
+, m_EnableMeshletCulling( true )
+, m_EnableMeshletCone( false )
+, m_IsFrontCounterClockwise( false )
+, m_ThreadPool()
+, m_AsyncLoader()
+, m_ShaderFuture()
+, m_SceneFuture()
+, m_LoadWatch()
+, m_LoadTimeMsec( 0.0 )
+, m_LodSelector()
+, m_EnableLod( true )
+, m_MainLod( 0 )
 {
-    /* DO_NOTHING */
+    for( int i=0; i<MAX_CASCADE; ++i )
+    {
+        m_DrawCasterInCascade[i] = true;
+        m_StereoTexelRatio[i]    = 1.0f;
+        m_ShadowLod[i]           = 0;
+        m_ShadowChunkVisible[i]  = 0;
+    }
+
+    m_LodSelector.SetPixelError( LOD_PIXEL_ERROR );
+
+    memset( &m_MeshCacheStats, 0, sizeof( m_MeshCacheStats ) );
 }
 
 //-----------------------------------------------------------------------------------
@@ -193,7 +285,7 @@ bool SampleApp::InitShadowState()
     HRESULT hr = S_OK;
 
     // シャドウマップの解像度.
-    u32 mapSize = 1024;
+    u32 mapSize = SHADOW_MAP_SIZE;
 
     for( int i=0; i<MAX_CASCADE; ++i )
     {
@@ -273,7 +365,7 @@ bool SampleApp::InitShadowState()
 
         if ( asdx::ShaderHelper::CompileShaderFromFile(
             L"../res/shader/ShadowVS.hlsl",
-            "VSFunc",
+            VS_ENTRY_POINT,
             asdx::ShaderHelper::VS_4_0,
             &pBlob ) )
         {
@@ -340,6 +432,24 @@ bool SampleApp::InitShadowState()
         }
     }
 
+    // シザー矩形を有効にしたラスタライザーステートの生成.
+    {
+        D3D11_RASTERIZER_DESC desc;
+        m_pRS->GetDesc( &desc );
+        desc.ScissorEnable = TRUE;
+
+        // 裏面カリングが有効な場合だけ, メッシュレットを法線コーンでカリングできる.
+        m_EnableMeshletCone       = ( desc.CullMode == D3D11_CULL_BACK );
+        m_IsFrontCounterClockwise = ( desc.FrontCounterClockwise != FALSE );
+
+        hr = m_pDevice->CreateRasterizerState( &desc, &m_ShadowState.pRS );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateRasterizerState() Failed." );
+            return false;
+        }
+    }
+
     // 正常終了.
     return true;
 }
@@ -359,131 +469,506 @@ bool SampleApp::InitForward()
 {
     HRESULT hr = S_OK;
 
-    // メッシュの読み込み.
+    // 定数バッファの生成.
     {
-        ID3DBlob* pVSBlob = nullptr;
-        hr = asdx::ShaderHelper::CompileShaderFromFile(
-            L"../res/shader/ForwardVS.hlsl",
-            "VSFunc",
-            asdx::ShaderHelper::VS_4_0,
-            &pVSBlob );
+        D3D11_BUFFER_DESC desc;
+        ZeroMemory( &desc, sizeof( desc ) );
+        desc.Usage     = D3D11_USAGE_DEFAULT;
+        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        desc.ByteWidth = sizeof( CBForward );
+        desc.CPUAccessFlags = 0;
+
+        hr = m_pDevice->CreateBuffer( &desc, nullptr, &m_pCBMatrixForward );
         if ( FAILED( hr ) )
         {
-            ELOG( "Error : CompileShaderFromFile() Failed." );
+            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
             return false;
         }
 
-        asdx::ResMesh resMesh;
-        if ( !resMesh.LoadFromFile( "../res/scene/scene.msh" ) )
+    }
+
+    // シェーダのコンパイルとメッシュの読み込みはスレッドプールで並行して進め, デバイスを使う処理だけをメインスレッドで行う.
+    // 起動時間は各処理の合計ではなく, 一番時間の掛かる読み込みで決まる.
+    std::shared_ptr< SceneData > data( new SceneData() );
+
+    // ピクセルシェーダの生成.
+    {
+        AsyncLoader::Desc desc;
+        desc.pName    = "Forward Pixel Shaders";
+        desc.Priority = AsyncLoader::PRIORITY_HIGH;
+        desc.Load     = [this, data]( const AsyncLoader::Future& ) { return LoadPixelShaders( *data ); };
+        desc.Create   = [this, data]() { return CreatePixelShaders( *data ); };
+
+        m_ShaderFuture = m_AsyncLoader.Submit( desc );
+    }
+
+    // メッシュの読み込み.
+    {
+        AsyncLoader::Desc desc;
+        desc.pName      = "Scene Mesh";
+        desc.Priority   = AsyncLoader::PRIORITY_NORMAL;
+        desc.Load       = [this, data]( const AsyncLoader::Future& ) { return LoadScene( *data ); };
+        desc.Create     = [this, data]() { return CreateScene( *data ); };
+        desc.OnComplete = [this, data]( AsyncLoader::STATE state )
+        {
+            // 描画できるようになってから, 詳細度と静的バッチを後追いで作る.
+            if ( state == AsyncLoader::STATE_COMPLETED )
+            { SubmitSceneDetails( data ); }
+        };
+
+        m_SceneFuture = m_AsyncLoader.Submit( desc );
+    }
+
+    return m_ShaderFuture.IsValid() && m_SceneFuture.IsValid();
+}
+
+//-----------------------------------------------------------------------------------
+//      ピクセルシェーダをコンパイルします(ワーカースレッド).
+//-----------------------------------------------------------------------------------
+bool SampleApp::LoadPixelShaders( SceneData& data )
+{
+    HRESULT hr = asdx::ShaderHelper::CompileShaderFromFile(
+        L"../res/shader/ForwardPS.hlsl",
+        "PSFunc",
+        asdx::ShaderHelper::PS_5_0,
+        &data.pPSBlob );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : Shader Compile Failed." );
+        return false;
+    }
+
+    // カバレッジでカスケードを選択するピクセルシェーダ.
+    hr = asdx::ShaderHelper::CompileShaderFromFile(
+        L"../res/shader/ForwardPS.hlsl",
+        "PSFuncCoverage",
+        asdx::ShaderHelper::PS_5_0,
+        &data.pPSCoverageBlob );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : Shader Compile Failed." );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      ピクセルシェーダを生成します(メインスレッド).
+//-----------------------------------------------------------------------------------
+bool SampleApp::CreatePixelShaders( SceneData& data )
+{
+    HRESULT hr = m_pDevice->CreatePixelShader(
+        data.pPSBlob->GetBufferPointer(),
+        data.pPSBlob->GetBufferSize(),
+        nullptr,
+        &m_pPS );
+    if ( SUCCEEDED( hr ) )
+    {
+        hr = m_pDevice->CreatePixelShader(
+            data.pPSCoverageBlob->GetBufferPointer(),
+            data.pPSCoverageBlob->GetBufferSize(),
+            nullptr,
+            &m_pPSCoverage );
+    }
+
+    ASDX_RELEASE( data.pPSBlob );
+    ASDX_RELEASE( data.pPSCoverageBlob );
+
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreatePixelShader() Failed." );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュを読み込みます(ワーカースレッド).
+//-----------------------------------------------------------------------------------
+bool SampleApp::LoadScene( SceneData& data )
+{
+    HRESULT hr = asdx::ShaderHelper::CompileShaderFromFile(
+        L"../res/shader/ForwardVS.hlsl",
+        VS_ENTRY_POINT,
+        asdx::ShaderHelper::VS_4_0,
+        &data.pVSBlob );
+    if ( SUCCEEDED( hr ) )
+    {
+        hr = asdx::ShaderHelper::CompileShaderFromFile(
+            L"../res/shader/ShadowVS.hlsl",
+            VS_ENTRY_POINT,
+            asdx::ShaderHelper::VS_4_0,
+            &data.pDepthBlob );
+    }
+    if ( SUCCEEDED( hr ) )
+    {
+        hr = asdx::ShaderHelper::CompileShaderFromFile(
+            L"../res/shader/ForwardVS.hlsl",
+            VS_INSTANCED_ENTRY_POINT,
+            asdx::ShaderHelper::VS_4_0,
+            &data.pInstancedBlob );
+    }
+    if ( SUCCEEDED( hr ) )
+    {
+        hr = asdx::ShaderHelper::CompileShaderFromFile(
+            L"../res/shader/ShadowVS.hlsl",
+            VS_INSTANCED_ENTRY_POINT,
+            asdx::ShaderHelper::VS_4_0,
+            &data.pDepthInstancedBlob );
+    }
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : CompileShaderFromFile() Failed." );
+        return false;
+    }
+
+    // クック済みのファイルがあれば優先して使う. AABBもクック時に求めてある.
+    if ( data.CookedMesh.LoadFromFile( "../res/scene/scene.cmsh" ) )
+    {
+        data.pResMesh   = &data.CookedMesh;
+        data.pMaterials = &data.CookedMesh.GetMaterialTable();
+        data.Box        = data.CookedMesh.GetBoundingBox();
+    }
+    else
+    {
+        // ファイルをマップして, 頂点データ等はコピーせずに直接参照する.
+        if ( !data.MappedMesh.LoadFromFile( "../res/scene/scene.msh" ) )
         {
-            ASDX_RELEASE( pVSBlob );
             ELOG( "Error : Mesh Load Failed." );
             return false;
         }
+        data.pResMesh = &data.MappedMesh;
 
         // AABBを求めておく.
-        if ( resMesh.GetVertexCount() >= 1 )
+        if ( data.MappedMesh.GetVertexCount() >= 1 )
         {
-            asdx::Vector3 mini = resMesh.GetVertex(0).Position;
-            asdx::Vector3 maxi = resMesh.GetVertex(0).Position;
+            const asdx::ResMesh::Vertex* pVertices = data.MappedMesh.GetVertices();
+            asdx::Vector3 mini = pVertices[0].Position;
+            asdx::Vector3 maxi = pVertices[0].Position;
 
-            for( u32 i=1; i<resMesh.GetVertexCount(); ++i )
+            for( u32 i=1; i<data.MappedMesh.GetVertexCount(); ++i )
             {
-                mini = asdx::Vector3::Min( mini, resMesh.GetVertex(i).Position );
-                maxi = asdx::Vector3::Max( maxi, resMesh.GetVertex(i).Position );
+                mini = asdx::Vector3::Min( mini, pVertices[i].Position );
+                maxi = asdx::Vector3::Max( maxi, pVertices[i].Position );
             }
 
-            m_Box_Dosei = asdx::BoundingBox( mini, maxi );
+            data.Box = asdx::BoundingBox( mini, maxi );
         }
+    }
 
-        if ( !m_Dosei.Init( 
-            m_pDevice,
-            resMesh,
-            pVSBlob->GetBufferPointer(),
-            pVSBlob->GetBufferSize(),
-            "../res/scene/",
-            "../res/dummy/" ) )
+    // 頂点キャッシュの効率を確認できるようにしておく.
+    data.CacheStats = MeshOptimizer::AnalyzeVertexCache(
+        data.pResMesh->GetIndices(),
+        data.pResMesh->GetIndexCount(),
+        data.pResMesh->GetVertexCount() );
+
+    // メッシュを格子状に並べる. 移動量はメッシュのローカル座標系で与える.
+    {
+        asdx::Vector3 size = data.Box.maxi - data.Box.mini;
+        asdx::Matrix  world = asdx::Matrix::CreateScale( 0.25f );
+        f32 stepX = size.x * INSTANCE_SPACING;
+        f32 stepZ = size.z * INSTANCE_SPACING;
+        f32 half  = f32( INSTANCE_GRID_SIZE - 1 ) * 0.5f;
+
+        data.InstanceWorlds.reserve( INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE );
+        for( u32 z=0; z<INSTANCE_GRID_SIZE; ++z )
         {
-            ELOG( "Error : Mesh Init Falied." );
-            ASDX_RELEASE( pVSBlob );
-            return false;
+            for( u32 x=0; x<INSTANCE_GRID_SIZE; ++x )
+            {
+                asdx::Matrix offset = asdx::Matrix::CreateTranslation(
+                    ( f32( x ) - half ) * stepX,
+                    0.0f,
+                    ( f32( z ) - half ) * stepZ );
+                data.InstanceWorlds.push_back( offset * world );
+            }
         }
 
-        resMesh.Release();
+        // 遮蔽判定用に, インスタンスごとのワールド空間のAABBを求めておく.
+        asdx::Vector3x8 corners;
+        data.Box.GetCorners( corners );
 
-        hr = m_pDevice->CreateVertexShader( pVSBlob->GetBufferPointer(),
-            pVSBlob->GetBufferSize(),
-            nullptr,
-            &m_pVS );
-
-        ASDX_RELEASE( pVSBlob );
-        if ( FAILED( hr ) )
+        data.InstanceBoxes.reserve( data.InstanceWorlds.size() );
+        for( size_t i=0; i<data.InstanceWorlds.size(); ++i )
         {
-            ELOG( "Error : ID3D11Device::CreateVertexShader() Failed." );
-            return false;
+            asdx::Vector3 mini = asdx::Vector3::Transform( corners[0], data.InstanceWorlds[i] );
+            asdx::Vector3 maxi = mini;
+            for( u32 j=1; j<corners.GetSize(); ++j )
+            {
+                asdx::Vector3 val = asdx::Vector3::Transform( corners[j], data.InstanceWorlds[i] );
+                mini = asdx::Vector3::Min( mini, val );
+                maxi = asdx::Vector3::Max( maxi, val );
+            }
+
+            asdx::Vector3 margin = ( maxi - mini ) * OCCLUSION_BOX_MARGIN;
+            data.InstanceBoxes.push_back( asdx::BoundingBox( mini - margin, maxi + margin ) );
         }
+
+        // シャドウマップの範囲を求めるために, 全インスタンスを覆うAABBを求めておく.
+        asdx::Vector3 extent( half * stepX, 0.0f, half * stepZ );
+        data.InstanceBox = asdx::BoundingBox( data.Box.mini - extent, data.Box.maxi + extent );
     }
 
-    // ピクセルシェーダの生成.
+    // オクルージョンカリングの遮蔽物を選んでおく.
+    // 面積の大きい三角形だけを残し, 参照される頂点の位置座標だけを詰めて持つ.
     {
-        ID3DBlob* pBlob;
+        const asdx::ResMesh::Vertex* pVertices = data.pResMesh->GetVertices();
+        const asdx::ResMesh::Index*  pIndices  = data.pResMesh->GetIndices();
+        u32 triangleCount = data.pResMesh->GetIndexCount() / 3;
+
+        typedef std::pair< f32, u32 >   AreaTriangle;
+        std::vector< AreaTriangle > triangles;
+        triangles.reserve( triangleCount );
+        for( u32 i=0; i<triangleCount; ++i )
+        {
+            const asdx::Vector3& p0 = pVertices[ pIndices[ i * 3 + 0 ] ].Position;
+            const asdx::Vector3& p1 = pVertices[ pIndices[ i * 3 + 1 ] ].Position;
+            const asdx::Vector3& p2 = pVertices[ pIndices[ i * 3 + 2 ] ].Position;
+
+            // 比較にしか使わないので, 面積の2乗のままにしておく.
+            f32 area = asdx::Vector3::Cross( p1 - p0, p2 - p0 ).LengthSq();
+            if ( area > 0.0f )
+            { triangles.push_back( AreaTriangle( area, i ) ); }
+        }
 
-        hr = asdx::ShaderHelper::CompileShaderFromFile(
-            L"../res/shader/ForwardPS.hlsl",
-            "PSFunc",
-            asdx::ShaderHelper::PS_5_0,
-            &pBlob );
+        if ( triangles.size() > OCCLUDER_MAX_TRIANGLES )
+        {
+            std::nth_element(
+                triangles.begin(),
+                triangles.begin() + OCCLUDER_MAX_TRIANGLES,
+                triangles.end(),
+                []( const AreaTriangle& lhs, const AreaTriangle& rhs )
+                { return lhs.first > rhs.first; } );
+            triangles.resize( OCCLUDER_MAX_TRIANGLES );
+        }
 
-        if ( FAILED( hr ) )
+        std::vector< u32 > remap( data.pResMesh->GetVertexCount(), 0xffffffff );
+        data.OccluderIndices.reserve( triangles.size() * 3 );
+        for( size_t i=0; i<triangles.size(); ++i )
         {
-            ELOG( "Error : Shader Compile Failed." );
-            return false;
+            for( u32 j=0; j<3; ++j )
+            {
+                u32 index = pIndices[ triangles[i].second * 3 + j ];
+                if ( remap[ index ] == 0xffffffff )
+                {
+                    remap[ index ] = u32( data.OccluderPositions.size() );
+                    data.OccluderPositions.push_back( pVertices[ index ].Position );
+                }
+                data.OccluderIndices.push_back( remap[ index ] );
+            }
         }
+    }
 
-        hr = m_pDevice->CreatePixelShader(
-            pBlob->GetBufferPointer(),
-            pBlob->GetBufferSize(),
-            nullptr,
-            &m_pPS );
+    return true;
+}
 
-        ASDX_RELEASE( pBlob );
+//-----------------------------------------------------------------------------------
+//      メッシュのGPUリソースを生成します(メインスレッド).
+//-----------------------------------------------------------------------------------
+bool SampleApp::CreateScene( SceneData& data )
+{
+    HRESULT hr = S_OK;
 
-        if ( FAILED( hr ) )
-        {
-            ELOG( "Error : ID3D11Device::CreatePixelShader() Failed." );
-            return false;
-        }
+    m_Box_Dosei      = data.Box;
+    m_Box_Instances  = data.InstanceBox;
+    m_InstanceWorlds = data.InstanceWorlds;
+    m_InstanceBoxes  = data.InstanceBoxes;
+    m_MeshCacheStats = data.CacheStats;
+
+    // 遮蔽物は描画スレッドでしか使わないので, そのまま引き取る.
+    m_OccluderPositions.swap( data.OccluderPositions );
+    m_OccluderIndices  .swap( data.OccluderIndices );
+
+    // ストリーミング用のファイルがあれば, 先頭の基本LODだけを読んでおく.
+    // 詳細化ブロックは描画しながらスレッドプールで読み込むので, ここでの処理時間はメッシュの大きさに依存しない.
+    // 無くても描画には支障が無いので, 続行する.
+    if ( !m_StreamingMesh.Init(
+        m_pDevice,
+        "../res/scene/scene.smsh",
+        ENABLE_PACKED_VERTEX,
+        data.pVSBlob->GetBufferPointer(),
+        data.pVSBlob->GetBufferSize(),
+        data.pDepthBlob->GetBufferPointer(),
+        data.pDepthBlob->GetBufferSize(),
+        &m_ThreadPool ) )
+    { ELOG( "Error : StreamingMesh::Init() Failed." ); }
+
+    if ( !m_Dosei.Init( 
+        m_pDevice,
+        *data.pResMesh,
+        data.pVSBlob->GetBufferPointer(),
+        data.pVSBlob->GetBufferSize(),
+        "../res/scene/",
+        "../res/dummy/",
+        ENABLE_PACKED_VERTEX,
+        data.pMaterials,
+        &m_ThreadPool ) )
+    {
+        ELOG( "Error : Mesh Init Falied." );
+        return false;
     }
 
-    // 定数バッファの生成.
+    // クック時に空間分割してあれば, チャンク単位でカリングできるようにしておく.
+    // 設定できなくても描画には支障が無いので, 続行する.
+    if ( !m_Dosei.InitChunks( data.CookedMesh.GetChunks(), data.CookedMesh.GetChunkCount() ) )
+    { ELOG( "Error : ClusteredMesh::InitChunks() Failed." ); }
+
+    // シャドウマップ描画用に位置座標だけの頂点ストリームを作っておく.
+    if ( !m_Dosei.InitDepthStream(
+        m_pDevice,
+        *data.pResMesh,
+        data.pDepthBlob->GetBufferPointer(),
+        data.pDepthBlob->GetBufferSize() ) )
     {
-        D3D11_BUFFER_DESC desc;
-        ZeroMemory( &desc, sizeof( desc ) );
-        desc.Usage     = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.ByteWidth = sizeof( CBForward );
-        desc.CPUAccessFlags = 0;
+        ELOG( "Error : Depth Stream Init Failed." );
+        return false;
+    }
 
-        hr = m_pDevice->CreateBuffer( &desc, nullptr, &m_pCBMatrixForward );
-        if ( FAILED( hr ) )
+    // インスタンス描画用の入力レイアウトを作っておく.
+    {
+        bool result = m_Dosei.InitInstancing(
+            m_pDevice,
+            data.pInstancedBlob->GetBufferPointer(),
+            data.pInstancedBlob->GetBufferSize(),
+            data.pDepthInstancedBlob->GetBufferPointer(),
+            data.pDepthInstancedBlob->GetBufferSize() );
+
+        if ( result )
         {
-            ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+            hr = m_pDevice->CreateVertexShader(
+                data.pInstancedBlob->GetBufferPointer(),
+                data.pInstancedBlob->GetBufferSize(),
+                nullptr,
+                &m_pInstancedVS );
+            if ( SUCCEEDED( hr ) )
+            {
+                hr = m_pDevice->CreateVertexShader(
+                    data.pDepthInstancedBlob->GetBufferPointer(),
+                    data.pDepthInstancedBlob->GetBufferSize(),
+                    nullptr,
+                    &m_ShadowState.pInstancedVS );
+            }
+            result = SUCCEEDED( hr );
+        }
+
+        ASDX_RELEASE( data.pInstancedBlob );
+        ASDX_RELEASE( data.pDepthInstancedBlob );
+
+        if ( !result )
+        {
+            ELOG( "Error : Mesh Instancing Init Failed." );
             return false;
         }
+    }
 
+    if ( !m_InstanceBuffer.Init( m_pDevice, u32( m_InstanceWorlds.size() ) ) )
+    {
+        ELOG( "Error : InstanceBuffer Init Failed." );
+        return false;
+    }
+
+    hr = m_pDevice->CreateVertexShader( data.pVSBlob->GetBufferPointer(),
+        data.pVSBlob->GetBufferSize(),
+        nullptr,
+        &m_pVS );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateVertexShader() Failed." );
+        return false;
     }
 
     return true;
 }
 
+//-----------------------------------------------------------------------------------
+//      描画に必須ではない詳細度と静的バッチの読み込みを要求します.
+//-----------------------------------------------------------------------------------
+void SampleApp::SubmitSceneDetails( const std::shared_ptr< SceneData >& data )
+{
+    // 詳細度を生成しておく. サブセットごとにスレッドプールで並列に処理される.
+    // 出来上がるまでは詳細度0で描画される.
+    {
+        AsyncLoader::Desc desc;
+        desc.pName    = "Scene LOD";
+        desc.Priority = AsyncLoader::PRIORITY_LOW;
+        desc.Load     = [this, data]( const AsyncLoader::Future& ) -> bool
+        {
+            MeshSimplifier::Config config;
+            if ( !MeshSimplifier::Build( *data->pResMesh, config, data->LodChain, &m_ThreadPool ) )
+            { ELOG( "Warning : MeshSimplifier::Build() Failed." ); }
+            return true;
+        };
+        desc.Create   = [this, data]()
+        { return m_Dosei.InitLod( m_pDevice, std::move( data->LodChain ) ); };
+
+        m_AsyncLoader.Submit( desc );
+    }
+
+    // 同じ配置をワールド空間に変換して1つの頂点・インデックスプールにまとめておく.
+    {
+        AsyncLoader::Desc desc;
+        desc.pName    = "Static Batch";
+        desc.Priority = AsyncLoader::PRIORITY_LOW;
+        desc.Load     = [data]( const AsyncLoader::Future& future ) -> bool
+        {
+            for( size_t i=0; i<data->InstanceWorlds.size(); ++i )
+            {
+                // 終了処理が始まっていれば途中で打ち切る.
+                if ( future.IsCanceled() )
+                { return false; }
+
+                if ( !data->Batch.Add( *data->pResMesh, data->InstanceWorlds[i] ) )
+                {
+                    ELOG( "Error : StaticBatchBuilder::Add() Failed." );
+                    return false;
+                }
+            }
+            data->Batch.Build();
+            return true;
+        };
+        desc.Create   = [this, data]()
+        {
+            return m_StaticBatch.Init(
+                m_pDevice,
+                data->Batch,
+                ENABLE_PACKED_VERTEX,
+                data->pVSBlob->GetBufferPointer(),
+                data->pVSBlob->GetBufferSize(),
+                data->pDepthBlob->GetBufferPointer(),
+                data->pDepthBlob->GetBufferSize() );
+        };
+
+        m_AsyncLoader.Submit( desc );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      描画に必要なリソースが揃ったかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool SampleApp::IsSceneReady() const
+{
+    return ( m_ShaderFuture.GetState() == AsyncLoader::STATE_COMPLETED )
+        && ( m_SceneFuture .GetState() == AsyncLoader::STATE_COMPLETED );
+}
+
 //-----------------------------------------------------------------------------------
 //      フォワードレンダリングの終了処理です.
 //-----------------------------------------------------------------------------------
 void SampleApp::TermForward()
 {
     ASDX_RELEASE( m_pVS );
+    ASDX_RELEASE( m_pInstancedVS );
     ASDX_RELEASE( m_pPS );
+    ASDX_RELEASE( m_pPSCoverage );
     ASDX_RELEASE( m_pCBMatrixForward );
+    m_InstanceBuffer.Term();
+    m_InstanceWorlds.clear();
+    m_InstanceBoxes.clear();
+    m_OccluderPositions.clear();
+    m_OccluderIndices.clear();
+    m_StaticBatch.Term();
+    m_StreamingMesh.Term();
     m_Dosei.Term();
 }
 
@@ -492,6 +977,10 @@ void SampleApp::TermForward()
 //-----------------------------------------------------------------------------------
 bool SampleApp::OnInit()
 {
+    // 全ての読み込みが終わるまでの時間を計る.
+    m_LoadWatch.Start();
+    m_LoadTimeMsec = 0.0;
+
     if ( !m_Font.Init( m_pDevice, "../res/font/SetoMini-P.fnt", f32(m_Width), f32(m_Height) ) )
     { return false; }
 
@@ -501,6 +990,16 @@ bool SampleApp::OnInit()
     if ( !InitShadowState() )
     { return false; }
 
+    if ( !m_ThreadPool.Init() )
+    { return false; }
+
+    if ( !m_AsyncLoader.Init( &m_ThreadPool ) )
+    { return false; }
+
+    if ( !m_OcclusionCuller.Init( OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT, &m_ThreadPool ) )
+    { return false; }
+
+    // メッシュとシェーダは読み込みを要求するだけで, 完了を待たずにフレームを回し始める.
     if ( !InitForward() )
     { return false; }
 
@@ -538,9 +1037,13 @@ bool SampleApp::OnInit()
 //-----------------------------------------------------------------------------------
 void SampleApp::OnTerm()
 {
+    // 読み込み中の要求が生成処理でメンバを触らないように, 先に止めておく.
+    m_AsyncLoader.Term();
     TermForward();
     TermQuad();
     TermShadowState();
+    m_OcclusionCuller.Term();
+    m_ThreadPool.Term();
     m_Font.Term();
 }
 
@@ -566,6 +1069,33 @@ asdx::Matrix SampleApp::CreateScreenMatrix
         tx,          ty,          0.0f,        1.0f ); 
 }
 
+//-----------------------------------------------------------------------------------
+//      メッシュの詳細度を選択します.
+//-----------------------------------------------------------------------------------
+u32 SampleApp::SelectLod
+(
+    const asdx::Matrix& worldViewProj,
+    f32 width,
+    f32 height
+)
+{
+    if ( !m_EnableLod )
+    { return 0; }
+
+    // メッシュ全体を覆うバウンディングスフィアで評価する.
+    asdx::Vector3 center = ( m_Box_Dosei.mini + m_Box_Dosei.maxi ) * 0.5f;
+    f32           radius = ( m_Box_Dosei.maxi - m_Box_Dosei.mini ).Length() * 0.5f;
+
+    return m_LodSelector.Select(
+        m_Dosei.GetLodErrors(),
+        m_Dosei.GetLodCount(),
+        worldViewProj,
+        center,
+        radius,
+        width,
+        height );
+}
+
 //-----------------------------------------------------------------------------------
 //      矩形を描画します.
 //-----------------------------------------------------------------------------------
@@ -650,6 +1180,29 @@ void SampleApp::DrawQuad( ID3D11ShaderResourceView** ppSRV )
 //---------------------------------------------------------------------------------------
 void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
 {
+    // 読み込みが済んだ要求のGPUリソースをメインスレッドで生成する.
+    m_AsyncLoader.Update();
+    if ( m_LoadTimeMsec <= 0.0 && m_AsyncLoader.IsIdle() )
+    {
+        m_LoadWatch.End();
+        m_LoadTimeMsec = m_LoadWatch.GetElapsedTimeMsec();
+    }
+
+    // 描画に必要なものが揃うまでは, 読み込みの進み具合だけを表示する.
+    if ( !IsSceneReady() )
+    {
+        DrawLoading( param );
+        return;
+    }
+
+    // 読み込みが済んだ詳細化ブロックを常駐させ, 主カメラから見た誤差で次に読み込むチャンクを決める.
+    // 表示していない間も読み込みは進めておく.
+    m_StreamingMesh.Update(
+        m_pDevice,
+        asdx::Matrix::CreateScale( 0.25f ) * m_View * m_Proj,
+        f32( m_Width ),
+        f32( m_Height ) );
+
     // PSSM行列を求める.
     ComputeShadowMatrixPSSM();
 
@@ -685,9 +1238,9 @@ void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
         m_pDeviceContext->ClearRenderTargetView( pRTV, m_ClearColor );
         m_pDeviceContext->ClearDepthStencilView( pDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0 );
 
-        m_pDeviceContext->VSSetShader( m_pVS,   nullptr, 0 );
+        m_pDeviceContext->VSSetShader( ( m_EnableInstancing ) ? m_pInstancedVS : m_pVS, nullptr, 0 );
         m_pDeviceContext->GSSetShader( nullptr, nullptr, 0 );   // ジオメトリシェーダつかったら遅かったので，使わない.
-        m_pDeviceContext->PSSetShader( m_pPS,   nullptr, 0 );
+        m_pDeviceContext->PSSetShader( ( m_EnableCoverage ) ? m_pPSCoverage : m_pPS, nullptr, 0 );
         m_pDeviceContext->HSSetShader( nullptr, nullptr, 0 );
         m_pDeviceContext->DSSetShader( nullptr, nullptr, 0 );
 
@@ -695,12 +1248,25 @@ void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
         asdx::Matrix lightRot = asdx::Matrix::CreateRotationX( m_LightRotX )
                               * asdx::Matrix::CreateRotationY( m_LightRotY );
         CBForward cbParam;
-        cbParam.World     = asdx::Matrix::CreateScale( 0.25f );
+        asdx::Matrix world = asdx::Matrix::CreateScale( 0.25f );
+
+        // 圧縮頂点の場合は逆量子化をワールド行列に含めておく.
         cbParam.View      = m_View;
         cbParam.Proj      = m_Proj;
         cbParam.CameraPos = m_Camera.GetCamera().GetPosition();
         cbParam.LightDir  = asdx::Vector3::Transform( m_LightDir, lightRot );
-        for( u32 i=0; i<4; ++i )
+
+        // インスタンス描画ではワールド行列をインスタンスごとに持つので, 逆量子化だけを設定する.
+        // 静的バッチは頂点をワールド空間で持っているので, バッチ全体の逆量子化だけを設定する.
+        if ( m_EnableInstancing )
+        { cbParam.World = m_Dosei.GetDequantizeMatrix(); }
+        else if ( m_EnableStaticBatch )
+        { cbParam.World = m_StaticBatch.GetDequantizeMatrix(); }
+        else if ( m_EnableStreaming )
+        { cbParam.World = m_StreamingMesh.GetDequantizeMatrix() * world; }
+        else
+        { cbParam.World = m_Dosei.GetDequantizeMatrix() * world; }
+        for( u32 i=0; i<MAX_CASCADE; ++i )
         {
             cbParam.Shadow[i]   = m_ShadowMatrix[i] * SHADOW_BIAS;
             cbParam.SplitPos[i] = m_SplitPos[i];
@@ -714,8 +1280,156 @@ void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
         // サンプラーステートを設定.
         m_pDeviceContext->PSSetSamplers( 3, 1, &m_ShadowState.pSmp );
 
-        // 描画キック.
-        m_Dosei.Draw ( m_pDeviceContext );
+        // 詳細度を選択する. 誤差はメッシュのローカル座標系なので逆量子化を含めない行列を使う.
+        m_MainLod = SelectLod( world * m_View * m_Proj, f32( m_Width ), f32( m_Height ) );
+
+        // マテリアル設定の統計情報はフレームごとに集計する.
+        m_Dosei.ResetBindStatistics();
+
+        // 視錐台の外側にあるチャンクは描画しない. インスタンス描画ではインスタンスごとに判定できないので使われない.
+        const u8* pChunkMask = nullptr;
+        m_MainChunkVisible = m_Dosei.GetChunkCount();
+        if ( m_EnableChunkCulling && m_Dosei.GetChunkCount() > 0 )
+        {
+            m_MainChunkMask.assign( m_Dosei.GetChunkCount(), 1 );
+            m_MainChunkVisible = m_Dosei.CullChunks( world * m_View * m_Proj, &m_MainChunkMask[0] );
+            pChunkMask = &m_MainChunkMask[0];
+        }
+        // 読み込み時に選んだ遮蔽物をソフトウェアラスタライズして, 隠れているインスタンスとチャンクを除く.
+        // 静的バッチとストリーミングはインスタンスやチャンクを選べないので対象外.
+        const asdx::Matrix* pInstanceWorlds = &m_InstanceWorlds[0];
+        u32                 instanceCount   = u32( m_InstanceWorlds.size() );
+        m_OcclusionStats = OcclusionCuller::Statistics();
+        if ( m_EnableOcclusionCulling
+          && !m_OccluderIndices.empty()
+          && ( m_EnableInstancing || ( pChunkMask != nullptr && !m_EnableStaticBatch && !m_EnableStreaming ) ) )
+        {
+            m_OcclusionCuller.Begin( m_View * m_Proj );
+            if ( m_EnableInstancing )
+            {
+                for( u32 i=0; i<instanceCount; ++i )
+                {
+                    m_OcclusionCuller.AddOccluder(
+                        m_InstanceWorlds[i],
+                        &m_OccluderPositions[0],
+                        sizeof( asdx::Vector3 ),
+                        u32( m_OccluderPositions.size() ),
+                        &m_OccluderIndices[0],
+                        u32( m_OccluderIndices.size() ) );
+                }
+            }
+            else
+            {
+                m_OcclusionCuller.AddOccluder(
+                    world,
+                    &m_OccluderPositions[0],
+                    sizeof( asdx::Vector3 ),
+                    u32( m_OccluderPositions.size() ),
+                    &m_OccluderIndices[0],
+                    u32( m_OccluderIndices.size() ) );
+            }
+            m_OcclusionCuller.Flush();
+
+            if ( m_EnableInstancing )
+            {
+                // 遮蔽されていないインスタンスだけを視錐台カリングに渡す.
+                m_OcclusionVisible.resize( instanceCount );
+                m_OcclusionCuller.TestBoxes( &m_InstanceBoxes[0], instanceCount, &m_OcclusionVisible[0] );
+
+                m_OcclusionWorlds.clear();
+                for( u32 i=0; i<instanceCount; ++i )
+                {
+                    if ( m_OcclusionVisible[i] != 0 )
+                    { m_OcclusionWorlds.push_back( m_InstanceWorlds[i] ); }
+                }
+
+                pInstanceWorlds = ( m_OcclusionWorlds.empty() ) ? nullptr : &m_OcclusionWorlds[0];
+                instanceCount   = u32( m_OcclusionWorlds.size() );
+            }
+            else
+            {
+                // チャンクのAABBはキャスターカリングで求めたワールド空間のものを使う.
+                u32 chunkCount = m_Dosei.GetChunkCount();
+                m_OcclusionBoxes  .resize( chunkCount );
+                m_OcclusionVisible.resize( chunkCount );
+                for( u32 i=0; i<chunkCount; ++i )
+                {
+                    const asdx::BoundingBox& box = m_ChunkBoxes[i];
+                    asdx::Vector3 margin = ( box.maxi - box.mini ) * OCCLUSION_BOX_MARGIN;
+                    m_OcclusionBoxes[i] = asdx::BoundingBox( box.mini - margin, box.maxi + margin );
+                }
+                m_OcclusionCuller.TestBoxes( &m_OcclusionBoxes[0], chunkCount, &m_OcclusionVisible[0] );
+
+                m_MainChunkVisible = 0;
+                for( u32 i=0; i<chunkCount; ++i )
+                {
+                    m_MainChunkMask[i] &= m_OcclusionVisible[i];
+                    m_MainChunkVisible += m_MainChunkMask[i];
+                }
+            }
+
+            m_OcclusionStats = m_OcclusionCuller.GetStatistics();
+        }
+        m_Dosei.SetChunkMask( pChunkMask );
+
+        // 描画キック. メッシュレットは元のメッシュにしか無いので, 詳細度を下げた場合はカリングしない.
+        if ( m_EnableInstancing )
+        {
+            // 視錐台に入るインスタンスだけを転送して, 1回の描画で済ませる.
+            // 詳細度は中央のインスタンスで選んだものを全インスタンスで共有する.
+            m_InstanceBuffer.Cull(
+                pInstanceWorlds,
+                instanceCount,
+                asdx::BoundingSphere::CreateFromBoundingBox( m_Box_Dosei ),
+                m_View * m_Proj );
+            m_InstanceBuffer.Upload( m_pDeviceContext );
+            m_MainInstanceStats = m_InstanceBuffer.GetStatistics();
+
+            m_MainCullResult.TotalTriangles   = m_Dosei.GetLodTriangleCount( 0 ) * m_MainInstanceStats.TestedCount;
+            m_MainCullResult.VisibleTriangles = m_Dosei.GetLodTriangleCount( m_MainLod ) * m_MainInstanceStats.VisibleCount;
+            m_Dosei.DrawInstanced( m_pDeviceContext, m_InstanceBuffer, m_MainLod );
+        }
+        else if ( m_EnableStaticBatch )
+        {
+            // マテリアルはメッシュのものを共有する. 詳細度とメッシュレットは使わない.
+            ClusteredMesh* pMesh = &m_Dosei;
+            pMesh->BeginMaterialBinding( m_pDeviceContext );
+            m_StaticBatch.Draw( m_pDeviceContext, m_View * m_Proj,
+                [pMesh]( ID3D11DeviceContext* pContext, u32 materialId )
+                { pMesh->BindMaterial( pContext, materialId ); } );
+            m_MainBatchStats = m_StaticBatch.GetStatistics();
+        }
+        else if ( m_EnableStreaming )
+        {
+            // マテリアルはメッシュのものを共有する. 常駐していないチャンクは基本LODで描画される.
+            ClusteredMesh* pMesh = &m_Dosei;
+            pMesh->BeginMaterialBinding( m_pDeviceContext );
+            m_StreamingMesh.Draw( m_pDeviceContext, world * m_View * m_Proj,
+                [pMesh]( ID3D11DeviceContext* pContext, u32 materialId )
+                { pMesh->BindMaterial( pContext, materialId ); } );
+            m_MainStreamStats = m_StreamingMesh.GetStatistics();
+        }
+        else if ( m_MainLod > 0 )
+        {
+            m_MainCullResult.TotalTriangles   = m_Dosei.GetLodTriangleCount( 0 );
+            m_MainCullResult.VisibleTriangles = m_Dosei.GetLodTriangleCount( m_MainLod );
+            m_Dosei.DrawLod( m_pDeviceContext, m_MainLod );
+        }
+        else if ( m_EnableMeshletCulling )
+        {
+            MeshClusterizer::CullView view;
+            view.WorldViewProj          = world * m_View * m_Proj;
+            view.CameraPosition         = asdx::Vector3::TransformCoord( cbParam.CameraPos, asdx::Matrix::Invert( world ) );
+            view.EnableCone             = m_EnableMeshletCone;
+            view.FrontCounterClockwise  = m_IsFrontCounterClockwise;
+
+            m_Dosei.GetClusterizer().Cull( view, m_MainCullResult );
+            m_Dosei.Draw( m_pDeviceContext, m_MainCullResult );
+        }
+        else
+        { m_Dosei.Draw ( m_pDeviceContext ); }
+
+        m_Dosei.SetChunkMask( nullptr );
 
         ID3D11ShaderResourceView* pNullSRV[4] = { nullptr, nullptr, nullptr, nullptr };
         m_pDeviceContext->PSSetShaderResources( 0, 4, pNullSRV );
@@ -730,6 +1444,147 @@ void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
             m_Font.DrawStringArg( 10, 30, "Light Rotation X : %f", m_LightRotX );
             m_Font.DrawStringArg( 10, 50, "Light Rotation Y : %f", m_LightRotY );
             m_Font.DrawStringArg( 10, 70, "Lamda : %f", m_Lamda );
+            m_Font.DrawStringArg( 10, 90, "Caster Culling : %s (Culled %u / %u)",
+                ( m_EnableCasterCulling ) ? "ON" : "OFF",
+                m_CasterCuller.GetStatistics().CulledCasters,
+                m_CasterCuller.GetStatistics().TestedCasters );
+            if ( m_EnableOcclusionCulling )
+            {
+                m_Font.DrawStringArg( 10, 110, "Occlusion Culling : ON (Culled %u / %u, %u Triangles)",
+                    m_OcclusionStats.OccludedObjects,
+                    m_OcclusionStats.TestedObjects,
+                    m_OcclusionStats.RasterizedTriangles );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 110, "Occlusion Culling : OFF" ); }
+            m_Font.DrawStringArg( 10, 130, "LiSPSM : %s, Split Count : %d",
+                ( m_EnableLiSPSM ) ? "ON" : "OFF",
+                m_SplitCount );
+            m_Font.DrawStringArg( 10, 150, "Cascade Overlap Elimination : %s",
+                ( m_EnableCoverage ) ? "ON" : "OFF" );
+            if ( m_EnableStereo )
+            {
+                m_Font.DrawStringArg( 10, 170, "Stereo : ON, Texel Ratio : %.2f %.2f %.2f %.2f",
+                    m_StereoTexelRatio[0],
+                    m_StereoTexelRatio[1],
+                    m_StereoTexelRatio[2],
+                    m_StereoTexelRatio[3] );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 170, "Stereo : OFF" ); }
+            m_Font.DrawStringArg( 10, 190, "Mesh ACMR : %.3f, ATVR : %.3f",
+                m_MeshCacheStats.ACMR,
+                m_MeshCacheStats.ATVR );
+            if ( m_EnableMeshletCulling )
+            {
+                u32 shadowVisible = 0;
+                u32 shadowTotal   = 0;
+                for( s32 i=0; i<m_SplitCount; ++i )
+                {
+                    shadowVisible += m_ShadowCullResult[i].VisibleTriangles;
+                    shadowTotal   += m_ShadowCullResult[i].TotalTriangles;
+                }
+
+                m_Font.DrawStringArg( 10, 210, "Meshlet Culling : ON, Main %u / %u, Shadow %u / %u",
+                    m_MainCullResult.VisibleTriangles,
+                    m_MainCullResult.TotalTriangles,
+                    shadowVisible,
+                    shadowTotal );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 210, "Meshlet Culling : OFF" ); }
+            m_Font.DrawStringArg( 10, 230, "Depth Stream : %u Vertices, %u Bytes/Vertex",
+                m_Dosei.GetDepthVertexCount(),
+                m_Dosei.GetDepthStride() );
+            m_Font.DrawStringArg( 10, 250, "Index Buffer : %u bit, %u Chunks",
+                m_Dosei.GetIndexStride() * 8,
+                m_Dosei.GetIndexChunkCount() );
+            if ( m_EnableLod )
+            {
+                m_Font.DrawStringArg( 10, 270, "LOD : ON (%u Levels), Main %u, Shadow %u %u %u %u",
+                    m_Dosei.GetLodCount(),
+                    m_MainLod,
+                    m_ShadowLod[0],
+                    m_ShadowLod[1],
+                    m_ShadowLod[2],
+                    m_ShadowLod[3] );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 270, "LOD : OFF" ); }
+            m_Font.DrawStringArg( 10, 290, "Material : %u, %u Strings, %u Bytes, %u Textures",
+                m_Dosei.GetMaterialTable().GetCount(),
+                m_Dosei.GetMaterialTable().GetStrings().GetCount(),
+                m_Dosei.GetMaterialTable().GetByteSize(),
+                m_Dosei.GetTextureCache().GetLoadedCount() );
+            m_Font.DrawStringArg( 10, 310, "Material Bind : %u / %u (%u Saved)",
+                m_Dosei.GetBindStatistics().BindCount,
+                m_Dosei.GetBindStatistics().RequestCount,
+                m_Dosei.GetBindStatistics().RequestCount - m_Dosei.GetBindStatistics().BindCount );
+            if ( m_EnableInstancing )
+            {
+                u32 shadowVisible = 0;
+                u32 shadowTested  = 0;
+                for( s32 i=0; i<m_SplitCount; ++i )
+                {
+                    shadowVisible += m_ShadowInstanceStats[i].VisibleCount;
+                    shadowTested  += m_ShadowInstanceStats[i].TestedCount;
+                }
+
+                m_Font.DrawStringArg( 10, 330, "Instancing : ON, Main %u / %u, Shadow %u / %u",
+                    m_MainInstanceStats.VisibleCount,
+                    m_MainInstanceStats.TestedCount,
+                    shadowVisible,
+                    shadowTested );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 330, "Instancing : OFF" ); }
+            if ( m_EnableStaticBatch )
+            {
+                u32 shadowCalls = 0;
+                for( s32 i=0; i<m_SplitCount; ++i )
+                { shadowCalls += m_ShadowBatchStats[i].DrawCallCount; }
+
+                m_Font.DrawStringArg( 10, 350, "Static Batch : ON, Main %u / %u (%u Calls), Shadow %u Calls",
+                    m_MainBatchStats.VisibleCount,
+                    m_MainBatchStats.TestedCount,
+                    m_MainBatchStats.DrawCallCount,
+                    shadowCalls );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 350, "Static Batch : OFF" ); }
+            if ( m_EnableChunkCulling && m_Dosei.GetChunkCount() > 0 )
+            {
+                m_Font.DrawStringArg( 10, 370, "Chunk Culling : ON, Main %u / %u, Shadow %u %u %u %u",
+                    m_MainChunkVisible,
+                    m_Dosei.GetChunkCount(),
+                    m_ShadowChunkVisible[0],
+                    m_ShadowChunkVisible[1],
+                    m_ShadowChunkVisible[2],
+                    m_ShadowChunkVisible[3] );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 370, "Chunk Culling : OFF (%u Chunks)", m_Dosei.GetChunkCount() ); }
+            if ( m_EnableStreaming )
+            {
+                const ChunkResidency::Statistics& residency = m_StreamingMesh.GetResidency().GetStatistics();
+                m_Font.DrawStringArg( 10, 390, "Streaming : ON, Resident %u / %u (Loading %u, %.1f MB), Base %u / %u Visible",
+                    residency.ResidentCount,
+                    m_StreamingMesh.GetChunkCount(),
+                    residency.LoadingCount,
+                    f32( residency.ResidentSize ) / ( 1024.0f * 1024.0f ),
+                    m_MainStreamStats.BaseCount,
+                    m_MainStreamStats.VisibleCount );
+            }
+            else
+            { m_Font.DrawStringArg( 10, 390, "Streaming : OFF (%u Chunks)", m_StreamingMesh.GetChunkCount() ); }
+            {
+                AsyncLoader::Statistics loadStats = m_AsyncLoader.GetStatistics();
+                m_Font.DrawStringArg( 10, 410, "Async Load : %.1f ms, Completed %u, Failed %u, Remain %u",
+                    m_LoadTimeMsec,
+                    loadStats.CompletedCount,
+                    loadStats.FailedCount,
+                    loadStats.PendingCount + loadStats.LoadingCount + loadStats.LoadedCount );
+            }
             m_Font.End( m_pDeviceContext );
         }
 
@@ -744,28 +1599,80 @@ void SampleApp::OnFrameRender( asdx::FrameEventParam& param )
     Present( 0 );
 }
 
+//---------------------------------------------------------------------------------------
+//      読み込み中の画面を描画する.
+//---------------------------------------------------------------------------------------
+void SampleApp::DrawLoading( asdx::FrameEventParam& param )
+{
+    ID3D11RenderTargetView* pRTV = m_RT.GetRTV();
+    ID3D11DepthStencilView* pDSV = m_DST.GetDSV();
+    if ( pRTV == nullptr || pDSV == nullptr )
+    { return; }
+
+    m_pDeviceContext->OMSetRenderTargets( 1, &pRTV, pDSV );
+
+    D3D11_VIEWPORT viewport;
+    viewport.TopLeftX = 0.0f;
+    viewport.TopLeftY = 0.0f;
+    viewport.Width    = f32(m_Width);
+    viewport.Height   = f32(m_Height);
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    m_pDeviceContext->RSSetViewports( 1, &viewport );
+
+    m_pDeviceContext->ClearRenderTargetView( pRTV, m_ClearColor );
+    m_pDeviceContext->ClearDepthStencilView( pDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0 );
+
+    bool isFailed = ( m_ShaderFuture.GetState() == AsyncLoader::STATE_FAILED )
+                 || ( m_SceneFuture .GetState() == AsyncLoader::STATE_FAILED );
+
+    AsyncLoader::Statistics loadStats = m_AsyncLoader.GetStatistics();
+    m_Font.Begin( m_pDeviceContext );
+    m_Font.DrawStringArg( 10, 10, "FPS : %.2f", param.FPS );
+    m_Font.DrawString   ( 10, 30, ( isFailed ) ? "Load Failed." : "Now Loading..." );
+    m_Font.DrawStringArg( 10, 50, "Pending %u, Loading %u, Waiting Create %u, Completed %u",
+        loadStats.PendingCount,
+        loadStats.LoadingCount,
+        loadStats.LoadedCount,
+        loadStats.CompletedCount );
+    m_Font.End( m_pDeviceContext );
+
+    Present( 0 );
+}
+
 //---------------------------------------------------------------------------------------
 //      シャドウマップに描画する.
 //---------------------------------------------------------------------------------------
+
 void SampleApp::DrawToShadowMap()
 {
     ID3D11RenderTargetView* pRTV = nullptr;
     ID3D11DepthStencilView* pDSV = nullptr;
 
-    m_pDeviceContext->VSSetShader( m_ShadowState.pVS, nullptr, 0 );
+    m_pDeviceContext->VSSetShader( ( m_EnableInstancing ) ? m_ShadowState.pInstancedVS : m_ShadowState.pVS, nullptr, 0 );
     m_pDeviceContext->GSSetShader( nullptr, nullptr, 0 );
     m_pDeviceContext->PSSetShader( nullptr, nullptr, 0 );   // 倍速Z-Onlyレンダリング使用.
     m_pDeviceContext->DSSetShader( nullptr, nullptr, 0 );
     m_pDeviceContext->HSSetShader( nullptr, nullptr, 0 );
 
     m_pDeviceContext->RSSetViewports( 1, &m_ShadowState.Viewport );
-    m_pDeviceContext->RSSetState( m_pRS );
+    m_pDeviceContext->RSSetState( ( m_EnableCoverage ) ? m_ShadowState.pRS : m_pRS );
     m_pDeviceContext->OMSetDepthStencilState( m_pDSS, 0 );
 
-    CBGenShadow param;
-    param.World = asdx::Matrix::CreateScale( 0.25f );
+    // メッシュレットは圧縮前の座標で構築してあるので, カリングには逆量子化を含めない行列を使う.
+    asdx::Matrix world = asdx::Matrix::CreateScale( 0.25f );
 
-    for( int i=0; i<MAX_CASCADE; ++i )
+    CBGenShadow param;
+    if ( m_EnableInstancing )
+    { param.World = m_Dosei.GetDequantizeMatrix(); }
+    else if ( m_EnableStaticBatch )
+    { param.World = m_StaticBatch.GetDequantizeMatrix(); }
+    else if ( m_EnableStreaming )
+    { param.World = m_StreamingMesh.GetDequantizeMatrix() * world; }
+    else
+    { param.World = m_Dosei.GetDequantizeMatrix() * world; }
+
+    for( int i=0; i<m_SplitCount; ++i )
     {
         pDSV = m_ShadowState.pDSV[i];
 
@@ -782,10 +1689,86 @@ void SampleApp::DrawToShadowMap()
         m_pDeviceContext->UpdateSubresource( m_ShadowState.pCB, 0, nullptr, &param, 0, 0 );
         m_pDeviceContext->VSSetConstantBuffers( 1, 1, &m_ShadowState.pCB );
 
+        // 細かいカスケードが覆っていない領域だけを描画する.
+        if ( m_EnableCoverage )
+        { m_pDeviceContext->RSSetScissorRects( 1, &m_ShadowState.Scissor[i] ); }
+
+        // 影が可視レシーバーに落ちないキャスター, 細かいカスケードだけに含まれるキャスターは描画しない.
+        if ( !m_IsCasterVisible || !m_DrawCasterInCascade[i] )
+        {
+            m_ShadowCullResult[i].VisibleTriangles = 0;
+            m_ShadowInstanceStats[i] = InstanceBuffer::Statistics();
+            m_ShadowBatchStats[i]    = StaticBatch::Statistics();
+            m_ShadowChunkVisible[i]  = 0;
+            continue;
+        }
+
+        // キャスターカリング・カスケード間の重複除去をチャンク単位で行った結果に, 視錐台カリングを重ねる.
+        const u8* pChunkMask = nullptr;
+        m_ShadowChunkVisible[i] = m_Dosei.GetChunkCount();
+        if ( m_EnableChunkCulling && m_ShadowChunkMask[i].size() == m_Dosei.GetChunkCount() && !m_ShadowChunkMask[i].empty() )
+        {
+            m_ShadowChunkVisible[i] = m_Dosei.CullChunks( world * m_ShadowMatrix[i], &m_ShadowChunkMask[i][0] );
+            pChunkMask = &m_ShadowChunkMask[i][0];
+        }
+        m_Dosei.SetChunkMask( pChunkMask );
+
+        // シャドウマップの解像度で詳細度を選択する.
+        m_ShadowLod[i] = SelectLod( world * m_ShadowMatrix[i], f32( SHADOW_MAP_SIZE ), f32( SHADOW_MAP_SIZE ) );
+
         // 描画キック.
-        m_Dosei.Draw ( m_pDeviceContext );
+        if ( m_EnableInstancing )
+        {
+            // インスタンスバッファは転送のたびに確保し直されるので, カスケードごとに詰め直して構わない.
+            m_InstanceBuffer.Cull(
+                &m_InstanceWorlds[0],
+                u32( m_InstanceWorlds.size() ),
+                asdx::BoundingSphere::CreateFromBoundingBox( m_Box_Dosei ),
+                m_ShadowMatrix[i] );
+            m_InstanceBuffer.Upload( m_pDeviceContext );
+            m_ShadowInstanceStats[i] = m_InstanceBuffer.GetStatistics();
+
+            m_ShadowCullResult[i].TotalTriangles   = m_Dosei.GetLodTriangleCount( 0 ) * m_ShadowInstanceStats[i].TestedCount;
+            m_ShadowCullResult[i].VisibleTriangles = m_Dosei.GetLodTriangleCount( m_ShadowLod[i] ) * m_ShadowInstanceStats[i].VisibleCount;
+            m_Dosei.DrawDepthOnlyInstanced( m_pDeviceContext, m_InstanceBuffer, m_ShadowLod[i] );
+        }
+        else if ( m_EnableStaticBatch )
+        {
+            m_StaticBatch.DrawDepthOnly( m_pDeviceContext, m_ShadowMatrix[i] );
+            m_ShadowBatchStats[i] = m_StaticBatch.GetStatistics();
+        }
+        else if ( m_EnableStreaming )
+        { m_StreamingMesh.DrawDepthOnly( m_pDeviceContext, world * m_ShadowMatrix[i] ); }
+        else if ( m_ShadowLod[i] > 0 )
+        {
+            m_ShadowCullResult[i].TotalTriangles   = m_Dosei.GetLodTriangleCount( 0 );
+            m_ShadowCullResult[i].VisibleTriangles = m_Dosei.GetLodTriangleCount( m_ShadowLod[i] );
+            m_Dosei.DrawDepthOnlyLod( m_pDeviceContext, m_ShadowLod[i] );
+        }
+        else if ( m_EnableMeshletCulling )
+        {
+            // シャドウマップは両面が描画され得るので, 法線コーンは使わない.
+            MeshClusterizer::CullView view;
+            view.WorldViewProj          = world * m_ShadowMatrix[i];
+            view.CameraPosition         = asdx::Vector3( 0.0f, 0.0f, 0.0f );
+            view.EnableCone             = false;
+            view.FrontCounterClockwise  = m_IsFrontCounterClockwise;
+
+            m_Dosei.GetClusterizer().Cull( view, m_ShadowCullResult[i] );
+            m_Dosei.DrawDepthOnly( m_pDeviceContext, m_ShadowCullResult[i] );
+        }
+        else
+        { m_Dosei.DrawDepthOnly( m_pDeviceContext ); }
     }
 
+    m_Dosei.SetChunkMask( nullptr );
+
+    // 使わないカスケードは影なしとして扱われるようにクリアしておく.
+    for( int i=m_SplitCount; i<MAX_CASCADE; ++i )
+    { m_pDeviceContext->ClearDepthStencilView( m_ShadowState.pDSV[i], D3D11_CLEAR_DEPTH, 1.0f, 0 ); }
+
+    m_pDeviceContext->RSSetState( m_pRS );
+
     m_pDeviceContext->VSSetShader( nullptr, nullptr, 0 );
     m_pDeviceContext->GSSetShader( nullptr, nullptr, 0 );
     m_pDeviceContext->PSSetShader( nullptr, nullptr, 0 );
@@ -837,8 +1820,8 @@ void SampleApp::ComputeShadowMatrixPSSM()
     // ライトの基底ベクトルを求める.
     m_LightBasis.InitFromW( lightDir );
 
-    // キャスターのAABB.
-    asdx::BoundingBox casterBox = m_Box_Dosei;
+    // キャスターのAABB. インスタンス描画・静的バッチでは全インスタンスを覆うAABBを使う.
+    asdx::BoundingBox casterBox = ( m_EnableInstancing || m_EnableStaticBatch ) ? m_Box_Instances : m_Box_Dosei;
 
     // 凸包.
     asdx::Vector3x8 convexHull;
@@ -959,29 +1942,247 @@ void SampleApp::ComputeShadowMatrixPSSM()
 
     // 平行分割処理.
     f32 splitPositions[ MAX_CASCADE + 1 ];
-    ComputeSplitPositions( 4, m_Lamda, nearClip, farClip, splitPositions );
+    ComputeSplitPositions( m_SplitCount, m_Lamda, nearClip, farClip, splitPositions );
+
+    //----------------------------------
+    // レシーバー駆動のキャスターカリング.
+    //----------------------------------
+    asdx::BoundingBox worldBox;
+    {
+        // ワールド空間でのAABBを求める.
+        asdx::Vector3 mini = convexHull[0];
+        asdx::Vector3 maxi = convexHull[0];
+        for( u32 i=1; i<convexHull.GetSize(); ++i )
+        {
+            mini = asdx::Vector3::Min( mini, convexHull[i] );
+            maxi = asdx::Vector3::Max( maxi, convexHull[i] );
+        }
+        worldBox = asdx::BoundingBox( mini, maxi );
+
+        // 調整済みのクリップ平面で可視レシーバー領域を求める.
+        asdx::Vector3 region[ 8 * MAX_EYE ];
+        u32 regionCount = CalculateFrustumCorners( nearClip, farClip, region );
+
+        m_CasterCuller.Begin( m_LightView, region, regionCount );
+        m_CasterCuller.AddReceiver( worldBox );
+
+        m_IsCasterVisible = m_CasterCuller.TestCaster( worldBox ) || !m_EnableCasterCulling;
+
+        // チャンクごとにもキャスターカリングを行う. ライト空間のフィッティングには全体のAABBを使ったままにする.
+        u32 chunkCount = m_Dosei.GetChunkCount();
+        m_ChunkBoxes .resize( chunkCount );
+        m_ChunkCaster.resize( chunkCount );
+        for( u32 i=0; i<chunkCount; ++i )
+        {
+            asdx::Vector3x8 corners;
+            m_Dosei.GetChunkBoundingBox( i ).GetCorners( corners );
+
+            asdx::Vector3 mini = asdx::Vector3::Transform( corners[0], world );
+            asdx::Vector3 maxi = mini;
+            for( u32 j=1; j<corners.GetSize(); ++j )
+            {
+                asdx::Vector3 val = asdx::Vector3::Transform( corners[j], world );
+                mini = asdx::Vector3::Min( mini, val );
+                maxi = asdx::Vector3::Max( maxi, val );
+            }
+
+            m_ChunkBoxes [i] = asdx::BoundingBox( mini, maxi );
+            m_ChunkCaster[i] = ( !m_EnableCasterCulling || m_CasterCuller.TestCaster( m_ChunkBoxes[i] ) ) ? 1 : 0;
+        }
+    }
 
     // カスケード処理.
-    for( u32 i=0; i<MAX_CASCADE; ++i )
+    // ステレオ時は両眼の視錐台をまとめた領域にフィッティングし, シャドウマップを共有する.
+    for( s32 i=0; i<m_SplitCount; ++i )
     {
-        // ライトのビュー射影行列.
-        m_ShadowMatrix[i] = m_LightView * m_LightProj;
+        m_SplitPos[i] = splitPositions[ i + 1 ];
+
+        // LiSPSMで歪ませる. 適用できない場合は正射影にフォールバック.
+        bool isWarped = false;
+        if ( m_EnableLiSPSM )
+        {
+            isWarped = ComputeLiSPSMMatrix(
+                splitPositions[ i + 0 ],
+                splitPositions[ i + 1 ],
+                convexHull,
+                m_ShadowMatrix[ i ] );
+        }
+
+        if ( !isWarped )
+        {
+            // ライトのビュー射影行列.
+            m_ShadowMatrix[i] = m_LightView * m_LightProj;
+
+            // 分割した視錘台の8角をもとめて，ライトのビュー射影空間でAABBを求める.
+            asdx::BoundingBox box = CalculateFrustum(
+                splitPositions[ i + 0 ],
+                splitPositions[ i + 1 ],
+                m_ShadowMatrix[ i ] );
+
+            // クロップ行列を求める.
+            asdx::Matrix crop = CreateCropMatrix( box );
+
+            // シャドウマップ行列を設定.
+            m_ShadowMatrix[i] = m_ShadowMatrix[i] * crop;
+        }
 
-        // 分割した視錘台の8角をもとめて，ライトのビュー射影空間でAABBを求める.
-        asdx::BoundingBox box = CalculateFrustum(
+        // 視点ごとにフィッティングした場合と比べた解像度を求める.
+        m_StereoTexelRatio[i] = ComputeStereoTexelRatio(
             splitPositions[ i + 0 ],
             splitPositions[ i + 1 ],
             m_ShadowMatrix[ i ] );
+    }
 
-        // クロップ行列を求める.
-        asdx::Matrix crop = CreateCropMatrix( box );
+    for( s32 i=m_SplitCount; i<MAX_CASCADE; ++i )
+    { m_StereoTexelRatio[i] = 1.0f; }
 
-        // シャドウマップ行列と分割位置を設定.
-        m_ShadowMatrix[i] = m_ShadowMatrix[i] * crop;
-        m_SplitPos[i]     = splitPositions[ i + 1 ];
+    // 使わないカスケードが選択されないように, 最後の分割を無限遠まで広げる.
+    for( s32 i=m_SplitCount - 1; i<MAX_CASCADE; ++i )
+    {
+        m_ShadowMatrix[i] = m_ShadowMatrix[ m_SplitCount - 1 ];
+        m_SplitPos[i]     = F32_MAX;
+    }
+
+    //----------------------------------
+    // カスケード間の重複除去.
+    //----------------------------------
+    {
+        f32 size   = f32( SHADOW_MAP_SIZE );
+        f32 border = SHADOW_COVERAGE_BORDER_TEXELS * 2.0f / size;
+        m_Coverage.Update( m_ShadowMatrix, u32( m_SplitCount ), border );
+
+        for( s32 i=0; i<m_SplitCount; ++i )
+        {
+            // キャスターが細かいカスケードだけに含まれる場合は描画しない.
+            m_DrawCasterInCascade[i] = !m_EnableCoverage || m_Coverage.TestBox( u32( i ), worldBox );
+
+            // チャンクも同様に判定しておく.
+            m_ShadowChunkMask[i].resize( m_ChunkBoxes.size() );
+            for( size_t j=0; j<m_ChunkBoxes.size(); ++j )
+            {
+                bool draw = ( m_ChunkCaster[j] != 0 ) && ( !m_EnableCoverage || m_Coverage.TestBox( u32( i ), m_ChunkBoxes[j] ) );
+                m_ShadowChunkMask[i][j] = ( draw ) ? 1 : 0;
+            }
+
+            // シザー矩形を求める. フィルタリング分として1テクセル広げておく.
+            CascadeCoverage::Rect rect;
+            D3D11_RECT& scissor = m_ShadowState.Scissor[i];
+            if ( m_Coverage.GetBoundingRect( u32( i ), rect ) )
+            {
+                scissor.left   = LONG( floorf( ( rect.MinX * 0.5f + 0.5f ) * size ) ) - 1;
+                scissor.right  = LONG( ceilf ( ( rect.MaxX * 0.5f + 0.5f ) * size ) ) + 1;
+                scissor.top    = LONG( floorf( ( 0.5f - rect.MaxY * 0.5f ) * size ) ) - 1;
+                scissor.bottom = LONG( ceilf ( ( 0.5f - rect.MinY * 0.5f ) * size ) ) + 1;
+
+                scissor.left   = asdx::Clamp< LONG >( scissor.left,   0, LONG( SHADOW_MAP_SIZE ) );
+                scissor.right  = asdx::Clamp< LONG >( scissor.right,  0, LONG( SHADOW_MAP_SIZE ) );
+                scissor.top    = asdx::Clamp< LONG >( scissor.top,    0, LONG( SHADOW_MAP_SIZE ) );
+                scissor.bottom = asdx::Clamp< LONG >( scissor.bottom, 0, LONG( SHADOW_MAP_SIZE ) );
+            }
+            else
+            {
+                scissor.left   = 0;
+                scissor.top    = 0;
+                scissor.right  = 0;
+                scissor.bottom = 0;
+                m_DrawCasterInCascade[i] = false;
+            }
+        }
     }
 }
 
+//---------------------------------------------------------------------------------------
+//      LiSPSM で歪ませたシャドウマップ行列を求めます.
+//---------------------------------------------------------------------------------------
+bool SampleApp::ComputeLiSPSMMatrix
+(
+    f32                     nearClip,
+    f32                     farClip,
+    const asdx::Vector3x8&  casterHull,
+    asdx::Matrix&           result
+)
+{
+    // ライトの方向ベクトルと視線ベクトル.
+    asdx::Vector3 lightDir = m_LightBasis.w;
+    asdx::Vector3 eyePos   = m_Camera.GetCamera().GetPosition();
+    asdx::Vector3 viewDir  = m_Camera.GetCamera().GetTarget() - eyePos;
+    viewDir.Normalize();
+
+    // ライトと視線のなす角.
+    f32 cosGamma = asdx::Vector3::Dot( lightDir, viewDir );
+    f32 sinGamma = sqrtf( asdx::Max( 1.0f - cosGamma * cosGamma, 0.0f ) );
+    if ( sinGamma < LISPSM_MIN_SIN_GAMMA )
+    { return false; }
+
+    // 視線ベクトルをライトに垂直な平面に射影したものを歪ませる軸(ライト空間のY軸)とする.
+    asdx::Vector3 up = viewDir - lightDir * cosGamma;
+    up.Normalize();
+
+    asdx::Matrix lightView = asdx::Matrix::CreateLookTo( eyePos, lightDir, up );
+
+    // 分割した視錐台の8角をライト空間に変換.
+    asdx::Vector3 body[ 8 * MAX_EYE ];
+    u32 bodyCount = CalculateFrustumCorners( nearClip, farClip, body );
+
+    f32 bodyMinY =  F32_MAX;
+    f32 bodyMaxY = -F32_MAX;
+    for( u32 i=0; i<bodyCount; ++i )
+    {
+        f32 y = asdx::Vector3::TransformCoord( body[i], lightView ).y;
+        bodyMinY = asdx::Min( bodyMinY, y );
+        bodyMaxY = asdx::Max( bodyMaxY, y );
+    }
+
+    // キャスターが射影中心の後ろに回り込まないようにする.
+    f32 minY = bodyMinY;
+    for( u32 i=0; i<casterHull.GetSize(); ++i )
+    {
+        f32 y = asdx::Vector3::TransformCoord( casterHull[i], lightView ).y;
+        minY = asdx::Min( minY, y );
+    }
+
+    // 最適なニア平面までの距離を求める.
+    // ※ M. Wimmer, D. Scherzer, W. Purgathofer, "Light Space Perspective Shadow Maps", EGSR 2004 を参照.
+    f32 nOpt = ( nearClip + sqrtf( nearClip * farClip ) ) / sinGamma;
+
+    // 射影中心はライト空間での視点の真上, 視錐台の手前 nOpt の位置.
+    f32 centerY = minY - nOpt;
+    f32 n       = bodyMinY - centerY;
+    f32 f       = asdx::Max( bodyMaxY - centerY, n + 1.0f );
+
+    // Y軸方向の透視変換(w = y). Z軸はライトからの距離が正になるように反転しておく.
+    asdx::Matrix warp(
+        1.0f,  0.0f,                        0.0f,  0.0f,
+        0.0f,  ( f + n ) / ( f - n ),       0.0f,  1.0f,
+        0.0f,  0.0f,                       -1.0f,  0.0f,
+        0.0f,  -2.0f * f * n / ( f - n ),   0.0f,  0.0f );
+
+    asdx::Matrix viewProj = lightView
+                          * asdx::Matrix::CreateTranslation( 0.0f, -centerY, 0.0f )
+                          * warp;
+
+    // XYは分割した視錐台に, Zはキャスターも含めてフィッティングする.
+    asdx::Vector3 point = asdx::Vector3::TransformCoord( body[0], viewProj );
+    asdx::Vector3 mini  = point;
+    asdx::Vector3 maxi  = point;
+    for( u32 i=1; i<bodyCount; ++i )
+    {
+        point = asdx::Vector3::TransformCoord( body[i], viewProj );
+        mini  = asdx::Vector3::Min( mini, point );
+        maxi  = asdx::Vector3::Max( maxi, point );
+    }
+
+    for( u32 i=0; i<casterHull.GetSize(); ++i )
+    {
+        point  = asdx::Vector3::TransformCoord( casterHull[i], viewProj );
+        mini.z = asdx::Min( mini.z, point.z );
+        maxi.z = asdx::Max( maxi.z, point.z );
+    }
+
+    result = viewProj * CreateUnitCubeClipMatrix( mini, maxi );
+    return true;
+}
+
 //---------------------------------------------------------------------------------------
 //      単位キューブクリッピング行列を作成します.
 //---------------------------------------------------------------------------------------
@@ -1155,24 +2356,64 @@ asdx::BoundingBox SampleApp::CalculateFrustum
     asdx::Matrix& viewProj
 )
 {
-    asdx::Camera camera = m_Camera.GetCamera();
-    asdx::Vector3 vZ = ( camera.GetTarget() - camera.GetPosition() ).Normalize();
-    asdx::Vector3 vX = ( asdx::Vector3::Cross( camera.GetUpward(), vZ ) ).Normalize();
-    asdx::Vector3 vY = ( asdx::Vector3::Cross( vZ, vX ) ).Normalize();
+    asdx::Vector3 corners[ 8 * MAX_EYE ];
+    u32 count = CalculateFrustumCorners( nearClip, farClip, corners );
 
-    f32 aspect = m_AspectRatio;
-    f32 fov    = m_CameraFov;
+    asdx::Vector3 point = asdx::Vector3::TransformCoord( corners[0], viewProj );
+    asdx::Vector3 mini = point;
+    asdx::Vector3 maxi = point;
+    for( u32 i=1; i<count; ++i )
+    {
+        point = asdx::Vector3::TransformCoord( corners[i], viewProj );
+        mini  = asdx::Vector3::Min( point, mini );
+        maxi  = asdx::Vector3::Max( point, maxi );
+    }
+
+    return asdx::BoundingBox( mini, maxi );
+}
+
+//---------------------------------------------------------------------------------------
+//      全視点の視錘台の8角を求めます.
+//---------------------------------------------------------------------------------------
+u32 SampleApp::CalculateFrustumCorners
+(
+    f32 nearClip,
+    f32 farClip,
+    asdx::Vector3* corners
+)
+{
+    EyeFrustum eyes[ MAX_EYE ];
+    u32 eyeCount = GetEyeFrustums( eyes );
 
-    f32 nearPlaneHalfHeight = tanf( fov * 0.5f ) * nearClip;
-    f32 nearPlaneHalfWidth  = nearPlaneHalfHeight * aspect;
+    for( u32 i=0; i<eyeCount; ++i )
+    { CalculateFrustumCorners( eyes[i], nearClip, farClip, &corners[ i * 8 ] ); }
 
-    f32 farPlaneHalfHeight = tanf( fov * 0.5f ) * farClip;
-    f32 farPlaneHalfWidth  = farPlaneHalfHeight * aspect;
+    return eyeCount * 8;
+}
 
-    asdx::Vector3 nearPlaneCenter = camera.GetPosition() + vZ * nearClip;
-    asdx::Vector3 farPlaneCenter  = camera.GetPosition() + vZ * farClip;;
+//---------------------------------------------------------------------------------------
+//      視錘台の8角を求めます.
+//---------------------------------------------------------------------------------------
+void SampleApp::CalculateFrustumCorners
+(
+    const EyeFrustum& eye,
+    f32 nearClip,
+    f32 farClip,
+    asdx::Vector3* corners
+)
+{
+    const asdx::Vector3& vX = eye.Right;
+    const asdx::Vector3& vY = eye.Upward;
+    const asdx::Vector3& vZ = eye.Forward;
 
-    asdx::Vector3 corners[8];
+    f32 nearPlaneHalfHeight = tanf( eye.Fov * 0.5f ) * nearClip;
+    f32 nearPlaneHalfWidth  = nearPlaneHalfHeight * eye.Aspect;
+
+    f32 farPlaneHalfHeight = tanf( eye.Fov * 0.5f ) * farClip;
+    f32 farPlaneHalfWidth  = farPlaneHalfHeight * eye.Aspect;
+
+    asdx::Vector3 nearPlaneCenter = eye.Position + vZ * nearClip;
+    asdx::Vector3 farPlaneCenter  = eye.Position + vZ * farClip;
 
     corners[0] = asdx::Vector3( nearPlaneCenter - vX * nearPlaneHalfWidth - vY * nearPlaneHalfHeight );
     corners[1] = asdx::Vector3( nearPlaneCenter - vX * nearPlaneHalfWidth + vY * nearPlaneHalfHeight );
@@ -1183,18 +2424,105 @@ asdx::BoundingBox SampleApp::CalculateFrustum
     corners[5] = asdx::Vector3( farPlaneCenter - vX * farPlaneHalfWidth + vY * farPlaneHalfHeight );
     corners[6] = asdx::Vector3( farPlaneCenter + vX * farPlaneHalfWidth + vY * farPlaneHalfHeight );
     corners[7] = asdx::Vector3( farPlaneCenter + vX * farPlaneHalfWidth - vY * farPlaneHalfHeight );
+}
 
-    asdx::Vector3 point = asdx::Vector3::TransformCoord( corners[0], viewProj );
-    asdx::Vector3 mini = point;
-    asdx::Vector3 maxi = point;
-    for( int i=1; i<8; ++i )
+//---------------------------------------------------------------------------------------
+//      視点ごとの視錘台を取得します.
+//---------------------------------------------------------------------------------------
+u32 SampleApp::GetEyeFrustums( EyeFrustum* pEyes )
+{
+    asdx::Camera camera = m_Camera.GetCamera();
+
+    EyeFrustum center;
+    center.Forward  = ( camera.GetTarget() - camera.GetPosition() ).Normalize();
+    center.Right    = ( asdx::Vector3::Cross( camera.GetUpward(), center.Forward ) ).Normalize();
+    center.Upward   = ( asdx::Vector3::Cross( center.Forward, center.Right ) ).Normalize();
+    center.Position = camera.GetPosition();
+    center.Fov      = m_CameraFov;
+    center.Aspect   = m_AspectRatio;
+
+    if ( !m_EnableStereo )
     {
-        point = asdx::Vector3::TransformCoord( corners[i], viewProj );
-        mini  = asdx::Vector3::Min( point, mini );
-        maxi  = asdx::Vector3::Max( point, maxi );
+        pEyes[0] = center;
+        return 1;
     }
 
-    return asdx::BoundingBox( mini, maxi );
+    // 両眼は視線方向を共有し, 左右にずらすだけなのでニア・ファーも共有できる.
+    f32 offset = m_EyeSeparation * 0.5f;
+
+    pEyes[0] = center;
+    pEyes[0].Position = center.Position - center.Right * offset;
+
+    pEyes[1] = center;
+    pEyes[1].Position = center.Position + center.Right * offset;
+
+    return 2;
+}
+
+//---------------------------------------------------------------------------------------
+//      視点ごとにフィッティングした場合に対する共有シャドウマップの解像度比を求めます.
+//---------------------------------------------------------------------------------------
+f32 SampleApp::ComputeStereoTexelRatio
+(
+    f32 nearClip,
+    f32 farClip,
+    const asdx::Matrix& shadowMatrix
+)
+{
+    EyeFrustum eyes[ MAX_EYE ];
+    u32 eyeCount = GetEyeFrustums( eyes );
+    if ( eyeCount <= 1 )
+    { return 1.0f; }
+
+    f32 unionMinX =  F32_MAX;
+    f32 unionMinY =  F32_MAX;
+    f32 unionMaxX = -F32_MAX;
+    f32 unionMaxY = -F32_MAX;
+    f32 eyeArea[ MAX_EYE ];
+
+    for( u32 i=0; i<eyeCount; ++i )
+    {
+        asdx::Vector3 corners[ 8 ];
+        CalculateFrustumCorners( eyes[i], nearClip, farClip, corners );
+
+        f32 minX =  F32_MAX;
+        f32 minY =  F32_MAX;
+        f32 maxX = -F32_MAX;
+        f32 maxY = -F32_MAX;
+        for( u32 j=0; j<8; ++j )
+        {
+            asdx::Vector3 point = asdx::Vector3::TransformCoord( corners[j], shadowMatrix );
+            minX = asdx::Min( minX, point.x );
+            minY = asdx::Min( minY, point.y );
+            maxX = asdx::Max( maxX, point.x );
+            maxY = asdx::Max( maxY, point.y );
+        }
+
+        // シャドウマップからはみ出した部分はどちらの場合も使われない.
+        minX = asdx::Clamp( minX, -1.0f, 1.0f );
+        minY = asdx::Clamp( minY, -1.0f, 1.0f );
+        maxX = asdx::Clamp( maxX, -1.0f, 1.0f );
+        maxY = asdx::Clamp( maxY, -1.0f, 1.0f );
+
+        eyeArea[i] = ( maxX - minX ) * ( maxY - minY );
+
+        unionMinX = asdx::Min( unionMinX, minX );
+        unionMinY = asdx::Min( unionMinY, minY );
+        unionMaxX = asdx::Max( unionMaxX, maxX );
+        unionMaxY = asdx::Max( unionMaxY, maxY );
+    }
+
+    f32 unionArea = ( unionMaxX - unionMinX ) * ( unionMaxY - unionMinY );
+    if ( unionArea <= 0.0f )
+    { return 1.0f; }
+
+    // 視点ごとにフィッティングすれば各視点の領域がシャドウマップ全体に広がるので,
+    // 面積比がそのままテクセル数の比になる. 最も損をする視点の値を返す.
+    f32 result = 1.0f;
+    for( u32 i=0; i<eyeCount; ++i )
+    { result = asdx::Min( result, eyeArea[i] / unionArea ); }
+
+    return result;
 }
 
 //---------------------------------------------------------------------------------------
@@ -1228,6 +2556,9 @@ void SampleApp::OnKey( const asdx::KeyEventParam& param )
                 m_LightRotX = asdx::F_PIDIV4;
                 m_LightRotY = asdx::F_PIDIV2;
                 m_Lamda = 0.5f;
+                m_EnableLiSPSM = false;
+                m_SplitCount   = MAX_CASCADE;
+                m_EnableStereo = false;
             }
             break;
 
@@ -1250,6 +2581,67 @@ void SampleApp::OnKey( const asdx::KeyEventParam& param )
         case 'H':
             { m_ShowTexture = (!m_ShowTexture); }
             break;
+
+        case 'C':
+            { m_EnableCasterCulling = (!m_EnableCasterCulling); }
+            break;
+
+        case 'L':
+            { m_EnableLiSPSM = (!m_EnableLiSPSM); }
+            break;
+
+        case 'N':
+            { m_SplitCount = ( m_SplitCount % MAX_CASCADE ) + 1; }
+            break;
+
+        case 'O':
+            { m_EnableCoverage = (!m_EnableCoverage); }
+            break;
+
+        case 'E':
+            { m_EnableStereo = (!m_EnableStereo); }
+            break;
+
+        case 'M':
+            { m_EnableMeshletCulling = (!m_EnableMeshletCulling); }
+            break;
+
+        case 'K':
+            { m_EnableLod = (!m_EnableLod); }
+            break;
+
+        case 'G':
+            {
+                m_EnableInstancing  = (!m_EnableInstancing);
+                m_EnableStaticBatch = false;
+                m_EnableStreaming   = false;
+            }
+            break;
+
+        case 'B':
+            {
+                m_EnableStaticBatch = (!m_EnableStaticBatch);
+                m_EnableInstancing  = false;
+                m_EnableStreaming   = false;
+            }
+            break;
+
+        case 'T':
+            {
+                // ストリーミング用のファイルが無い場合は切り替えない.
+                m_EnableStreaming   = (!m_EnableStreaming) && m_StreamingMesh.IsValid();
+                m_EnableInstancing  = false;
+                m_EnableStaticBatch = false;
+            }
+            break;
+
+        case 'P':
+            { m_EnableChunkCulling = (!m_EnableChunkCulling); }
+            break;
+
+        case 'V':
+            { m_EnableOcclusionCulling = (!m_EnableOcclusionCulling); }
+            break;
         }
     }
 }
\ No newline at end of file
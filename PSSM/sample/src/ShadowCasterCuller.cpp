@@ -0,0 +1,164 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ShadowCasterCuller.cpp
+// Desc : Receiver Driven Shadow Caster Culling Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ShadowCasterCuller.h>
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ShadowCasterCuller class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+ShadowCasterCuller::ShadowCasterCuller()
+: m_LightView   ()
+, m_Region      ()
+, m_Receivers   ()
+, m_Statistics  ()
+{
+    m_LightView.Identity();
+    m_Region.MinX = m_Region.MinY = m_Region.MinZ = 0.0f;
+    m_Region.MaxX = m_Region.MaxY = m_Region.MaxZ = 0.0f;
+}
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+ShadowCasterCuller::~ShadowCasterCuller()
+{ m_Receivers.clear(); }
+
+//-----------------------------------------------------------------------------------
+//      フレームの開始処理です.
+//-----------------------------------------------------------------------------------
+void ShadowCasterCuller::Begin
+(
+    const asdx::Matrix&     lightView,
+    const asdx::Vector3*    pRegion,
+    u32                     count
+)
+{
+    m_LightView  = lightView;
+    m_Statistics = Statistics();
+    m_Receivers.clear();
+
+    ComputeRect( pRegion, count, m_Region );
+}
+
+//-----------------------------------------------------------------------------------
+//      可視レシーバーを追加します.
+//-----------------------------------------------------------------------------------
+void ShadowCasterCuller::AddReceiver( const asdx::BoundingBox& box )
+{
+    Rect rect;
+    ComputeRect( box, rect );
+
+    // 可視レシーバー領域でクリップする.
+    rect.MinX = asdx::Max( rect.MinX, m_Region.MinX );
+    rect.MinY = asdx::Max( rect.MinY, m_Region.MinY );
+    rect.MinZ = asdx::Max( rect.MinZ, m_Region.MinZ );
+    rect.MaxX = asdx::Min( rect.MaxX, m_Region.MaxX );
+    rect.MaxY = asdx::Min( rect.MaxY, m_Region.MaxY );
+    rect.MaxZ = asdx::Min( rect.MaxZ, m_Region.MaxZ );
+
+    // 領域外のレシーバーは見えないので登録しない.
+    if ( rect.MinX > rect.MaxX || rect.MinY > rect.MaxY || rect.MinZ > rect.MaxZ )
+    { return; }
+
+    m_Receivers.push_back( rect );
+    m_Statistics.ReceiverCount++;
+}
+
+//-----------------------------------------------------------------------------------
+//      キャスターの影が可視レシーバーに落ちるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool ShadowCasterCuller::TestCaster( const asdx::BoundingBox& box )
+{
+    m_Statistics.TestedCasters++;
+
+    // ライトのビュー行列は右手系なので, ライトから遠いほど深度は小さくなる.
+    // キャスターをライト方向に押し出した影領域は, XY矩形が同じで深度が (-∞, MaxZ] となる.
+    Rect caster;
+    ComputeRect( box, caster );
+
+    if ( m_Receivers.empty() )
+    {
+        if ( caster.MaxX >= m_Region.MinX && caster.MinX <= m_Region.MaxX
+          && caster.MaxY >= m_Region.MinY && caster.MinY <= m_Region.MaxY
+          && m_Region.MinZ <= caster.MaxZ )
+        { return true; }
+    }
+    else
+    {
+        for( size_t i=0; i<m_Receivers.size(); ++i )
+        {
+            const Rect& receiver = m_Receivers[i];
+            if ( caster.MaxX >= receiver.MinX && caster.MinX <= receiver.MaxX
+              && caster.MaxY >= receiver.MinY && caster.MinY <= receiver.MaxY
+              && receiver.MinZ <= caster.MaxZ )
+            { return true; }
+        }
+    }
+
+    m_Statistics.CulledCasters++;
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const ShadowCasterCuller::Statistics& ShadowCasterCuller::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      点群のライト空間での範囲を求めます.
+//-----------------------------------------------------------------------------------
+void ShadowCasterCuller::ComputeRect( const asdx::Vector3* pPoints, u32 count, Rect& result ) const
+{
+    if ( pPoints == nullptr || count == 0 )
+    {
+        result.MinX = result.MinY = result.MinZ = 0.0f;
+        result.MaxX = result.MaxY = result.MaxZ = 0.0f;
+        return;
+    }
+
+    asdx::Vector3 point = asdx::Vector3::TransformCoord( pPoints[0], m_LightView );
+    asdx::Vector3 mini  = point;
+    asdx::Vector3 maxi  = point;
+    for( u32 i=1; i<count; ++i )
+    {
+        point = asdx::Vector3::TransformCoord( pPoints[i], m_LightView );
+        mini  = asdx::Vector3::Min( mini, point );
+        maxi  = asdx::Vector3::Max( maxi, point );
+    }
+
+    result.MinX = mini.x;
+    result.MinY = mini.y;
+    result.MinZ = mini.z;
+    result.MaxX = maxi.x;
+    result.MaxY = maxi.y;
+    result.MaxZ = maxi.z;
+}
+
+//-----------------------------------------------------------------------------------
+//      AABBのライト空間での範囲を求めます.
+//-----------------------------------------------------------------------------------
+void ShadowCasterCuller::ComputeRect( const asdx::BoundingBox& box, Rect& result ) const
+{
+    asdx::Vector3 corners[ 8 ];
+    for( u32 i=0; i<8; ++i )
+    {
+        corners[i] = asdx::Vector3(
+            ( i & 0x1 ) ? box.maxi.x : box.mini.x,
+            ( i & 0x2 ) ? box.maxi.y : box.mini.y,
+            ( i & 0x4 ) ? box.maxi.z : box.mini.z );
+    }
+
+    ComputeRect( corners, 8, result );
+}
@@ -0,0 +1,366 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StaticBatch.cpp
+// Desc : Static Geometry Batch Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <StaticBatch.h>
+#include <PackedVertex.h>
+#include <FrustumCulling.h>
+#include <asdxLog.h>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です.
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT =
+{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です(圧縮頂点用).
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT_PACKED =
+{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      後ろの描画を前の描画に続けて1回で描画できるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool CanMerge( const StaticBatchBuilder::Draw& prev, const StaticBatchBuilder::Draw& next )
+{
+    return ( prev.MaterialID == next.MaterialID )
+        && ( prev.BaseVertex == next.BaseVertex )
+        && ( prev.StartIndex + prev.IndexCount == next.StartIndex );
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// StaticBatch class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+StaticBatch::StaticBatch()
+: m_pVB         ( nullptr )
+, m_pDepthVB    ( nullptr )
+, m_pIB         ( nullptr )
+, m_pIL         ( nullptr )
+, m_pDepthIL    ( nullptr )
+, m_Stride      ( 0 )
+, m_DepthStride ( 0 )
+, m_IndexFormat ( DXGI_FORMAT_R32_UINT )
+, m_Draws       ()
+, m_DepthDraws  ()
+, m_Dequantize  ()
+, m_Bounds      ()
+, m_Statistics  ()
+{ m_Dequantize.Identity(); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+StaticBatch::~StaticBatch()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool StaticBatch::Init
+(
+    ID3D11Device*               pDevice,
+    const StaticBatchBuilder&   builder,
+    bool                        usePackedVertex,
+    const void*                 pShaderBytecode,
+    const u32                   byteCodeLength,
+    const void*                 pDepthShaderBytecode,
+    const u32                   depthByteCodeLength
+)
+{
+    Term();
+
+    const std::vector< asdx::ResMesh::Vertex >& vertices = builder.GetVertices();
+    const std::vector< u32 >&                   indices  = builder.GetIndices();
+    if ( pDevice == nullptr || vertices.empty() || indices.empty() )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    const u32 vertexCount = u32( vertices.size() );
+    const u32 indexCount  = u32( indices.size() );
+
+    m_Bounds = builder.GetBounds();
+    const asdx::Vector3& mini = m_Bounds.mini;
+    const asdx::Vector3& maxi = m_Bounds.maxi;
+
+    // 頂点プールの生成. 圧縮する場合は全体のAABBで量子化する.
+    if ( usePackedVertex )
+    {
+        std::vector< PackedVertex > packed( vertexCount );
+        PackVertices( &vertices[0], vertexCount, mini, maxi, &packed[0] );
+
+        m_Stride     = sizeof( PackedVertex );
+        m_Dequantize = ComputeDequantizeMatrix( mini, maxi );
+        if ( !CreateBuffer( pDevice, D3D11_BIND_VERTEX_BUFFER, &packed[0], m_Stride * vertexCount, &m_pVB ) )
+        { Term(); return false; }
+    }
+    else
+    {
+        m_Stride = sizeof( asdx::ResMesh::Vertex );
+        if ( !CreateBuffer( pDevice, D3D11_BIND_VERTEX_BUFFER, &vertices[0], m_Stride * vertexCount, &m_pVB ) )
+        { Term(); return false; }
+    }
+
+    // 位置座標だけの頂点プールの生成. 深度の値を一致させるため圧縮方法も揃える.
+    {
+        m_DepthStride = ( usePackedVertex ) ? sizeof( u16 ) * 4 : sizeof( asdx::Vector3 );
+
+        std::vector< u8 > positions( vertexCount * m_DepthStride );
+        for( u32 i=0; i<vertexCount; ++i )
+        {
+            u8* ptr = &positions[ i * m_DepthStride ];
+            if ( usePackedVertex )
+            { PackPosition( vertices[i].Position, mini, maxi, reinterpret_cast<u16*>( ptr ) ); }
+            else
+            { memcpy( ptr, &vertices[i].Position, m_DepthStride ); }
+        }
+
+        if ( !CreateBuffer( pDevice, D3D11_BIND_VERTEX_BUFFER, &positions[0], u32( positions.size() ), &m_pDepthVB ) )
+        { Term(); return false; }
+    }
+
+    // インデックスプールの生成. 頂点番号はメッシュごとの相対値なので, 多くの場合16bitに収まる.
+    if ( builder.CanUse16BitIndex() )
+    {
+        std::vector< u16 > indices16( indexCount );
+        for( u32 i=0; i<indexCount; ++i )
+        { indices16[i] = u16( indices[i] ); }
+
+        m_IndexFormat = DXGI_FORMAT_R16_UINT;
+        if ( !CreateBuffer( pDevice, D3D11_BIND_INDEX_BUFFER, &indices16[0], sizeof( u16 ) * indexCount, &m_pIB ) )
+        { Term(); return false; }
+    }
+    else
+    {
+        m_IndexFormat = DXGI_FORMAT_R32_UINT;
+        if ( !CreateBuffer( pDevice, D3D11_BIND_INDEX_BUFFER, &indices[0], sizeof( u32 ) * indexCount, &m_pIB ) )
+        { Term(); return false; }
+    }
+
+    // 入力レイアウトの生成.
+    {
+        const D3D11_INPUT_ELEMENT_DESC* pElements    = ( usePackedVertex ) ? PackedVertex::INPUT_ELEMENTS    : asdx::ResMesh::INPUT_ELEMENTS;
+        const u32                       elementCount = ( usePackedVertex ) ? PackedVertex::NUM_INPUT_ELEMENT : asdx::ResMesh::NUM_INPUT_ELEMENT;
+
+        HRESULT hr = pDevice->CreateInputLayout( pElements, elementCount, pShaderBytecode, byteCodeLength, &m_pIL );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+            Term();
+            return false;
+        }
+
+        const D3D11_INPUT_ELEMENT_DESC& element = ( usePackedVertex ) ? DEPTH_INPUT_ELEMENT_PACKED : DEPTH_INPUT_ELEMENT;
+
+        hr = pDevice->CreateInputLayout( &element, 1, pDepthShaderBytecode, depthByteCodeLength, &m_pDepthIL );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+            Term();
+            return false;
+        }
+    }
+
+    m_Draws      = builder.GetDraws();
+    m_DepthDraws = builder.GetDepthDraws();
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void StaticBatch::Term()
+{
+    ASDX_RELEASE( m_pVB );
+    ASDX_RELEASE( m_pDepthVB );
+    ASDX_RELEASE( m_pIB );
+    ASDX_RELEASE( m_pIL );
+    ASDX_RELEASE( m_pDepthIL );
+
+    m_Stride      = 0;
+    m_DepthStride = 0;
+    m_IndexFormat = DXGI_FORMAT_R32_UINT;
+    m_Draws     .clear();
+    m_DepthDraws.clear();
+    m_Dequantize.Identity();
+    m_Bounds      = asdx::BoundingBox();
+    m_Statistics  = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入る描画をまとめて描画します.
+//-----------------------------------------------------------------------------------
+void StaticBatch::Draw
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    const asdx::Matrix&     viewProj,
+    const MaterialBinder&   binder
+)
+{
+    m_Statistics = Statistics();
+    if ( m_pVB == nullptr || m_Draws.empty() )
+    { return; }
+
+    Bind( pDeviceContext, m_pVB, m_Stride, m_pIL );
+
+    asdx::BoundingFrustum frustum( viewProj );
+    m_Statistics.TestedCount = u32( m_Draws.size() );
+
+    // マテリアル順に並んでいるので, 見える描画だけを拾って隣り合うものはまとめて発行する.
+    StaticBatchBuilder::Draw pending;
+    bool                     hasPending    = false;
+    u32                      boundMaterial = 0;
+
+    for( size_t i=0; i<m_Draws.size(); ++i )
+    {
+        const StaticBatchBuilder::Draw& draw = m_Draws[i];
+        if ( IsOutside( frustum, draw.Bounds ) )
+        { continue; }
+
+        m_Statistics.VisibleCount++;
+
+        if ( hasPending && CanMerge( pending, draw ) )
+        {
+            pending.IndexCount += draw.IndexCount;
+            continue;
+        }
+
+        if ( hasPending )
+        {
+            pDeviceContext->DrawIndexed( pending.IndexCount, pending.StartIndex, pending.BaseVertex );
+            m_Statistics.DrawCallCount++;
+        }
+
+        if ( !hasPending || boundMaterial != draw.MaterialID )
+        {
+            if ( binder )
+            { binder( pDeviceContext, draw.MaterialID ); }
+
+            boundMaterial = draw.MaterialID;
+            m_Statistics.MaterialChangeCount++;
+        }
+
+        pending    = draw;
+        hasPending = true;
+    }
+
+    if ( hasPending )
+    {
+        pDeviceContext->DrawIndexed( pending.IndexCount, pending.StartIndex, pending.BaseVertex );
+        m_Statistics.DrawCallCount++;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入るメッシュの深度のみを描画します.
+//-----------------------------------------------------------------------------------
+void StaticBatch::DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const asdx::Matrix& viewProj )
+{
+    m_Statistics = Statistics();
+    if ( m_pDepthVB == nullptr || m_DepthDraws.empty() )
+    { return; }
+
+    Bind( pDeviceContext, m_pDepthVB, m_DepthStride, m_pDepthIL );
+
+    asdx::BoundingFrustum frustum( viewProj );
+    m_Statistics.TestedCount = u32( m_DepthDraws.size() );
+
+    for( size_t i=0; i<m_DepthDraws.size(); ++i )
+    {
+        const StaticBatchBuilder::Draw& draw = m_DepthDraws[i];
+        if ( IsOutside( frustum, draw.Bounds ) )
+        { continue; }
+
+        pDeviceContext->DrawIndexed( draw.IndexCount, draw.StartIndex, draw.BaseVertex );
+        m_Statistics.VisibleCount++;
+        m_Statistics.DrawCallCount++;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      位置座標の逆量子化行列を取得します.
+//-----------------------------------------------------------------------------------
+const asdx::Matrix& StaticBatch::GetDequantizeMatrix() const
+{ return m_Dequantize; }
+
+//-----------------------------------------------------------------------------------
+//      全体のAABBを取得します.
+//-----------------------------------------------------------------------------------
+const asdx::BoundingBox& StaticBatch::GetBounds() const
+{ return m_Bounds; }
+
+//-----------------------------------------------------------------------------------
+//      最後に行った描画の統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const StaticBatch::Statistics& StaticBatch::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      バッファを生成します.
+//-----------------------------------------------------------------------------------
+bool StaticBatch::CreateBuffer
+(
+    ID3D11Device*   pDevice,
+    UINT            bindFlags,
+    const void*     pData,
+    u32             size,
+    ID3D11Buffer**  ppBuffer
+)
+{
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Usage          = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth      = size;
+    desc.BindFlags      = bindFlags;
+    desc.CPUAccessFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA res;
+    ZeroMemory( &res, sizeof( res ) );
+    res.pSysMem = pData;
+
+    HRESULT hr = pDevice->CreateBuffer( &desc, &res, ppBuffer );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点プールとインデックスプールを設定します.
+//-----------------------------------------------------------------------------------
+void StaticBatch::Bind
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    ID3D11Buffer*           pVB,
+    u32                     stride,
+    ID3D11InputLayout*      pIL
+)
+{
+    u32 offset = 0;
+    pDeviceContext->IASetInputLayout( pIL );
+    pDeviceContext->IASetVertexBuffers( 0, 1, &pVB, &stride, &offset );
+    pDeviceContext->IASetIndexBuffer( m_pIB, m_IndexFormat, 0 );
+    pDeviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+}
@@ -0,0 +1,247 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StaticBatchBuilder.cpp
+// Desc : Static Geometry Batch Builder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <StaticBatchBuilder.h>
+#include <asdxLog.h>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      マテリアル番号で比較します.
+//-----------------------------------------------------------------------------------
+bool LessMaterial( const StaticBatchBuilder::Draw& a, const StaticBatchBuilder::Draw& b )
+{ return a.MaterialID < b.MaterialID; }
+
+//-----------------------------------------------------------------------------------
+//      インデックス範囲が参照する頂点のAABBを求めます.
+//-----------------------------------------------------------------------------------
+asdx::BoundingBox ComputeBounds
+(
+    const asdx::ResMesh::Vertex*    pVertices,
+    const u32*                      pIndices,
+    u32                             indexCount
+)
+{
+    asdx::Vector3 mini = pVertices[ pIndices[0] ].Position;
+    asdx::Vector3 maxi = mini;
+
+    for( u32 i=1; i<indexCount; ++i )
+    {
+        const asdx::Vector3& pos = pVertices[ pIndices[i] ].Position;
+        mini = asdx::Vector3::Min( mini, pos );
+        maxi = asdx::Vector3::Max( maxi, pos );
+    }
+
+    return asdx::BoundingBox( mini, maxi );
+}
+
+//-----------------------------------------------------------------------------------
+//      2つのAABBを合わせたAABBを求めます.
+//-----------------------------------------------------------------------------------
+asdx::BoundingBox MergeBounds( const asdx::BoundingBox& a, const asdx::BoundingBox& b )
+{
+    return asdx::BoundingBox(
+        asdx::Vector3::Min( a.mini, b.mini ),
+        asdx::Vector3::Max( a.maxi, b.maxi ) );
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// StaticBatchBuilder class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+StaticBatchBuilder::StaticBatchBuilder()
+: m_Vertices        ()
+, m_Indices         ()
+, m_Draws           ()
+, m_DepthDraws      ()
+, m_Bounds          ()
+, m_MaxSourceVertex ( 0 )
+, m_Statistics      ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+StaticBatchBuilder::~StaticBatchBuilder()
+{ Clear(); }
+
+//-----------------------------------------------------------------------------------
+//      追加したメッシュを全て削除します.
+//-----------------------------------------------------------------------------------
+void StaticBatchBuilder::Clear()
+{
+    m_Vertices  .clear();
+    m_Indices   .clear();
+    m_Draws     .clear();
+    m_DepthDraws.clear();
+
+    m_Bounds          = asdx::BoundingBox();
+    m_MaxSourceVertex = 0;
+    m_Statistics      = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      メッシュを追加します.
+//-----------------------------------------------------------------------------------
+bool StaticBatchBuilder::Add( const asdx::ResMesh& mesh, const asdx::Matrix& world, u32 materialOffset )
+{
+    const u32 vertexCount = mesh.GetVertexCount();
+    const u32 indexCount  = mesh.GetIndexCount();
+
+    if ( mesh.GetVertices() == nullptr || mesh.GetIndices() == nullptr || vertexCount == 0 || indexCount == 0 )
+    {
+        ELOG( "Error : Invalid Mesh." );
+        return false;
+    }
+
+    // 32bitの範囲を超える場合は追加できない.
+    if ( u64( m_Vertices.size() ) + vertexCount > u64( 0x7fffffff )
+      || u64( m_Indices.size() )  + indexCount  > u64( 0xffffffff ) )
+    {
+        ELOG( "Error : Batch Size Overflow." );
+        return false;
+    }
+
+    const u32 sourceId   = u32( m_DepthDraws.size() );
+    const u32 baseVertex = u32( m_Vertices.size() );
+    const u32 startIndex = u32( m_Indices.size() );
+
+    // 法線ベクトルは逆転置行列で変換しないと不均一な拡大縮小で向きがずれる.
+    asdx::Matrix normalMatrix = asdx::Matrix::Transpose( asdx::Matrix::Invert( world ) );
+
+    m_Vertices.resize( baseVertex + vertexCount );
+    const asdx::ResMesh::Vertex* pSrc = mesh.GetVertices();
+    asdx::ResMesh::Vertex*       pDst = &m_Vertices[ baseVertex ];
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        pDst[i].Position = asdx::Vector3::TransformCoord ( pSrc[i].Position, world );
+        pDst[i].Normal   = asdx::Vector3::TransformNormal( pSrc[i].Normal,   normalMatrix );
+        pDst[i].Tangent  = asdx::Vector3::TransformNormal( pSrc[i].Tangent,  world );
+        pDst[i].TexCoord = pSrc[i].TexCoord;
+
+        pDst[i].Normal .Normalize();
+        pDst[i].Tangent.Normalize();
+    }
+
+    // 頂点番号はメッシュ内の相対値のまま持ち, 描画時に BaseVertex で補う.
+    const asdx::ResMesh::Index* pIndices = mesh.GetIndices();
+    for( u32 i=0; i<indexCount; ++i )
+    {
+        if ( pIndices[i] >= vertexCount )
+        {
+            ELOG( "Error : Invalid Index. index = %u", pIndices[i] );
+            m_Vertices.resize( baseVertex );
+            m_Indices .resize( startIndex );
+            return false;
+        }
+    }
+    m_Indices.insert( m_Indices.end(), pIndices, pIndices + indexCount );
+
+    const u32* pLocal = &m_Indices[ startIndex ];
+
+    Draw depthDraw;
+    depthDraw.IndexCount = indexCount;
+    depthDraw.StartIndex = startIndex;
+    depthDraw.BaseVertex = s32( baseVertex );
+    depthDraw.MaterialID = materialOffset;
+    depthDraw.SourceID   = sourceId;
+    depthDraw.Bounds     = ComputeBounds( pDst, pLocal, indexCount );
+    m_DepthDraws.push_back( depthDraw );
+
+    if ( mesh.GetSubsetCount() == 0 || mesh.GetSubsets() == nullptr )
+    { m_Draws.push_back( depthDraw ); }
+    else
+    {
+        const asdx::ResMesh::Subset* pSubsets = mesh.GetSubsets();
+        for( u32 i=0; i<mesh.GetSubsetCount(); ++i )
+        {
+            const asdx::ResMesh::Subset& subset = pSubsets[i];
+            if ( subset.IndexCount == 0 || u64( subset.IndexOffset ) + subset.IndexCount > indexCount )
+            { continue; }
+
+            Draw draw;
+            draw.IndexCount = subset.IndexCount;
+            draw.StartIndex = startIndex + subset.IndexOffset;
+            draw.BaseVertex = s32( baseVertex );
+            draw.MaterialID = materialOffset + subset.MaterialID;
+            draw.SourceID   = sourceId;
+            draw.Bounds     = ComputeBounds( pDst, pLocal + subset.IndexOffset, subset.IndexCount );
+            m_Draws.push_back( draw );
+        }
+    }
+
+    m_Bounds = ( sourceId == 0 ) ? depthDraw.Bounds : MergeBounds( m_Bounds, depthDraw.Bounds );
+    m_MaxSourceVertex = asdx::Max( m_MaxSourceVertex, vertexCount );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      描画を並べ替えて確定します.
+//-----------------------------------------------------------------------------------
+void StaticBatchBuilder::Build()
+{
+    std::stable_sort( m_Draws.begin(), m_Draws.end(), LessMaterial );
+
+    m_Statistics.SourceCount    = u32( m_DepthDraws.size() );
+    m_Statistics.DrawCount      = u32( m_Draws.size() );
+    m_Statistics.DepthDrawCount = u32( m_DepthDraws.size() );
+    m_Statistics.VertexCount    = u32( m_Vertices.size() );
+    m_Statistics.IndexCount     = u32( m_Indices.size() );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点プールを取得します.
+//-----------------------------------------------------------------------------------
+const std::vector< asdx::ResMesh::Vertex >& StaticBatchBuilder::GetVertices() const
+{ return m_Vertices; }
+
+//-----------------------------------------------------------------------------------
+//      インデックスプールを取得します.
+//-----------------------------------------------------------------------------------
+const std::vector< u32 >& StaticBatchBuilder::GetIndices() const
+{ return m_Indices; }
+
+//-----------------------------------------------------------------------------------
+//      描画を取得します.
+//-----------------------------------------------------------------------------------
+const std::vector< StaticBatchBuilder::Draw >& StaticBatchBuilder::GetDraws() const
+{ return m_Draws; }
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の描画を取得します.
+//-----------------------------------------------------------------------------------
+const std::vector< StaticBatchBuilder::Draw >& StaticBatchBuilder::GetDepthDraws() const
+{ return m_DepthDraws; }
+
+//-----------------------------------------------------------------------------------
+//      全ての頂点を覆うAABBを取得します.
+//-----------------------------------------------------------------------------------
+const asdx::BoundingBox& StaticBatchBuilder::GetBounds() const
+{ return m_Bounds; }
+
+//-----------------------------------------------------------------------------------
+//      16bitインデックスで表せるかどうかを取得します.
+//-----------------------------------------------------------------------------------
+bool StaticBatchBuilder::CanUse16BitIndex() const
+{ return ( m_MaxSourceVertex <= 0x10000 ); }
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const StaticBatchBuilder::Statistics& StaticBatchBuilder::GetStatistics() const
+{ return m_Statistics; }
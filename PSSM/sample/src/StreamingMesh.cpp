@@ -0,0 +1,736 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StreamingMesh.cpp
+// Desc : Progressive Streaming Mesh Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <StreamingMesh.h>
+#include <PackedVertex.h>
+#include <FrustumCulling.h>
+#include <asdxLog.h>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+// マテリアルが設定されていないことを表す番号です.
+static const u32 INVALID_MATERIAL = 0xffffffff;
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です.
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT =
+{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      深度描画用の入力要素です(圧縮頂点用).
+//-----------------------------------------------------------------------------------
+static const D3D11_INPUT_ELEMENT_DESC DEPTH_INPUT_ELEMENT_PACKED =
+{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+
+//-----------------------------------------------------------------------------------
+//      アライメントを考慮したサイズを求めます.
+//-----------------------------------------------------------------------------------
+inline u64 AlignSize( u64 size )
+{ return ( size + SMSH_ALIGNMENT - 1 ) & ~u64( SMSH_ALIGNMENT - 1 ); }
+
+//-----------------------------------------------------------------------------------
+//      範囲が上限に収まるかどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool IsInRange( u64 offset, u64 count, u64 stride, u64 limit )
+{ return ( offset <= limit ) && ( count * stride <= limit - offset ); }
+
+//-----------------------------------------------------------------------------------
+//      インデックスを16bitで格納できるかどうか判定します.
+//-----------------------------------------------------------------------------------
+inline bool CanUse16BitIndex( u32 vertexCount )
+{ return vertexCount <= 0x10000; }
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// StreamingMesh class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+StreamingMesh::StreamingMesh()
+: m_File            ()
+, m_pPool           ( nullptr )
+, m_Config          ()
+, m_pBaseVB         ( nullptr )
+, m_pBaseIB         ( nullptr )
+, m_BaseIndexFormat ( DXGI_FORMAT_R32_UINT )
+, m_pIL             ( nullptr )
+, m_pDepthIL        ( nullptr )
+, m_Stride          ( 0 )
+, m_UsePackedVertex ( false )
+, m_MaterialCount   ( 0 )
+, m_BaseSubsets     ()
+, m_Chunks          ()
+, m_Residency       ()
+, m_Dequantize      ()
+, m_Bounds          ()
+, m_Statistics      ()
+, m_Requests        ()
+, m_Evictions       ()
+, m_Uploads         ()
+, m_ResidentVisible ()
+, m_Mutex           ()
+, m_Condition       ()
+, m_Completed       ()
+, m_PendingCount    ( 0 )
+, m_Cancel          ( false )
+{ m_Dequantize.Identity(); }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+StreamingMesh::~StreamingMesh()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool StreamingMesh::Init
+(
+    ID3D11Device*   pDevice,
+    const char*     filename,
+    bool            usePackedVertex,
+    const void*     pShaderBytecode,
+    const u32       byteCodeLength,
+    const void*     pDepthShaderBytecode,
+    const u32       depthByteCodeLength,
+    ThreadPool*     pPool,
+    const Config&   config
+)
+{
+    Term();
+
+    if ( pDevice == nullptr || filename == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    // ファイル全体をマップするが, ここで触れるのは先頭部分だけ.
+    if ( !m_File.Open( filename ) )
+    {
+        ELOG( "Error : File Open Failed. filename = %s", filename );
+        return false;
+    }
+
+    StreamingMeshHeader header;
+    if ( m_File.GetSize() < sizeof( header ) )
+    {
+        ELOG( "Error : Invalid File Size. filename = %s", filename );
+        Term();
+        return false;
+    }
+    memcpy( &header, m_File.GetData(), sizeof( header ) );
+
+    if ( !Validate( header, filename ) )
+    {
+        Term();
+        return false;
+    }
+
+    const u8* pData = m_File.GetData();
+
+    m_pPool           = pPool;
+    m_Config          = config;
+    m_UsePackedVertex = usePackedVertex;
+    m_Stride          = ( usePackedVertex ) ? sizeof( PackedVertex ) : sizeof( asdx::ResMesh::Vertex );
+    m_MaterialCount   = header.MaterialCount;
+    m_Bounds          = asdx::BoundingBox(
+        asdx::Vector3( header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2] ),
+        asdx::Vector3( header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2] ) );
+
+    // 詳細化ブロックも同じAABBで量子化するので, 逆量子化行列は全体で1つ.
+    if ( usePackedVertex )
+    { m_Dequantize = ComputeDequantizeMatrix( m_Bounds.mini, m_Bounds.maxi ); }
+
+    // 基本LODのバッファを生成.
+    if ( header.BaseIndexCount > 0 )
+    {
+        std::vector< u8 > vertices;
+        ConvertVertices( reinterpret_cast<const MshVertex*>( pData + header.BaseVertexOffset ), header.BaseVertexCount, vertices );
+        if ( !CreateBuffer( pDevice, D3D11_BIND_VERTEX_BUFFER, &vertices[0], u32( vertices.size() ), &m_pBaseVB ) )
+        { Term(); return false; }
+
+        std::vector< u8 > indices;
+        ConvertIndices(
+            reinterpret_cast<const u32*>( pData + header.BaseIndexOffset ),
+            header.BaseIndexCount,
+            header.BaseVertexCount,
+            indices,
+            m_BaseIndexFormat );
+        if ( !CreateBuffer( pDevice, D3D11_BIND_INDEX_BUFFER, &indices[0], u32( indices.size() ), &m_pBaseIB ) )
+        { Term(); return false; }
+
+        const MshSubset* pSubsets = reinterpret_cast<const MshSubset*>( pData + header.BaseSubsetOffset );
+        m_BaseSubsets.assign( pSubsets, pSubsets + header.BaseSubsetCount );
+    }
+
+    // チャンクの情報を取り込む. 詳細化データの大きさはGPUバッファに置いたときのサイズで見積もる.
+    m_Chunks.resize( header.ChunkCount );
+    m_Residency.Init( header.ChunkCount, config.Residency );
+    for( u32 i=0; i<header.ChunkCount; ++i )
+    {
+        Chunk& chunk = m_Chunks[i];
+        memcpy( &chunk.Info, pData + header.ChunkOffset + sizeof( StreamingChunk ) * i, sizeof( chunk.Info ) );
+
+        asdx::Vector3 mini( chunk.Info.Min[0], chunk.Info.Min[1], chunk.Info.Min[2] );
+        asdx::Vector3 maxi( chunk.Info.Max[0], chunk.Info.Max[1], chunk.Info.Max[2] );
+        chunk.Box         = asdx::BoundingBox( mini, maxi );
+        chunk.pVB         = nullptr;
+        chunk.pIB         = nullptr;
+        chunk.IndexFormat = DXGI_FORMAT_R32_UINT;
+        chunk.Loaded      = false;
+
+        u64 indexStride = CanUse16BitIndex( chunk.Info.VertexCount ) ? sizeof( u16 ) : sizeof( u32 );
+        u64 size        = u64( chunk.Info.VertexCount ) * m_Stride + u64( chunk.Info.IndexCount ) * indexStride;
+        m_Residency.SetChunk( i, mini, maxi, chunk.Info.BaseError, size );
+    }
+
+    // 入力レイアウトの生成. 深度描画も同じ頂点バッファを使い, 位置座標だけを読む.
+    {
+        const D3D11_INPUT_ELEMENT_DESC* pElements    = ( usePackedVertex ) ? PackedVertex::INPUT_ELEMENTS    : asdx::ResMesh::INPUT_ELEMENTS;
+        const u32                       elementCount = ( usePackedVertex ) ? PackedVertex::NUM_INPUT_ELEMENT : asdx::ResMesh::NUM_INPUT_ELEMENT;
+
+        HRESULT hr = pDevice->CreateInputLayout( pElements, elementCount, pShaderBytecode, byteCodeLength, &m_pIL );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+            Term();
+            return false;
+        }
+
+        const D3D11_INPUT_ELEMENT_DESC& element = ( usePackedVertex ) ? DEPTH_INPUT_ELEMENT_PACKED : DEPTH_INPUT_ELEMENT;
+
+        hr = pDevice->CreateInputLayout( &element, 1, pDepthShaderBytecode, depthByteCodeLength, &m_pDepthIL );
+        if ( FAILED( hr ) )
+        {
+            ELOG( "Error : ID3D11Device::CreateInputLayout() Failed." );
+            Term();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::Term()
+{
+    // ワーカースレッドがマップしたファイルを参照しているので, 読み込み中のブロックを待つ.
+    {
+        std::unique_lock< std::mutex > lock( m_Mutex );
+        m_Cancel = true;
+        while( m_PendingCount > 0 )
+        { m_Condition.wait( lock ); }
+
+        m_Completed.clear();
+        m_Cancel = false;
+    }
+
+    for( size_t i=0; i<m_Chunks.size(); ++i )
+    {
+        ASDX_RELEASE( m_Chunks[i].pVB );
+        ASDX_RELEASE( m_Chunks[i].pIB );
+    }
+
+    ASDX_RELEASE( m_pBaseVB );
+    ASDX_RELEASE( m_pBaseIB );
+    ASDX_RELEASE( m_pIL );
+    ASDX_RELEASE( m_pDepthIL );
+
+    m_File.Close();
+    m_pPool           = nullptr;
+    m_Config          = Config();
+    m_BaseIndexFormat = DXGI_FORMAT_R32_UINT;
+    m_Stride          = 0;
+    m_UsePackedVertex = false;
+    m_MaterialCount   = 0;
+    m_BaseSubsets    .clear();
+    m_Chunks         .clear();
+    m_Requests       .clear();
+    m_Evictions      .clear();
+    m_Uploads        .clear();
+    m_ResidentVisible.clear();
+    m_Residency.Term();
+    m_Dequantize.Identity();
+    m_Bounds     = asdx::BoundingBox();
+    m_Statistics = Statistics();
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込みが完了したチャンクを常駐させ, 次に読み込むチャンクを決めます.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::Update
+(
+    ID3D11Device*           pDevice,
+    const asdx::Matrix&     worldViewProj,
+    f32                     width,
+    f32                     height
+)
+{
+    if ( !IsValid() || pDevice == nullptr )
+    { return; }
+
+    // ワーカースレッドで読み込みが完了したものを受け取る.
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        m_Uploads.insert( m_Uploads.end(), m_Completed.begin(), m_Completed.end() );
+        m_Completed.clear();
+    }
+
+    // GPUバッファの生成はフレームあたりの数を制限して, 読み込みが集中してもフレーム時間を乱さないようにする.
+    size_t consumed = 0;
+    for( ; consumed < m_Uploads.size() && consumed < m_Config.MaxUploadsPerFrame; ++consumed )
+    {
+        u32    index = m_Uploads[ consumed ];
+        Chunk& chunk = m_Chunks[ index ];
+
+        bool success = chunk.Loaded
+            && CreateBuffer( pDevice, D3D11_BIND_VERTEX_BUFFER, &chunk.Vertices[0], u32( chunk.Vertices.size() ), &chunk.pVB )
+            && CreateBuffer( pDevice, D3D11_BIND_INDEX_BUFFER,  &chunk.Indices [0], u32( chunk.Indices .size() ), &chunk.pIB );
+        if ( !success )
+        { Evict( index ); }
+
+        // 転送が済んだら作業用のデータは不要.
+        std::vector< u8 >().swap( chunk.Vertices );
+        std::vector< u8 >().swap( chunk.Indices );
+
+        m_Residency.OnLoaded( index, success );
+    }
+    m_Uploads.erase( m_Uploads.begin(), m_Uploads.begin() + consumed );
+
+    // 優先度を更新して, 解放と読み込みの要求を行う.
+    m_Residency.Update( worldViewProj, width, height, m_Requests, m_Evictions );
+
+    for( size_t i=0; i<m_Evictions.size(); ++i )
+    { Evict( m_Evictions[i] ); }
+
+    for( size_t i=0; i<m_Requests.size(); ++i )
+    {
+        u32 index = m_Requests[i];
+        {
+            std::lock_guard< std::mutex > locker( m_Mutex );
+            m_PendingCount++;
+        }
+
+        if ( m_pPool != nullptr )
+        { m_pPool->Push( [this, index]() { LoadBlock( index ); } ); }
+        else
+        { LoadBlock( index ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入るチャンクを描画します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::Draw
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    const asdx::Matrix&     worldViewProj,
+    const MaterialBinder&   binder
+)
+{ DrawChunks( pDeviceContext, worldViewProj, &binder, m_pIL ); }
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入るチャンクの深度のみを描画します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::DrawDepthOnly( ID3D11DeviceContext* pDeviceContext, const asdx::Matrix& worldViewProj )
+{ DrawChunks( pDeviceContext, worldViewProj, nullptr, m_pDepthIL ); }
+
+//-----------------------------------------------------------------------------------
+//      初期化済みかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool StreamingMesh::IsValid() const
+{ return m_File.IsOpen() && m_pIL != nullptr; }
+
+//-----------------------------------------------------------------------------------
+//      チャンク数を取得します.
+//-----------------------------------------------------------------------------------
+u32 StreamingMesh::GetChunkCount() const
+{ return u32( m_Chunks.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      マテリアル数を取得します.
+//-----------------------------------------------------------------------------------
+u32 StreamingMesh::GetMaterialCount() const
+{ return m_MaterialCount; }
+
+//-----------------------------------------------------------------------------------
+//      位置座標の逆量子化行列を取得します.
+//-----------------------------------------------------------------------------------
+const asdx::Matrix& StreamingMesh::GetDequantizeMatrix() const
+{ return m_Dequantize; }
+
+//-----------------------------------------------------------------------------------
+//      メッシュ全体のAABBを取得します.
+//-----------------------------------------------------------------------------------
+const asdx::BoundingBox& StreamingMesh::GetBoundingBox() const
+{ return m_Bounds; }
+
+//-----------------------------------------------------------------------------------
+//      常駐管理を取得します.
+//-----------------------------------------------------------------------------------
+const ChunkResidency& StreamingMesh::GetResidency() const
+{ return m_Residency; }
+
+//-----------------------------------------------------------------------------------
+//      最後に行った描画の統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const StreamingMesh::Statistics& StreamingMesh::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      ヘッダと先頭部分のデータを検証します.
+//-----------------------------------------------------------------------------------
+bool StreamingMesh::Validate( const StreamingMeshHeader& header, const char* filename ) const
+{
+    if ( header.Magic[0] != 'S' || header.Magic[1] != 'M' || header.Magic[2] != 'S' || header.Magic[3] != 'H' )
+    {
+        ELOG( "Error : Invalid File Magic. filename = %s", filename );
+        return false;
+    }
+
+    if ( header.Version != SMSH_VERSION || header.HeaderSize != sizeof( header ) )
+    {
+        ELOG( "Error : Unsupported File Version. filename = %s, version = 0x%08x", filename, header.Version );
+        return false;
+    }
+
+    if ( header.FileSize != m_File.GetSize() || header.BaseSize > header.FileSize )
+    {
+        ELOG( "Error : Invalid File Size. filename = %s", filename );
+        return false;
+    }
+
+    // 先頭部分に収まっていること.
+    const u64 limit = header.BaseSize;
+    if ( !IsInRange( header.MaterialOffset,    header.MaterialCount,   sizeof( CookedMaterial ), limit )
+      || !IsInRange( header.StringTableOffset, header.StringTableSize, sizeof( char           ), limit )
+      || !IsInRange( header.ChunkOffset,       header.ChunkCount,      sizeof( StreamingChunk ), limit )
+      || !IsInRange( header.BaseVertexOffset,  header.BaseVertexCount, sizeof( MshVertex      ), limit )
+      || !IsInRange( header.BaseIndexOffset,   header.BaseIndexCount,  sizeof( u32            ), limit )
+      || !IsInRange( header.BaseSubsetOffset,  header.BaseSubsetCount, sizeof( MshSubset      ), limit ) )
+    {
+        ELOG( "Error : Section Out Of Range. filename = %s", filename );
+        return false;
+    }
+
+    const u8* pData = m_File.GetData();
+
+    const u32* pIndices = reinterpret_cast<const u32*>( pData + header.BaseIndexOffset );
+    for( u32 i=0; i<header.BaseIndexCount; ++i )
+    {
+        if ( pIndices[i] >= header.BaseVertexCount )
+        {
+            ELOG( "Error : Base Index Out Of Range. filename = %s", filename );
+            return false;
+        }
+    }
+
+    const MshSubset* pSubsets = reinterpret_cast<const MshSubset*>( pData + header.BaseSubsetOffset );
+    for( u32 i=0; i<header.BaseSubsetCount; ++i )
+    {
+        if ( u64( pSubsets[i].IndexOffset ) + pSubsets[i].IndexCount > header.BaseIndexCount )
+        {
+            ELOG( "Error : Base Subset Out Of Range. filename = %s, subset = %u", filename, i );
+            return false;
+        }
+    }
+
+    for( u32 i=0; i<header.ChunkCount; ++i )
+    {
+        StreamingChunk chunk;
+        memcpy( &chunk, pData + header.ChunkOffset + sizeof( StreamingChunk ) * i, sizeof( chunk ) );
+
+        // ブロック内のレイアウトは MeshCooker の書き出しと同じ規則で求める.
+        u64 blockSize = AlignSize( u64( chunk.VertexCount ) * sizeof( MshVertex ) )
+                      + AlignSize( u64( chunk.IndexCount  ) * sizeof( u32 ) )
+                      + u64( chunk.SubsetCount ) * sizeof( MshSubset );
+
+        if ( u64( chunk.BaseSubsetOffset ) + chunk.BaseSubsetCount > header.BaseSubsetCount
+          || chunk.BlockOffset < header.BaseSize
+          || !IsInRange( chunk.BlockOffset, chunk.BlockSize, 1, header.FileSize )
+          || blockSize > chunk.BlockSize
+          || ( chunk.VertexCount == 0 ) != ( chunk.IndexCount == 0 ) )
+        {
+            ELOG( "Error : Chunk Out Of Range. filename = %s, chunk = %u", filename, i );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細化ブロックを読み込みます(ワーカースレッドから呼び出されます).
+//-----------------------------------------------------------------------------------
+void StreamingMesh::LoadBlock( u32 index )
+{
+    Chunk& chunk = m_Chunks[ index ];
+
+    bool cancel;
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        cancel = m_Cancel;
+    }
+
+    // ブロックに初めて触れるのはここなので, ファイルの読み込みもこのスレッドで発生する.
+    bool loaded = false;
+    if ( !cancel && chunk.Info.IndexCount > 0 )
+    {
+        const StreamingChunk& info   = chunk.Info;
+        const u8*             pBlock = m_File.GetData() + info.BlockOffset;
+
+        const u64 indexOffset  = AlignSize( u64( info.VertexCount ) * sizeof( MshVertex ) );
+        const u64 subsetOffset = indexOffset + AlignSize( u64( info.IndexCount ) * sizeof( u32 ) );
+
+        const MshVertex* pVertices = reinterpret_cast<const MshVertex*>( pBlock );
+        const u32*       pIndices  = reinterpret_cast<const u32*>      ( pBlock + indexOffset );
+        const MshSubset* pSubsets  = reinterpret_cast<const MshSubset*>( pBlock + subsetOffset );
+
+        loaded = true;
+        for( u32 i=0; i<info.IndexCount && loaded; ++i )
+        { loaded = ( pIndices[i] < info.VertexCount ); }
+
+        for( u32 i=0; i<info.SubsetCount && loaded; ++i )
+        { loaded = ( u64( pSubsets[i].IndexOffset ) + pSubsets[i].IndexCount <= info.IndexCount ); }
+
+        if ( loaded )
+        {
+            ConvertVertices( pVertices, info.VertexCount, chunk.Vertices );
+            ConvertIndices( pIndices, info.IndexCount, info.VertexCount, chunk.Indices, chunk.IndexFormat );
+            chunk.Subsets.assign( pSubsets, pSubsets + info.SubsetCount );
+        }
+        else
+        { ELOG( "Error : Invalid Streaming Block. chunk = %u", index ); }
+    }
+    chunk.Loaded = loaded;
+
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        m_Completed.push_back( index );
+        m_PendingCount--;
+    }
+    m_Condition.notify_all();
+}
+
+//-----------------------------------------------------------------------------------
+//      詳細化データを解放します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::Evict( u32 index )
+{
+    Chunk& chunk = m_Chunks[ index ];
+    ASDX_RELEASE( chunk.pVB );
+    ASDX_RELEASE( chunk.pIB );
+    std::vector< MshSubset >().swap( chunk.Subsets );
+}
+
+//-----------------------------------------------------------------------------------
+//      バッファを生成します.
+//-----------------------------------------------------------------------------------
+bool StreamingMesh::CreateBuffer
+(
+    ID3D11Device*   pDevice,
+    UINT            bindFlags,
+    const void*     pData,
+    u32             size,
+    ID3D11Buffer**  ppBuffer
+)
+{
+    D3D11_BUFFER_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Usage          = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth      = size;
+    desc.BindFlags      = bindFlags;
+    desc.CPUAccessFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA res;
+    ZeroMemory( &res, sizeof( res ) );
+    res.pSysMem = pData;
+
+    HRESULT hr = pDevice->CreateBuffer( &desc, &res, ppBuffer );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateBuffer() Failed." );
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点をGPUバッファの形式に変換します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::ConvertVertices( const MshVertex* pVertices, u32 count, std::vector< u8 >& result ) const
+{
+    result.resize( size_t( count ) * m_Stride );
+    if ( count == 0 )
+    { return; }
+
+    // MshVertex と asdx::ResMesh::Vertex は同じレイアウト.
+    if ( m_UsePackedVertex )
+    {
+        PackVertices(
+            reinterpret_cast<const asdx::ResMesh::Vertex*>( pVertices ),
+            count,
+            m_Bounds.mini,
+            m_Bounds.maxi,
+            reinterpret_cast<PackedVertex*>( &result[0] ) );
+    }
+    else
+    { memcpy( &result[0], pVertices, result.size() ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点インデックスをGPUバッファの形式に変換します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::ConvertIndices
+(
+    const u32*          pIndices,
+    u32                 count,
+    u32                 vertexCount,
+    std::vector< u8 >&  result,
+    DXGI_FORMAT&        format
+) const
+{
+    // チャンクの頂点番号はブロック内の相対値なので, ほとんどの場合16bitに収まる.
+    if ( CanUse16BitIndex( vertexCount ) )
+    {
+        format = DXGI_FORMAT_R16_UINT;
+        result.resize( size_t( count ) * sizeof( u16 ) );
+
+        u16* pDst = reinterpret_cast<u16*>( ( count > 0 ) ? &result[0] : nullptr );
+        for( u32 i=0; i<count; ++i )
+        { pDst[i] = u16( pIndices[i] ); }
+    }
+    else
+    {
+        format = DXGI_FORMAT_R32_UINT;
+        result.resize( size_t( count ) * sizeof( u32 ) );
+        if ( count > 0 )
+        { memcpy( &result[0], pIndices, result.size() ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点バッファとインデックスバッファを設定します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::Bind
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    ID3D11Buffer*           pVB,
+    ID3D11Buffer*           pIB,
+    DXGI_FORMAT             format,
+    ID3D11InputLayout*      pIL
+)
+{
+    u32 offset = 0;
+    pDeviceContext->IASetInputLayout( pIL );
+    pDeviceContext->IASetVertexBuffers( 0, 1, &pVB, &m_Stride, &offset );
+    pDeviceContext->IASetIndexBuffer( pIB, format, 0 );
+    pDeviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台に入るチャンクを描画します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::DrawChunks
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    const asdx::Matrix&     worldViewProj,
+    const MaterialBinder*   pBinder,
+    ID3D11InputLayout*      pIL
+)
+{
+    m_Statistics = Statistics();
+    if ( !IsValid() )
+    { return; }
+
+    asdx::BoundingFrustum frustum( worldViewProj );
+    m_ResidentVisible.clear();
+
+    // 詳細化データが無いチャンクは基本LODのバッファを1回だけ設定してまとめて描画する.
+    u32  boundMaterial = INVALID_MATERIAL;
+    bool baseBound     = false;
+    for( u32 i=0; i<u32( m_Chunks.size() ); ++i )
+    {
+        const Chunk& chunk = m_Chunks[i];
+        if ( IsOutside( frustum, chunk.Box ) )
+        { continue; }
+
+        m_Statistics.VisibleCount++;
+
+        if ( m_Residency.GetState( i ) == ChunkResidency::STATE_RESIDENT && chunk.pVB != nullptr )
+        {
+            m_ResidentVisible.push_back( i );
+            continue;
+        }
+
+        if ( m_pBaseVB == nullptr || chunk.Info.BaseSubsetCount == 0 )
+        { continue; }
+
+        if ( !baseBound )
+        {
+            Bind( pDeviceContext, m_pBaseVB, m_pBaseIB, m_BaseIndexFormat, pIL );
+            baseBound = true;
+        }
+
+        DrawSubsets( pDeviceContext, &m_BaseSubsets[ chunk.Info.BaseSubsetOffset ], chunk.Info.BaseSubsetCount, pBinder, boundMaterial );
+        m_Statistics.BaseCount++;
+    }
+
+    for( size_t i=0; i<m_ResidentVisible.size(); ++i )
+    {
+        const Chunk& chunk = m_Chunks[ m_ResidentVisible[i] ];
+        if ( chunk.Subsets.empty() )
+        { continue; }
+
+        Bind( pDeviceContext, chunk.pVB, chunk.pIB, chunk.IndexFormat, pIL );
+        DrawSubsets( pDeviceContext, &chunk.Subsets[0], u32( chunk.Subsets.size() ), pBinder, boundMaterial );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセットを描画します.
+//-----------------------------------------------------------------------------------
+void StreamingMesh::DrawSubsets
+(
+    ID3D11DeviceContext*    pDeviceContext,
+    const MshSubset*        pSubsets,
+    u32                     count,
+    const MaterialBinder*   pBinder,
+    u32&                    boundMaterial
+)
+{
+    for( u32 i=0; i<count; ++i )
+    {
+        const MshSubset& subset = pSubsets[i];
+        if ( subset.IndexCount == 0 )
+        { continue; }
+
+        // チャンクをまたいで同じマテリアルが続く場合は設定し直さない.
+        if ( pBinder != nullptr && *pBinder && boundMaterial != subset.MaterialID )
+        {
+            (*pBinder)( pDeviceContext, subset.MaterialID );
+            boundMaterial = subset.MaterialID;
+        }
+
+        pDeviceContext->DrawIndexed( subset.IndexCount, subset.IndexOffset, 0 );
+        m_Statistics.DrawCallCount++;
+        m_Statistics.TriangleCount += subset.IndexCount / 3;
+    }
+}
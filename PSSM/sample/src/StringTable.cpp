@@ -0,0 +1,232 @@
+﻿//-----------------------------------------------------------------------------------
+// File : StringTable.cpp
+// Desc : Interned String Table Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <StringTable.h>
+#include <asdxMath.h>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+// ハッシュテーブルの最小サイズ(2のべき乗).
+static const u32 MIN_SLOT_COUNT = 16;
+
+//-----------------------------------------------------------------------------------
+//      FNV-1a (32bit) でハッシュ値を求めます.
+//-----------------------------------------------------------------------------------
+inline u32 ComputeHash( const char* value, u32 length )
+{
+    u32 hash = 0x811c9dc5;
+    for( u32 i=0; i<length; ++i )
+    {
+        hash ^= u8( value[i] );
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// StringTable class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+StringTable::StringTable()
+: m_Chars   ()
+, m_Offsets ()
+, m_Hashes  ()
+, m_Slots   ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+StringTable::~StringTable()
+{ Clear(); }
+
+//-----------------------------------------------------------------------------------
+//      コピーコンストラクタです.
+//-----------------------------------------------------------------------------------
+StringTable::StringTable( const StringTable& value )
+: m_Chars   ( value.m_Chars )
+, m_Offsets ( value.m_Offsets )
+, m_Hashes  ( value.m_Hashes )
+, m_Slots   ( value.m_Slots )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      代入演算子です.
+//-----------------------------------------------------------------------------------
+StringTable& StringTable::operator = ( const StringTable& value )
+{
+    if ( this != &value )
+    {
+        m_Chars   = value.m_Chars;
+        m_Offsets = value.m_Offsets;
+        m_Hashes  = value.m_Hashes;
+        m_Slots   = value.m_Slots;
+    }
+
+    return (*this);
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列を登録します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::Intern( const char* value )
+{
+    if ( value == nullptr )
+    { return INVALID_ID; }
+
+    return Intern( value, u32( strlen( value ) ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      長さを指定して文字列を登録します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::Intern( const char* value, u32 length )
+{
+    if ( value == nullptr || length == 0 )
+    { return INVALID_ID; }
+
+    u32 hash = ComputeHash( value, length );
+    u32 slot = FindSlot( value, length, hash );
+    if ( slot < m_Slots.size() && m_Slots[ slot ] != 0 )
+    { return m_Slots[ slot ] - 1; }
+
+    // 使用率が半分を超えないように広げる.
+    u32 id = u32( m_Offsets.size() );
+    if ( ( id + 1 ) * 2 > m_Slots.size() )
+    {
+        Rehash( asdx::Max( MIN_SLOT_COUNT, u32( m_Slots.size() ) * 2 ) );
+        slot = FindSlot( value, length, hash );
+    }
+
+    m_Offsets.push_back( u32( m_Chars.size() ) );
+    m_Hashes .push_back( hash );
+    m_Chars  .insert( m_Chars.end(), value, value + length );
+    m_Chars  .push_back( '\0' );
+    m_Slots[ slot ] = id + 1;
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------------
+//      登録済みの文字列を検索します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::Find( const char* value ) const
+{
+    if ( value == nullptr || value[0] == '\0' || m_Slots.empty() )
+    { return INVALID_ID; }
+
+    u32 length = u32( strlen( value ) );
+    u32 slot   = FindSlot( value, length, ComputeHash( value, length ) );
+    if ( m_Slots[ slot ] == 0 )
+    { return INVALID_ID; }
+
+    return m_Slots[ slot ] - 1;
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列を取得します.
+//-----------------------------------------------------------------------------------
+const char* StringTable::GetString( u32 id ) const
+{
+    if ( id >= m_Offsets.size() )
+    { return ""; }
+
+    return &m_Chars[ m_Offsets[ id ] ];
+}
+
+//-----------------------------------------------------------------------------------
+//      登録されている文字列数を取得します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::GetCount() const
+{ return u32( m_Offsets.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      文字列の格納に使っているバイト数を取得します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::GetByteSize() const
+{ return u32( m_Chars.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      全ての文字列を破棄します.
+//-----------------------------------------------------------------------------------
+void StringTable::Clear()
+{
+    m_Chars  .clear();
+    m_Offsets.clear();
+    m_Hashes .clear();
+    m_Slots  .clear();
+}
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void StringTable::Swap( StringTable& value )
+{
+    m_Chars  .swap( value.m_Chars );
+    m_Offsets.swap( value.m_Offsets );
+    m_Hashes .swap( value.m_Hashes );
+    m_Slots  .swap( value.m_Slots );
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列が入っているスロット, または入るべき空きスロットを探します.
+//-----------------------------------------------------------------------------------
+u32 StringTable::FindSlot( const char* value, u32 length, u32 hash ) const
+{
+    u32 count = u32( m_Slots.size() );
+    if ( count == 0 )
+    { return 0; }
+
+    // 線形探索. 使用率は半分以下なので必ず空きが見つかる.
+    u32 mask = count - 1;
+    u32 slot = hash & mask;
+    for( ;; )
+    {
+        u32 entry = m_Slots[ slot ];
+        if ( entry == 0 )
+        { return slot; }
+
+        // 長さは次の文字列の開始位置から求める.
+        u32 id  = entry - 1;
+        u32 end = ( id + 1 < m_Offsets.size() ) ? m_Offsets[ id + 1 ] : u32( m_Chars.size() );
+        if ( m_Hashes[ id ] == hash && end - m_Offsets[ id ] == length + 1 )
+        {
+            if ( memcmp( &m_Chars[ m_Offsets[ id ] ], value, length ) == 0 )
+            { return slot; }
+        }
+
+        slot = ( slot + 1 ) & mask;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      ハッシュテーブルを作り直します.
+//-----------------------------------------------------------------------------------
+void StringTable::Rehash( u32 slotCount )
+{
+    m_Slots.assign( slotCount, 0 );
+
+    u32 mask = slotCount - 1;
+    for( u32 id=0; id<u32( m_Offsets.size() ); ++id )
+    {
+        u32 slot = m_Hashes[ id ] & mask;
+        while( m_Slots[ slot ] != 0 )
+        { slot = ( slot + 1 ) & mask; }
+
+        m_Slots[ slot ] = id + 1;
+    }
+}
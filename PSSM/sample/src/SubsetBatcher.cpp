@@ -0,0 +1,143 @@
+﻿//-----------------------------------------------------------------------------------
+// File : SubsetBatcher.cpp
+// Desc : Material Sorted Subset Batcher Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <SubsetBatcher.h>
+#include <algorithm>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//! @brief      サブセット番号をマテリアル番号で比較します.
+//-----------------------------------------------------------------------------------
+struct MaterialLess
+{
+    const MshSubset*    pSubsets;   //!< サブセットです.
+
+    explicit MaterialLess( const MshSubset* subsets )
+    : pSubsets( subsets )
+    { /* DO_NOTHING */ }
+
+    bool operator () ( u32 lhs, u32 rhs ) const
+    { return pSubsets[ lhs ].MaterialID < pSubsets[ rhs ].MaterialID; }
+};
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// SubsetBatcher class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      サブセットをマテリアル順に並び替えて結合します.
+//-----------------------------------------------------------------------------------
+void SubsetBatcher::SortAndMerge
+(
+    std::vector< u32 >&         indices,
+    std::vector< MshSubset >&   subsets,
+    Statistics*                 pStats
+)
+{
+    u32 subsetCount = u32( subsets.size() );
+    u32 indexCount  = u32( indices.size() );
+
+    std::vector< u32 > order;
+    ComputeDrawOrder( ( subsets.empty() ) ? nullptr : &subsets[0], subsetCount, order );
+
+    if ( pStats != nullptr )
+    {
+        pStats->SubsetCountBefore     = subsetCount;
+        pStats->MaterialChangesBefore = CountMaterialChanges( ( subsets.empty() ) ? nullptr : &subsets[0], nullptr, subsetCount );
+    }
+
+    std::vector< u32 >       sortedIndices;
+    std::vector< MshSubset > mergedSubsets;
+    sortedIndices.reserve( indexCount );
+    mergedSubsets.reserve( subsetCount );
+
+    for( u32 i=0; i<subsetCount; ++i )
+    {
+        const MshSubset& src = subsets[ order[i] ];
+
+        // 範囲外を参照している部分は描画されないので取り除く.
+        u32 begin = std::min( src.IndexOffset, indexCount );
+        u32 end   = u32( std::min( u64( src.IndexOffset ) + src.IndexCount, u64( indexCount ) ) );
+
+        if ( mergedSubsets.empty() || mergedSubsets.back().MaterialID != src.MaterialID )
+        {
+            MshSubset dst;
+            dst.IndexOffset = u32( sortedIndices.size() );
+            dst.IndexCount  = 0;
+            dst.MaterialID  = src.MaterialID;
+            mergedSubsets.push_back( dst );
+        }
+
+        sortedIndices.insert( sortedIndices.end(), indices.begin() + begin, indices.begin() + end );
+        mergedSubsets.back().IndexCount += end - begin;
+    }
+
+    indices.swap( sortedIndices );
+    subsets.swap( mergedSubsets );
+
+    if ( pStats != nullptr )
+    {
+        pStats->SubsetCountAfter     = u32( subsets.size() );
+        pStats->MaterialChangesAfter = CountMaterialChanges( ( subsets.empty() ) ? nullptr : &subsets[0], nullptr, u32( subsets.size() ) );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアル順の描画順を求めます.
+//-----------------------------------------------------------------------------------
+void SubsetBatcher::ComputeDrawOrder
+(
+    const MshSubset*            pSubsets,
+    u32                         subsetCount,
+    std::vector< u32 >&         order
+)
+{
+    order.resize( subsetCount );
+    for( u32 i=0; i<subsetCount; ++i )
+    { order[i] = i; }
+
+    if ( pSubsets == nullptr || subsetCount <= 1 )
+    { return; }
+
+    // 同じマテリアル内ではファイルでの順番を保つ.
+    std::stable_sort( order.begin(), order.end(), MaterialLess( pSubsets ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルの切り替え回数を求めます.
+//-----------------------------------------------------------------------------------
+u32 SubsetBatcher::CountMaterialChanges
+(
+    const MshSubset*            pSubsets,
+    const u32*                  pOrder,
+    u32                         subsetCount
+)
+{
+    if ( pSubsets == nullptr )
+    { return 0; }
+
+    u32 count = 0;
+    u32 prev  = 0;
+    for( u32 i=0; i<subsetCount; ++i )
+    {
+        const MshSubset& subset = pSubsets[ ( pOrder != nullptr ) ? pOrder[i] : i ];
+        if ( i == 0 || subset.MaterialID != prev )
+        {
+            count++;
+            prev = subset.MaterialID;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,297 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TangentGenerator.cpp
+// Desc : Tangent Frame Generator Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <TangentGenerator.h>
+#include <asdxMath.h>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+// 並列処理の粒度.
+static const u32 TRIANGLE_GRAIN = 2048;
+static const u32 VERTEX_GRAIN   = 4096;
+
+// 長さが無いとみなす値.
+static const f32 LENGTH_EPSILON = 1e-12f;
+
+// テクスチャ座標が縮退しているとみなす面積.
+static const f32 AREA_EPSILON = 1e-20f;
+
+// 三角形の向きです.
+static const s8 ORIENT_DEGENERATE = 0;
+static const s8 ORIENT_POSITIVE   = 1;
+static const s8 ORIENT_NEGATIVE   = -1;
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Corner structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct Corner
+{
+    asdx::Vector3   Tangent;        //!< 角の大きさで重み付けした接ベクトルです.
+    s8              Orient;         //!< テクスチャ座標の向きです.
+};
+
+//-----------------------------------------------------------------------------------
+//      配列から3次元ベクトルを取得します.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ToVector3( const f32* value )
+{ return asdx::Vector3( value[0], value[1], value[2] ); }
+
+//-----------------------------------------------------------------------------------
+//      ベクトルを法線に垂直な平面に射影して正規化します.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ProjectToPlane( const asdx::Vector3& value, const asdx::Vector3& normal )
+{
+    asdx::Vector3 result = value - normal * asdx::Vector3::Dot( normal, value );
+    f32 lenSq = result.LengthSq();
+    if ( lenSq > LENGTH_EPSILON )
+    { result *= 1.0f / sqrtf( lenSq ); }
+    else
+    { result = asdx::Vector3( 0.0f, 0.0f, 0.0f ); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      法線に垂直な任意のベクトルを求めます.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ComputePerpendicular( const asdx::Vector3& normal )
+{
+    asdx::Vector3 axis = ( fabs( normal.x ) < 0.9f )
+                       ? asdx::Vector3( 1.0f, 0.0f, 0.0f )
+                       : asdx::Vector3( 0.0f, 1.0f, 0.0f );
+    asdx::Vector3 result = asdx::Vector3::Cross( normal, axis );
+    return result.Normalize();
+}
+
+//-----------------------------------------------------------------------------------
+//      合計した接ベクトルを正規化します. 求まらない場合は法線から決めます.
+//-----------------------------------------------------------------------------------
+bool ResolveTangent( const asdx::Vector3& sum, const asdx::Vector3& normal, f32* result )
+{
+    bool resolved = true;
+
+    asdx::Vector3 tangent = ProjectToPlane( sum, normal );
+    if ( tangent.LengthSq() <= LENGTH_EPSILON )
+    {
+        tangent  = ComputePerpendicular( normal );
+        resolved = false;
+    }
+
+    result[0] = tangent.x;
+    result[1] = tangent.y;
+    result[2] = tangent.z;
+
+    return resolved;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TangentGenerator class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      接ベクトルを生成します.
+//-----------------------------------------------------------------------------------
+void TangentGenerator::Generate
+(
+    std::vector< MshVertex >&   vertices,
+    std::vector< u32 >&         indices,
+    ThreadPool*                 pPool,
+    Statistics*                 pStats
+)
+{
+    u32 vertexCount   = u32( vertices.size() );
+    u32 triangleCount = u32( indices.size() / 3 );
+    u32 cornerCount   = triangleCount * 3;
+
+    if ( pStats != nullptr )
+    {
+        *pStats = Statistics();
+        pStats->TriangleCount = triangleCount;
+    }
+
+    if ( vertexCount == 0 )
+    { return; }
+
+    // 三角形ごとに角の接ベクトルを並列に求める.
+    std::vector< Corner > corners( cornerCount );
+    ThreadPool::RunRange( pPool, triangleCount, TRIANGLE_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 t=begin; t<end; ++t )
+        {
+            const u32* pTri = &indices[ t * 3 ];
+            if ( pTri[0] >= vertexCount || pTri[1] >= vertexCount || pTri[2] >= vertexCount )
+            {
+                for( u32 k=0; k<3; ++k )
+                {
+                    corners[ t * 3 + k ].Tangent = asdx::Vector3( 0.0f, 0.0f, 0.0f );
+                    corners[ t * 3 + k ].Orient  = ORIENT_DEGENERATE;
+                }
+                continue;
+            }
+
+            const MshVertex& v0 = vertices[ pTri[0] ];
+            const MshVertex& v1 = vertices[ pTri[1] ];
+            const MshVertex& v2 = vertices[ pTri[2] ];
+
+            asdx::Vector3 e1 = ToVector3( v1.Position ) - ToVector3( v0.Position );
+            asdx::Vector3 e2 = ToVector3( v2.Position ) - ToVector3( v0.Position );
+
+            f32 du1 = v1.TexCoord[0] - v0.TexCoord[0];
+            f32 dv1 = v1.TexCoord[1] - v0.TexCoord[1];
+            f32 du2 = v2.TexCoord[0] - v0.TexCoord[0];
+            f32 dv2 = v2.TexCoord[1] - v0.TexCoord[1];
+
+            // テクスチャ空間での符号付き面積の符号が向きになる.
+            f32 area   = du1 * dv2 - du2 * dv1;
+            s8  orient = ( fabs( area ) <= AREA_EPSILON ) ? ORIENT_DEGENERATE
+                       : ( area > 0.0f )                  ? ORIENT_POSITIVE
+                       :                                    ORIENT_NEGATIVE;
+
+            asdx::Vector3 faceTangent( 0.0f, 0.0f, 0.0f );
+            if ( orient != ORIENT_DEGENERATE )
+            {
+                faceTangent = e1 * dv2 - e2 * dv1;
+                f32 lenSq = faceTangent.LengthSq();
+                faceTangent = ( lenSq > LENGTH_EPSILON )
+                            ? faceTangent * ( f32( orient ) / sqrtf( lenSq ) )
+                            : asdx::Vector3( 0.0f, 0.0f, 0.0f );
+            }
+
+            const asdx::Vector3 positions[3] = {
+                ToVector3( v0.Position ),
+                ToVector3( v1.Position ),
+                ToVector3( v2.Position ),
+            };
+
+            for( u32 k=0; k<3; ++k )
+            {
+                Corner& corner = corners[ t * 3 + k ];
+                corner.Orient  = orient;
+
+                // 角の大きさは法線に垂直な平面に射影した辺で求める.
+                asdx::Vector3 normal = ToVector3( vertices[ pTri[k] ].Normal );
+                asdx::Vector3 edge0  = ProjectToPlane( positions[ ( k + 1 ) % 3 ] - positions[k], normal );
+                asdx::Vector3 edge1  = ProjectToPlane( positions[ ( k + 2 ) % 3 ] - positions[k], normal );
+                f32 cosine = asdx::Clamp( asdx::Vector3::Dot( edge0, edge1 ), -1.0f, 1.0f );
+                f32 angle  = acosf( cosine );
+
+                corner.Tangent = ProjectToPlane( faceTangent, normal ) * angle;
+            }
+        }
+    } );
+
+    // 頂点ごとに参照している角の一覧を作る.
+    std::vector< u32 > offsets( vertexCount + 1, 0 );
+    for( u32 i=0; i<cornerCount; ++i )
+    {
+        if ( indices[i] < vertexCount )
+        { offsets[ indices[i] + 1 ]++; }
+    }
+
+    for( u32 i=0; i<vertexCount; ++i )
+    { offsets[ i + 1 ] += offsets[i]; }
+
+    std::vector< u32 > vertexCorners( offsets[ vertexCount ] );
+    {
+        std::vector< u32 > cursor( offsets.begin(), offsets.end() - 1 );
+        for( u32 i=0; i<cornerCount; ++i )
+        {
+            if ( indices[i] < vertexCount )
+            { vertexCorners[ cursor[ indices[i] ]++ ] = i; }
+        }
+    }
+
+    // 頂点ごとに向きの同じ角を合計する. 多い方の向きを元の頂点に割り当て, 少ない方は分割する.
+    std::vector< s8 >            primary  ( vertexCount, ORIENT_POSITIVE );
+    std::vector< u8 >            needSplit( vertexCount, 0 );
+    std::vector< asdx::Vector3 > secondary( vertexCount );
+    std::vector< u8 >            fallback ( vertexCount, 0 );
+    ThreadPool::RunRange( pPool, vertexCount, VERTEX_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 v=begin; v<end; ++v )
+        {
+            asdx::Vector3 sumPositive( 0.0f, 0.0f, 0.0f );
+            asdx::Vector3 sumNegative( 0.0f, 0.0f, 0.0f );
+            u32 countPositive = 0;
+            u32 countNegative = 0;
+
+            for( u32 i=offsets[v]; i<offsets[ v + 1 ]; ++i )
+            {
+                const Corner& corner = corners[ vertexCorners[i] ];
+                if ( corner.Orient == ORIENT_POSITIVE )
+                {
+                    sumPositive += corner.Tangent;
+                    countPositive++;
+                }
+                else if ( corner.Orient == ORIENT_NEGATIVE )
+                {
+                    sumNegative += corner.Tangent;
+                    countNegative++;
+                }
+            }
+
+            asdx::Vector3 normal = ToVector3( vertices[v].Normal );
+            bool positive = ( countPositive >= countNegative );
+            primary[v] = ( positive ) ? ORIENT_POSITIVE : ORIENT_NEGATIVE;
+
+            if ( !ResolveTangent( ( positive ) ? sumPositive : sumNegative, normal, vertices[v].Tangent ) )
+            { fallback[v] = 1; }
+
+            if ( countPositive > 0 && countNegative > 0 )
+            {
+                needSplit[v] = 1;
+                secondary[v] = ( positive ) ? sumNegative : sumPositive;
+            }
+        }
+    } );
+
+    // 向きの混在する頂点を分割して, 少ない方の向きの角を付け替える.
+    u32 splitCount    = 0;
+    u32 fallbackCount = 0;
+    for( u32 v=0; v<vertexCount; ++v )
+    {
+        if ( fallback[v] )
+        { fallbackCount++; }
+
+        if ( !needSplit[v] )
+        { continue; }
+
+        MshVertex vertex = vertices[v];
+        ResolveTangent( secondary[v], ToVector3( vertex.Normal ), vertex.Tangent );
+
+        u32 newIndex = u32( vertices.size() );
+        vertices.push_back( vertex );
+        splitCount++;
+
+        for( u32 i=offsets[v]; i<offsets[ v + 1 ]; ++i )
+        {
+            u32 c = vertexCorners[i];
+            if ( corners[c].Orient != ORIENT_DEGENERATE && corners[c].Orient != primary[v] )
+            { indices[c] = newIndex; }
+        }
+    }
+
+    if ( pStats != nullptr )
+    {
+        for( u32 t=0; t<triangleCount; ++t )
+        {
+            if ( corners[ t * 3 ].Orient == ORIENT_DEGENERATE )
+            { pStats->DegenerateTriangles++; }
+        }
+
+        pStats->SplitVertices    = splitCount;
+        pStats->FallbackVertices = fallbackCount;
+    }
+}
@@ -0,0 +1,465 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TextureCache.cpp
+// Desc : Texture Cache Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <TextureCache.h>
+#include <MapTexture.h>
+#include <asdxUtil.h>
+#include <asdxLog.h>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+
+namespace /* anonymous */ {
+
+//-----------------------------------------------------------------------------------
+//      ダミーテクスチャのファイル名です.
+//-----------------------------------------------------------------------------------
+static const char* DUMMY_FILENAME[ TextureCache::NUM_DUMMY_TYPE ] = {
+    "dummyDiffuse.map",
+    "dummySpecular.map",
+    "dummyBump.map",
+};
+
+//-----------------------------------------------------------------------------------
+//      MAPフォーマットに対応するDXGIフォーマットを取得します.
+//-----------------------------------------------------------------------------------
+DXGI_FORMAT ToDxgiFormat( u32 format )
+{
+    switch( format )
+    {
+    case MAP_FORMAT_R8:
+        return DXGI_FORMAT_R8_UNORM;
+
+    case MAP_FORMAT_BC3:
+        return DXGI_FORMAT_BC3_UNORM;
+
+    case MAP_FORMAT_BC1:
+        return DXGI_FORMAT_BC1_UNORM;
+
+    case MAP_FORMAT_BC4:
+        return DXGI_FORMAT_BC4_UNORM;
+
+    case MAP_FORMAT_BC5:
+        return DXGI_FORMAT_BC5_UNORM;
+
+    case MAP_FORMAT_BC7:
+        return DXGI_FORMAT_BC7_UNORM;
+
+    default:
+        break;
+    }
+
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込み済みのMAPテクスチャからテクスチャを生成します.
+//-----------------------------------------------------------------------------------
+bool CreateFromMap
+(
+    ID3D11Device*               pDevice,
+    const MapTexture&           image,
+    ID3D11Texture2D**           ppTexture,
+    ID3D11ShaderResourceView**  ppSRV
+)
+{
+    DXGI_FORMAT format = ToDxgiFormat( image.GetFormat() );
+    if ( pDevice == nullptr || format == DXGI_FORMAT_UNKNOWN )
+    { return false; }
+
+    // サーフェイスはミップレベル + 配列番号 * ミップマップ数 の順に並んでいるので, そのままサブリソースになる.
+    // ピクセルデータはマップした領域を直接渡すので, コピーは発生しない.
+    u32 count = image.GetMipMapCount() * image.GetSurfaceCount();
+    std::vector< D3D11_SUBRESOURCE_DATA > res( count );
+    for( u32 i=0; i<count; ++i )
+    {
+        const MapTexture::Surface& surface = image.GetSurface( i );
+        res[i].pSysMem          = surface.pPixels;
+        res[i].SysMemPitch      = surface.Pitch;
+        res[i].SysMemSlicePitch = surface.SlicePitch;
+    }
+
+    D3D11_TEXTURE2D_DESC desc;
+    ZeroMemory( &desc, sizeof( desc ) );
+    desc.Width              = image.GetWidth();
+    desc.Height             = image.GetHeight();
+    desc.MipLevels          = image.GetMipMapCount();
+    desc.ArraySize          = image.GetSurfaceCount();
+    desc.Format             = format;
+    desc.SampleDesc.Count   = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage              = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags          = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags     = 0;
+
+    HRESULT hr = pDevice->CreateTexture2D( &desc, &res[0], ppTexture );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateTexture2D() Failed." );
+        return false;
+    }
+
+    hr = pDevice->CreateShaderResourceView( (*ppTexture), nullptr, ppSRV );
+    if ( FAILED( hr ) )
+    {
+        ELOG( "Error : ID3D11Device::CreateShaderResourceView() Failed." );
+        ASDX_RELEASE( (*ppTexture) );
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TextureCache::SharedTexture structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct TextureCache::SharedTexture
+{
+    std::string                 Path;           //!< ファイルパスです.
+    ID3D11Texture2D*            pTexture;       //!< テクスチャです(読み込みに失敗した場合はnullptr).
+    ID3D11ShaderResourceView*   pSRV;           //!< シェーダリソースビューです(読み込みに失敗した場合はnullptr).
+    u32                         RefCount;       //!< 参照カウントです.
+    bool                        IsReady;        //!< 読み込みを終えたかどうか(Registry::Mutex で保護します).
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TextureCache::Registry structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct TextureCache::Registry
+{
+    std::mutex                                  Mutex;          //!< ミューテックスです.
+    std::condition_variable                     Ready;          //!< 読み込みを終えたことを通知する条件変数です.
+    std::map< std::string, SharedTexture* >     Textures;       //!< ファイルパスごとの共有テクスチャです.
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TextureCache class
+/////////////////////////////////////////////////////////////////////////////////////
+TextureCache::Registry TextureCache::s_Registry;
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+TextureCache::TextureCache()
+: m_pDevice         ( nullptr )
+, m_ResFolderPath   ()
+, m_Entries         ()
+, m_LoadedCount     ( 0 )
+, m_RequestCount    ( 0 )
+{
+    for( u32 i=0; i<NUM_DUMMY_TYPE; ++i )
+    { m_pDummy[i] = nullptr; }
+}
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+TextureCache::~TextureCache()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool TextureCache::Init( ID3D11Device* pDevice, const char* resFolderPath, const char* dummyFolderPath, ThreadPool* pPool )
+{
+    Term();
+
+    if ( pDevice == nullptr )
+    {
+        ELOG( "Error : Invalid Argument." );
+        return false;
+    }
+
+    m_pDevice       = pDevice;
+    m_ResFolderPath = ( resFolderPath != nullptr ) ? resFolderPath : "";
+
+    // ダミーテクスチャも他のキャッシュと共有するので, 読み込むのはプロセス内で1度だけになる.
+    std::string dummyPath = ( dummyFolderPath != nullptr ) ? dummyFolderPath : "";
+    std::vector< std::string > paths( NUM_DUMMY_TYPE );
+    for( u32 i=0; i<NUM_DUMMY_TYPE; ++i )
+    { paths[i] = dummyPath + DUMMY_FILENAME[i]; }
+
+    Acquire( pDevice, paths, pPool, m_pDummy );
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void TextureCache::Term()
+{
+    for( size_t i=0; i<m_Entries.size(); ++i )
+    {
+        if ( m_Entries[i].pTexture != nullptr )
+        { Release( m_Entries[i].pTexture ); }
+    }
+    m_Entries.clear();
+
+    for( u32 i=0; i<NUM_DUMMY_TYPE; ++i )
+    {
+        if ( m_pDummy[i] != nullptr )
+        {
+            Release( m_pDummy[i] );
+            m_pDummy[i] = nullptr;
+        }
+    }
+
+    m_pDevice       = nullptr;
+    m_LoadedCount   = 0;
+    m_RequestCount  = 0;
+    m_ResFolderPath.clear();
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列IDに対応するテクスチャを取得します.
+//-----------------------------------------------------------------------------------
+ID3D11ShaderResourceView* TextureCache::Resolve( const StringTable& strings, u32 id, DUMMY_TYPE fallback )
+{
+    m_RequestCount++;
+
+    ID3D11ShaderResourceView* pDummy = GetSRV( m_pDummy[ fallback ] );
+    if ( id == StringTable::INVALID_ID || id >= strings.GetCount() )
+    { return pDummy; }
+
+    // 先読みしていなければ, ここで読み込む.
+    Prefetch( strings, &id, 1, nullptr );
+
+    ID3D11ShaderResourceView* pSRV = GetSRV( m_Entries[ id ].pTexture );
+    return ( pSRV != nullptr ) ? pSRV : pDummy;
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列IDに対応するテクスチャをまとめて読み込んでおきます.
+//-----------------------------------------------------------------------------------
+void TextureCache::Prefetch( const StringTable& strings, const u32* pIds, u32 count, ThreadPool* pPool )
+{
+    if ( pIds == nullptr || count == 0 )
+    { return; }
+
+    if ( m_Entries.size() < strings.GetCount() )
+    {
+        Entry entry;
+        entry.pTexture   = nullptr;
+        entry.IsResolved = false;
+        m_Entries.resize( strings.GetCount(), entry );
+    }
+
+    // まだ読み込みを試していないIDだけを集める.
+    std::vector< u32 >          ids;
+    std::vector< std::string >  paths;
+    for( u32 i=0; i<count; ++i )
+    {
+        u32 id = pIds[i];
+        if ( id == StringTable::INVALID_ID || id >= strings.GetCount() || m_Entries[ id ].IsResolved )
+        { continue; }
+
+        m_Entries[ id ].IsResolved = true;
+        ids  .push_back( id );
+        paths.push_back( m_ResFolderPath + strings.GetString( id ) );
+    }
+
+    if ( ids.empty() )
+    { return; }
+
+    std::vector< SharedTexture* > textures( ids.size(), nullptr );
+    Acquire( m_pDevice, paths, pPool, &textures[0] );
+
+    for( size_t i=0; i<ids.size(); ++i )
+    {
+        m_Entries[ ids[i] ].pTexture = textures[i];
+        if ( textures[i]->pSRV != nullptr )
+        { m_LoadedCount++; }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      読み込んだテクスチャ数を取得します.
+//-----------------------------------------------------------------------------------
+u32 TextureCache::GetLoadedCount() const
+{ return m_LoadedCount; }
+
+//-----------------------------------------------------------------------------------
+//      Resolve() の呼び出し回数を取得します.
+//-----------------------------------------------------------------------------------
+u32 TextureCache::GetRequestCount() const
+{ return m_RequestCount; }
+
+//-----------------------------------------------------------------------------------
+//      内容を交換します.
+//-----------------------------------------------------------------------------------
+void TextureCache::Swap( TextureCache& value )
+{
+    std::swap( m_pDevice, value.m_pDevice );
+    m_ResFolderPath.swap( value.m_ResFolderPath );
+    m_Entries      .swap( value.m_Entries );
+    for( u32 i=0; i<NUM_DUMMY_TYPE; ++i )
+    { std::swap( m_pDummy[i], value.m_pDummy[i] ); }
+    std::swap( m_LoadedCount,  value.m_LoadedCount );
+    std::swap( m_RequestCount, value.m_RequestCount );
+}
+
+//-----------------------------------------------------------------------------------
+//      全てのキャッシュで共有しているテクスチャ数を取得します.
+//-----------------------------------------------------------------------------------
+u32 TextureCache::GetSharedCount()
+{
+    std::lock_guard< std::mutex > locker( s_Registry.Mutex );
+    return u32( s_Registry.Textures.size() );
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイルパスに対応する共有テクスチャの参照を取得します.
+//-----------------------------------------------------------------------------------
+void TextureCache::Acquire
+(
+    ID3D11Device*                       pDevice,
+    const std::vector< std::string >&   paths,
+    ThreadPool*                         pPool,
+    SharedTexture**                     ppResults
+)
+{
+    // 登録済みのものは参照カウントを増やすだけにして, 未登録のものだけを読み込む.
+    // 他のスレッドが読み込み中のものは, 自分の分を読み込んだ後で完了を待つ.
+    std::vector< SharedTexture* > created;
+    std::vector< SharedTexture* > waiting;
+    {
+        std::lock_guard< std::mutex > locker( s_Registry.Mutex );
+        for( size_t i=0; i<paths.size(); ++i )
+        {
+            std::map< std::string, SharedTexture* >::iterator itr = s_Registry.Textures.find( paths[i] );
+            if ( itr != s_Registry.Textures.end() )
+            {
+                itr->second->RefCount++;
+                ppResults[i] = itr->second;
+                if ( !itr->second->IsReady )
+                { waiting.push_back( itr->second ); }
+                continue;
+            }
+
+            SharedTexture* pTexture = new SharedTexture();
+            pTexture->Path     = paths[i];
+            pTexture->pTexture = nullptr;
+            pTexture->pSRV     = nullptr;
+            pTexture->RefCount = 1;
+            pTexture->IsReady  = false;
+
+            s_Registry.Textures[ paths[i] ] = pTexture;
+            created.push_back( pTexture );
+            ppResults[i] = pTexture;
+        }
+    }
+
+    if ( !created.empty() )
+    { Load( pDevice, created, pPool ); }
+
+    if ( waiting.empty() )
+    { return; }
+
+    std::unique_lock< std::mutex > locker( s_Registry.Mutex );
+    for( size_t i=0; i<waiting.size(); ++i )
+    {
+        SharedTexture* pTexture = waiting[i];
+        s_Registry.Ready.wait( locker, [pTexture]() { return pTexture->IsReady; } );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      登録した共有テクスチャを読み込んで, 読み込みを待っているスレッドに通知します.
+//-----------------------------------------------------------------------------------
+void TextureCache::Load
+(
+    ID3D11Device*                           pDevice,
+    const std::vector< SharedTexture* >&    created,
+    ThreadPool*                             pPool
+)
+{
+    // ファイルのマップと解析, ページインはデバイスを使わないので, ファイルごとに並列に行う.
+    u32 count = u32( created.size() );
+    std::unique_ptr< MapTexture[] > images( new MapTexture[ count ] );
+    std::vector< u8 >               loaded( count, 0 );
+
+    ThreadPool::RangeJob job = [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        {
+            if ( images[i].LoadFromFile( created[i]->Path.c_str() ) )
+            {
+                images[i].Touch();
+                loaded[i] = 1;
+            }
+            else
+            { ELOG( "Warning : MapTexture::LoadFromFile() Failed. filename = %s, %s", created[i]->Path.c_str(), images[i].GetError() ); }
+        }
+    };
+
+    ThreadPool::RunRange( pPool, count, 1, job );
+
+    // テクスチャの生成は呼び出しスレッドで行う.
+    for( u32 i=0; i<count; ++i )
+    {
+        SharedTexture* pTexture = created[i];
+        if ( loaded[i] && CreateFromMap( pDevice, images[i], &pTexture->pTexture, &pTexture->pSRV ) )
+        {
+            images[i].Release();
+            continue;
+        }
+        images[i].Release();
+
+        // 対応していないフォーマットは asdx::Texture2D に任せる.
+        asdx::Texture2D texture;
+        if ( pDevice != nullptr && texture.CreateFromFile( pDevice, pTexture->Path.c_str() ) )
+        {
+            pTexture->pTexture = texture.GetTexture();
+            pTexture->pSRV     = texture.GetSRV();
+            pTexture->pTexture->AddRef();
+            pTexture->pSRV    ->AddRef();
+        }
+        else
+        { ELOG( "Warning : Texture Load Failed. filename = %s", pTexture->Path.c_str() ); }
+    }
+
+    // 読み込みに失敗したものも完了扱いにして, 待っている側はダミーテクスチャを使う.
+    {
+        std::lock_guard< std::mutex > locker( s_Registry.Mutex );
+        for( u32 i=0; i<count; ++i )
+        { created[i]->IsReady = true; }
+    }
+    s_Registry.Ready.notify_all();
+}
+
+//-----------------------------------------------------------------------------------
+//      共有テクスチャの参照を解放します.
+//-----------------------------------------------------------------------------------
+void TextureCache::Release( SharedTexture* pTexture )
+{
+    std::lock_guard< std::mutex > locker( s_Registry.Mutex );
+
+    pTexture->RefCount--;
+    if ( pTexture->RefCount > 0 )
+    { return; }
+
+    s_Registry.Textures.erase( pTexture->Path );
+    ASDX_RELEASE( pTexture->pSRV );
+    ASDX_RELEASE( pTexture->pTexture );
+    delete pTexture;
+}
+
+//-----------------------------------------------------------------------------------
+//      共有テクスチャのシェーダリソースビューを取得します.
+//-----------------------------------------------------------------------------------
+ID3D11ShaderResourceView* TextureCache::GetSRV( const SharedTexture* pTexture )
+{ return ( pTexture != nullptr ) ? pTexture->pSRV : nullptr; }
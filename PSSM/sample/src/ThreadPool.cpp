@@ -0,0 +1,281 @@
+﻿//-----------------------------------------------------------------------------------
+// File : ThreadPool.cpp
+// Desc : Thread Pool Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ThreadPool.h>
+#include <asdxMath.h>
+#include <memory>
+
+
+namespace /* anonymous */ {
+
+// 1スレッドあたりに割り当てる最大ジョブ数.
+static const u32 JOBS_PER_THREAD = 4;
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// RangeCounter structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct RangeCounter
+{
+    std::mutex              Mutex;      //!< ミューテックスです.
+    std::condition_variable Cond;       //!< 条件変数です.
+    u32                     Remain;     //!< 残りジョブ数です.
+};
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+ThreadPool::ThreadPool()
+: m_Threads  ()
+, m_Queue    ()
+, m_BusyCount( 0 )
+, m_IsTerm   ( false )
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{ Term(); }
+
+//-----------------------------------------------------------------------------------
+//      初期化処理です.
+//-----------------------------------------------------------------------------------
+bool ThreadPool::Init( u32 threadCount )
+{
+    if ( !m_Threads.empty() )
+    { return false; }
+
+    if ( threadCount == 0 )
+    {
+        u32 hardwareCount = std::thread::hardware_concurrency();
+        threadCount = ( hardwareCount > 1 ) ? hardwareCount - 1 : 1;
+    }
+
+    m_IsTerm    = false;
+    m_BusyCount = 0;
+
+    m_Threads.reserve( threadCount );
+    for( u32 i=0; i<threadCount; ++i )
+    { m_Threads.push_back( std::thread( &ThreadPool::WorkerMain, this ) ); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      終了処理です.
+//-----------------------------------------------------------------------------------
+void ThreadPool::Term()
+{
+    if ( m_Threads.empty() )
+    { return; }
+
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        m_IsTerm = true;
+    }
+    m_WakeCond.notify_all();
+
+    for( size_t i=0; i<m_Threads.size(); ++i )
+    { m_Threads[i].join(); }
+
+    m_Threads.clear();
+    m_Queue.clear();
+}
+
+//-----------------------------------------------------------------------------------
+//      ジョブを追加します.
+//-----------------------------------------------------------------------------------
+void ThreadPool::Push( const Job& job )
+{
+    if ( m_Threads.empty() )
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        m_Queue.push_back( job );
+    }
+    m_WakeCond.notify_one();
+}
+
+//-----------------------------------------------------------------------------------
+//      全てのジョブの完了を待機します.
+//-----------------------------------------------------------------------------------
+void ThreadPool::Wait()
+{
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    while( !m_Queue.empty() || m_BusyCount > 0 )
+    {
+        if ( !TryRunOne( lock ) )
+        { m_DoneCond.wait( lock ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      範囲を分割して並列実行します.
+//-----------------------------------------------------------------------------------
+void ThreadPool::ParallelFor( u32 count, u32 grain, const RangeJob& job )
+{
+    if ( count == 0 )
+    { return; }
+
+    u32 jobCount = GetSlotCount( count, grain );
+    u32 stride   = ( count + jobCount - 1 ) / jobCount;
+
+    // 分割できない場合はそのまま実行.
+    if ( jobCount == 1 || m_Threads.empty() )
+    {
+        for( u32 i=0, begin=0; begin<count; ++i, begin+=stride )
+        { job( begin, asdx::Min( begin + stride, count ), i ); }
+        return;
+    }
+
+    std::shared_ptr< RangeCounter > counter( new RangeCounter() );
+    counter->Remain = jobCount;
+
+    {
+        std::lock_guard< std::mutex > locker( m_Mutex );
+        for( u32 i=0; i<jobCount; ++i )
+        {
+            u32 begin = i * stride;
+            u32 end   = asdx::Min( begin + stride, count );
+            m_Queue.push_back( [=, &job]()
+            {
+                if ( begin < end )
+                { job( begin, end, i ); }
+
+                std::lock_guard< std::mutex > counterLocker( counter->Mutex );
+                if ( --counter->Remain == 0 )
+                { counter->Cond.notify_all(); }
+            });
+        }
+    }
+    m_WakeCond.notify_all();
+
+    // 呼び出しスレッドもキューを消化しながら完了を待つ.
+    for( ;; )
+    {
+        {
+            std::lock_guard< std::mutex > counterLocker( counter->Mutex );
+            if ( counter->Remain == 0 )
+            { break; }
+        }
+
+        std::unique_lock< std::mutex > lock( m_Mutex );
+        if ( TryRunOne( lock ) )
+        { continue; }
+        lock.unlock();
+
+        std::unique_lock< std::mutex > counterLock( counter->Mutex );
+        while( counter->Remain > 0 )
+        { counter->Cond.wait( counterLock ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      ワーカースレッド数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ThreadPool::GetThreadCount() const
+{ return u32( m_Threads.size() ); }
+
+//-----------------------------------------------------------------------------------
+//      ParallelFor() で渡されるスロット番号の最大数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ThreadPool::GetSlotCount( u32 count, u32 grain ) const
+{
+    if ( count == 0 )
+    { return 1; }
+
+    grain = asdx::Max( grain, 1u );
+
+    u32 rangeCount = ( count + grain - 1 ) / grain;
+    u32 maxCount   = ( u32( m_Threads.size() ) + 1 ) * JOBS_PER_THREAD;
+    u32 jobCount   = asdx::Clamp( rangeCount, 1u, maxCount );
+
+    // 空の範囲が出来ないように調整.
+    u32 stride = ( count + jobCount - 1 ) / jobCount;
+    return ( count + stride - 1 ) / stride;
+}
+
+//-----------------------------------------------------------------------------------
+//      スレッドプールがあれば並列に, 無ければ呼び出しスレッドで範囲ジョブを実行します.
+//-----------------------------------------------------------------------------------
+void ThreadPool::RunRange( ThreadPool* pPool, u32 count, u32 grain, const RangeJob& job )
+{
+    if ( pPool != nullptr )
+    {
+        pPool->ParallelFor( count, grain, job );
+        return;
+    }
+
+    if ( count > 0 )
+    { job( 0, count, 0 ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      RunRange() で渡されるスロット番号の最大数を取得します.
+//-----------------------------------------------------------------------------------
+u32 ThreadPool::GetRangeSlotCount( ThreadPool* pPool, u32 count, u32 grain )
+{
+    if ( pPool != nullptr )
+    { return pPool->GetSlotCount( count, grain ); }
+
+    return 1;
+}
+
+//-----------------------------------------------------------------------------------
+//      ワーカースレッドのメイン処理です.
+//-----------------------------------------------------------------------------------
+void ThreadPool::WorkerMain()
+{
+    std::unique_lock< std::mutex > lock( m_Mutex );
+    for( ;; )
+    {
+        if ( TryRunOne( lock ) )
+        { continue; }
+
+        if ( m_IsTerm )
+        { break; }
+
+        m_WakeCond.wait( lock );
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      キューからジョブを1つ取り出して実行します.
+//-----------------------------------------------------------------------------------
+bool ThreadPool::TryRunOne( std::unique_lock< std::mutex >& lock )
+{
+    if ( m_Queue.empty() )
+    { return false; }
+
+    Job job = m_Queue.front();
+    m_Queue.pop_front();
+    m_BusyCount++;
+
+    lock.unlock();
+    job();
+    lock.lock();
+
+    m_BusyCount--;
+    if ( m_Queue.empty() && m_BusyCount == 0 )
+    { m_DoneCond.notify_all(); }
+
+    return true;
+}
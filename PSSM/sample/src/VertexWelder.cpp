@@ -0,0 +1,297 @@
+﻿//-----------------------------------------------------------------------------------
+// File : VertexWelder.cpp
+// Desc : Vertex Welder Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <VertexWelder.h>
+#include <asdxMath.h>
+#include <cmath>
+
+
+namespace /* anonymous */ {
+
+// 並列処理の粒度.
+static const u32 VERTEX_GRAIN = 4096;
+static const u32 BUCKET_GRAIN = 1024;
+static const u32 INDEX_GRAIN  = 16384;
+
+// 接ベクトルが設定されていないとみなす長さ.
+static const f32 TANGENT_EPSILON = 1e-6f;
+
+//-----------------------------------------------------------------------------------
+//      セルの座標からハッシュ値を求めます.
+//-----------------------------------------------------------------------------------
+u32 ComputeHash( const s64* cell )
+{
+    u64 hash = 0;
+    const u64 primes[3] = { 0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL };
+    for( u32 i=0; i<3; ++i )
+    { hash ^= u64( cell[i] ) * primes[i]; }
+
+    // 近いセル同士が同じバケットに偏らないように混ぜる.
+    hash ^= ( hash >> 33 );
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= ( hash >> 33 );
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= ( hash >> 33 );
+
+    return u32( hash );
+}
+
+//-----------------------------------------------------------------------------------
+//      位置座標を含むセルのバケットを求めます.
+//-----------------------------------------------------------------------------------
+u32 ComputeBucket( const f32* position, f64 invCellSize, u32 bucketMask )
+{
+    s64 cell[3];
+    for( u32 i=0; i<3; ++i )
+    { cell[i] = s64( floor( f64( position[i] ) * invCellSize ) ); }
+
+    return ComputeHash( cell ) & bucketMask;
+}
+
+//-----------------------------------------------------------------------------------
+//      許容誤差内の頂点が入りうるセルのバケットを求めます.
+//-----------------------------------------------------------------------------------
+u32 ComputeNeighborBuckets( const f32* position, f64 invCellSize, u32 bucketMask, u32* pBuckets )
+{
+    // セルの一辺は許容誤差の4倍なので, 許容誤差内の頂点は各軸で自分のセルか近い側の隣のセルに入る.
+    // 丸め誤差でセルの境界に乗っても取りこぼさないように, 2倍ではなく4倍にして余裕を持たせている.
+    s64 cell[3];
+    s64 side[3];
+    for( u32 i=0; i<3; ++i )
+    {
+        f64 value = f64( position[i] ) * invCellSize;
+        cell[i] = s64( floor( value ) );
+        side[i] = ( value - f64( cell[i] ) < 0.5 ) ? -1 : 1;
+    }
+
+    u32 count = 0;
+    for( u32 n=0; n<8; ++n )
+    {
+        s64 neighbor[3];
+        for( u32 i=0; i<3; ++i )
+        { neighbor[i] = ( n & ( 1 << i ) ) ? cell[i] + side[i] : cell[i]; }
+
+        // ハッシュが衝突したバケットを何度も調べないように除く.
+        u32 bucket = ComputeHash( neighbor ) & bucketMask;
+        bool found = false;
+        for( u32 i=0; i<count && !found; ++i )
+        { found = ( pBuckets[i] == bucket ); }
+
+        if ( !found )
+        { pBuckets[ count++ ] = bucket; }
+    }
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------------
+//      ベクトルが設定されているかどうかチェックします.
+//-----------------------------------------------------------------------------------
+inline bool HasVector( const f32* value )
+{ return ( value[0] * value[0] + value[1] * value[1] + value[2] * value[2] ) > TANGENT_EPSILON; }
+
+//-----------------------------------------------------------------------------------
+//      方向の差が許容誤差内かどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool IsSameDirection( const f32* lhs, const f32* rhs, f32 tolerance )
+{
+    f32 lenSq = ( lhs[0] * lhs[0] + lhs[1] * lhs[1] + lhs[2] * lhs[2] )
+              * ( rhs[0] * rhs[0] + rhs[1] * rhs[1] + rhs[2] * rhs[2] );
+    if ( lenSq <= 0.0f )
+    { return ( lhs[0] == rhs[0] && lhs[1] == rhs[1] && lhs[2] == rhs[2] ); }
+
+    f32 dot = lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+    return dot >= tolerance * sqrtf( lenSq );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点が許容誤差内で一致するかどうかチェックします.
+//-----------------------------------------------------------------------------------
+bool IsEqual( const MshVertex& lhs, const MshVertex& rhs, const VertexWelder::Config& config )
+{
+    for( u32 i=0; i<3; ++i )
+    {
+        if ( fabs( lhs.Position[i] - rhs.Position[i] ) > config.PositionTolerance )
+        { return false; }
+    }
+
+    for( u32 i=0; i<2; ++i )
+    {
+        if ( fabs( lhs.TexCoord[i] - rhs.TexCoord[i] ) > config.TexCoordTolerance )
+        { return false; }
+    }
+
+    if ( !IsSameDirection( lhs.Normal, rhs.Normal, config.NormalTolerance ) )
+    { return false; }
+
+    bool hasTangent = HasVector( lhs.Tangent );
+    if ( hasTangent != HasVector( rhs.Tangent ) )
+    { return false; }
+
+    if ( hasTangent && !IsSameDirection( lhs.Tangent, rhs.Tangent, config.NormalTolerance ) )
+    { return false; }
+
+    return true;
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// VertexWelder class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      重複する頂点を結合します.
+//-----------------------------------------------------------------------------------
+void VertexWelder::Weld
+(
+    std::vector< MshVertex >&   vertices,
+    std::vector< u32 >&         indices,
+    const Config&               config,
+    ThreadPool*                 pPool,
+    Statistics*                 pStats
+)
+{
+    u32 vertexCount = u32( vertices.size() );
+
+    if ( pStats != nullptr )
+    {
+        *pStats = Statistics();
+        pStats->VertexCountBefore = vertexCount;
+        pStats->VertexCountAfter  = vertexCount;
+    }
+
+    if ( vertexCount <= 1 )
+    { return; }
+
+    // バケット数は頂点数以上の2の累乗にする.
+    u32 bucketCount = 1;
+    while( bucketCount < vertexCount && bucketCount < 0x80000000 )
+    { bucketCount <<= 1; }
+    const u32 bucketMask = bucketCount - 1;
+
+    f64 cellSize    = asdx::Max( f64( config.PositionTolerance ) * 4.0, 1e-12 );
+    f64 invCellSize = 1.0 / cellSize;
+
+    // ハッシュ値を並列に求める.
+    std::vector< u32 > buckets( vertexCount );
+    ThreadPool::RunRange( pPool, vertexCount, VERTEX_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        { buckets[i] = ComputeBucket( vertices[i].Position, invCellSize, bucketMask ); }
+    } );
+
+    // バケットごとに頂点番号を並べる. 頂点番号の小さい順に詰めるので, バケット内も番号順になる.
+    std::vector< u32 > offsets( bucketCount + 1, 0 );
+    for( u32 i=0; i<vertexCount; ++i )
+    { offsets[ buckets[i] + 1 ]++; }
+
+    for( u32 i=0; i<bucketCount; ++i )
+    { offsets[ i + 1 ] += offsets[i]; }
+
+    std::vector< u32 > sorted( vertexCount );
+    {
+        std::vector< u32 > cursor( offsets.begin(), offsets.end() - 1 );
+        for( u32 i=0; i<vertexCount; ++i )
+        { sorted[ cursor[ buckets[i] ]++ ] = i; }
+    }
+
+    // 隣のセルも含めて, 自分より前で一致する最小の頂点番号を並列に求める.
+    std::vector< u32 > match( vertexCount );
+    ThreadPool::RunRange( pPool, vertexCount, VERTEX_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        u32 neighbors[ 8 ];
+        for( u32 i=begin; i<end; ++i )
+        {
+            match[i] = i;
+
+            u32 count = ComputeNeighborBuckets( vertices[i].Position, invCellSize, bucketMask, neighbors );
+            for( u32 n=0; n<count; ++n )
+            {
+                u32 b = neighbors[n];
+                for( u32 k=offsets[b]; k<offsets[ b + 1 ] && sorted[k] < match[i]; ++k )
+                {
+                    if ( IsEqual( vertices[ sorted[k] ], vertices[i], config ) )
+                    {
+                        match[i] = sorted[k];
+                        break;
+                    }
+                }
+            }
+        }
+    } );
+
+    // 番号順に代表を決める. 一致した頂点が既に他の代表に結合されている場合だけ, 代表の中から探し直す.
+    std::vector< u32 > representative( vertexCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        u32 other = match[i];
+        representative[i] = other;
+        if ( other == i || representative[ other ] == other )
+        { continue; }
+
+        representative[i] = i;
+
+        u32 neighbors[ 8 ];
+        u32 count = ComputeNeighborBuckets( vertices[i].Position, invCellSize, bucketMask, neighbors );
+        for( u32 n=0; n<count; ++n )
+        {
+            u32 b = neighbors[n];
+            for( u32 k=offsets[b]; k<offsets[ b + 1 ] && sorted[k] < representative[i]; ++k )
+            {
+                u32 index = sorted[k];
+                if ( representative[ index ] == index && IsEqual( vertices[ index ], vertices[i], config ) )
+                {
+                    representative[i] = index;
+                    break;
+                }
+            }
+        }
+    }
+
+    // 代表の頂点だけを元の順番で詰める. 代表は必ず自分より前にあるので, 1回の走査で番号が決まる.
+    std::vector< u32 > remap( vertexCount );
+    u32 weldedCount = 0;
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        u32 other = representative[i];
+        remap[i] = ( other == i ) ? weldedCount++ : remap[ other ];
+    }
+
+    if ( pStats != nullptr )
+    {
+        pStats->VertexCountAfter = weldedCount;
+        pStats->BucketCount      = bucketCount;
+        for( u32 i=0; i<bucketCount; ++i )
+        { pStats->MaxBucketSize = asdx::Max( pStats->MaxBucketSize, offsets[ i + 1 ] - offsets[i] ); }
+    }
+
+    if ( weldedCount == vertexCount )
+    { return; }
+
+    std::vector< MshVertex > welded( weldedCount );
+    for( u32 i=0; i<vertexCount; ++i )
+    {
+        if ( representative[i] == i )
+        { welded[ remap[i] ] = vertices[i]; }
+    }
+
+    u32 indexCount = u32( indices.size() );
+    ThreadPool::RunRange( pPool, indexCount, INDEX_GRAIN, [&]( u32 begin, u32 end, u32 )
+    {
+        for( u32 i=begin; i<end; ++i )
+        {
+            if ( indices[i] < vertexCount )
+            { indices[i] = remap[ indices[i] ]; }
+        }
+    } );
+
+    vertices.swap( welded );
+}
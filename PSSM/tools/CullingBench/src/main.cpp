@@ -0,0 +1,555 @@
+﻿//-----------------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Culling Bench Command Line Entry Point.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+//
+// 使い方 :
+//     CullingBench [-j threads] [-n frames]
+//
+//     GPUを使わずにカリングモジュールの判定結果を確認します.
+//     最後に街並みのシーンでオクルージョンカリングによる描画数の削減と処理時間を計測します.
+//     全ての確認に成功した場合は 0 を, 1つでも失敗した場合は 1 を返します.
+//     -j でワーカースレッド数を指定します(省略時はハードウェアスレッド数-1).
+//     -n で計測するフレーム数を指定します(省略時は200).
+//
+// Linux でのビルド :
+//     g++ -std=c++11 -O2 -pthread -I../../sample/include -I../../asdx/include
+//         src/main.cpp ../../sample/src/ShadowCasterCuller.cpp
+//         ../../sample/src/OcclusionCuller.cpp ../../sample/src/ThreadPool.cpp -o CullingBench
+//
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <ShadowCasterCuller.h>
+#include <OcclusionCuller.h>
+#include <FrustumCulling.h>
+#include <ThreadPool.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+
+namespace /* anonymous */ {
+
+// オクルージョンバッファの解像度です.
+static const u32 OCCLUSION_WIDTH  = 320;
+static const u32 OCCLUSION_HEIGHT = 180;
+
+// 街並みのシーンの設定です.
+static const u32 BLOCK_COUNT     = 8;           // 一辺の街区数です.
+static const f32 BLOCK_PITCH     = 20.0f;       // 街区の間隔です.
+static const f32 BUILDING_SIZE   = 14.0f;       // 建物の幅です.
+static const f32 BUILDING_HEIGHT = 30.0f;       // 建物の高さです.
+static const u32 CHUNKS_PER_BLOCK = 4;          // 街区あたりのチャンク数です.
+
+// 箱の頂点インデックスです.
+static const u32 BOX_INDICES[ 36 ] = {
+    0, 2, 1,  1, 2, 3,      // -Z
+    4, 5, 6,  5, 7, 6,      // +Z
+    0, 1, 4,  1, 5, 4,      // -Y
+    2, 6, 3,  3, 6, 7,      // +Y
+    0, 4, 2,  2, 4, 6,      // -X
+    1, 3, 5,  3, 7, 5,      // +X
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CityScene structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct CityScene
+{
+    std::vector< asdx::Vector3 >        Positions;      //!< 遮蔽物(建物)の頂点位置です.
+    std::vector< u32 >                  Indices;        //!< 遮蔽物(建物)の頂点インデックスです.
+    std::vector< asdx::BoundingBox >    Buildings;      //!< 建物のAABBです.
+    std::vector< asdx::BoundingBox >    Objects;        //!< 描画するオブジェクト(インスタンスとチャンク)のAABBです.
+    u32                                 InstanceCount;  //!< オブジェクトのうちインスタンスの数です.
+    asdx::Vector3                       Eye;            //!< カメラ位置です.
+    asdx::Matrix                        ViewProj;       //!< ビュー射影行列です.
+};
+
+//-----------------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------------
+bool Check( const char* name, bool result )
+{
+    printf( "%s %s\n", ( result ) ? "[ OK ]" : "[ NG ]", name );
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      真上から照らした地面に対するキャスターカリングを確認します.
+//-----------------------------------------------------------------------------------
+bool CheckShadowCaster()
+{
+    // ライトは (0, 50, 0) から真下を向く.
+    asdx::Matrix lightView = asdx::Matrix::CreateLookTo(
+        asdx::Vector3( 0.0f, 50.0f, 0.0f ),
+        asdx::Vector3( 0.0f, -1.0f, 0.0f ),
+        asdx::Vector3( 0.0f,  0.0f, 1.0f ) );
+
+    // 可視レシーバー領域は地面付近の薄い箱.
+    asdx::Vector3 region[ 8 ];
+    for( u32 i=0; i<8; ++i )
+    {
+        region[i] = asdx::Vector3(
+            ( i & 0x1 ) ? 10.0f : -10.0f,
+            ( i & 0x2 ) ?  1.0f :  -1.0f,
+            ( i & 0x4 ) ? 10.0f : -10.0f );
+    }
+
+    asdx::BoundingBox ground( asdx::Vector3( -10.0f, -1.0f, -10.0f ), asdx::Vector3( 10.0f, 0.0f, 10.0f ) );
+    asdx::BoundingBox above ( asdx::Vector3(  -1.0f,  5.0f,  -1.0f ), asdx::Vector3(  1.0f, 7.0f,  1.0f ) );
+    asdx::BoundingBox below ( asdx::Vector3(  -1.0f, -9.0f,  -1.0f ), asdx::Vector3(  1.0f,-7.0f,  1.0f ) );
+    asdx::BoundingBox aside ( asdx::Vector3(  30.0f,  5.0f,  -1.0f ), asdx::Vector3( 32.0f, 7.0f,  1.0f ) );
+
+    bool result = true;
+    ShadowCasterCuller culler;
+
+    // レシーバー指定あり.
+    culler.Begin( lightView, region, 8 );
+    culler.AddReceiver( ground );
+    result &= Check( "caster above the ground is kept",   culler.TestCaster( above ) );
+    result &= Check( "caster below the ground is culled", !culler.TestCaster( below ) );
+    result &= Check( "caster beside the ground is culled", !culler.TestCaster( aside ) );
+
+    // レシーバー指定なし(可視レシーバー領域全体がレシーバー).
+    culler.Begin( lightView, region, 8 );
+    result &= Check( "caster above the region is kept",   culler.TestCaster( above ) );
+    result &= Check( "caster below the region is culled", !culler.TestCaster( below ) );
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      チャンクごとのキャスターカリングを確認します.
+//-----------------------------------------------------------------------------------
+bool CheckChunkCaster()
+{
+    // サンプルと同じく, メッシュ全体をレシーバーとして各チャンクを判定する.
+    asdx::Matrix lightView = asdx::Matrix::CreateLookTo(
+        asdx::Vector3( 0.0f, 50.0f, 0.0f ),
+        asdx::Vector3( 0.0f, -1.0f, 0.0f ),
+        asdx::Vector3( 0.0f,  0.0f, 1.0f ) );
+
+    // 地面から上に積み重なった 8 個のチャンク.
+    static const u32 CHUNK_COUNT = 8;
+    asdx::BoundingBox chunks[ CHUNK_COUNT ];
+    for( u32 i=0; i<CHUNK_COUNT; ++i )
+    {
+        f32 y = f32( i ) * 2.0f;
+        chunks[i] = asdx::BoundingBox( asdx::Vector3( -2.0f, y, -2.0f ), asdx::Vector3( 2.0f, y + 2.0f, 2.0f ) );
+    }
+    asdx::BoundingBox whole( asdx::Vector3( -2.0f, 0.0f, -2.0f ), asdx::Vector3( 2.0f, f32( CHUNK_COUNT ) * 2.0f, 2.0f ) );
+
+    // 可視レシーバー領域は地面の高さだけを含む.
+    asdx::Vector3 region[ 8 ];
+    for( u32 i=0; i<8; ++i )
+    {
+        region[i] = asdx::Vector3(
+            ( i & 0x1 ) ? 10.0f : -10.0f,
+            ( i & 0x2 ) ?  1.0f :  -1.0f,
+            ( i & 0x4 ) ? 10.0f : -10.0f );
+    }
+
+    ShadowCasterCuller culler;
+    culler.Begin( lightView, region, 8 );
+    culler.AddReceiver( whole );
+
+    u32 keptCount = 0;
+    for( u32 i=0; i<CHUNK_COUNT; ++i )
+    {
+        if ( culler.TestCaster( chunks[i] ) )
+        { keptCount++; }
+    }
+
+    return Check( "chunks between the light and the receiver are kept", keptCount == CHUNK_COUNT );
+}
+
+//-----------------------------------------------------------------------------------
+//      視錐台とAABBの判定を確認します.
+//-----------------------------------------------------------------------------------
+bool CheckFrustum()
+{
+    asdx::Matrix view = asdx::Matrix::CreateLookAt(
+        asdx::Vector3( 0.0f, 0.0f, 10.0f ),
+        asdx::Vector3( 0.0f, 0.0f,  0.0f ),
+        asdx::Vector3( 0.0f, 1.0f,  0.0f ) );
+    asdx::Matrix proj = asdx::Matrix::CreatePerspectiveFieldOfView( asdx::F_PIDIV4, 1.0f, 1.0f, 100.0f );
+    asdx::BoundingFrustum frustum( view * proj );
+
+    asdx::BoundingBox inside ( asdx::Vector3(  -1.0f, -1.0f, -1.0f ), asdx::Vector3(  1.0f, 1.0f,  1.0f ) );
+    asdx::BoundingBox behind ( asdx::Vector3(  -1.0f, -1.0f, 20.0f ), asdx::Vector3(  1.0f, 1.0f, 22.0f ) );
+    asdx::BoundingBox side   ( asdx::Vector3(  50.0f, -1.0f, -1.0f ), asdx::Vector3( 52.0f, 1.0f,  1.0f ) );
+    asdx::BoundingBox overlap( asdx::Vector3(  -1.0f, -1.0f,  5.0f ), asdx::Vector3(  1.0f, 1.0f, 20.0f ) );
+
+    bool result = true;
+    result &= Check( "box inside the frustum is visible",     !IsOutside( frustum, inside ) );
+    result &= Check( "box behind the camera is outside",       IsOutside( frustum, behind ) );
+    result &= Check( "box beside the frustum is outside",      IsOutside( frustum, side ) );
+    result &= Check( "box crossing the near plane is visible", !IsOutside( frustum, overlap ) );
+    return result;
+}
+
+
+
+//-----------------------------------------------------------------------------------
+//      AABBを囲む箱の三角形を追加します.
+//-----------------------------------------------------------------------------------
+void AppendBox( const asdx::BoundingBox& box, std::vector< asdx::Vector3 >& positions, std::vector< u32 >& indices )
+{
+    u32 base = u32( positions.size() );
+    for( u32 i=0; i<8; ++i )
+    {
+        positions.push_back( asdx::Vector3(
+            ( i & 0x1 ) ? box.maxi.x : box.mini.x,
+            ( i & 0x2 ) ? box.maxi.y : box.mini.y,
+            ( i & 0x4 ) ? box.maxi.z : box.mini.z ) );
+    }
+
+    for( u32 i=0; i<36; ++i )
+    { indices.push_back( base + BOX_INDICES[ i ] ); }
+}
+
+//-----------------------------------------------------------------------------------
+//      線分がAABBを通過するかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool IntersectSegment( const asdx::BoundingBox& box, const asdx::Vector3& start, const asdx::Vector3& end )
+{
+    f32 tmin = 0.0f;
+    f32 tmax = 1.0f;
+    const f32 p[3] = { start.x, start.y, start.z };
+    const f32 d[3] = { end.x - start.x, end.y - start.y, end.z - start.z };
+    const f32 mini[3] = { box.mini.x, box.mini.y, box.mini.z };
+    const f32 maxi[3] = { box.maxi.x, box.maxi.y, box.maxi.z };
+
+    for( u32 i=0; i<3; ++i )
+    {
+        if ( fabs( d[i] ) < 1e-8f )
+        {
+            if ( p[i] < mini[i] || p[i] > maxi[i] )
+            { return false; }
+            continue;
+        }
+
+        f32 t0 = ( mini[i] - p[i] ) / d[i];
+        f32 t1 = ( maxi[i] - p[i] ) / d[i];
+        if ( t0 > t1 )
+        { std::swap( t0, t1 ); }
+
+        tmin = asdx::Max( tmin, t0 );
+        tmax = asdx::Min( tmax, t1 );
+        if ( tmin > tmax )
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      オブジェクトの一部がカメラから直接見えるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool HasLineOfSight( const CityScene& scene, const asdx::BoundingBox& box )
+{
+    // 中心と, 中心に少し寄せた8角へ視線を飛ばす.
+    asdx::Vector3 center = ( box.mini + box.maxi ) * 0.5f;
+    for( u32 i=0; i<9; ++i )
+    {
+        asdx::Vector3 target = center;
+        if ( i < 8 )
+        {
+            asdx::Vector3 corner(
+                ( i & 0x1 ) ? box.maxi.x : box.mini.x,
+                ( i & 0x2 ) ? box.maxi.y : box.mini.y,
+                ( i & 0x4 ) ? box.maxi.z : box.mini.z );
+            target = asdx::Vector3::Lerp( center, corner, 0.99f );
+        }
+
+        // 画面外の点は見えない.
+        asdx::Vector4 clip;
+        asdx::Vector4::Transform( asdx::Vector4( target, 1.0f ), scene.ViewProj, clip );
+        if ( clip.w <= 0.0f || fabs( clip.x ) > clip.w || fabs( clip.y ) > clip.w || clip.z < 0.0f || clip.z > clip.w )
+        { continue; }
+
+        bool blocked = false;
+        for( size_t j=0; j<scene.Buildings.size() && !blocked; ++j )
+        { blocked = IntersectSegment( scene.Buildings[j], scene.Eye, target ); }
+
+        if ( !blocked )
+        { return true; }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      街並みのシーンを作成します.
+//-----------------------------------------------------------------------------------
+void CreateCityScene( CityScene& scene )
+{
+    f32 half = f32( BLOCK_COUNT - 1 ) * 0.5f;
+    f32 yard = ( BLOCK_PITCH + BUILDING_SIZE ) * 0.25f;     // 建物と道路の間の中心までの距離.
+
+    // 街区ごとに建物を1つ, 建物の裏にインスタンスを1つ, 四隅にチャンクを置く.
+    std::vector< asdx::BoundingBox > chunks;
+    for( u32 z=0; z<BLOCK_COUNT; ++z )
+    {
+        for( u32 x=0; x<BLOCK_COUNT; ++x )
+        {
+            asdx::Vector3 center( ( f32( x ) - half ) * BLOCK_PITCH, 0.0f, ( f32( z ) - half ) * BLOCK_PITCH );
+
+            asdx::BoundingBox building(
+                center + asdx::Vector3( -BUILDING_SIZE * 0.5f, 0.0f,            -BUILDING_SIZE * 0.5f ),
+                center + asdx::Vector3(  BUILDING_SIZE * 0.5f, BUILDING_HEIGHT,  BUILDING_SIZE * 0.5f ) );
+            scene.Buildings.push_back( building );
+            AppendBox( building, scene.Positions, scene.Indices );
+
+            asdx::Vector3 instance = center + asdx::Vector3( 0.0f, 0.0f, yard );
+            scene.Objects.push_back( asdx::BoundingBox(
+                instance + asdx::Vector3( -1.0f, 0.0f, -1.0f ),
+                instance + asdx::Vector3(  1.0f, 2.0f,  1.0f ) ) );
+
+            for( u32 i=0; i<CHUNKS_PER_BLOCK; ++i )
+            {
+                asdx::Vector3 corner = center + asdx::Vector3(
+                    ( i & 0x1 ) ? yard : -yard,
+                    0.0f,
+                    ( i & 0x2 ) ? yard : -yard );
+                chunks.push_back( asdx::BoundingBox(
+                    corner + asdx::Vector3( -0.75f, 0.0f, -0.75f ),
+                    corner + asdx::Vector3(  0.75f, 3.0f,  0.75f ) ) );
+            }
+        }
+    }
+
+    scene.InstanceCount = u32( scene.Objects.size() );
+    scene.Objects.insert( scene.Objects.end(), chunks.begin(), chunks.end() );
+
+    // 街の外から中央の道路に沿って少し斜めに見る.
+    f32 edge = half * BLOCK_PITCH + BLOCK_PITCH;
+    scene.Eye = asdx::Vector3( 0.0f, 2.0f, -edge );
+    asdx::Matrix view = asdx::Matrix::CreateLookAt(
+        scene.Eye,
+        asdx::Vector3( BLOCK_PITCH, 2.0f, edge ),
+        asdx::Vector3( 0.0f, 1.0f, 0.0f ) );
+    asdx::Matrix proj = asdx::Matrix::CreatePerspectiveFieldOfView(
+        asdx::F_PIDIV4,
+        f32( OCCLUSION_WIDTH ) / f32( OCCLUSION_HEIGHT ),
+        0.1f,
+        1000.0f );
+    scene.ViewProj = view * proj;
+}
+
+//-----------------------------------------------------------------------------------
+//      遮蔽物と被遮蔽物の判定を確認します.
+//-----------------------------------------------------------------------------------
+bool CheckOcclusion( ThreadPool* pPool )
+{
+    asdx::Matrix view = asdx::Matrix::CreateLookAt(
+        asdx::Vector3( 0.0f, 0.0f, 10.0f ),
+        asdx::Vector3( 0.0f, 0.0f,  0.0f ),
+        asdx::Vector3( 0.0f, 1.0f,  0.0f ) );
+    asdx::Matrix proj = asdx::Matrix::CreatePerspectiveFieldOfView( asdx::F_PIDIV4, 1.0f, 1.0f, 100.0f );
+
+    // 原点に置いた 4x4 の壁を遮蔽物にする.
+    std::vector< asdx::Vector3 > positions;
+    std::vector< u32 >           indices;
+    AppendBox( asdx::BoundingBox( asdx::Vector3( -2.0f, -2.0f, -0.1f ), asdx::Vector3( 2.0f, 2.0f, 0.1f ) ), positions, indices );
+
+    OcclusionCuller culler;
+    if ( !culler.Init( OCCLUSION_HEIGHT, OCCLUSION_HEIGHT, pPool ) )
+    { return Check( "occlusion culler is initialized", false ); }
+
+    asdx::Matrix world;
+    world.Identity();
+
+    culler.Begin( view * proj );
+    culler.AddOccluder( world, &positions[0], sizeof( asdx::Vector3 ), u32( positions.size() ), &indices[0], u32( indices.size() ) );
+    culler.Flush();
+
+    asdx::BoundingBox behind ( asdx::Vector3( -0.5f, -0.5f, -5.5f ), asdx::Vector3( 0.5f, 0.5f, -4.5f ) );
+    asdx::BoundingBox front  ( asdx::Vector3( -0.5f, -0.5f,  4.5f ), asdx::Vector3( 0.5f, 0.5f,  5.5f ) );
+    asdx::BoundingBox beside ( asdx::Vector3(  3.5f, -0.5f, -5.5f ), asdx::Vector3( 4.5f, 0.5f, -4.5f ) );
+    asdx::BoundingBox larger ( asdx::Vector3( -4.0f, -4.0f, -5.5f ), asdx::Vector3( 4.0f, 4.0f, -4.5f ) );
+
+    bool result = true;
+    result &= Check( "occludee behind the wall is culled",       !culler.TestBox( behind ) );
+    result &= Check( "occludee in front of the wall is visible",  culler.TestBox( front ) );
+    result &= Check( "occludee beside the wall is visible",       culler.TestBox( beside ) );
+    result &= Check( "occludee larger than the wall is visible",  culler.TestBox( larger ) );
+
+    // 画面を覆う壁の後ろの大きな箱は, 粗いレベルだけで遮蔽と判定される.
+    positions.clear();
+    indices.clear();
+    AppendBox( asdx::BoundingBox( asdx::Vector3( -50.0f, -50.0f, -0.1f ), asdx::Vector3( 50.0f, 50.0f, 0.1f ) ), positions, indices );
+
+    culler.Begin( view * proj );
+    culler.AddOccluder( world, &positions[0], sizeof( asdx::Vector3 ), u32( positions.size() ), &indices[0], u32( indices.size() ) );
+    culler.Flush();
+
+    asdx::BoundingBox large( asdx::Vector3( -6.0f, -6.0f, -5.5f ), asdx::Vector3( 6.0f, 6.0f, -4.5f ) );
+    result &= Check( "large occludee behind a screen-filling wall is culled", !culler.TestBox( large ) );
+
+    culler.Term();
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      1フレーム分のオクルージョンカリングを行います.
+//-----------------------------------------------------------------------------------
+u32 RunOcclusionFrame( OcclusionCuller& culler, const CityScene& scene, const std::vector< u8 >& frustumVisible, std::vector< u8 >& visible )
+{
+    asdx::Matrix world;
+    world.Identity();
+
+    culler.Begin( scene.ViewProj );
+    culler.AddOccluder(
+        world,
+        &scene.Positions[0],
+        sizeof( asdx::Vector3 ),
+        u32( scene.Positions.size() ),
+        &scene.Indices[0],
+        u32( scene.Indices.size() ) );
+    culler.Flush();
+    culler.TestBoxes( &scene.Objects[0], u32( scene.Objects.size() ), &visible[0] );
+
+    u32 count = 0;
+    for( size_t i=0; i<visible.size(); ++i )
+    {
+        visible[i] &= frustumVisible[i];
+        count += visible[i];
+    }
+
+    return count;
+}
+
+//-----------------------------------------------------------------------------------
+//      街並みのシーンで描画数の削減と処理時間を計測します.
+//-----------------------------------------------------------------------------------
+bool BenchOcclusion( ThreadPool* pPool, u32 frameCount )
+{
+    CityScene scene;
+    CreateCityScene( scene );
+
+    u32 objectCount = u32( scene.Objects.size() );
+
+    // 視錐台カリングだけの場合の描画数.
+    asdx::BoundingFrustum frustum( scene.ViewProj );
+    std::vector< u8 > frustumVisible( objectCount, 0 );
+    u32 frustumCount = 0;
+    for( u32 i=0; i<objectCount; ++i )
+    {
+        frustumVisible[i] = IsOutside( frustum, scene.Objects[i] ) ? 0 : 1;
+        frustumCount += frustumVisible[i];
+    }
+
+    OcclusionCuller culler;
+    if ( !culler.Init( OCCLUSION_WIDTH, OCCLUSION_HEIGHT, pPool ) )
+    { return Check( "occlusion culler is initialized", false ); }
+
+    std::vector< u8 > visible( objectCount, 0 );
+    u32 occlusionCount = RunOcclusionFrame( culler, scene, frustumVisible, visible );
+
+    u32 instanceCount = 0;
+    for( u32 i=0; i<scene.InstanceCount; ++i )
+    { instanceCount += visible[i]; }
+
+    // 視線が通るオブジェクトを消していないか確認する.
+    u32 wrongCount = 0;
+    for( u32 i=0; i<objectCount; ++i )
+    {
+        if ( visible[i] == 0 && HasLineOfSight( scene, scene.Objects[i] ) )
+        { wrongCount++; }
+    }
+
+    // 計測.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( u32 i=0; i<frameCount; ++i )
+    { RunOcclusionFrame( culler, scene, frustumVisible, visible ); }
+    f64 elapsed = std::chrono::duration< f64, std::milli >( std::chrono::steady_clock::now() - start ).count();
+
+    printf( "city scene : %u occluders (%u triangles), %u objects (%u instances, %u chunks), %ux%u buffer\n",
+        u32( scene.Buildings.size() ),
+        u32( scene.Indices.size() / 3 ),
+        objectCount,
+        scene.InstanceCount,
+        objectCount - scene.InstanceCount,
+        OCCLUSION_WIDTH,
+        OCCLUSION_HEIGHT );
+    printf( "    no culling        : %u draws\n", objectCount );
+    printf( "    frustum culling   : %u draws\n", frustumCount );
+    printf( "    + occlusion       : %u draws (%u instances, %.1f%% fewer than frustum culling)\n",
+        occlusionCount,
+        instanceCount,
+        ( frustumCount > 0 ) ? 100.0 * f64( frustumCount - occlusionCount ) / f64( frustumCount ) : 0.0 );
+    printf( "    occlusion time    : %.3f ms/frame (%u frames, %u worker threads)\n",
+        ( frameCount > 0 ) ? elapsed / f64( frameCount ) : 0.0,
+        frameCount,
+        ( pPool != nullptr ) ? pPool->GetThreadCount() : 0 );
+
+    bool result = true;
+    result &= Check( "occlusion culling reduces the draw count", occlusionCount < frustumCount );
+    result &= Check( "objects in the line of sight are never culled", wrongCount == 0 );
+
+    culler.Term();
+    return result;
+}
+
+//-----------------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf( "usage : CullingBench [-j threads] [-n frames]\n" );
+    printf( "    -j threads   number of worker threads.\n" );
+    printf( "    -n frames    number of frames to measure.\n" );
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------------
+int main( int argc, char** argv )
+{
+    u32 threadCount = 0;
+    u32 frameCount  = 200;
+
+    // 引数を解析.
+    for( int i=1; i<argc; ++i )
+    {
+        if ( strcmp( argv[i], "-j" ) == 0 && i + 1 < argc )
+        { threadCount = u32( atoi( argv[ ++i ] ) ); }
+        else if ( strcmp( argv[i], "-n" ) == 0 && i + 1 < argc )
+        { frameCount = u32( atoi( argv[ ++i ] ) ); }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    ThreadPool pool;
+    if ( !pool.Init( threadCount ) )
+    {
+        fprintf( stderr, "Error : ThreadPool::Init() Failed.\n" );
+        return -1;
+    }
+
+    bool result = true;
+    result &= CheckShadowCaster();
+    result &= CheckChunkCaster();
+    result &= CheckFrustum();
+    result &= CheckOcclusion( &pool );
+    result &= BenchOcclusion( &pool, frameCount );
+
+    pool.Term();
+
+    printf( "%s\n", ( result ) ? "all checks passed." : "some checks failed." );
+    return ( result ) ? 0 : 1;
+}
@@ -0,0 +1,215 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshCooker.h
+// Desc : Mesh Cooker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __MESH_COOKER_H__
+#define __MESH_COOKER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <CookedMeshFormat.h>
+#include <MeshOptimizer.h>
+#include <SubsetBatcher.h>
+#include <MeshChunker.h>
+#include <VertexWelder.h>
+#include <TangentGenerator.h>
+#include <ProgressiveMeshBuilder.h>
+#include <string>
+#include <vector>
+#include <map>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// MeshCooker class
+//////////////////////////////////////////////////////////////////////////////////////
+class MeshCooker
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //////////////////////////////////////////////////////////////////////////////////
+    // RESULT enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum RESULT
+    {
+        RESULT_COOKED = 0,          //!< クックしました.
+        RESULT_UP_TO_DATE,          //!< 出力ファイルが最新のためスキップしました.
+        RESULT_FAILED,              //!< 失敗しました.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     VertexCount;              //!< 頂点数です.
+        u32     SourceVertexCount;        //!< 結合前の頂点数です.
+        u32     WeldedVertexCount;        //!< 結合後の頂点数です.
+        u32     TangentSplitCount;        //!< 接ベクトルの生成で分割した頂点数です.
+        u32     IndexCount;               //!< 頂点インデックス数です.
+        u32     MaterialCount;            //!< マテリアル数です.
+        u32     SubsetCount;              //!< サブセット数です.
+        u32     SourceSubsetCount;        //!< 結合前のサブセット数です.
+        u32     MaterialChangesBefore;    //!< 並び替え前のマテリアルの切り替え回数です.
+        u32     MaterialChangesAfter;     //!< 並び替え後のマテリアルの切り替え回数です.
+        u32     ChunkCount;               //!< 空間分割のチャンク数です.
+        u32     BaseTriangleCount;        //!< ストリーミング用の基本LODの三角形数です.
+        u32     StreamingBaseSize;        //!< ストリーミング用ファイルの先頭部分のサイズです.
+        u64     StreamingFileSize;        //!< ストリーミング用ファイルのサイズです(出力しない場合は 0).
+        u32     StringTableSize;          //!< 文字列テーブルのサイズです.
+        u64     FileSize;                 //!< 出力ファイルサイズです.
+        bool    GeneratedTangent;         //!< 接ベクトルを生成したかどうか.
+        f32     ACMRBefore;               //!< 最適化前のACMRです.
+        f32     ACMRAfter;                //!< 最適化後のACMRです.
+        f32     ATVRBefore;               //!< 最適化前のATVRです.
+        f32     ATVRAfter;                //!< 最適化後のATVRです.
+
+        Statistics()
+        : VertexCount           ( 0 )
+        , SourceVertexCount     ( 0 )
+        , WeldedVertexCount     ( 0 )
+        , TangentSplitCount     ( 0 )
+        , IndexCount            ( 0 )
+        , MaterialCount         ( 0 )
+        , SubsetCount           ( 0 )
+        , SourceSubsetCount     ( 0 )
+        , MaterialChangesBefore ( 0 )
+        , MaterialChangesAfter  ( 0 )
+        , ChunkCount            ( 0 )
+        , BaseTriangleCount     ( 0 )
+        , StreamingBaseSize     ( 0 )
+        , StreamingFileSize     ( 0 )
+        , StringTableSize       ( 0 )
+        , FileSize              ( 0 )
+        , GeneratedTangent      ( false )
+        , ACMRBefore            ( 0.0f )
+        , ACMRAfter             ( 0.0f )
+        , ATVRBefore            ( 0.0f )
+        , ATVRAfter             ( 0.0f )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    MeshCooker();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~MeshCooker();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      出力ファイルが最新でもクックし直すかどうか設定します.
+    //!
+    //! @param [in]     value       クックし直す場合は true を指定します.
+    //-------------------------------------------------------------------------------
+    void SetForce( bool value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      頂点の結合・接ベクトルの生成に使うスレッドプールを設定します.
+    //!
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //! @note       ThreadPool::ParallelFor() はジョブ内から呼び出せるので, ファイル単位の並列処理と併用できます.
+    //-------------------------------------------------------------------------------
+    void SetThreadPool( ThreadPool* pPool );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      ストリーミング用の .smsh ファイルも出力するかどうか設定します.
+    //!
+    //! @param [in]     value       出力する場合は true を指定します.
+    //! @note       .smsh ファイルは出力ファイルの拡張子を .smsh に置き換えた名前で出力します.
+    //-------------------------------------------------------------------------------
+    void SetStreaming( bool value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      .msh ファイルをクックして .cmsh ファイルに出力します.
+    //!
+    //! @param [in]     input       入力ファイル名です.
+    //! @param [in]     output      出力ファイル名です.
+    //! @return     処理結果を返却します.
+    //-------------------------------------------------------------------------------
+    RESULT Cook( const char* input, const char* output );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      エラーメッセージを取得します.
+    //!
+    //! @return     最後に失敗した処理のエラーメッセージを返却します.
+    //-------------------------------------------------------------------------------
+    const std::string& GetError() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @return     最後にクックしたメッシュの統計情報を返却します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    bool                        m_Force;            //!< 常にクックし直すかどうか.
+    bool                        m_Streaming;        //!< ストリーミング用ファイルも出力するかどうか.
+    ThreadPool*                 m_pPool;            //!< スレッドプールです.
+    std::string                 m_Error;            //!< エラーメッセージです.
+    Statistics                  m_Statistics;       //!< 統計情報です.
+    MeshOptimizer               m_Optimizer;        //!< メッシュ最適化です.
+
+    std::vector< MshVertex >    m_Vertices;         //!< 頂点データです.
+    std::vector< u32 >          m_Indices;          //!< 頂点インデックスデータです.
+    std::vector< MshMaterial >  m_Materials;        //!< マテリアルデータです.
+    std::vector< MshSubset >    m_Subsets;          //!< サブセットデータです.
+    std::vector< CookedChunk >  m_Chunks;           //!< チャンクデータです.
+    std::vector< char >         m_StringTable;      //!< 文字列テーブルです.
+    std::map< std::string, u32 > m_StringOffsets;   //!< 登録済み文字列のオフセットです.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    bool Load( const u8* pData, u64 size );
+    bool Validate();
+    bool IsUpToDate( const char* output, u64 sourceHash ) const;
+    void WeldVertices();
+    bool GenerateTangents();
+    void BatchSubsets();
+    void ChunkSubsets();
+    void Optimize();
+    void ComputeBounds( u32 indexOffset, u32 indexCount, CookedBounds& result ) const;
+    u32  AddString( const char* value, u32 maxLength );
+    void BuildMaterials( std::vector< CookedMaterial >& materials );
+    bool Write( const char* output, u64 sourceHash, u32 flags );
+    bool WriteStreaming( const char* output, u64 sourceHash, u32 flags );
+    bool WriteFile( const char* output, const std::vector< u8 >& image );
+
+    bool SetError( const char* format, ... );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    MeshCooker      ( const MeshCooker& );      // アクセス禁止.
+    void operator = ( const MeshCooker& );      // アクセス禁止.
+};
+
+#endif//__MESH_COOKER_H__
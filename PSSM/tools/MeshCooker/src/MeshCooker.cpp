@@ -0,0 +1,737 @@
+﻿//-----------------------------------------------------------------------------------
+// File : MeshCooker.cpp
+// Desc : Mesh Cooker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshCooker.h>
+#include <MappedFile.h>
+#include <asdxMath.h>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+
+
+namespace /* anonymous */ {
+
+// 接ベクトルが設定されていないとみなす長さ.
+static const f32 TANGENT_EPSILON = 1e-6f;
+
+//-----------------------------------------------------------------------------------
+//      アライメントを考慮したオフセットを求めます.
+//-----------------------------------------------------------------------------------
+inline u64 AlignOffset( u64 offset, u64 alignment = CMSH_ALIGNMENT )
+{ return ( offset + alignment - 1 ) & ~( alignment - 1 ); }
+
+//-----------------------------------------------------------------------------------
+//      配列から3次元ベクトルを取得します.
+//-----------------------------------------------------------------------------------
+inline asdx::Vector3 ToVector3( const f32* value )
+{ return asdx::Vector3( value[0], value[1], value[2] ); }
+
+//-----------------------------------------------------------------------------------
+//      3次元ベクトルを配列に格納します.
+//-----------------------------------------------------------------------------------
+inline void FromVector3( const asdx::Vector3& value, f32* result )
+{
+    result[0] = value.x;
+    result[1] = value.y;
+    result[2] = value.z;
+}
+
+//-----------------------------------------------------------------------------------
+//      ストリーミング用ファイルのファイル名を求めます.
+//-----------------------------------------------------------------------------------
+std::string GetStreamingFileName( const char* output )
+{
+    static const char* COOKED_EXTENSION = ".cmsh";
+
+    std::string result( output );
+    size_t length = strlen( COOKED_EXTENSION );
+    if ( result.size() >= length && result.compare( result.size() - length, length, COOKED_EXTENSION ) == 0 )
+    { result.erase( result.size() - length ); }
+
+    return result + ".smsh";
+}
+
+//-----------------------------------------------------------------------------------
+//      配列をイメージにコピーします.
+//-----------------------------------------------------------------------------------
+template< typename T >
+void CopyToImage( std::vector< u8 >& image, u64 offset, const std::vector< T >& values )
+{
+    if ( !values.empty() )
+    { memcpy( &image[ size_t( offset ) ], &values[0], sizeof( T ) * values.size() ); }
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MeshCooker class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+MeshCooker::MeshCooker()
+: m_Force       ( false )
+, m_Streaming   ( false )
+, m_pPool       ( nullptr )
+, m_Error       ()
+, m_Statistics  ()
+, m_Optimizer   ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+MeshCooker::~MeshCooker()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      出力ファイルが最新でもクックし直すかどうか設定します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::SetForce( bool value )
+{ m_Force = value; }
+
+//-----------------------------------------------------------------------------------
+//      スレッドプールを設定します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::SetThreadPool( ThreadPool* pPool )
+{ m_pPool = pPool; }
+
+//-----------------------------------------------------------------------------------
+//      ストリーミング用ファイルも出力するかどうか設定します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::SetStreaming( bool value )
+{ m_Streaming = value; }
+
+//-----------------------------------------------------------------------------------
+//      .msh ファイルをクックして .cmsh ファイルに出力します.
+//-----------------------------------------------------------------------------------
+MeshCooker::RESULT MeshCooker::Cook( const char* input, const char* output )
+{
+    m_Error.clear();
+    m_Statistics = Statistics();
+
+    MappedFile file;
+    if ( !file.Open( input ) )
+    {
+        SetError( "file open failed. filename = %s", input );
+        return RESULT_FAILED;
+    }
+
+    // 元ファイルが変わっていなければ何もしない.
+    u64 sourceHash = ComputeFnv1a64( file.GetData(), size_t( file.GetSize() ) );
+    if ( !m_Force && IsUpToDate( output, sourceHash ) )
+    { return RESULT_UP_TO_DATE; }
+
+    if ( !Load( file.GetData(), file.GetSize() ) )
+    { return RESULT_FAILED; }
+
+    file.Close();
+
+    if ( !Validate() )
+    { return RESULT_FAILED; }
+
+    // 接ベクトルは頂点番号で共有を判定するので, 先に重複する頂点を結合しておく.
+    u32 flags = 0;
+    WeldVertices();
+    flags |= CMSH_FLAG_WELDED;
+
+    if ( GenerateTangents() )
+    { flags |= CMSH_FLAG_GENERATED_TANGENT; }
+
+    // 三角形の並び替えはサブセットの範囲内で行うので, 先にサブセットを結合しておく.
+    BatchSubsets();
+    flags |= CMSH_FLAG_MATERIAL_SORTED;
+
+    // 大きなメッシュはチャンク単位でカリングできるように空間的に分割する.
+    // 分割後もチャンク内ではマテリアル順に並ぶ.
+    ChunkSubsets();
+    if ( !m_Chunks.empty() )
+    { flags |= CMSH_FLAG_CHUNKED; }
+
+    Optimize();
+    flags |= CMSH_FLAG_OPTIMIZED;
+
+    if ( !Write( output, sourceHash, flags ) )
+    { return RESULT_FAILED; }
+
+    // 粗い基本LODを先頭に置いたストリーミング用のファイルを並べて出力する.
+    if ( m_Streaming && !WriteStreaming( GetStreamingFileName( output ).c_str(), sourceHash, flags ) )
+    { return RESULT_FAILED; }
+
+    return RESULT_COOKED;
+}
+
+//-----------------------------------------------------------------------------------
+//      エラーメッセージを取得します.
+//-----------------------------------------------------------------------------------
+const std::string& MeshCooker::GetError() const
+{ return m_Error; }
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const MeshCooker::Statistics& MeshCooker::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      .msh ファイルのデータを読み込みます.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::Load( const u8* pData, u64 size )
+{
+    MshFileHeader header;
+    if ( size < sizeof( header ) )
+    { return SetError( "invalid file size." ); }
+
+    memcpy( &header, pData, sizeof( header ) );
+
+    if ( header.Magic[0] != 'M' || header.Magic[1] != 'S' || header.Magic[2] != 'H' || header.Magic[3] != '\0' )
+    { return SetError( "invalid file magic." ); }
+
+    if ( header.Version != MSH_VERSION || header.DataHeaderSize < MSH_DATA_HEADER_SIZE )
+    { return SetError( "unsupported file version. version = %u", header.Version ); }
+
+    const MshDataHeader& info = header.DataHeader;
+    if ( info.VertexStructureSize   != sizeof( MshVertex   )
+      || info.IndexStructureSize    != sizeof( u32         )
+      || info.MaterialStructureSize != sizeof( MshMaterial )
+      || info.SubsetStructureSize   != sizeof( MshSubset   ) )
+    { return SetError( "structure size mismatch." ); }
+
+    u64 offset = offsetof( MshFileHeader, DataHeader ) + u64( header.DataHeaderSize );
+    u64 end    = offset
+               + u64( info.NumVertices  ) * sizeof( MshVertex   )
+               + u64( info.NumIndices   ) * sizeof( u32         )
+               + u64( info.NumMaterials ) * sizeof( MshMaterial )
+               + u64( info.NumSubsets   ) * sizeof( MshSubset   );
+    if ( end > size )
+    { return SetError( "data out of range." ); }
+
+    // 元ファイルはアライメントされていない場合があるのでコピーする.
+    m_Vertices .resize( info.NumVertices  );
+    m_Indices  .resize( info.NumIndices   );
+    m_Materials.resize( info.NumMaterials );
+    m_Subsets  .resize( info.NumSubsets   );
+
+    if ( !m_Vertices.empty() )
+    { memcpy( &m_Vertices[0], pData + offset, sizeof( MshVertex ) * m_Vertices.size() ); }
+    offset += sizeof( MshVertex ) * m_Vertices.size();
+
+    if ( !m_Indices.empty() )
+    { memcpy( &m_Indices[0], pData + offset, sizeof( u32 ) * m_Indices.size() ); }
+    offset += sizeof( u32 ) * m_Indices.size();
+
+    if ( !m_Materials.empty() )
+    { memcpy( &m_Materials[0], pData + offset, sizeof( MshMaterial ) * m_Materials.size() ); }
+    offset += sizeof( MshMaterial ) * m_Materials.size();
+
+    if ( !m_Subsets.empty() )
+    { memcpy( &m_Subsets[0], pData + offset, sizeof( MshSubset ) * m_Subsets.size() ); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      データの整合性を検証します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::Validate()
+{
+    u32 vertexCount = u32( m_Vertices.size() );
+    for( size_t i=0; i<m_Indices.size(); ++i )
+    {
+        if ( m_Indices[i] >= vertexCount )
+        { return SetError( "index out of range. index[%u] = %u", u32( i ), m_Indices[i] ); }
+    }
+
+    for( size_t i=0; i<m_Subsets.size(); ++i )
+    {
+        const MshSubset& subset = m_Subsets[i];
+        if ( u64( subset.IndexOffset ) + subset.IndexCount > m_Indices.size() )
+        { return SetError( "subset index range out of range. subset = %u", u32( i ) ); }
+
+        if ( !m_Materials.empty() && subset.MaterialID >= m_Materials.size() )
+        { return SetError( "subset material out of range. subset = %u", u32( i ) ); }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      出力ファイルが最新かどうか判定します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::IsUpToDate( const char* output, u64 sourceHash ) const
+{
+    MappedFile file;
+    if ( !file.Open( output ) )
+    { return false; }
+
+    CookedMeshHeader header;
+    if ( file.GetSize() < sizeof( header ) )
+    { return false; }
+
+    memcpy( &header, file.GetData(), sizeof( header ) );
+
+    bool result = ( header.Magic[0] == 'C' && header.Magic[1] == 'M' && header.Magic[2] == 'S' && header.Magic[3] == 'H' )
+               && ( header.Version    == CMSH_VERSION )
+               && ( header.Flags      &  CMSH_FLAG_OPTIMIZED )
+               && ( header.Flags      &  CMSH_FLAG_MATERIAL_SORTED )
+               && ( header.Flags      &  CMSH_FLAG_WELDED )
+               && ( header.SourceHash == sourceHash )
+               && ( header.FileSize   == file.GetSize() );
+    if ( !result || !m_Streaming )
+    { return result; }
+
+    // ストリーミング用ファイルも同じ元ファイルから作られている必要がある.
+    MappedFile streaming;
+    if ( !streaming.Open( GetStreamingFileName( output ).c_str() ) )
+    { return false; }
+
+    StreamingMeshHeader streamingHeader;
+    if ( streaming.GetSize() < sizeof( streamingHeader ) )
+    { return false; }
+
+    memcpy( &streamingHeader, streaming.GetData(), sizeof( streamingHeader ) );
+
+    return ( streamingHeader.Magic[0] == 'S' && streamingHeader.Magic[1] == 'M' && streamingHeader.Magic[2] == 'S' && streamingHeader.Magic[3] == 'H' )
+        && ( streamingHeader.Version    == SMSH_VERSION )
+        && ( streamingHeader.SourceHash == sourceHash )
+        && ( streamingHeader.FileSize   == streaming.GetSize() );
+}
+
+//-----------------------------------------------------------------------------------
+//      重複する頂点を結合します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::WeldVertices()
+{
+    VertexWelder::Statistics stats;
+    VertexWelder::Weld( m_Vertices, m_Indices, VertexWelder::Config(), m_pPool, &stats );
+
+    m_Statistics.SourceVertexCount = stats.VertexCountBefore;
+    m_Statistics.WeldedVertexCount = stats.VertexCountAfter;
+}
+
+//-----------------------------------------------------------------------------------
+//      接ベクトルが設定されていない場合に生成します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::GenerateTangents()
+{
+    for( size_t i=0; i<m_Vertices.size(); ++i )
+    {
+        if ( ToVector3( m_Vertices[i].Tangent ).LengthSq() > TANGENT_EPSILON )
+        { return false; }
+    }
+
+    TangentGenerator::Statistics stats;
+    TangentGenerator::Generate( m_Vertices, m_Indices, m_pPool, &stats );
+
+    m_Statistics.TangentSplitCount = stats.SplitVertices;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセットをマテリアル順に並び替えて結合します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::BatchSubsets()
+{
+    SubsetBatcher::Statistics stats;
+    SubsetBatcher::SortAndMerge( m_Indices, m_Subsets, &stats );
+
+    m_Statistics.SourceSubsetCount     = stats.SubsetCountBefore;
+    m_Statistics.MaterialChangesBefore = stats.MaterialChangesBefore;
+    m_Statistics.MaterialChangesAfter  = stats.MaterialChangesAfter;
+}
+
+//-----------------------------------------------------------------------------------
+//      サブセットを空間的なチャンクに分割します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::ChunkSubsets()
+{
+    m_Chunks.clear();
+    if ( m_Vertices.empty() || m_Indices.empty() )
+    { return; }
+
+    MeshChunker::Statistics stats;
+    MeshChunker::Split(
+        m_Vertices[0].Position,
+        sizeof( MshVertex ),
+        u32( m_Vertices.size() ),
+        MeshChunker::Config(),
+        m_Indices,
+        m_Subsets,
+        m_Chunks,
+        &stats );
+
+    // 1つにしか分かれない場合はチャンクを持たせない.
+    if ( m_Chunks.size() <= 1 )
+    { m_Chunks.clear(); }
+
+    m_Statistics.ChunkCount = u32( m_Chunks.size() );
+}
+
+//-----------------------------------------------------------------------------------
+//      頂点キャッシュ・オーバードロー・頂点フェッチの最適化を行います.
+//-----------------------------------------------------------------------------------
+void MeshCooker::Optimize()
+{
+    if ( m_Vertices.empty() || m_Indices.empty() )
+    { return; }
+
+    // 三角形はサブセットの範囲内でのみ並び替える.
+    std::vector< MeshOptimizer::Range > ranges( m_Subsets.size() );
+    for( size_t i=0; i<m_Subsets.size(); ++i )
+    {
+        ranges[i].IndexOffset = m_Subsets[i].IndexOffset;
+        ranges[i].IndexCount  = m_Subsets[i].IndexCount;
+    }
+
+    m_Optimizer.Optimize(
+        &m_Vertices[0],
+        sizeof( MshVertex ),
+        u32( m_Vertices.size() ),
+        &m_Indices[0],
+        u32( m_Indices.size() ),
+        ( ranges.empty() ) ? nullptr : &ranges[0],
+        u32( ranges.size() ) );
+
+    const MeshOptimizer::Statistics& stats = m_Optimizer.GetStatistics();
+    m_Statistics.ACMRBefore = stats.Before.ACMR;
+    m_Statistics.ACMRAfter  = stats.After .ACMR;
+    m_Statistics.ATVRBefore = stats.Before.ATVR;
+    m_Statistics.ATVRAfter  = stats.After .ATVR;
+}
+
+//-----------------------------------------------------------------------------------
+//      インデックス範囲が参照する頂点のAABBを求めます.
+//-----------------------------------------------------------------------------------
+void MeshCooker::ComputeBounds( u32 indexOffset, u32 indexCount, CookedBounds& result ) const
+{
+    if ( indexCount == 0 )
+    {
+        memset( &result, 0, sizeof( result ) );
+        return;
+    }
+
+    asdx::Vector3 mini = ToVector3( m_Vertices[ m_Indices[ indexOffset ] ].Position );
+    asdx::Vector3 maxi = mini;
+    for( u32 i=1; i<indexCount; ++i )
+    {
+        asdx::Vector3 pos = ToVector3( m_Vertices[ m_Indices[ indexOffset + i ] ].Position );
+        mini = asdx::Vector3::Min( mini, pos );
+        maxi = asdx::Vector3::Max( maxi, pos );
+    }
+
+    FromVector3( mini, result.Min );
+    FromVector3( maxi, result.Max );
+}
+
+//-----------------------------------------------------------------------------------
+//      文字列テーブルに文字列を登録します.
+//-----------------------------------------------------------------------------------
+u32 MeshCooker::AddString( const char* value, u32 maxLength )
+{
+    // 終端されていない場合に備えて長さを制限する.
+    size_t length = 0;
+    while( length < maxLength && value[ length ] != '\0' )
+    { length++; }
+
+    if ( length == 0 )
+    { return CMSH_INVALID_STRING; }
+
+    std::string key( value, length );
+    std::map< std::string, u32 >::const_iterator itr = m_StringOffsets.find( key );
+    if ( itr != m_StringOffsets.end() )
+    { return itr->second; }
+
+    u32 offset = u32( m_StringTable.size() );
+    m_StringTable.insert( m_StringTable.end(), key.begin(), key.end() );
+    m_StringTable.push_back( '\0' );
+    m_StringOffsets[ key ] = offset;
+
+    return offset;
+}
+
+//-----------------------------------------------------------------------------------
+//      マテリアルのファイル名を文字列テーブルに移します.
+//-----------------------------------------------------------------------------------
+void MeshCooker::BuildMaterials( std::vector< CookedMaterial >& materials )
+{
+    m_StringTable.clear();
+    m_StringOffsets.clear();
+
+    materials.resize( m_Materials.size() );
+    for( size_t i=0; i<m_Materials.size(); ++i )
+    {
+        const MshMaterial& src = m_Materials[i];
+        CookedMaterial&    dst = materials[i];
+
+        memcpy( dst.Ambient,  src.Ambient,  sizeof( dst.Ambient  ) );
+        memcpy( dst.Diffuse,  src.Diffuse,  sizeof( dst.Diffuse  ) );
+        memcpy( dst.Specular, src.Specular, sizeof( dst.Specular ) );
+        memcpy( dst.Emissive, src.Emissive, sizeof( dst.Emissive ) );
+        dst.Alpha           = src.Alpha;
+        dst.Power           = src.Power;
+        dst.AmbientMap      = AddString( src.AmbientMap,      MSH_FILENAME_LENGTH );
+        dst.DiffuseMap      = AddString( src.DiffuseMap,      MSH_FILENAME_LENGTH );
+        dst.SpecularMap     = AddString( src.SpecularMap,     MSH_FILENAME_LENGTH );
+        dst.BumpMap         = AddString( src.BumpMap,         MSH_FILENAME_LENGTH );
+        dst.DisplacementMap = AddString( src.DisplacementMap, MSH_FILENAME_LENGTH );
+        dst.Reserved        = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      .cmsh ファイルに書き出します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::Write( const char* output, u64 sourceHash, u32 flags )
+{
+    std::vector< CookedMaterial > materials;
+    BuildMaterials( materials );
+
+    // サブセットごとのAABBを求める.
+    std::vector< CookedBounds > subsetBounds( m_Subsets.size() );
+    for( size_t i=0; i<m_Subsets.size(); ++i )
+    { ComputeBounds( m_Subsets[i].IndexOffset, m_Subsets[i].IndexCount, subsetBounds[i] ); }
+
+    // レイアウトを決める.
+    CookedMeshHeader header;
+    memset( &header, 0, sizeof( header ) );
+
+    u64 offset = AlignOffset( sizeof( header ) );
+    u64 vertexOffset       = offset; offset = AlignOffset( offset + sizeof( MshVertex      ) * m_Vertices.size()  );
+    u64 indexOffset        = offset; offset = AlignOffset( offset + sizeof( u32            ) * m_Indices.size()   );
+    u64 materialOffset     = offset; offset = AlignOffset( offset + sizeof( CookedMaterial ) * materials.size()   );
+    u64 subsetOffset       = offset; offset = AlignOffset( offset + sizeof( MshSubset      ) * m_Subsets.size()   );
+    u64 subsetBoundsOffset = offset; offset = AlignOffset( offset + sizeof( CookedBounds   ) * subsetBounds.size() );
+    u64 chunkOffset        = offset; offset = AlignOffset( offset + sizeof( CookedChunk    ) * m_Chunks.size()    );
+    u64 stringTableOffset  = offset; offset = offset + m_StringTable.size();
+    u64 fileSize           = offset;
+
+    if ( fileSize > u64( 0xffffffff ) )
+    { return SetError( "cooked data too large." ); }
+
+    header.Magic[0]           = 'C';
+    header.Magic[1]           = 'M';
+    header.Magic[2]           = 'S';
+    header.Magic[3]           = 'H';
+    header.Version            = CMSH_VERSION;
+    header.HeaderSize         = sizeof( header );
+    header.Flags              = flags;
+    header.SourceHash         = sourceHash;
+    header.FileSize           = fileSize;
+    header.VertexCount        = u32( m_Vertices.size() );
+    header.VertexStride       = sizeof( MshVertex );
+    header.IndexCount         = u32( m_Indices.size() );
+    header.IndexStride        = sizeof( u32 );
+    header.MaterialCount      = u32( materials.size() );
+    header.SubsetCount        = u32( m_Subsets.size() );
+    header.StringTableSize    = u32( m_StringTable.size() );
+    header.VertexOffset       = u32( vertexOffset );
+    header.IndexOffset        = u32( indexOffset );
+    header.MaterialOffset     = u32( materialOffset );
+    header.SubsetOffset       = u32( subsetOffset );
+    header.SubsetBoundsOffset = u32( subsetBoundsOffset );
+    header.StringTableOffset  = u32( stringTableOffset );
+    header.ChunkCount         = u32( m_Chunks.size() );
+    header.ChunkOffset        = u32( chunkOffset );
+
+    CookedBounds bounds;
+    ComputeBounds( 0, u32( m_Indices.size() ), bounds );
+    memcpy( header.BoundsMin, bounds.Min, sizeof( header.BoundsMin ) );
+    memcpy( header.BoundsMax, bounds.Max, sizeof( header.BoundsMax ) );
+
+    // イメージを作成.
+    std::vector< u8 > image( size_t( fileSize ), 0 );
+    if ( !m_Vertices.empty() )
+    { memcpy( &image[ size_t( vertexOffset ) ], &m_Vertices[0], sizeof( MshVertex ) * m_Vertices.size() ); }
+    if ( !m_Indices.empty() )
+    { memcpy( &image[ size_t( indexOffset ) ], &m_Indices[0], sizeof( u32 ) * m_Indices.size() ); }
+    if ( !materials.empty() )
+    { memcpy( &image[ size_t( materialOffset ) ], &materials[0], sizeof( CookedMaterial ) * materials.size() ); }
+    if ( !m_Subsets.empty() )
+    {
+        memcpy( &image[ size_t( subsetOffset ) ], &m_Subsets[0], sizeof( MshSubset ) * m_Subsets.size() );
+        memcpy( &image[ size_t( subsetBoundsOffset ) ], &subsetBounds[0], sizeof( CookedBounds ) * subsetBounds.size() );
+    }
+    if ( !m_Chunks.empty() )
+    { memcpy( &image[ size_t( chunkOffset ) ], &m_Chunks[0], sizeof( CookedChunk ) * m_Chunks.size() ); }
+    if ( !m_StringTable.empty() )
+    { memcpy( &image[ size_t( stringTableOffset ) ], &m_StringTable[0], m_StringTable.size() ); }
+
+    header.ContentHash = ComputeFnv1a64( &image[ sizeof( header ) ], image.size() - sizeof( header ) );
+    memcpy( &image[0], &header, sizeof( header ) );
+
+    if ( !WriteFile( output, image ) )
+    { return false; }
+
+    m_Statistics.VertexCount      = header.VertexCount;
+    m_Statistics.IndexCount       = header.IndexCount;
+    m_Statistics.MaterialCount    = header.MaterialCount;
+    m_Statistics.SubsetCount      = header.SubsetCount;
+    m_Statistics.StringTableSize  = header.StringTableSize;
+    m_Statistics.FileSize         = header.FileSize;
+    m_Statistics.GeneratedTangent = ( flags & CMSH_FLAG_GENERATED_TANGENT ) != 0;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      .smsh ファイルに書き出します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::WriteStreaming( const char* output, u64 sourceHash, u32 flags )
+{
+    ProgressiveMeshBuilder::Result     result;
+    ProgressiveMeshBuilder::Statistics stats;
+    ProgressiveMeshBuilder::Build(
+        m_Vertices,
+        m_Indices,
+        m_Subsets,
+        m_Chunks,
+        ProgressiveMeshBuilder::Config(),
+        result,
+        &stats );
+
+    std::vector< CookedMaterial > materials;
+    BuildMaterials( materials );
+
+    // 最初のフレームに必要なデータを先頭にまとめる.
+    StreamingMeshHeader header;
+    memset( &header, 0, sizeof( header ) );
+
+    u64 offset = AlignOffset( sizeof( header ), SMSH_ALIGNMENT );
+    u64 materialOffset    = offset; offset = AlignOffset( offset + sizeof( CookedMaterial ) * materials.size(),           SMSH_ALIGNMENT );
+    u64 stringTableOffset = offset; offset = AlignOffset( offset + m_StringTable.size(),                                  SMSH_ALIGNMENT );
+    u64 chunkOffset       = offset; offset = AlignOffset( offset + sizeof( StreamingChunk ) * result.Chunks.size(),       SMSH_ALIGNMENT );
+    u64 baseVertexOffset  = offset; offset = AlignOffset( offset + sizeof( MshVertex      ) * result.BaseVertices.size(), SMSH_ALIGNMENT );
+    u64 baseIndexOffset   = offset; offset = AlignOffset( offset + sizeof( u32            ) * result.BaseIndices.size(),  SMSH_ALIGNMENT );
+    u64 baseSubsetOffset  = offset; offset = offset + sizeof( MshSubset ) * result.BaseSubsets.size();
+    u64 baseSize          = offset;
+
+    // 詳細化ブロックはチャンクごとにページ境界から並べる.
+    std::vector< u64 > indexOffsets ( result.Blocks.size() );
+    std::vector< u64 > subsetOffsets( result.Blocks.size() );
+    for( size_t i=0; i<result.Blocks.size(); ++i )
+    {
+        const ProgressiveMeshBuilder::Block& block = result.Blocks[i];
+        StreamingChunk& chunk = result.Chunks[i];
+
+        u64 blockOffset  = AlignOffset( offset, SMSH_BLOCK_ALIGNMENT );
+        indexOffsets[i]  = AlignOffset( blockOffset     + sizeof( MshVertex ) * block.Vertices.size(), SMSH_ALIGNMENT );
+        subsetOffsets[i] = AlignOffset( indexOffsets[i] + sizeof( u32       ) * block.Indices .size(), SMSH_ALIGNMENT );
+        offset           = subsetOffsets[i] + sizeof( MshSubset ) * block.Subsets.size();
+
+        chunk.BlockOffset = u32( blockOffset );
+        chunk.BlockSize   = u32( offset - blockOffset );
+    }
+    u64 fileSize = offset;
+
+    if ( fileSize > u64( 0xffffffff ) )
+    { return SetError( "streaming data too large." ); }
+
+    header.Magic[0]          = 'S';
+    header.Magic[1]          = 'M';
+    header.Magic[2]          = 'S';
+    header.Magic[3]          = 'H';
+    header.Version           = SMSH_VERSION;
+    header.HeaderSize        = sizeof( header );
+    header.Flags             = flags;
+    header.SourceHash        = sourceHash;
+    header.FileSize          = fileSize;
+    header.MaterialCount     = u32( materials.size() );
+    header.MaterialOffset    = u32( materialOffset );
+    header.StringTableSize   = u32( m_StringTable.size() );
+    header.StringTableOffset = u32( stringTableOffset );
+    header.ChunkCount        = u32( result.Chunks.size() );
+    header.ChunkOffset       = u32( chunkOffset );
+    header.BaseVertexCount   = u32( result.BaseVertices.size() );
+    header.BaseVertexOffset  = u32( baseVertexOffset );
+    header.BaseIndexCount    = u32( result.BaseIndices.size() );
+    header.BaseIndexOffset   = u32( baseIndexOffset );
+    header.BaseSubsetCount   = u32( result.BaseSubsets.size() );
+    header.BaseSubsetOffset  = u32( baseSubsetOffset );
+    header.BaseSize          = u32( baseSize );
+
+    CookedBounds bounds;
+    ComputeBounds( 0, u32( m_Indices.size() ), bounds );
+    memcpy( header.BoundsMin, bounds.Min, sizeof( header.BoundsMin ) );
+    memcpy( header.BoundsMax, bounds.Max, sizeof( header.BoundsMax ) );
+
+    // イメージを作成.
+    std::vector< u8 > image( size_t( fileSize ), 0 );
+    memcpy( &image[0], &header, sizeof( header ) );
+    CopyToImage( image, materialOffset,    materials );
+    CopyToImage( image, stringTableOffset, m_StringTable );
+    CopyToImage( image, chunkOffset,       result.Chunks );
+    CopyToImage( image, baseVertexOffset,  result.BaseVertices );
+    CopyToImage( image, baseIndexOffset,   result.BaseIndices );
+    CopyToImage( image, baseSubsetOffset,  result.BaseSubsets );
+    for( size_t i=0; i<result.Blocks.size(); ++i )
+    {
+        const ProgressiveMeshBuilder::Block& block = result.Blocks[i];
+        CopyToImage( image, result.Chunks[i].BlockOffset, block.Vertices );
+        CopyToImage( image, indexOffsets[i],              block.Indices );
+        CopyToImage( image, subsetOffsets[i],             block.Subsets );
+    }
+
+    if ( !WriteFile( output, image ) )
+    { return false; }
+
+    m_Statistics.BaseTriangleCount = stats.BaseTriangleCount;
+    m_Statistics.StreamingBaseSize = header.BaseSize;
+    m_Statistics.StreamingFileSize = header.FileSize;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      イメージをファイルに書き出します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::WriteFile( const char* output, const std::vector< u8 >& image )
+{
+    // 書き込み途中のファイルが残らないように, 一時ファイルに書いてから置き換える.
+    std::string temp = std::string( output ) + ".tmp";
+    FILE* pFile = fopen( temp.c_str(), "wb" );
+    if ( pFile == nullptr )
+    { return SetError( "file open failed. filename = %s", temp.c_str() ); }
+
+    size_t written = fwrite( &image[0], 1, image.size(), pFile );
+    int    closed  = fclose( pFile );
+    if ( written != image.size() || closed != 0 )
+    {
+        remove( temp.c_str() );
+        return SetError( "file write failed. filename = %s", temp.c_str() );
+    }
+
+    remove( output );
+    if ( rename( temp.c_str(), output ) != 0 )
+    {
+        remove( temp.c_str() );
+        return SetError( "file rename failed. filename = %s", output );
+    }
+
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------------
+//      エラーメッセージを設定します.
+//-----------------------------------------------------------------------------------
+bool MeshCooker::SetError( const char* format, ... )
+{
+    char buffer[ 1024 ];
+
+    va_list arg;
+    va_start( arg, format );
+    vsnprintf( buffer, sizeof( buffer ), format, arg );
+    va_end( arg );
+
+    m_Error = buffer;
+    return false;
+}
@@ -0,0 +1,360 @@
+﻿//-----------------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Mesh Cooker Command Line Entry Point.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+//
+// 使い方 :
+//     MeshCooker [-f] [-s] [-j threads] <input> <output>
+//
+//     <input> がディレクトリの場合は, 以下の .msh ファイルを全てクックして
+//     <output> 以下に同じ階層で .cmsh ファイルを出力します.
+//     -f を指定すると, 出力ファイルが最新でもクックし直します.
+//     -s を指定すると, 粗い基本LODを先頭に置いたストリーミング用の .smsh ファイルも出力します.
+//     -j でワーカースレッド数を指定します(省略時はハードウェアスレッド数-1).
+//
+// Linux でのビルド :
+//     g++ -std=c++11 -O2 -pthread -Iinclude -I../../sample/include -I../../asdx/include
+//         src/main.cpp src/MeshCooker.cpp ../../sample/src/MappedFile.cpp
+//         ../../sample/src/ThreadPool.cpp ../../sample/src/MeshOptimizer.cpp
+//         ../../sample/src/SubsetBatcher.cpp ../../sample/src/MeshChunker.cpp
+//         ../../sample/src/VertexWelder.cpp ../../sample/src/TangentGenerator.cpp
+//         ../../sample/src/ProgressiveMeshBuilder.cpp -o MeshCooker
+//
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <MeshCooker.h>
+#include <ThreadPool.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+// 入力ファイルの拡張子.
+static const char* INPUT_EXTENSION  = ".msh";
+
+// 出力ファイルの拡張子.
+static const char* OUTPUT_EXTENSION = ".cmsh";
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CookJob structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct CookJob
+{
+    std::string             Input;          //!< 入力ファイル名です.
+    std::string             Output;         //!< 出力ファイル名です.
+    MeshCooker::RESULT      Result;         //!< 処理結果です.
+    std::string             Error;          //!< エラーメッセージです.
+    MeshCooker::Statistics  Statistics;     //!< 統計情報です.
+};
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool IsDirectory( const std::string& path )
+{
+#if defined(_WIN32)
+    DWORD attr = GetFileAttributesA( path.c_str() );
+    return ( attr != INVALID_FILE_ATTRIBUTES ) && ( attr & FILE_ATTRIBUTE_DIRECTORY );
+#else
+    struct stat info;
+    return ( stat( path.c_str(), &info ) == 0 ) && S_ISDIR( info.st_mode );
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリを作成します(途中のディレクトリも作成します).
+//-----------------------------------------------------------------------------------
+bool CreateDirectories( const std::string& path )
+{
+    if ( path.empty() || IsDirectory( path ) )
+    { return true; }
+
+    size_t pos = path.find_last_of( "/\\" );
+    if ( pos != std::string::npos && pos > 0 )
+    {
+        if ( !CreateDirectories( path.substr( 0, pos ) ) )
+        { return false; }
+    }
+
+#if defined(_WIN32)
+    _mkdir( path.c_str() );
+#else
+    mkdir( path.c_str(), 0755 );
+#endif
+
+    // 他のスレッドが同時に作成した場合もあるので, 結果は存在するかどうかで判定する.
+    return IsDirectory( path );
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイル名が指定した拡張子で終わるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool HasExtension( const std::string& filename, const char* ext )
+{
+    size_t length = strlen( ext );
+    if ( filename.size() < length )
+    { return false; }
+
+    for( size_t i=0; i<length; ++i )
+    {
+        char c = filename[ filename.size() - length + i ];
+        if ( c >= 'A' && c <= 'Z' )
+        { c = char( c - 'A' + 'a' ); }
+
+        if ( c != ext[i] )
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      出力ファイル名を求めます.
+//-----------------------------------------------------------------------------------
+std::string ReplaceExtension( const std::string& filename )
+{ return filename.substr( 0, filename.size() - strlen( INPUT_EXTENSION ) ) + OUTPUT_EXTENSION; }
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリ直下のエントリ名を取得します.
+//-----------------------------------------------------------------------------------
+void ListDirectory( const std::string& dir, std::vector< std::string >& result )
+{
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE hFind = FindFirstFileA( ( dir + "/*" ).c_str(), &data );
+    if ( hFind == INVALID_HANDLE_VALUE )
+    { return; }
+
+    do
+    { result.push_back( data.cFileName ); }
+    while( FindNextFileA( hFind, &data ) );
+
+    FindClose( hFind );
+#else
+    DIR* pDir = opendir( dir.c_str() );
+    if ( pDir == nullptr )
+    { return; }
+
+    while( dirent* pEntry = readdir( pDir ) )
+    { result.push_back( pEntry->d_name ); }
+
+    closedir( pDir );
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリ以下の入力ファイルを集めます.
+//-----------------------------------------------------------------------------------
+void CollectFiles( const std::string& root, const std::string& relative, std::vector< std::string >& result )
+{
+    std::vector< std::string > names;
+    ListDirectory( ( relative.empty() ) ? root : root + "/" + relative, names );
+
+    for( size_t i=0; i<names.size(); ++i )
+    {
+        const std::string& name = names[i];
+        if ( name == "." || name == ".." )
+        { continue; }
+
+        std::string path = ( relative.empty() ) ? name : relative + "/" + name;
+        if ( IsDirectory( root + "/" + path ) )
+        { CollectFiles( root, path, result ); }
+        else if ( HasExtension( name, INPUT_EXTENSION ) )
+        { result.push_back( path ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf( "usage : MeshCooker [-f] [-s] [-j threads] <input> <output>\n" );
+    printf( "    <input>      .msh file or directory.\n" );
+    printf( "    <output>     .cmsh file or directory.\n" );
+    printf( "    -f           cook even if the output is up to date.\n" );
+    printf( "    -s           also write a progressive .smsh file for streaming.\n" );
+    printf( "    -j threads   number of worker threads.\n" );
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------------
+int main( int argc, char** argv )
+{
+    bool        force       = false;
+    bool        streaming   = false;
+    u32         threadCount = 0;
+    std::string input;
+    std::string output;
+
+    // 引数を解析.
+    for( int i=1; i<argc; ++i )
+    {
+        if ( strcmp( argv[i], "-f" ) == 0 )
+        { force = true; }
+        else if ( strcmp( argv[i], "-s" ) == 0 )
+        { streaming = true; }
+        else if ( strcmp( argv[i], "-j" ) == 0 && i + 1 < argc )
+        { threadCount = u32( atoi( argv[ ++i ] ) ); }
+        else if ( input.empty() )
+        { input = argv[i]; }
+        else if ( output.empty() )
+        { output = argv[i]; }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if ( input.empty() || output.empty() )
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    // ジョブを作成.
+    std::vector< CookJob > jobs;
+    if ( IsDirectory( input ) )
+    {
+        std::vector< std::string > files;
+        CollectFiles( input, "", files );
+
+        jobs.resize( files.size() );
+        for( size_t i=0; i<files.size(); ++i )
+        {
+            jobs[i].Input  = input  + "/" + files[i];
+            jobs[i].Output = output + "/" + ReplaceExtension( files[i] );
+        }
+    }
+    else
+    {
+        jobs.resize( 1 );
+        jobs[0].Input  = input;
+        jobs[0].Output = output;
+    }
+
+    ThreadPool pool;
+    if ( !pool.Init( threadCount ) )
+    {
+        fprintf( stderr, "Error : ThreadPool::Init() Failed.\n" );
+        return -1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // ファイル単位で並列にクックする.
+    pool.ParallelFor( u32( jobs.size() ), 1, [&]( u32 begin, u32 end, u32 )
+    {
+        MeshCooker cooker;
+        cooker.SetForce( force );
+        cooker.SetStreaming( streaming );
+        cooker.SetThreadPool( &pool );
+
+        for( u32 i=begin; i<end; ++i )
+        {
+            CookJob& job = jobs[i];
+
+            size_t pos = job.Output.find_last_of( "/\\" );
+            if ( pos != std::string::npos && !CreateDirectories( job.Output.substr( 0, pos ) ) )
+            {
+                job.Result = MeshCooker::RESULT_FAILED;
+                job.Error  = "directory create failed.";
+                continue;
+            }
+
+            job.Result     = cooker.Cook( job.Input.c_str(), job.Output.c_str() );
+            job.Error      = cooker.GetError();
+            job.Statistics = cooker.GetStatistics();
+        }
+    } );
+
+    pool.Term();
+
+    f64 elapsed = std::chrono::duration< f64 >( std::chrono::steady_clock::now() - start ).count();
+
+    // 結果を表示.
+    u32 cooked   = 0;
+    u32 upToDate = 0;
+    u32 failed   = 0;
+    for( size_t i=0; i<jobs.size(); ++i )
+    {
+        const CookJob& job = jobs[i];
+        switch( job.Result )
+        {
+        case MeshCooker::RESULT_COOKED:
+            {
+                printf( "cooked     : %s (vertex %u, index %u, subset %u, %llu bytes%s)\n",
+                    job.Output.c_str(),
+                    job.Statistics.VertexCount,
+                    job.Statistics.IndexCount,
+                    job.Statistics.SubsetCount,
+                    static_cast<unsigned long long>( job.Statistics.FileSize ),
+                    ( job.Statistics.GeneratedTangent ) ? ", tangent generated" : "" );
+                printf( "             vertex %u -> %u welded, %u split for tangent\n",
+                    job.Statistics.SourceVertexCount,
+                    job.Statistics.WeldedVertexCount,
+                    job.Statistics.TangentSplitCount );
+                printf( "             ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+                    job.Statistics.ACMRBefore,
+                    job.Statistics.ACMRAfter,
+                    job.Statistics.ATVRBefore,
+                    job.Statistics.ATVRAfter );
+                printf( "             subset %u -> %u, material changes %u -> %u, chunk %u\n",
+                    job.Statistics.SourceSubsetCount,
+                    job.Statistics.SubsetCount,
+                    job.Statistics.MaterialChangesBefore,
+                    job.Statistics.MaterialChangesAfter,
+                    job.Statistics.ChunkCount );
+                if ( job.Statistics.StreamingFileSize > 0 )
+                {
+                    printf( "             streaming base %u triangles, %u / %llu bytes resident at first frame\n",
+                        job.Statistics.BaseTriangleCount,
+                        job.Statistics.StreamingBaseSize,
+                        static_cast<unsigned long long>( job.Statistics.StreamingFileSize ) );
+                }
+
+                cooked++;
+            }
+            break;
+
+        case MeshCooker::RESULT_UP_TO_DATE:
+            {
+                printf( "up to date : %s\n", job.Output.c_str() );
+                upToDate++;
+            }
+            break;
+
+        default:
+            {
+                fprintf( stderr, "failed     : %s (%s)\n", job.Input.c_str(), job.Error.c_str() );
+                failed++;
+            }
+            break;
+        }
+    }
+
+    printf( "%u cooked, %u up to date, %u failed. (%.3f sec)\n", cooked, upToDate, failed, elapsed );
+
+    return ( failed == 0 ) ? 0 : -1;
+}
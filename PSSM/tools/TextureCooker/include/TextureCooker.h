@@ -0,0 +1,208 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TextureCooker.h
+// Desc : Texture Cooker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_COOKER_H__
+#define __TEXTURE_COOKER_H__
+
+//------------------------------------------------------------------------------------
+// Includes
+//------------------------------------------------------------------------------------
+#include <MapFormat.h>
+#include <MapTexture.h>
+#include <BlockCompressor.h>
+#include <string>
+#include <vector>
+
+
+//////////////////////////////////////////////////////////////////////////////////////
+// TextureCooker class
+//////////////////////////////////////////////////////////////////////////////////////
+class TextureCooker
+{
+    //================================================================================
+    // list of friend classes and methods.
+    //================================================================================
+    /* NOTHING */
+
+public:
+    //////////////////////////////////////////////////////////////////////////////////
+    // RESULT enum
+    //////////////////////////////////////////////////////////////////////////////////
+    enum RESULT
+    {
+        RESULT_COOKED = 0,          //!< クックしました.
+        RESULT_UP_TO_DATE,          //!< 出力ファイルが最新のためスキップしました.
+        RESULT_FAILED,              //!< 失敗しました.
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////
+    // Statistics structure
+    //////////////////////////////////////////////////////////////////////////////////
+    struct Statistics
+    {
+        u32     Width;                  //!< 横幅です.
+        u32     Height;                 //!< 縦幅です.
+        u32     MipMapCount;            //!< ミップマップ数です.
+        u32     SurfaceCount;           //!< サーフェイス数です.
+        u32     SourceFormat;           //!< 入力ファイルのフォーマットです(MAP_FORMAT).
+        u32     Format;                 //!< 出力ファイルのフォーマットです(MAP_FORMAT).
+        u32     BlockCount;             //!< エンコードしたブロック数です.
+        u32     TileCount;              //!< 並列処理したタイル数です.
+        u64     SourceSize;             //!< 入力ファイルのピクセルデータのサイズです.
+        u64     UncompressedSize;       //!< RGBA8 にした場合のピクセルデータのサイズです.
+        u64     CompressedSize;         //!< 出力ファイルのピクセルデータのサイズです.
+        u64     FileSize;               //!< 出力ファイルサイズです.
+        f32     ColorPSNR;              //!< デコードした入力画像に対するカラーチャンネルのPSNR(dB)です.
+        f32     AlphaPSNR;              //!< デコードした入力画像に対するアルファチャンネルのPSNR(dB)です.
+        bool    HasAlpha;               //!< 出力フォーマットがアルファを扱うかどうか.
+        bool    Reencoded;              //!< エンコードし直したかどうか(同じフォーマットの場合はそのまま書き出します).
+        bool    GeneratedNormal;        //!< 高さマップから法線マップを生成したかどうか.
+
+        Statistics()
+        : Width             ( 0 )
+        , Height            ( 0 )
+        , MipMapCount       ( 0 )
+        , SurfaceCount      ( 0 )
+        , SourceFormat      ( 0 )
+        , Format            ( 0 )
+        , BlockCount        ( 0 )
+        , TileCount         ( 0 )
+        , SourceSize        ( 0 )
+        , UncompressedSize  ( 0 )
+        , CompressedSize    ( 0 )
+        , FileSize          ( 0 )
+        , ColorPSNR         ( 0.0f )
+        , AlphaPSNR         ( 0.0f )
+        , HasAlpha          ( false )
+        , Reencoded         ( false )
+        , GeneratedNormal   ( false )
+        { /* DO_NOTHING */ }
+    };
+
+    //================================================================================
+    // public variables.
+    //================================================================================
+
+    // 入力に合わせて出力フォーマットを選ぶことを表す値です.
+    static const u32 FORMAT_AUTO = 0;
+
+    //================================================================================
+    // public methods.
+    //================================================================================
+
+    //-------------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------------
+    TextureCooker();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------------
+    ~TextureCooker();
+
+    //-------------------------------------------------------------------------------
+    //! @brief      出力ファイルが最新でもクックし直すかどうか設定します.
+    //!
+    //! @param [in]     value       クックし直す場合は true を指定します.
+    //-------------------------------------------------------------------------------
+    void SetForce( bool value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      タイル単位の並列エンコードに使うスレッドプールを設定します.
+    //!
+    //! @param [in]     pPool       スレッドプールです(nullptrの場合は呼び出しスレッドで処理します).
+    //-------------------------------------------------------------------------------
+    void SetThreadPool( ThreadPool* pPool );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      出力フォーマットを設定します.
+    //!
+    //! @param [in]     format      MAP_FORMAT_BC1, BC3, BC4, BC5, BC7 または FORMAT_AUTO です.
+    //! @note       FORMAT_AUTO の場合は, 法線マップは BC5, 1チャンネルの入力は BC4,
+    //!             アルファが全て 255 の入力は BC1, それ以外は BC3 を選びます.
+    //-------------------------------------------------------------------------------
+    void SetFormat( u32 format );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      エンコードの品質を設定します.
+    //!
+    //! @param [in]     quality     品質です.
+    //-------------------------------------------------------------------------------
+    void SetQuality( BlockCompressor::QUALITY quality );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      法線マップとして扱うかどうか設定します.
+    //!
+    //! @param [in]     value       法線マップとして扱う場合は true を指定します.
+    //! @note       1チャンネルの入力は高さマップとみなして, ミップレベルごとに法線を求めます.
+    //!             法線マップは RG に XY を格納し, Z はシェーダで求める前提です.
+    //-------------------------------------------------------------------------------
+    void SetNormalMap( bool value );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      .map ファイルを圧縮して .map ファイルに出力します.
+    //!
+    //! @param [in]     input       入力ファイル名です.
+    //! @param [in]     output      出力ファイル名です.
+    //! @return     処理結果を返却します.
+    //-------------------------------------------------------------------------------
+    RESULT Cook( const char* input, const char* output );
+
+    //-------------------------------------------------------------------------------
+    //! @brief      エラーメッセージを取得します.
+    //!
+    //! @return     最後に失敗した処理のエラーメッセージを返却します.
+    //-------------------------------------------------------------------------------
+    const std::string& GetError() const;
+
+    //-------------------------------------------------------------------------------
+    //! @brief      統計情報を取得します.
+    //!
+    //! @return     最後にクックしたテクスチャの統計情報を返却します.
+    //-------------------------------------------------------------------------------
+    const Statistics& GetStatistics() const;
+
+protected:
+    //================================================================================
+    // protected variables.
+    //================================================================================
+    bool                        m_Force;            //!< 常にクックし直すかどうか.
+    bool                        m_NormalMap;        //!< 法線マップとして扱うかどうか.
+    u32                         m_Format;           //!< 出力フォーマットです.
+    BlockCompressor::QUALITY    m_Quality;          //!< エンコードの品質です.
+    ThreadPool*                 m_pPool;            //!< スレッドプールです.
+    std::string                 m_Error;            //!< エラーメッセージです.
+    Statistics                  m_Statistics;       //!< 統計情報です.
+
+    std::vector< std::vector< u8 > >    m_Images;   //!< サーフェイスごとの RGBA8 の画像です.
+
+    //================================================================================
+    // protected methods.
+    //================================================================================
+    bool IsUpToDate( const char* input, const char* output ) const;
+    bool DecodeSurfaces( const MapTexture& source );
+    void GenerateNormals( const MapTexture& source );
+    u32  SelectFormat( const MapTexture& source ) const;
+    bool Encode( const MapTexture& source, u32 format, std::vector< u8 >& image );
+    bool Copy( const MapTexture& source, std::vector< u8 >& image );
+    bool WriteFile( const char* output, const std::vector< u8 >& image );
+
+    bool SetError( const char* format, ... );
+
+private:
+    //================================================================================
+    // private variables.
+    //================================================================================
+    /* NOTHING */
+
+    //================================================================================
+    // private methods.
+    //================================================================================
+    TextureCooker   ( const TextureCooker& );   // アクセス禁止.
+    void operator = ( const TextureCooker& );   // アクセス禁止.
+};
+
+#endif//__TEXTURE_COOKER_H__
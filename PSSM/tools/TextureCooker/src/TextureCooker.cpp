@@ -0,0 +1,558 @@
+﻿//-----------------------------------------------------------------------------------
+// File : TextureCooker.cpp
+// Desc : Texture Cooker Module.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <TextureCooker.h>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cmath>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+namespace /* anonymous */ {
+
+// 高さマップの隣接画素の差を傾きに変換する係数です(高さ 0～255 を 0～1 とした場合の倍率).
+static const f32 HEIGHT_TO_SLOPE = 4.0f;
+
+// 誤差が無い場合のPSNR(dB)です.
+static const f32 MAX_PSNR = 99.0f;
+
+//-----------------------------------------------------------------------------------
+//      MAPフォーマットに対応するエンコーダのフォーマットを取得します.
+//-----------------------------------------------------------------------------------
+bool ToCompressorFormat( u32 format, BlockCompressor::FORMAT& result )
+{
+    switch( format )
+    {
+    case MAP_FORMAT_BC1:
+        result = BlockCompressor::FORMAT_BC1;
+        return true;
+
+    case MAP_FORMAT_BC3:
+        result = BlockCompressor::FORMAT_BC3;
+        return true;
+
+    case MAP_FORMAT_BC4:
+        result = BlockCompressor::FORMAT_BC4;
+        return true;
+
+    case MAP_FORMAT_BC5:
+        result = BlockCompressor::FORMAT_BC5;
+        return true;
+
+    case MAP_FORMAT_BC7:
+        result = BlockCompressor::FORMAT_BC7;
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      1チャンネルのフォーマットかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool IsSingleChannel( u32 format )
+{ return ( format == MAP_FORMAT_R8 || format == MAP_FORMAT_BC4 ); }
+
+//-----------------------------------------------------------------------------------
+//      二乗誤差の合計からPSNR(dB)を求めます.
+//-----------------------------------------------------------------------------------
+f32 ComputePSNR( f64 squaredError, f64 sampleCount )
+{
+    f64 mse = ( sampleCount > 0.0 ) ? squaredError / sampleCount : 0.0;
+    return ( mse > 0.0 ) ? f32( 10.0 * log10( 255.0 * 255.0 / mse ) ) : MAX_PSNR;
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイルの更新時刻を取得します.
+//-----------------------------------------------------------------------------------
+bool GetModifiedTime( const char* filename, s64& result )
+{
+#if defined(_WIN32)
+    struct _stat64 info;
+    if ( _stat64( filename, &info ) != 0 )
+    { return false; }
+#else
+    struct stat info;
+    if ( stat( filename, &info ) != 0 )
+    { return false; }
+#endif
+
+    result = s64( info.st_mtime );
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      値をイメージの末尾に追加します.
+//-----------------------------------------------------------------------------------
+template< typename T >
+void Append( std::vector< u8 >& image, const T& value )
+{
+    size_t offset = image.size();
+    image.resize( offset + sizeof( T ) );
+    memcpy( &image[ offset ], &value, sizeof( T ) );
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイルヘッダをイメージに追加します.
+//-----------------------------------------------------------------------------------
+void AppendFileHeader( std::vector< u8 >& image, const MapTexture& source, u32 format )
+{
+    MapFileHeader header;
+    memset( &header, 0, sizeof( header ) );
+    header.Magic[0]                 = 'M';
+    header.Magic[1]                 = 'A';
+    header.Magic[2]                 = 'P';
+    header.Magic[3]                 = '\0';
+    header.Version                  = MAP_VERSION;
+    header.DataHeaderSize           = MAP_DATA_HEADER_SIZE;
+    header.DataHeader.Width         = source.GetWidth();
+    header.DataHeader.Height        = source.GetHeight();
+    header.DataHeader.Depth         = 0;
+    header.DataHeader.Format        = format;
+    header.DataHeader.MipMapCount   = source.GetMipMapCount();
+    header.DataHeader.SurfaceCount  = source.GetSurfaceCount();
+
+    Append( image, header );
+}
+
+} // namespace /* anonymous */
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TextureCooker class
+/////////////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------------
+TextureCooker::TextureCooker()
+: m_Force       ( false )
+, m_NormalMap   ( false )
+, m_Format      ( FORMAT_AUTO )
+, m_Quality     ( BlockCompressor::QUALITY_NORMAL )
+, m_pPool       ( nullptr )
+, m_Error       ()
+, m_Statistics  ()
+, m_Images      ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------------
+TextureCooker::~TextureCooker()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------------
+//      出力ファイルが最新でもクックし直すかどうか設定します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::SetForce( bool value )
+{ m_Force = value; }
+
+//-----------------------------------------------------------------------------------
+//      スレッドプールを設定します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::SetThreadPool( ThreadPool* pPool )
+{ m_pPool = pPool; }
+
+//-----------------------------------------------------------------------------------
+//      出力フォーマットを設定します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::SetFormat( u32 format )
+{ m_Format = format; }
+
+//-----------------------------------------------------------------------------------
+//      エンコードの品質を設定します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::SetQuality( BlockCompressor::QUALITY quality )
+{ m_Quality = quality; }
+
+//-----------------------------------------------------------------------------------
+//      法線マップとして扱うかどうか設定します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::SetNormalMap( bool value )
+{ m_NormalMap = value; }
+
+//-----------------------------------------------------------------------------------
+//      .map ファイルを圧縮して .map ファイルに出力します.
+//-----------------------------------------------------------------------------------
+TextureCooker::RESULT TextureCooker::Cook( const char* input, const char* output )
+{
+    m_Error.clear();
+    m_Statistics = Statistics();
+    m_Images.clear();
+
+    if ( !m_Force && IsUpToDate( input, output ) )
+    { return RESULT_UP_TO_DATE; }
+
+    MapTexture source;
+    if ( !source.LoadFromFile( input ) )
+    {
+        SetError( "file load failed. filename = %s, %s", input, source.GetError() );
+        return RESULT_FAILED;
+    }
+
+    m_Statistics.Width          = source.GetWidth();
+    m_Statistics.Height         = source.GetHeight();
+    m_Statistics.MipMapCount    = source.GetMipMapCount();
+    m_Statistics.SurfaceCount   = source.GetSurfaceCount();
+    m_Statistics.SourceFormat   = source.GetFormat();
+
+    u32 count = source.GetMipMapCount() * source.GetSurfaceCount();
+    for( u32 i=0; i<count; ++i )
+    {
+        const MapTexture::Surface& surface = source.GetSurface( i );
+        m_Statistics.SourceSize       += surface.SlicePitch;
+        m_Statistics.UncompressedSize += u64( surface.Width ) * surface.Height * 4;
+    }
+
+    u32 format = SelectFormat( source );
+    if ( format == FORMAT_AUTO )
+    {
+        if ( !DecodeSurfaces( source ) )
+        { return RESULT_FAILED; }
+
+        format = SelectFormat( source );
+    }
+
+    std::vector< u8 > image;
+
+    // 同じフォーマットに圧縮し直すと劣化するだけなので, そのまま書き出す.
+    if ( format == source.GetFormat() && !( m_NormalMap && IsSingleChannel( format ) ) )
+    {
+        if ( !Copy( source, image ) )
+        { return RESULT_FAILED; }
+    }
+    else
+    {
+        if ( m_Images.empty() && !DecodeSurfaces( source ) )
+        { return RESULT_FAILED; }
+
+        if ( m_NormalMap && IsSingleChannel( source.GetFormat() ) )
+        { GenerateNormals( source ); }
+
+        if ( !Encode( source, format, image ) )
+        { return RESULT_FAILED; }
+    }
+
+    // 出力するまでにマップを解除しておく(入力と出力が同じファイルでも置き換えられるようにする).
+    source.Release();
+    m_Images.clear();
+
+    if ( !WriteFile( output, image ) )
+    { return RESULT_FAILED; }
+
+    m_Statistics.Format   = format;
+    m_Statistics.FileSize = image.size();
+
+    return RESULT_COOKED;
+}
+
+//-----------------------------------------------------------------------------------
+//      エラーメッセージを取得します.
+//-----------------------------------------------------------------------------------
+const std::string& TextureCooker::GetError() const
+{ return m_Error; }
+
+//-----------------------------------------------------------------------------------
+//      統計情報を取得します.
+//-----------------------------------------------------------------------------------
+const TextureCooker::Statistics& TextureCooker::GetStatistics() const
+{ return m_Statistics; }
+
+//-----------------------------------------------------------------------------------
+//      出力ファイルが最新かどうか判定します.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::IsUpToDate( const char* input, const char* output ) const
+{
+    // .map ファイルには元ファイルのハッシュを入れる場所が無いので, 更新時刻で判定する.
+    s64 inputTime  = 0;
+    s64 outputTime = 0;
+    if ( !GetModifiedTime( input, inputTime ) || !GetModifiedTime( output, outputTime ) )
+    { return false; }
+
+    if ( outputTime < inputTime )
+    { return false; }
+
+    // 指定したフォーマットと異なる場合はクックし直す.
+    MapTexture cooked;
+    if ( !cooked.LoadFromFile( output ) )
+    { return false; }
+
+    if ( m_Format != FORMAT_AUTO )
+    { return ( cooked.GetFormat() == m_Format ); }
+
+    if ( m_NormalMap )
+    { return ( cooked.GetFormat() == MAP_FORMAT_BC5 ); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      全てのサーフェイスを RGBA8 にデコードします.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::DecodeSurfaces( const MapTexture& source )
+{
+    u32 count = source.GetMipMapCount() * source.GetSurfaceCount();
+    m_Images.resize( count );
+
+    for( u32 i=0; i<count; ++i )
+    {
+        const MapTexture::Surface& surface = source.GetSurface( i );
+        std::vector< u8 >& rgba = m_Images[ i ];
+        rgba.resize( size_t( surface.Width ) * surface.Height * 4 );
+
+        // R8 はシェーダで読んだ場合と同じく (R, 0, 0, 1) にする.
+        if ( source.GetFormat() == MAP_FORMAT_R8 )
+        {
+            for( u32 y=0; y<surface.Height; ++y )
+            {
+                for( u32 x=0; x<surface.Width; ++x )
+                {
+                    u8* pDst = &rgba[ ( size_t( y ) * surface.Width + x ) * 4 ];
+                    pDst[0] = surface.pPixels[ size_t( y ) * surface.Pitch + x ];
+                    pDst[1] = 0;
+                    pDst[2] = 0;
+                    pDst[3] = 255;
+                }
+            }
+            continue;
+        }
+
+        BlockCompressor::FORMAT format;
+        if ( !ToCompressorFormat( source.GetFormat(), format ) )
+        { return SetError( "unsupported source format. format = %u", source.GetFormat() ); }
+
+        if ( surface.Pitch < BlockCompressor::GetPitch( format, surface.Width ) ||
+             surface.SlicePitch < BlockCompressor::GetSlicePitch( format, surface.Width, surface.Height ) )
+        { return SetError( "invalid surface size. surface = %u", i ); }
+
+        if ( !BlockCompressor::Decode( format, surface.pPixels, surface.Width, surface.Height, surface.Pitch, &rgba[0], surface.Width * 4 ) )
+        { return SetError( "unsupported block mode. surface = %u", i ); }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      高さマップから法線マップを生成します.
+//-----------------------------------------------------------------------------------
+void TextureCooker::GenerateNormals( const MapTexture& source )
+{
+    u32 mipCount = source.GetMipMapCount();
+    for( u32 i=0; i<u32( m_Images.size() ); ++i )
+    {
+        const MapTexture::Surface& surface = source.GetSurface( i );
+        u32 w = surface.Width;
+        u32 h = surface.Height;
+
+        // ミップレベルが下がるほど1画素が広い範囲を表すので, 傾きも小さくなる.
+        f32 scale = HEIGHT_TO_SLOPE / ( 255.0f * 2.0f * f32( 1 << ( i % mipCount ) ) );
+
+        const std::vector< u8 > height( m_Images[ i ] );
+        std::vector< u8 >& rgba = m_Images[ i ];
+
+        for( u32 y=0; y<h; ++y )
+        {
+            for( u32 x=0; x<w; ++x )
+            {
+                // 端は反対側とつながっているものとして扱う.
+                u32 l = ( x + w - 1 ) % w;
+                u32 r = ( x + 1 ) % w;
+                u32 u = ( y + h - 1 ) % h;
+                u32 d = ( y + 1 ) % h;
+
+                f32 dx = ( f32( height[ ( size_t( y ) * w + l ) * 4 ] ) - f32( height[ ( size_t( y ) * w + r ) * 4 ] ) ) * scale;
+                f32 dy = ( f32( height[ ( size_t( u ) * w + x ) * 4 ] ) - f32( height[ ( size_t( d ) * w + x ) * 4 ] ) ) * scale;
+                f32 inv = 1.0f / sqrtf( dx * dx + dy * dy + 1.0f );
+
+                u8* pDst = &rgba[ ( size_t( y ) * w + x ) * 4 ];
+                pDst[0] = u8( floorf( ( dx  * inv * 0.5f + 0.5f ) * 255.0f + 0.5f ) );
+                pDst[1] = u8( floorf( ( dy  * inv * 0.5f + 0.5f ) * 255.0f + 0.5f ) );
+                pDst[2] = u8( floorf( ( inv       * 0.5f + 0.5f ) * 255.0f + 0.5f ) );
+                pDst[3] = 255;
+            }
+        }
+    }
+
+    m_Statistics.GeneratedNormal = true;
+}
+
+//-----------------------------------------------------------------------------------
+//      出力フォーマットを選びます.
+//-----------------------------------------------------------------------------------
+u32 TextureCooker::SelectFormat( const MapTexture& source ) const
+{
+    if ( m_Format != FORMAT_AUTO )
+    { return m_Format; }
+
+    if ( m_NormalMap )
+    { return MAP_FORMAT_BC5; }
+
+    if ( IsSingleChannel( source.GetFormat() ) )
+    { return MAP_FORMAT_BC4; }
+
+    // アルファを調べるにはデコードした画像が必要.
+    if ( m_Images.empty() )
+    { return FORMAT_AUTO; }
+
+    for( size_t i=0; i<m_Images.size(); ++i )
+    {
+        const std::vector< u8 >& rgba = m_Images[ i ];
+        for( size_t j=3; j<rgba.size(); j+=4 )
+        {
+            if ( rgba[ j ] != 255 )
+            { return MAP_FORMAT_BC3; }
+        }
+    }
+
+    return MAP_FORMAT_BC1;
+}
+
+//-----------------------------------------------------------------------------------
+//      デコードした画像をエンコードしてイメージを作成します.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::Encode( const MapTexture& source, u32 format, std::vector< u8 >& image )
+{
+    BlockCompressor::Config config;
+    config.Quality = m_Quality;
+    if ( !ToCompressorFormat( format, config.Format ) )
+    { return SetError( "unsupported output format. format = %u", format ); }
+
+    AppendFileHeader( image, source, format );
+
+    f64 colorError = 0.0;
+    f64 alphaError = 0.0;
+    f64 colorCount = 0.0;
+    f64 alphaCount = 0.0;
+
+    // サーフェイスごとにタイル単位で並列にエンコードする.
+    for( u32 i=0; i<u32( m_Images.size() ); ++i )
+    {
+        const MapTexture::Surface& surface = source.GetSurface( i );
+
+        MapSurfaceHeader header;
+        header.Width      = surface.Width;
+        header.Height     = surface.Height;
+        header.Pitch      = BlockCompressor::GetPitch( config.Format, surface.Width );
+        header.SlicePitch = BlockCompressor::GetSlicePitch( config.Format, surface.Width, surface.Height );
+        Append( image, header );
+
+        size_t offset = image.size();
+        image.resize( offset + header.SlicePitch );
+
+        BlockCompressor::Statistics stats;
+        BlockCompressor::Encode(
+            &m_Images[ i ][0],
+            surface.Width,
+            surface.Height,
+            surface.Width * 4,
+            config,
+            &image[ offset ],
+            m_pPool,
+            &stats );
+
+        colorError += stats.ColorSquaredError;
+        alphaError += stats.AlphaSquaredError;
+        colorCount += f64( stats.PixelCount ) * stats.ColorChannelCount;
+        alphaCount += f64( stats.PixelCount ) * stats.AlphaChannelCount;
+
+        m_Statistics.BlockCount     += stats.BlockCount;
+        m_Statistics.TileCount      += stats.TileCount;
+        m_Statistics.CompressedSize += header.SlicePitch;
+    }
+
+    // アルファの誤差がカラーの誤差に埋もれないように, 別々に求める.
+    m_Statistics.ColorPSNR = ComputePSNR( colorError, colorCount );
+    m_Statistics.AlphaPSNR = ComputePSNR( alphaError, alphaCount );
+    m_Statistics.HasAlpha  = ( alphaCount > 0.0 );
+    m_Statistics.Reencoded = true;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      入力ファイルのサーフェイスをそのままイメージにコピーします.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::Copy( const MapTexture& source, std::vector< u8 >& image )
+{
+    AppendFileHeader( image, source, source.GetFormat() );
+
+    u32 count = source.GetMipMapCount() * source.GetSurfaceCount();
+    for( u32 i=0; i<count; ++i )
+    {
+        const MapTexture::Surface& surface = source.GetSurface( i );
+
+        MapSurfaceHeader header;
+        header.Width      = surface.Width;
+        header.Height     = surface.Height;
+        header.Pitch      = surface.Pitch;
+        header.SlicePitch = surface.SlicePitch;
+        Append( image, header );
+
+        size_t offset = image.size();
+        image.resize( offset + surface.SlicePitch );
+        memcpy( &image[ offset ], surface.pPixels, surface.SlicePitch );
+
+        m_Statistics.CompressedSize += surface.SlicePitch;
+    }
+
+    m_Statistics.ColorPSNR = MAX_PSNR;
+    m_Statistics.AlphaPSNR = MAX_PSNR;
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      イメージをファイルに書き出します.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::WriteFile( const char* output, const std::vector< u8 >& image )
+{
+    // 書き込み途中のファイルが残らないように, 一時ファイルに書いてから置き換える.
+    std::string temp = std::string( output ) + ".tmp";
+    FILE* pFile = fopen( temp.c_str(), "wb" );
+    if ( pFile == nullptr )
+    { return SetError( "file open failed. filename = %s", temp.c_str() ); }
+
+    size_t written = fwrite( &image[0], 1, image.size(), pFile );
+    int    closed  = fclose( pFile );
+    if ( written != image.size() || closed != 0 )
+    {
+        remove( temp.c_str() );
+        return SetError( "file write failed. filename = %s", temp.c_str() );
+    }
+
+    remove( output );
+    if ( rename( temp.c_str(), output ) != 0 )
+    {
+        remove( temp.c_str() );
+        return SetError( "file rename failed. filename = %s", output );
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      エラーメッセージを設定します.
+//-----------------------------------------------------------------------------------
+bool TextureCooker::SetError( const char* format, ... )
+{
+    char buffer[ 1024 ];
+
+    va_list arg;
+    va_start( arg, format );
+    vsnprintf( buffer, sizeof( buffer ), format, arg );
+    va_end( arg );
+
+    m_Error = buffer;
+    return false;
+}
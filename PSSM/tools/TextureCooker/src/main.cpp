@@ -0,0 +1,434 @@
+﻿//-----------------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Texture Cooker Command Line Entry Point.
+// Copyright(c) Project Asura. All right reserved.
+//-----------------------------------------------------------------------------------
+//
+// 使い方 :
+//     TextureCooker [-f] [-n] [-c format] [-q quality] [-j threads] <input> <output>
+//
+//     <input> がディレクトリの場合は, 以下の .map ファイルを全て圧縮して
+//     <output> 以下に同じ階層・同じファイル名で出力します.
+//     -f を指定すると, 出力ファイルが最新でもクックし直します.
+//     -n を指定すると, 法線マップとして BC5 で出力します(1チャンネルの入力は高さマップとして扱います).
+//     -c で出力フォーマット(auto, bc1, bc3, bc4, bc5, bc7)を指定します(省略時は auto).
+//     -q で品質(fast, normal, high)を指定します(省略時は normal).
+//     -j でワーカースレッド数を指定します(省略時はハードウェアスレッド数-1).
+//
+// Linux でのビルド :
+//     g++ -std=c++11 -O2 -pthread -Iinclude -I../../sample/include -I../../asdx/include
+//         src/main.cpp src/TextureCooker.cpp ../../sample/src/MappedFile.cpp
+//         ../../sample/src/ThreadPool.cpp ../../sample/src/MapTexture.cpp
+//         ../../sample/src/BlockCompressor.cpp -o TextureCooker
+//
+//-----------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------------
+#include <TextureCooker.h>
+#include <ThreadPool.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+
+namespace /* anonymous */ {
+
+// 入力ファイルの拡張子.
+static const char* INPUT_EXTENSION = ".map";
+
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CookJob structure
+/////////////////////////////////////////////////////////////////////////////////////
+struct CookJob
+{
+    std::string                 Input;          //!< 入力ファイル名です.
+    std::string                 Output;         //!< 出力ファイル名です.
+    TextureCooker::RESULT       Result;         //!< 処理結果です.
+    std::string                 Error;          //!< エラーメッセージです.
+    TextureCooker::Statistics   Statistics;     //!< 統計情報です.
+};
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool IsDirectory( const std::string& path )
+{
+#if defined(_WIN32)
+    DWORD attr = GetFileAttributesA( path.c_str() );
+    return ( attr != INVALID_FILE_ATTRIBUTES ) && ( attr & FILE_ATTRIBUTE_DIRECTORY );
+#else
+    struct stat info;
+    return ( stat( path.c_str(), &info ) == 0 ) && S_ISDIR( info.st_mode );
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリを作成します(途中のディレクトリも作成します).
+//-----------------------------------------------------------------------------------
+bool CreateDirectories( const std::string& path )
+{
+    if ( path.empty() || IsDirectory( path ) )
+    { return true; }
+
+    size_t pos = path.find_last_of( "/\\" );
+    if ( pos != std::string::npos && pos > 0 )
+    {
+        if ( !CreateDirectories( path.substr( 0, pos ) ) )
+        { return false; }
+    }
+
+#if defined(_WIN32)
+    _mkdir( path.c_str() );
+#else
+    mkdir( path.c_str(), 0755 );
+#endif
+
+    // 他のスレッドが同時に作成した場合もあるので, 結果は存在するかどうかで判定する.
+    return IsDirectory( path );
+}
+
+//-----------------------------------------------------------------------------------
+//      ファイル名が指定した拡張子で終わるかどうか判定します.
+//-----------------------------------------------------------------------------------
+bool HasExtension( const std::string& filename, const char* ext )
+{
+    size_t length = strlen( ext );
+    if ( filename.size() < length )
+    { return false; }
+
+    for( size_t i=0; i<length; ++i )
+    {
+        char c = filename[ filename.size() - length + i ];
+        if ( c >= 'A' && c <= 'Z' )
+        { c = char( c - 'A' + 'a' ); }
+
+        if ( c != ext[i] )
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリ直下のエントリ名を取得します.
+//-----------------------------------------------------------------------------------
+void ListDirectory( const std::string& dir, std::vector< std::string >& result )
+{
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE hFind = FindFirstFileA( ( dir + "/*" ).c_str(), &data );
+    if ( hFind == INVALID_HANDLE_VALUE )
+    { return; }
+
+    do
+    { result.push_back( data.cFileName ); }
+    while( FindNextFileA( hFind, &data ) );
+
+    FindClose( hFind );
+#else
+    DIR* pDir = opendir( dir.c_str() );
+    if ( pDir == nullptr )
+    { return; }
+
+    while( dirent* pEntry = readdir( pDir ) )
+    { result.push_back( pEntry->d_name ); }
+
+    closedir( pDir );
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+//      ディレクトリ以下の入力ファイルを集めます.
+//-----------------------------------------------------------------------------------
+void CollectFiles( const std::string& root, const std::string& relative, std::vector< std::string >& result )
+{
+    std::vector< std::string > names;
+    ListDirectory( ( relative.empty() ) ? root : root + "/" + relative, names );
+
+    for( size_t i=0; i<names.size(); ++i )
+    {
+        const std::string& name = names[i];
+        if ( name == "." || name == ".." )
+        { continue; }
+
+        std::string path = ( relative.empty() ) ? name : relative + "/" + name;
+        if ( IsDirectory( root + "/" + path ) )
+        { CollectFiles( root, path, result ); }
+        else if ( HasExtension( name, INPUT_EXTENSION ) )
+        { result.push_back( path ); }
+    }
+}
+
+//-----------------------------------------------------------------------------------
+//      フォーマット名から MAP フォーマットを取得します.
+//-----------------------------------------------------------------------------------
+bool ParseFormat( const char* name, u32& result )
+{
+    static const struct { const char* Name; u32 Format; } TABLE[] = {
+        { "auto", TextureCooker::FORMAT_AUTO },
+        { "bc1",  MAP_FORMAT_BC1 },
+        { "bc3",  MAP_FORMAT_BC3 },
+        { "bc4",  MAP_FORMAT_BC4 },
+        { "bc5",  MAP_FORMAT_BC5 },
+        { "bc7",  MAP_FORMAT_BC7 },
+    };
+
+    for( size_t i=0; i<sizeof( TABLE ) / sizeof( TABLE[0] ); ++i )
+    {
+        if ( strcmp( name, TABLE[i].Name ) == 0 )
+        {
+            result = TABLE[i].Format;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------------
+//      品質名から品質を取得します.
+//-----------------------------------------------------------------------------------
+bool ParseQuality( const char* name, BlockCompressor::QUALITY& result )
+{
+    if ( strcmp( name, "fast" ) == 0 )
+    { result = BlockCompressor::QUALITY_FAST; }
+    else if ( strcmp( name, "normal" ) == 0 )
+    { result = BlockCompressor::QUALITY_NORMAL; }
+    else if ( strcmp( name, "high" ) == 0 )
+    { result = BlockCompressor::QUALITY_HIGH; }
+    else
+    { return false; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------------
+//      MAP フォーマットの表示名を取得します.
+//-----------------------------------------------------------------------------------
+const char* GetFormatName( u32 format )
+{
+    switch( format )
+    {
+    case MAP_FORMAT_R8:  return "R8";
+    case MAP_FORMAT_BC1: return "BC1";
+    case MAP_FORMAT_BC3: return "BC3";
+    case MAP_FORMAT_BC4: return "BC4";
+    case MAP_FORMAT_BC5: return "BC5";
+    case MAP_FORMAT_BC7: return "BC7";
+    default:             break;
+    }
+
+    return "unknown";
+}
+
+//-----------------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf( "usage : TextureCooker [-f] [-n] [-c format] [-q quality] [-j threads] <input> <output>\n" );
+    printf( "    <input>      .map file or directory.\n" );
+    printf( "    <output>     .map file or directory.\n" );
+    printf( "    -f           cook even if the output is up to date.\n" );
+    printf( "    -n           treat as a normal map and write BC5 (single channel input is a height map).\n" );
+    printf( "    -c format    auto, bc1, bc3, bc4, bc5 or bc7.\n" );
+    printf( "    -q quality   fast, normal or high.\n" );
+    printf( "    -j threads   number of worker threads.\n" );
+}
+
+} // namespace /* anonymous */
+
+
+//-----------------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------------
+int main( int argc, char** argv )
+{
+    bool                        force       = false;
+    bool                        normalMap   = false;
+    u32                         format      = TextureCooker::FORMAT_AUTO;
+    BlockCompressor::QUALITY    quality     = BlockCompressor::QUALITY_NORMAL;
+    u32                         threadCount = 0;
+    std::string                 input;
+    std::string                 output;
+
+    // 引数を解析.
+    for( int i=1; i<argc; ++i )
+    {
+        if ( strcmp( argv[i], "-f" ) == 0 )
+        { force = true; }
+        else if ( strcmp( argv[i], "-n" ) == 0 )
+        { normalMap = true; }
+        else if ( strcmp( argv[i], "-c" ) == 0 && i + 1 < argc && ParseFormat( argv[ i + 1 ], format ) )
+        { ++i; }
+        else if ( strcmp( argv[i], "-q" ) == 0 && i + 1 < argc && ParseQuality( argv[ i + 1 ], quality ) )
+        { ++i; }
+        else if ( strcmp( argv[i], "-j" ) == 0 && i + 1 < argc )
+        { threadCount = u32( atoi( argv[ ++i ] ) ); }
+        else if ( argv[i][0] != '-' && input.empty() )
+        { input = argv[i]; }
+        else if ( argv[i][0] != '-' && output.empty() )
+        { output = argv[i]; }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if ( input.empty() || output.empty() )
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    // ジョブを作成.
+    std::vector< CookJob > jobs;
+    if ( IsDirectory( input ) )
+    {
+        // 同じファイル名で出力するので, 入力を上書きしないようにする.
+        if ( input == output )
+        {
+            fprintf( stderr, "Error : output directory must differ from input directory.\n" );
+            return -1;
+        }
+
+        std::vector< std::string > files;
+        CollectFiles( input, "", files );
+
+        jobs.resize( files.size() );
+        for( size_t i=0; i<files.size(); ++i )
+        {
+            jobs[i].Input  = input  + "/" + files[i];
+            jobs[i].Output = output + "/" + files[i];
+        }
+    }
+    else
+    {
+        jobs.resize( 1 );
+        jobs[0].Input  = input;
+        jobs[0].Output = output;
+    }
+
+    ThreadPool pool;
+    if ( !pool.Init( threadCount ) )
+    {
+        fprintf( stderr, "Error : ThreadPool::Init() Failed.\n" );
+        return -1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // ファイル単位で並列にクックし, ファイル内はタイル単位で並列にエンコードする.
+    pool.ParallelFor( u32( jobs.size() ), 1, [&]( u32 begin, u32 end, u32 )
+    {
+        TextureCooker cooker;
+        cooker.SetForce( force );
+        cooker.SetNormalMap( normalMap );
+        cooker.SetFormat( format );
+        cooker.SetQuality( quality );
+        cooker.SetThreadPool( &pool );
+
+        for( u32 i=begin; i<end; ++i )
+        {
+            CookJob& job = jobs[i];
+
+            size_t pos = job.Output.find_last_of( "/\\" );
+            if ( pos != std::string::npos && !CreateDirectories( job.Output.substr( 0, pos ) ) )
+            {
+                job.Result = TextureCooker::RESULT_FAILED;
+                job.Error  = "directory create failed.";
+                continue;
+            }
+
+            job.Result     = cooker.Cook( job.Input.c_str(), job.Output.c_str() );
+            job.Error      = cooker.GetError();
+            job.Statistics = cooker.GetStatistics();
+        }
+    } );
+
+    pool.Term();
+
+    f64 elapsed = std::chrono::duration< f64 >( std::chrono::steady_clock::now() - start ).count();
+
+    // 結果を表示.
+    u32 cooked   = 0;
+    u32 upToDate = 0;
+    u32 failed   = 0;
+    for( size_t i=0; i<jobs.size(); ++i )
+    {
+        const CookJob& job = jobs[i];
+        switch( job.Result )
+        {
+        case TextureCooker::RESULT_COOKED:
+            {
+                const TextureCooker::Statistics& stats = job.Statistics;
+                printf( "cooked     : %s (%ux%u, mip %u, %s -> %s%s%s)\n",
+                    job.Output.c_str(),
+                    stats.Width,
+                    stats.Height,
+                    stats.MipMapCount,
+                    GetFormatName( stats.SourceFormat ),
+                    GetFormatName( stats.Format ),
+                    ( stats.Reencoded )       ? "" : ", copied",
+                    ( stats.GeneratedNormal ) ? ", normal generated" : "" );
+                printf( "             pixel data %llu -> %llu bytes (RGBA8 %llu bytes, %.1fx smaller)\n",
+                    static_cast<unsigned long long>( stats.SourceSize ),
+                    static_cast<unsigned long long>( stats.CompressedSize ),
+                    static_cast<unsigned long long>( stats.UncompressedSize ),
+                    ( stats.CompressedSize > 0 ) ? f64( stats.UncompressedSize ) / f64( stats.CompressedSize ) : 0.0 );
+                if ( stats.Reencoded )
+                {
+                    if ( stats.HasAlpha )
+                    {
+                        printf( "             %u blocks in %u tiles, PSNR RGB %.2f dB, alpha %.2f dB\n",
+                            stats.BlockCount,
+                            stats.TileCount,
+                            stats.ColorPSNR,
+                            stats.AlphaPSNR );
+                    }
+                    else
+                    {
+                        printf( "             %u blocks in %u tiles, PSNR %.2f dB\n",
+                            stats.BlockCount,
+                            stats.TileCount,
+                            stats.ColorPSNR );
+                    }
+                }
+
+                cooked++;
+            }
+            break;
+
+        case TextureCooker::RESULT_UP_TO_DATE:
+            {
+                printf( "up to date : %s\n", job.Output.c_str() );
+                upToDate++;
+            }
+            break;
+
+        default:
+            {
+                fprintf( stderr, "failed     : %s (%s)\n", job.Input.c_str(), job.Error.c_str() );
+                failed++;
+            }
+            break;
+        }
+    }
+
+    printf( "%u cooked, %u up to date, %u failed. (%.3f sec)\n", cooked, upToDate, failed, elapsed );
+
+    return ( failed == 0 ) ? 0 : -1;
+}